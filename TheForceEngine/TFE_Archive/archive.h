@@ -55,6 +55,9 @@ public:
 	virtual u32 getFileCount() = 0;
 	virtual const char* getFileName(u32 index) = 0;
 	virtual size_t getFileLength(u32 index) = 0;
+	// Offset of the file data within the archive file, so it can be read directly (for example when streaming).
+	// Returns false if the data is not stored uncompressed.
+	virtual bool getFileDataOffset(u32 index, size_t* offset) { return false; }
 
 	// Edit
 	virtual void addFile(const char* fileName, const char* filePath) = 0;
@@ -175,6 +175,13 @@ size_t GobArchive::getFileLength(u32 index)
 	return m_fileList.entries[index].LEN;
 }
 
+bool GobArchive::getFileDataOffset(u32 index, size_t* offset)
+{
+	if (!m_archiveOpen || index >= getFileCount()) { return false; }
+	*offset = (size_t)m_fileList.entries[index].IX;
+	return true;
+}
+
 // Edit
 void GobArchive::addFile(const char* fileName, const char* filePath)
 {
@@ -160,6 +160,13 @@ size_t LabArchive::getFileLength(u32 index)
 	return m_entries[index].len;
 }
 
+bool LabArchive::getFileDataOffset(u32 index, size_t* offset)
+{
+	if (!m_archiveOpen || index >= getFileCount()) { return false; }
+	*offset = (size_t)m_entries[index].dataOffset;
+	return true;
+}
+
 // Edit
 void LabArchive::addFile(const char* fileName, const char* filePath)
 {
@@ -31,6 +31,7 @@ public:
 	u32 getFileCount() override;
 	const char* getFileName(u32 index) override;
 	size_t getFileLength(u32 index) override;
+	bool getFileDataOffset(u32 index, size_t* offset) override;
 
 	// Edit
 	void addFile(const char* fileName, const char* filePath) override;
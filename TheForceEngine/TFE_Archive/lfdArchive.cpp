@@ -192,6 +192,13 @@ size_t LfdArchive::getFileLength(u32 index)
 	return m_fileList.entries[index].LENGTH;
 }
 
+bool LfdArchive::getFileDataOffset(u32 index, size_t* offset)
+{
+	if (!m_archiveOpen || index >= getFileCount()) { return false; }
+	*offset = (size_t)m_fileList.entries[index].IX;
+	return true;
+}
+
 // Edit
 void LfdArchive::addFile(const char* fileName, const char* filePath)
 {
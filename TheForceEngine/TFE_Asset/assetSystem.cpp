@@ -111,4 +111,31 @@ namespace TFE_AssetSystem
 		}
 		return false;
 	}
+
+	bool getAssetLocation(const char* defaultArchive, ArchiveType type, const char* filename, char* archivePath, size_t* offset, size_t* length)
+	{
+		// Use the same search order as openArchiveFile().
+		Archive* archive = nullptr;
+		u32 index = INVALID_FILE;
+		if (s_customArchive)
+		{
+			index = s_customArchive->getFileIndex(filename);
+			if (index != INVALID_FILE) { archive = s_customArchive; }
+		}
+		if (!archive)
+		{
+			char gobPath[TFE_MAX_PATH];
+			TFE_Paths::appendPath(PATH_SOURCE_DATA, defaultArchive, gobPath);
+			archive = Archive::getArchive(type, defaultArchive, gobPath);
+			index = archive ? archive->getFileIndex(filename) : INVALID_FILE;
+		}
+		if (index == INVALID_FILE || !archive->getFileDataOffset(index, offset))
+		{
+			return false;
+		}
+
+		strcpy(archivePath, archive->getPath());
+		*length = archive->getFileLength(index);
+		return true;
+	}
 }
@@ -17,4 +17,7 @@ namespace TFE_AssetSystem
 	bool readAssetFromArchive(const char* defaultArchive, ArchiveType type, const char* filename, std::vector<char>& buffer);
 	bool readAssetFromArchive(const char* defaultArchive, const char* filename, std::vector<u8>& buffer);
 	bool readAssetFromArchive(const char* defaultArchive, const char* filename, std::vector<char>& buffer);
+	// Find where the file data is stored so that it can be read incrementally, 'archivePath' must hold at least TFE_MAX_PATH characters.
+	// Returns false if the file does not exist or is compressed.
+	bool getAssetLocation(const char* defaultArchive, ArchiveType type, const char* filename, char* archivePath, size_t* offset, size_t* length);
 }
@@ -4,6 +4,10 @@
 #include <TFE_Archive/archive.h>
 #include <TFE_System/parser.h>
 #include <TFE_Audio/audioSystem.h>
+#include <TFE_Audio/audioStream.h>
+#include <TFE_Audio/audioMixer.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_Settings/settings.h>
 #include <assert.h>
 #include <map>
 #include <algorithm>
@@ -16,8 +20,14 @@ namespace TFE_VocAsset
 	static VocList s_vocAssetList;
 	static std::vector<u8> s_buffer;
 	static const char* c_defaultGob = "SOUNDS.GOB";
+	// VOCs at least this size are streamed by getStreamIndex(), about 6 seconds at 11kHz.
+	static const size_t c_streamMinSize = 64 * 1024;
+	// Names of the streamed VOCs, indexed by the stream index.
+	static std::map<std::string, s32> s_streamMap;
+	static std::vector<std::string> s_streamList;
 
 	bool parseVoc(SoundBuffer* voc);
+	SoundStreamDecoder* createStreamDecoder(const char* archivePath, size_t offset, size_t length);
 	
 	SoundBuffer* get(const char* name)
 	{
@@ -52,11 +62,14 @@ namespace TFE_VocAsset
 		for (; iVoc != s_vocAssetList.end(); ++iVoc)
 		{
 			SoundBuffer* voc = *iVoc;
-			delete[] voc->data;
+			// Allocated with realloc() while parsing.
+			free(voc->data);
 			delete voc;
 		}
 		s_vocAssets.clear();
 		s_vocAssetList.clear();
+		s_streamMap.clear();
+		s_streamList.clear();
 	}
 
 	s32 getIndex(const char* name)
@@ -92,6 +105,57 @@ namespace TFE_VocAsset
 		return s_vocAssetList[index];
 	}
 
+	SoundBuffer* openStream(const char* name)
+	{
+		char archivePath[TFE_MAX_PATH];
+		size_t offset, length;
+		if (!TFE_AssetSystem::getAssetLocation(c_defaultGob, ARCHIVE_GOB, name, archivePath, &offset, &length))
+		{
+			return nullptr;
+		}
+
+		SoundStreamDecoder* decoder = createStreamDecoder(archivePath, offset, length);
+		if (!decoder)
+		{
+			TFE_System::logWrite(LOG_WARNING, "VOC", "Cannot stream \"%s\".", name);
+			return nullptr;
+		}
+		return TFE_AudioStream::create(decoder);
+	}
+
+	void closeStream(SoundBuffer* stream)
+	{
+		TFE_AudioStream::close(stream);
+	}
+
+	s32 getStreamIndex(const char* name)
+	{
+		std::map<std::string, s32>::iterator iStream = s_streamMap.find(name);
+		if (iStream != s_streamMap.end())
+		{
+			return iStream->second;
+		}
+
+		// Compressed files have no location in the archive and are loaded normally.
+		char archivePath[TFE_MAX_PATH];
+		size_t offset, length;
+		if (!TFE_AssetSystem::getAssetLocation(c_defaultGob, ARCHIVE_GOB, name, archivePath, &offset, &length) || length < c_streamMinSize)
+		{
+			return -1;
+		}
+
+		const s32 index = (s32)s_streamList.size();
+		s_streamMap[name] = index;
+		s_streamList.push_back(name);
+		return index;
+	}
+
+	SoundBuffer* openStreamFromIndex(s32 index)
+	{
+		if (index < 0 || index >= (s32)s_streamList.size()) { return nullptr; }
+		return openStream(s_streamList[index].c_str());
+	}
+
 	////////////////////////////////////////
 	//////////// Internal //////////////////
 	////////////////////////////////////////
@@ -259,6 +323,178 @@ namespace TFE_VocAsset
 			voc->loopEnd = voc->size;
 		}
 
+		// Optionally convert to the output sample rate now, so the mixer doesn't have to resample during playback.
+		if (voc->data && TFE_Settings::getSoundSettings()->preResampleVoc)
+		{
+			TFE_Audio::resampleBuffer(voc, TFE_Audio::getOutputSampleRate());
+		}
+
 		return voc->data != nullptr;
 	}
+
+	// Decodes VOC blocks directly from the archive file, a small amount at a time.
+	class VocStreamDecoder : public SoundStreamDecoder
+	{
+	public:
+		bool open(const char* archivePath, size_t offset, size_t length)
+		{
+			if (length < sizeof(VocHeader) || !m_file.open(archivePath, FileStream::MODE_READ)) { return false; }
+			m_base = offset;
+			m_length = length;
+			m_sampleRate = 0;
+			m_loopPos = 0;
+			m_hasLoop = false;
+
+			VocHeader header;
+			m_file.seekFromStart(u64(m_base));
+			m_file.readBuffer(&header, sizeof(VocHeader));
+			if (header.datablockOffset >= m_length) { return false; }
+			m_dataPos = header.datablockOffset;
+
+			rewind(false);
+			return true;
+		}
+
+		u32 decode(f32* out, u32 count, bool looping) override
+		{
+			u32 total = 0;
+			while (total < count)
+			{
+				if (m_blockRemaining)
+				{
+					const u32 samples = std::min(std::min(count - total, m_blockRemaining), (u32)sizeof(m_readBuffer));
+					m_file.readBuffer(m_readBuffer, samples);
+					TFE_AudioMixer::convertToFloat(SOUND_DATA_8BIT, m_readBuffer, 0, samples, out + total);
+					m_blockRemaining -= samples;
+					m_pos += samples;
+					total += samples;
+				}
+				else if (m_silenceRemaining)
+				{
+					const u32 samples = std::min(count - total, m_silenceRemaining);
+					memset(out + total, 0, sizeof(f32) * samples);
+					m_silenceRemaining -= samples;
+					total += samples;
+				}
+				else if (!nextBlock(looping))
+				{
+					break;
+				}
+			}
+			return total;
+		}
+
+		void rewind(bool loop) override
+		{
+			seek(loop && m_hasLoop ? m_loopPos : m_dataPos);
+			m_blockRemaining = 0;
+			m_silenceRemaining = 0;
+		}
+
+		u32 getSampleRate() override
+		{
+			return m_sampleRate;
+		}
+
+	private:
+		void seek(size_t pos)
+		{
+			m_pos = pos;
+			m_file.seekFromStart(u64(m_base + m_pos));
+		}
+
+		// Read the next block header and setup the block state, returns false at the end of the data
+		// or, when looping, at the end of the repeat section.
+		bool nextBlock(bool looping)
+		{
+			const size_t blockStart = m_pos;
+			if (m_pos + 4 > m_length) { return false; }
+
+			u8 blockHeader[4];
+			m_file.readBuffer(blockHeader, 4);
+			m_pos += 4;
+			const BlockType type = BlockType(blockHeader[0]);
+			if (type == VOC_TERMINATOR || type > VOC_END_REPEAT)
+			{
+				m_pos = m_length;
+				return false;
+			}
+			const u32 blockLen = blockHeader[1] | (blockHeader[2] << 8u) | (blockHeader[3] << 16u);
+			const size_t blockEnd = std::min(m_pos + blockLen, m_length);
+
+			u8 params[3] = { 0 };
+			switch (type)
+			{
+				case VOC_SOUND_DATA:
+				{
+					if (blockEnd - m_pos < 2) { break; }
+					m_file.readBuffer(params, 2);
+					m_pos += 2;
+					assert(params[1] == CODEC_8BITS);
+					m_sampleRate = 1000000 / (256 - (u32)params[0]);
+					// See addSoundData(), Dark Forces plays 10989Hz VOCs at 11025Hz.
+					if (m_sampleRate == 10989) { m_sampleRate = 11025; }
+					m_blockRemaining = u32(blockEnd - m_pos);
+					return true;
+				}
+				case VOC_SOUND_CONTINUE:
+				{
+					m_blockRemaining = u32(blockEnd - m_pos);
+					return true;
+				}
+				case VOC_SILENCE:
+				{
+					if (blockEnd - m_pos < 3) { break; }
+					m_file.readBuffer(params, 3);
+					m_pos += 3;
+					m_silenceRemaining = params[0] | (params[1] << 8u);
+				} break;
+				case VOC_REPEAT:
+				{
+					// Dark Forces VOC files only have zero or one looping section, the repeat count is ignored (see loopStart()).
+					m_loopPos = blockEnd;
+					m_hasLoop = true;
+				} break;
+				case VOC_END_REPEAT:
+				{
+					// Stay on this block so that the caller rewinds to the loop start, the data after the
+					// repeat section is only played when not looping.
+					if (looping && m_hasLoop)
+					{
+						seek(blockStart);
+						return false;
+					}
+				} break;
+				default:
+					// Markers and text are ignored.
+					break;
+			};
+			seek(blockEnd);
+			return true;
+		}
+
+	private:
+		FileStream m_file;
+		size_t m_base;
+		size_t m_length;
+		size_t m_pos;
+		size_t m_dataPos;
+		size_t m_loopPos;
+		bool m_hasLoop;
+		u32 m_sampleRate;
+		u32 m_blockRemaining;
+		u32 m_silenceRemaining;
+		u8 m_readBuffer[1024];
+	};
+
+	SoundStreamDecoder* createStreamDecoder(const char* archivePath, size_t offset, size_t length)
+	{
+		VocStreamDecoder* decoder = new VocStreamDecoder();
+		if (!decoder->open(archivePath, offset, length))
+		{
+			delete decoder;
+			return nullptr;
+		}
+		return decoder;
+	}
 }
@@ -17,4 +17,16 @@ namespace TFE_VocAsset
 
 	s32 getIndex(const char* name);
 	SoundBuffer* getFromIndex(s32 index);
+
+	// Stream the VOC from its archive instead of loading it into memory, useful for long sounds.
+	// Each stream should only be played by one source at a time and must be closed with closeStream().
+	// Returns nullptr if the VOC can't be streamed (for example if it is stored compressed).
+	SoundBuffer* openStream(const char* name);
+	void closeStream(SoundBuffer* stream);
+
+	// Long VOCs, such as ambient loops, are streamed while in use instead of being loaded with the level.
+	// Returns the index to pass to openStreamFromIndex(), or -1 if the VOC is short or can't be streamed
+	// and should be loaded with get() instead.
+	s32 getStreamIndex(const char* name);
+	SoundBuffer* openStreamFromIndex(s32 index);
 };
@@ -0,0 +1,82 @@
+#include "wavWriter.h"
+#include <TFE_System/system.h>
+#include <TFE_FileSystem/filestream.h>
+#include <algorithm>
+#include <vector>
+
+namespace TFE_WAV
+{
+	// Size of the RIFF, fmt and data chunk headers.
+	static const u32 c_headerSize = 44;
+
+	static FileStream s_file;
+	static u32 s_channelCount;
+	static u32 s_frameCount;
+	static std::vector<s16> s_tempBuffer;
+
+	void writeHeader(u32 sampleRate, u32 dataSize)
+	{
+		const u16 format = 1;	// PCM
+		const u16 channelCount = u16(s_channelCount);
+		const u16 blockAlign = u16(s_channelCount * sizeof(s16));
+		const u16 bitsPerSample = 16;
+		const u32 byteRate = sampleRate * blockAlign;
+		const u32 riffSize = c_headerSize - 8 + dataSize;
+		const u32 fmtSize = 16;
+
+		s_file.writeBuffer("RIFF", 4);
+		s_file.write(&riffSize);
+		s_file.writeBuffer("WAVEfmt ", 8);
+		s_file.write(&fmtSize);
+		s_file.write(&format);
+		s_file.write(&channelCount);
+		s_file.write(&sampleRate);
+		s_file.write(&byteRate);
+		s_file.write(&blockAlign);
+		s_file.write(&bitsPerSample);
+		s_file.writeBuffer("data", 4);
+		s_file.write(&dataSize);
+	}
+
+	bool startWav(const char* path, u32 sampleRate, u32 channelCount)
+	{
+		if (!s_file.open(path, FileStream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_ERROR, "WAV", "Cannot open \"%s\" for writing.", path);
+			return false;
+		}
+		s_channelCount = channelCount;
+		s_frameCount = 0;
+		// The sizes are filled in by write().
+		writeHeader(sampleRate, 0);
+		return true;
+	}
+
+	void addSamples(const f32* samples, u32 frameCount)
+	{
+		if (!s_file.isOpen()) { return; }
+
+		const u32 count = frameCount * s_channelCount;
+		s_tempBuffer.resize(count);
+		for (u32 i = 0; i < count; i++)
+		{
+			s_tempBuffer[i] = s16(std::max(-1.0f, std::min(samples[i], 1.0f)) * 32767.0f);
+		}
+		s_file.write(s_tempBuffer.data(), count);
+		s_frameCount += frameCount;
+	}
+
+	bool write()
+	{
+		if (!s_file.isOpen()) { return false; }
+
+		const u32 dataSize = s_frameCount * s_channelCount * sizeof(s16);
+		const u32 riffSize = c_headerSize - 8 + dataSize;
+		s_file.seek(4);
+		s_file.write(&riffSize);
+		s_file.seek(c_headerSize - 4);
+		s_file.write(&dataSize);
+		s_file.close();
+		return true;
+	}
+}
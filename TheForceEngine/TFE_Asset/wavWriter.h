@@ -0,0 +1,15 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine WAV Writer
+// Writes 16-bit PCM WAV files, samples are streamed to disk as they
+// are added so long recordings don't need to be held in memory.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace TFE_WAV
+{
+	bool startWav(const char* path, u32 sampleRate, u32 channelCount);
+	// Add 'frameCount' interleaved frames in the [-1, 1] range.
+	void addSamples(const f32* samples, u32 frameCount);
+	bool write();
+}
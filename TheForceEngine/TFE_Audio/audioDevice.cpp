@@ -1,12 +1,23 @@
 #include "AudioDevice.h"
 #include <TFE_System/system.h>
+#include <TFE_System/Threads/thread.h>
+#include <TFE_Asset/wavWriter.h>
 #include "RtAudio.h"
+#include <algorithm>
+#include <vector>
 
 //This system uses "RtAudio" as the low level, cross platform interface to the Audio system.
 //https://www.music.mcgill.ca/~gary/rtaudio/
+//
+//The Null and WAV outputs don't use RtAudio, instead the stream callback is called from a thread that
+//runs in realtime or as fast as possible, or from the game thread through advance(). This allows the
+//mixer to run on machines without an audio device and deterministic audio captures.
 
 namespace TFE_AudioDevice
 {
+	// Limit the amount of audio mixed at once if the realtime clock falls behind.
+	static const f64 c_maxPendingFrames = 8192.0;
+
 	static RtAudio* s_device = NULL;
 	static u32 s_outputDevice;
 	static u32 s_inputDevice;
@@ -17,10 +28,47 @@ namespace TFE_AudioDevice
 	static u32  s_audioFrameSize;
 	static bool s_streamStarted;
 
-	bool init(u32 audioFrameSize)
+	// Null and WAV output.
+	static TFE_AudioOutput s_output = TFE_AUDIO_OUTPUT_DEVICE;
+	static TFE_AudioClock s_clock = TFE_AUDIO_CLOCK_REALTIME;
+	static char s_capturePath[TFE_MAX_PATH];
+	static StreamCallback s_callback = nullptr;
+	static void* s_callbackUserData = nullptr;
+	static u32 s_channels;
+	static u32 s_sampleRate;
+	static f64 s_streamTime;
+	static std::vector<f32> s_outputBuffer;
+	static Thread* s_outputThread = nullptr;
+	static atomic_bool s_runOutputThread;
+
+	TFE_THREADRET nullOutputFunc(void* userData);
+
+	bool init(u32 audioFrameSize, TFE_AudioOutput output, TFE_AudioClock clock, const char* capturePath)
 	{
+		s_streamStarted  = false;
+		s_audioFrameSize = audioFrameSize;
+		s_output = output;
+		s_clock = clock;
+		s_capturePath[0] = 0;
+		if (capturePath) { strcpy(s_capturePath, capturePath); }
+
+		if (s_output != TFE_AUDIO_OUTPUT_DEVICE)
+		{
+			TFE_System::logWrite(LOG_MSG, "Audio", "Using the %s audio output, clock: %s.", c_tfeAudioOutputStrings[s_output], c_tfeAudioClockStrings[s_clock]);
+			return true;
+		}
+
 		s_device = new RtAudio();
 		if (!s_device) { return false; }
+		if (!s_device->getDeviceCount())
+		{
+			TFE_System::logWrite(LOG_WARNING, "Audio", "No audio devices found, using the Null audio output.");
+			delete s_device;
+			s_device = NULL;
+			s_output = TFE_AUDIO_OUTPUT_NULL;
+			s_clock = TFE_AUDIO_CLOCK_REALTIME;
+			return true;
+		}
 
 		s_outputDevice = s_device->getDefaultOutputDevice();
 		s_inputDevice  = s_device->getDefaultInputDevice();
@@ -28,9 +76,6 @@ namespace TFE_AudioDevice
 		s_InputInfo  = s_device->getDeviceInfo(s_inputDevice);
 		s_OutputInfo = s_device->getDeviceInfo(s_outputDevice);
 
-		s_streamStarted  = false;
-		s_audioFrameSize = audioFrameSize;
-
 		return true;
 	}
 
@@ -38,6 +83,7 @@ namespace TFE_AudioDevice
 	{
 		stopOutput();
 		delete s_device;
+		s_device = NULL;
 	}
 
 	void errorCallback(RtAudioError::Type type, const std::string &errorText)
@@ -45,8 +91,40 @@ namespace TFE_AudioDevice
 		TFE_System::logWrite(LOG_ERROR, "Audio Device", "%s", errorText.c_str());
 	}
 
+	bool startNullOutput(StreamCallback callback, void* userData, u32 channels, u32 sampleRate)
+	{
+		if (s_output == TFE_AUDIO_OUTPUT_WAV && !TFE_WAV::startWav(s_capturePath, sampleRate, channels))
+		{
+			return false;
+		}
+
+		s_callback = callback;
+		s_callbackUserData = userData;
+		s_channels = channels;
+		s_sampleRate = sampleRate;
+		s_streamTime = 0.0;
+		s_outputBuffer.resize(s_audioFrameSize * channels);
+		s_streamStarted = true;
+
+		if (s_clock != TFE_AUDIO_CLOCK_GAME)
+		{
+			s_runOutputThread.store(true);
+			s_outputThread = Thread::create("AudioOutputThread", nullOutputFunc, nullptr);
+			if (!s_outputThread || !s_outputThread->run())
+			{
+				TFE_System::logWrite(LOG_ERROR, "Audio", "Cannot start the audio output thread.");
+				return false;
+			}
+		}
+		return true;
+	}
+
 	bool startOutput(StreamCallback callback, void* userData, u32 channels, u32 sampleRate)
 	{
+		if (s_output != TFE_AUDIO_OUTPUT_DEVICE)
+		{
+			return startNullOutput(callback, userData, channels, sampleRate);
+		}
 		if (!s_device) { return false; }
 
 		RtAudio::StreamParameters  outParam;
@@ -70,11 +148,92 @@ namespace TFE_AudioDevice
 
 	void stopOutput()
 	{
-		if (s_device && s_streamStarted)
+		if (!s_streamStarted) { return; }
+		TFE_System::logWrite(LOG_MSG, "Audio", "Stop Audio Stream.");
+
+		if (s_output != TFE_AUDIO_OUTPUT_DEVICE)
+		{
+			if (s_outputThread)
+			{
+				s_runOutputThread.store(false);
+				s_outputThread->waitOnExit();
+				delete s_outputThread;
+				s_outputThread = nullptr;
+			}
+			if (s_output == TFE_AUDIO_OUTPUT_WAV)
+			{
+				TFE_WAV::write();
+			}
+		}
+		else if (s_device)
 		{
-			TFE_System::logWrite(LOG_MSG, "Audio", "Stop Audio Stream.");
 			s_device->stopStream();
-			s_streamStarted = false;
+			// Close the stream so that output can be started again.
+			s_device->closeStream();
+		}
+		s_streamStarted = false;
+	}
+
+	TFE_AudioOutput getOutput()
+	{
+		return s_output;
+	}
+
+	bool usesGameClock()
+	{
+		return s_output != TFE_AUDIO_OUTPUT_DEVICE && s_clock == TFE_AUDIO_CLOCK_GAME;
+	}
+
+	bool isOutputThreadRunning()
+	{
+		return s_streamStarted && !usesGameClock();
+	}
+
+	// Call the stream callback for 'frameCount' frames, split into blocks of at most the audio frame size.
+	void renderFrames(u32 frameCount)
+	{
+		while (frameCount)
+		{
+			const u32 count = std::min(frameCount, s_audioFrameSize);
+			s_callback(s_outputBuffer.data(), nullptr, count, s_streamTime, 0u, s_callbackUserData);
+			if (s_output == TFE_AUDIO_OUTPUT_WAV)
+			{
+				TFE_WAV::addSamples(s_outputBuffer.data(), count);
+			}
+			s_streamTime += f64(count) / f64(s_sampleRate);
+			frameCount -= count;
+		}
+	}
+
+	void advance(u32 frameCount)
+	{
+		if (!s_streamStarted || !usesGameClock()) { return; }
+		renderFrames(frameCount);
+	}
+
+	// Thread Function
+	TFE_THREADRET nullOutputFunc(void* userData)
+	{
+		u64 localTime = 0;
+		f64 pendingFrames = 0.0;
+		while (s_runOutputThread.load())
+		{
+			if (s_clock == TFE_AUDIO_CLOCK_UNTHROTTLED)
+			{
+				renderFrames(s_audioFrameSize);
+				continue;
+			}
+
+			// Realtime: mix whole buffers as the time elapses.
+			pendingFrames = std::min(pendingFrames + TFE_System::updateThreadLocal(&localTime) * f64(s_sampleRate), c_maxPendingFrames);
+			if (pendingFrames < f64(s_audioFrameSize))
+			{
+				TFE_System::sleep(1);
+				continue;
+			}
+			renderFrames(s_audioFrameSize);
+			pendingFrames -= f64(s_audioFrameSize);
 		}
+		return (TFE_THREADRET)0;
 	}
 }
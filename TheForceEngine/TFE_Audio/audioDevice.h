@@ -1,6 +1,7 @@
 #pragma once
 #include <TFE_System/types.h>
 #include <TFE_FileSystem/paths.h>
+#include <TFE_Settings/settings.h>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN 1
@@ -24,9 +25,19 @@ typedef s32(*StreamCallback)(void* outputBuffer, void* inputBuffer, u32 nFrames,
 
 namespace TFE_AudioDevice
 {
-	bool init(u32 audioFrameSize = 256u);
+	// The Null and WAV outputs pull the stream callback from the selected clock instead of an audio device,
+	// the WAV output is written to 'capturePath'. The Null output is also used if no audio device is found.
+	bool init(u32 audioFrameSize = 256u, TFE_AudioOutput output = TFE_AUDIO_OUTPUT_DEVICE, TFE_AudioClock clock = TFE_AUDIO_CLOCK_REALTIME, const char* capturePath = nullptr);
 	void destroy();
 
 	bool startOutput(StreamCallback callback, void* userData = 0, u32 channels = 2, u32 sampleRate = 44100);
 	void stopOutput();
+
+	TFE_AudioOutput getOutput();
+	// Returns true if the output is driven by advance() rather than an audio thread.
+	bool usesGameClock();
+	// Returns true if an audio thread is currently calling the stream callback.
+	bool isOutputThreadRunning();
+	// Game clock only: run the stream callback for 'frameCount' frames on the calling thread.
+	void advance(u32 frameCount);
 };
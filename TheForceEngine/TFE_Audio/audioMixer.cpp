@@ -0,0 +1,280 @@
+#include "audioMixer.h"
+#include <TFE_System/math.h>
+#include <assert.h>
+#include <algorithm>
+#include <string.h>
+
+// SSE2 is always available on x64, other targets use the scalar paths.
+#if defined(_M_X64) || defined(__SSE2__)
+#define AUDIO_MIXER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Comment out the desired sigmoid function and comment all of the others.
+//#define AUDIO_SIGMOID_CLIP 1
+#define AUDIO_SIGMOID_TANH 1
+//#define AUDIO_SIGMOID_RCP_SQRT 1
+
+namespace TFE_AudioMixer
+{
+	static const f32 c_channelLimit = 1.0f;
+	// tanhf_series() is only valid in this range, outside of it the result is +/-1.
+	static const f32 c_tanhRange = 4.8f;
+
+	static const f32 c_scale[]  = { 2.0f / 255.0f, 2.0f / 65535.0f, 1.0f, 1.0f };
+	static const f32 c_offset[] = { -1.0f, -1.0f, 0.0f, 0.0f };
+
+	// Polyphase windowed-sinc table, the fractional position selects one of the phases.
+	#define SINC_PHASE_BITS 6
+	#define SINC_PHASE_COUNT (1 << SINC_PHASE_BITS)
+	// Cutoff relative to the source Nyquist frequency, slightly below 1.0 to reduce imaging when upsampling.
+	static const f64 c_sincCutoff = 0.92;
+	static const f32 c_fracScale = 1.0f / 4294967296.0f;
+	alignas(16) static f32 s_sincTable[SINC_PHASE_COUNT][RESAMPLE_SINC_TAPS];
+
+	void init()
+	{
+		const f64 pi = 3.14159265358979323846;
+		const f64 halfWidth = f64(RESAMPLE_SINC_TAPS / 2);
+		for (s32 p = 0; p < SINC_PHASE_COUNT; p++)
+		{
+			const f64 phase = f64(p) / f64(SINC_PHASE_COUNT);
+			f64 sum = 0.0;
+			f64 taps[RESAMPLE_SINC_TAPS];
+			for (s32 t = 0; t < RESAMPLE_SINC_TAPS; t++)
+			{
+				// Distance from the output position to the tap.
+				const f64 x = f64(t - RESAMPLE_HISTORY) - phase;
+				const f64 arg = pi * c_sincCutoff * x;
+				const f64 sinc = fabs(x) < 1e-9 ? 1.0 : sin(arg) / arg;
+				// Blackman window spanning the filter width.
+				const f64 w = 0.42 + 0.5 * cos(pi * x / halfWidth) + 0.08 * cos(2.0 * pi * x / halfWidth);
+				taps[t] = fabs(x) < halfWidth ? sinc * w : 0.0;
+				sum += taps[t];
+			}
+			// Normalize each phase for unity gain at DC.
+			for (s32 t = 0; t < RESAMPLE_SINC_TAPS; t++)
+			{
+				s_sincTable[p][t] = f32(taps[t] / sum);
+			}
+		}
+	}
+
+	void convertToFloat(SoundDataType type, const u8* data, u32 index, u32 count, f32* out)
+	{
+		const f32 scale  = c_scale[type];
+		const f32 offset = c_offset[type];
+		u32 i = 0;
+
+		switch (type)
+		{
+			case SOUND_DATA_8BIT:
+			{
+				const u8* src = data + index;
+			#ifdef AUDIO_MIXER_SSE2
+				const __m128 scale4  = _mm_set1_ps(scale);
+				const __m128 offset4 = _mm_set1_ps(offset);
+				const __m128i zero   = _mm_setzero_si128();
+				for (; i + 16 <= count; i += 16)
+				{
+					const __m128i bytes = _mm_loadu_si128((const __m128i*)(src + i));
+					const __m128i lo16  = _mm_unpacklo_epi8(bytes, zero);
+					const __m128i hi16  = _mm_unpackhi_epi8(bytes, zero);
+					_mm_storeu_ps(out + i +  0, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo16, zero)), scale4), offset4));
+					_mm_storeu_ps(out + i +  4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo16, zero)), scale4), offset4));
+					_mm_storeu_ps(out + i +  8, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi16, zero)), scale4), offset4));
+					_mm_storeu_ps(out + i + 12, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi16, zero)), scale4), offset4));
+				}
+			#endif
+				for (; i < count; i++)
+				{
+					out[i] = f32(src[i]) * scale + offset;
+				}
+			} break;
+			case SOUND_DATA_16BIT:
+			{
+				const u16* src = (const u16*)data + index;
+			#ifdef AUDIO_MIXER_SSE2
+				const __m128 scale4  = _mm_set1_ps(scale);
+				const __m128 offset4 = _mm_set1_ps(offset);
+				const __m128i zero   = _mm_setzero_si128();
+				for (; i + 8 <= count; i += 8)
+				{
+					const __m128i words = _mm_loadu_si128((const __m128i*)(src + i));
+					_mm_storeu_ps(out + i + 0, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero)), scale4), offset4));
+					_mm_storeu_ps(out + i + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero)), scale4), offset4));
+				}
+			#endif
+				for (; i < count; i++)
+				{
+					out[i] = f32(src[i]) * scale + offset;
+				}
+			} break;
+			case SOUND_DATA_FLOAT:
+			{
+				memcpy(out, (const f32*)data + index, sizeof(f32) * count);
+			} break;
+			case SOUND_DATA_STREAM:
+			{
+				// Stream buffers are already float and are read directly by the mixer.
+				assert(0);
+				memset(out, 0, sizeof(f32) * count);
+			} break;
+		}
+	}
+
+	void accumulate(const f32* in, u32 count, f32 gainLeft, f32 gainRight, f32* busLeft, f32* busRight)
+	{
+		u32 i = 0;
+	#ifdef AUDIO_MIXER_SSE2
+		const __m128 gainLeft4  = _mm_set1_ps(gainLeft);
+		const __m128 gainRight4 = _mm_set1_ps(gainRight);
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 value = _mm_loadu_ps(in + i);
+			_mm_storeu_ps(busLeft  + i, _mm_add_ps(_mm_loadu_ps(busLeft  + i), _mm_mul_ps(value, gainLeft4)));
+			_mm_storeu_ps(busRight + i, _mm_add_ps(_mm_loadu_ps(busRight + i), _mm_mul_ps(value, gainRight4)));
+		}
+	#endif
+		for (; i < count; i++)
+		{
+			busLeft[i]  += in[i] * gainLeft;
+			busRight[i] += in[i] * gainRight;
+		}
+	}
+
+	void accumulateRamp(const f32* in, u32 count, f32 gainLeft, f32 gainRight, f32 stepLeft, f32 stepRight, f32* busLeft, f32* busRight)
+	{
+		u32 i = 0;
+	#ifdef AUDIO_MIXER_SSE2
+		__m128 gainLeft4  = _mm_add_ps(_mm_set1_ps(gainLeft),  _mm_mul_ps(_mm_set1_ps(stepLeft),  _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)));
+		__m128 gainRight4 = _mm_add_ps(_mm_set1_ps(gainRight), _mm_mul_ps(_mm_set1_ps(stepRight), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)));
+		const __m128 stepLeft4  = _mm_set1_ps(stepLeft  * 4.0f);
+		const __m128 stepRight4 = _mm_set1_ps(stepRight * 4.0f);
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 value = _mm_loadu_ps(in + i);
+			_mm_storeu_ps(busLeft  + i, _mm_add_ps(_mm_loadu_ps(busLeft  + i), _mm_mul_ps(value, gainLeft4)));
+			_mm_storeu_ps(busRight + i, _mm_add_ps(_mm_loadu_ps(busRight + i), _mm_mul_ps(value, gainRight4)));
+			gainLeft4  = _mm_add_ps(gainLeft4,  stepLeft4);
+			gainRight4 = _mm_add_ps(gainRight4, stepRight4);
+		}
+		gainLeft  += stepLeft  * f32(i);
+		gainRight += stepRight * f32(i);
+	#endif
+		for (; i < count; i++)
+		{
+			busLeft[i]  += in[i] * gainLeft;
+			busRight[i] += in[i] * gainRight;
+			gainLeft  += stepLeft;
+			gainRight += stepRight;
+		}
+	}
+
+	// Audio outside of the [-1, 1] range will cause overflow, which is a major artifact.
+	// Instead the audio needs to be limited in range, which can be done in several ways.
+	// Sigmoid functions map an arbitrary range into [-1, 1] generall along an S-Curve, allowing us to avoid overflow.
+	inline f32 limit(f32 value)
+	{
+	#if defined(AUDIO_SIGMOID_CLIP)		// Not really a Sigmoid function but acts in a similar way, naively mapping to the required range.
+		return std::max(-c_channelLimit, std::min(value, c_channelLimit));
+	#elif defined(AUDIO_SIGMOID_TANH)	// Considered one of the most "musical sounding" sigmoid functions, it avoids hard clipping.
+		// Note the usable range is approximately -4.8 to 4.8 so the volumes should be adjusted to stay within those ranges when possible.
+		// Still much better than the effect -1 to 1 range with hard clipping and cheaper than the more accurate library tanh(). :)
+		return TFE_Math::tanhf_series(value);
+	#elif defined(AUDIO_SIGMOID_RCP_SQRT)
+		return value / sqrtf(1.0f + value * value);
+	#endif
+	}
+
+#ifdef AUDIO_MIXER_SSE2
+	// 4-wide version of limit().
+	inline __m128 limit4(__m128 value)
+	{
+	#if defined(AUDIO_SIGMOID_CLIP)
+		return _mm_max_ps(_mm_set1_ps(-c_channelLimit), _mm_min_ps(value, _mm_set1_ps(c_channelLimit)));
+	#elif defined(AUDIO_SIGMOID_TANH)
+		// Same rational approximation as TFE_Math::tanhf_series(), the input is clamped to the valid range
+		// rather than branching, which yields +/-0.99994 instead of +/-1.0 at the extremes.
+		const __m128 beta = _mm_max_ps(_mm_set1_ps(-c_tanhRange), _mm_min_ps(value, _mm_set1_ps(c_tanhRange)));
+		const __m128 x2 = _mm_mul_ps(beta, beta);
+		__m128 a = _mm_add_ps(_mm_set1_ps(378.0f), x2);
+		a = _mm_add_ps(_mm_set1_ps(17325.0f), _mm_mul_ps(x2, a));
+		a = _mm_add_ps(_mm_set1_ps(135135.0f), _mm_mul_ps(x2, a));
+		a = _mm_mul_ps(beta, a);
+		__m128 b = _mm_add_ps(_mm_set1_ps(3150.0f), _mm_mul_ps(x2, _mm_set1_ps(28.0f)));
+		b = _mm_add_ps(_mm_set1_ps(62370.0f), _mm_mul_ps(x2, b));
+		b = _mm_add_ps(_mm_set1_ps(135135.0f), _mm_mul_ps(x2, b));
+		return _mm_div_ps(a, b);
+	#elif defined(AUDIO_SIGMOID_RCP_SQRT)
+		return _mm_div_ps(value, _mm_sqrt_ps(_mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(value, value))));
+	#endif
+	}
+#endif
+
+	void resampleLinear(const f32* src, u32 frac, u64 step, u32 count, f32* out)
+	{
+		u64 pos = frac;
+		for (u32 i = 0; i < count; i++, pos += step)
+		{
+			const f32* s = src + (pos >> 32ull);
+			const f32 t = f32(pos & 0xffffffffull) * c_fracScale;
+			out[i] = s[0] + (s[1] - s[0]) * t;
+		}
+	}
+
+	void resampleSinc(const f32* src, u32 frac, u64 step, u32 count, f32* out)
+	{
+		u64 pos = frac;
+		for (u32 i = 0; i < count; i++, pos += step)
+		{
+			const f32* s = src + (pos >> 32ull) - RESAMPLE_HISTORY;
+			const f32* coeff = s_sincTable[(pos & 0xffffffffull) >> (32 - SINC_PHASE_BITS)];
+		#ifdef AUDIO_MIXER_SSE2
+			__m128 sum = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s), _mm_load_ps(coeff)), _mm_mul_ps(_mm_loadu_ps(s + 4), _mm_load_ps(coeff + 4)));
+			sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+			sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+			out[i] = _mm_cvtss_f32(sum);
+		#else
+			f32 sum = 0.0f;
+			for (s32 t = 0; t < RESAMPLE_SINC_TAPS; t++)
+			{
+				sum += s[t] * coeff[t];
+			}
+			out[i] = sum;
+		#endif
+		}
+	}
+
+	void resample(TFE_AudioResampler filter, const f32* src, u32 frac, u64 step, u32 count, f32* out)
+	{
+		if (filter == TFE_RESAMPLER_SINC)
+		{
+			resampleSinc(src, frac, step, count, out);
+		}
+		else
+		{
+			resampleLinear(src, frac, step, count, out);
+		}
+	}
+
+	void limitAndInterleave(const f32* busLeft, const f32* busRight, u32 count, f32* out)
+	{
+		u32 i = 0;
+	#ifdef AUDIO_MIXER_SSE2
+		for (; i + 4 <= count; i += 4, out += 8)
+		{
+			const __m128 left  = limit4(_mm_loadu_ps(busLeft + i));
+			const __m128 right = limit4(_mm_loadu_ps(busRight + i));
+			//stereo output.
+			_mm_storeu_ps(out + 0, _mm_unpacklo_ps(left, right));
+			_mm_storeu_ps(out + 4, _mm_unpackhi_ps(left, right));
+		}
+	#endif
+		for (; i < count; i++, out += 2)
+		{
+			out[0] = limit(busLeft[i]);
+			out[1] = limit(busRight[i]);
+		}
+	}
+}
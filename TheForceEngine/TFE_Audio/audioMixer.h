@@ -0,0 +1,41 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Audio Mixer
+// Block based mixing kernels used by the audio thread.
+// Source data is converted to float a block at a time, scaled by
+// per-channel gains and accumulated into a stereo bus, which is
+// limited and interleaved into the output buffer at the end.
+//////////////////////////////////////////////////////////////////////
+
+#include <TFE_System/types.h>
+#include <TFE_Settings/settings.h>
+#include "audioSystem.h"
+
+// Maximum number of frames processed at once, larger output buffers are split into multiple blocks.
+#define MIX_BLOCK_SIZE 256
+// Resampling works on a 32.32 fixed point source position.
+// The filters read RESAMPLE_HISTORY samples before and RESAMPLE_LOOKAHEAD samples after the integer position.
+#define RESAMPLE_SINC_TAPS 8
+#define RESAMPLE_HISTORY   (RESAMPLE_SINC_TAPS / 2 - 1)
+#define RESAMPLE_LOOKAHEAD (RESAMPLE_SINC_TAPS / 2)
+
+namespace TFE_AudioMixer
+{
+	// Builds the resampling filter tables, must be called before mixing.
+	void init();
+
+	// Fixed point (32.32) source step per output sample.
+	inline u64 getResampleStep(u32 srcRate, u32 dstRate) { return (u64(srcRate) << 32ull) / u64(dstRate); }
+
+	// Convert 'count' samples, starting at sample 'index', to floating point in the [-1, 1] range.
+	void convertToFloat(SoundDataType type, const u8* data, u32 index, u32 count, f32* out);
+	// busLeft[i] += in[i] * gainLeft; busRight[i] += in[i] * gainRight
+	void accumulate(const f32* in, u32 count, f32 gainLeft, f32 gainRight, f32* busLeft, f32* busRight);
+	// Same as accumulate() but the gains change linearly by 'stepLeft' and 'stepRight' per sample, used for envelopes.
+	void accumulateRamp(const f32* in, u32 count, f32 gainLeft, f32 gainRight, f32 stepLeft, f32 stepRight, f32* busLeft, f32* busRight);
+	// Limit the bus to the [-1, 1] range and write 'count' interleaved stereo frames to 'out'.
+	void limitAndInterleave(const f32* busLeft, const f32* busRight, u32 count, f32* out);
+	// Generate 'count' output samples starting at the fractional position 'frac' (0.32 fixed point) relative to src[0].
+	// src[-RESAMPLE_HISTORY] through src[(frac + step * (count - 1)) >> 32 + RESAMPLE_LOOKAHEAD] must be readable.
+	void resample(TFE_AudioResampler filter, const f32* src, u32 frac, u64 step, u32 count, f32* out);
+}
@@ -0,0 +1,368 @@
+#include "audioStream.h"
+#include "audioMixer.h"
+#include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <TFE_System/Threads/thread.h>
+#include <TFE_System/Threads/mutex.h>
+#include <assert.h>
+#include <algorithm>
+#include <vector>
+
+// Threading model:
+// The streaming thread owns the decoder and resampling state and is the only writer of the ring buffer.
+// The audio thread is the only reader. Restarting a stream is requested by the audio thread and carried out
+// by the streaming thread, the reader outputs nothing until the request has been handled.
+// Streams are closed by the game thread through the audio command queue, so that the audio thread has stopped
+// using the stream before the streaming thread frees it.
+
+namespace TFE_AudioStream
+{
+	// Ring buffer size in output frames, must be a power of 2.
+	#define STREAM_RING_SIZE 16384
+	#define STREAM_RING_MASK (STREAM_RING_SIZE - 1)
+	// Source samples decoded at once.
+	#define STREAM_SOURCE_SIZE 4096
+	// Maximum number of frames resampled at once.
+	#define STREAM_CHUNK_SIZE 1024
+
+	// Don't bother waking up the decoder for less than this many frames.
+	static const u32 c_minWriteFrames = 256;
+	static const u32 c_threadSleepMs = 4;
+
+	struct SoundStreamState
+	{
+		// Source samples at the decoder sample rate, the first RESAMPLE_HISTORY samples are the filter history.
+		// Room is left for RESAMPLE_LOOKAHEAD + 1 samples of padding at the end of the data.
+		f32 source[STREAM_SOURCE_SIZE + RESAMPLE_LOOKAHEAD + 1];
+		u32 sourceCount;
+		bool sourceEnded;
+		u32 sampleRate;
+		u32 frac;
+		u64 step;
+	};
+}
+
+struct SoundStream
+{
+	SoundBuffer buffer;
+	SoundStreamDecoder* decoder;
+
+	// Written by the streaming thread, read by the audio thread. Positions are in frames and wrap around naturally.
+	f32 ring[STREAM_RING_SIZE];
+	atomic_u32 writePos;
+	atomic_u32 readPos;
+	atomic_bool ended;			// Set once all of the data has been written to the ring buffer.
+	atomic_bool looping;
+	atomic_u32 restartRequest;	// Incremented by the audio thread.
+	atomic_u32 restartAck;		// Set to restartRequest by the streaming thread once the stream has been restarted.
+	atomic_bool released;		// The audio thread no longer references the stream.
+
+	// Audio thread.
+	u32 restartReadPos;			// Read position when the stream was last restarted.
+
+	// Streaming thread.
+	TFE_AudioStream::SoundStreamState state;
+};
+
+namespace TFE_AudioStream
+{
+	static u32 s_outputSampleRate = 11025;
+	static std::vector<SoundStream*> s_streams;
+	static Mutex* s_streamMutex = nullptr;
+	static Thread* s_streamThread = nullptr;
+	static atomic_bool s_runStreamThread;
+	static atomic_u32 s_underrunCount;
+
+	TFE_THREADRET streamThreadFunc(void* userData);
+	void fillStream(SoundStream* stream);
+	void resetState(SoundStream* stream);
+	void freeStream(SoundStream* stream);
+
+	bool init(u32 outputSampleRate)
+	{
+		s_outputSampleRate = outputSampleRate;
+		s_underrunCount.store(0);
+		s_streamMutex = Mutex::create();
+
+		s_runStreamThread.store(true);
+		s_streamThread = Thread::create("AudioStreamThread", streamThreadFunc, nullptr);
+		if (!s_streamThread || !s_streamThread->run())
+		{
+			TFE_System::logWrite(LOG_ERROR, "Audio", "Cannot start the audio streaming thread.");
+			return false;
+		}
+		return true;
+	}
+
+	void shutdown()
+	{
+		if (s_streamThread)
+		{
+			s_runStreamThread.store(false);
+			s_streamThread->waitOnExit();
+			delete s_streamThread;
+			s_streamThread = nullptr;
+		}
+
+		// The audio output has been stopped, so any remaining streams can be freed directly.
+		for (size_t i = 0; i < s_streams.size(); i++)
+		{
+			freeStream(s_streams[i]);
+		}
+		s_streams.clear();
+
+		delete s_streamMutex;
+		s_streamMutex = nullptr;
+	}
+
+	SoundBuffer* create(SoundStreamDecoder* decoder)
+	{
+		if (!decoder) { return nullptr; }
+
+		SoundStream* stream = new SoundStream();
+		stream->decoder = decoder;
+		stream->buffer = {};
+		stream->buffer.type = SOUND_DATA_STREAM;
+		stream->buffer.sampleRate = s_outputSampleRate;
+		stream->buffer.data = (u8*)stream;
+		stream->writePos.store(0);
+		stream->readPos.store(0);
+		stream->ended.store(false);
+		stream->looping.store(false);
+		stream->restartRequest.store(0);
+		stream->restartAck.store(0);
+		stream->released.store(false);
+		stream->restartReadPos = 0;
+		resetState(stream);
+
+		// Fill the ring buffer before the stream is visible to the other threads, so playback can start immediately.
+		fillStream(stream);
+
+		s_streamMutex->lock();
+		s_streams.push_back(stream);
+		s_streamMutex->unlock();
+
+		return &stream->buffer;
+	}
+
+	void close(SoundBuffer* buffer)
+	{
+		if (!buffer || buffer->type != SOUND_DATA_STREAM) { return; }
+		TFE_Audio::releaseStream(buffer);
+	}
+
+	/////////////////////////////////////////////
+	// Audio thread
+	/////////////////////////////////////////////
+	void restart(SoundStream* stream, bool looping)
+	{
+		// Nothing has been read since the stream was started, so it only has to be restarted if it already
+		// reached the end without looping.
+		const bool unread = stream->readPos.load(std::memory_order_relaxed) == stream->restartReadPos;
+		const bool pending = stream->restartRequest.load(std::memory_order_relaxed) != stream->restartAck.load(std::memory_order_acquire);
+		stream->looping.store(looping);
+		if (pending || (unread && (!looping || !stream->ended.load(std::memory_order_acquire))))
+		{
+			return;
+		}
+
+		stream->restartReadPos = stream->readPos.load(std::memory_order_relaxed);
+		stream->restartRequest.fetch_add(1, std::memory_order_release);
+	}
+
+	u32 read(SoundStream* stream, f32* out, u32 count, bool* finished)
+	{
+		*finished = false;
+		// Wait for the streaming thread to restart the stream.
+		if (stream->restartRequest.load(std::memory_order_relaxed) != stream->restartAck.load(std::memory_order_acquire))
+		{
+			return 0;
+		}
+
+		// Read 'ended' first, so that if it is set the write position includes all of the data.
+		const bool ended = stream->ended.load(std::memory_order_acquire);
+		const u32 writePos = stream->writePos.load(std::memory_order_acquire);
+		const u32 readPos = stream->readPos.load(std::memory_order_relaxed);
+		const u32 frames = std::min(count, writePos - readPos);
+
+		const u32 index = readPos & STREAM_RING_MASK;
+		const u32 first = std::min(frames, STREAM_RING_SIZE - index);
+		memcpy(out, stream->ring + index, sizeof(f32) * first);
+		memcpy(out + first, stream->ring, sizeof(f32) * (frames - first));
+		stream->readPos.store(readPos + frames, std::memory_order_release);
+
+		if (frames < count)
+		{
+			if (ended) { *finished = true; }
+			else { s_underrunCount.fetch_add(1, std::memory_order_relaxed); }
+		}
+		return frames;
+	}
+
+	void release(SoundStream* stream)
+	{
+		stream->released.store(true, std::memory_order_release);
+	}
+
+	u32 getUnderrunCount()
+	{
+		return s_underrunCount.load();
+	}
+
+	/////////////////////////////////////////////
+	// Streaming thread
+	/////////////////////////////////////////////
+	TFE_THREADRET streamThreadFunc(void* userData)
+	{
+		TFE_PROFILE_THREAD("Audio Stream");
+		while (s_runStreamThread.load())
+		{
+			TFE_ZONE_BEGIN(streamFill, "Stream Fill");
+			s_streamMutex->lock();
+			for (size_t i = 0; i < s_streams.size();)
+			{
+				SoundStream* stream = s_streams[i];
+				if (stream->released.load(std::memory_order_acquire))
+				{
+					freeStream(stream);
+					s_streams[i] = s_streams.back();
+					s_streams.pop_back();
+					continue;
+				}
+				fillStream(stream);
+				i++;
+			}
+			s_streamMutex->unlock();
+			TFE_ZONE_END(streamFill);
+
+			TFE_System::sleep(c_threadSleepMs);
+		}
+		return (TFE_THREADRET)0;
+	}
+
+	void freeStream(SoundStream* stream)
+	{
+		delete stream->decoder;
+		delete stream;
+	}
+
+	void resetState(SoundStream* stream)
+	{
+		SoundStreamState* state = &stream->state;
+		memset(state->source, 0, sizeof(f32) * RESAMPLE_HISTORY);
+		state->sourceCount = RESAMPLE_HISTORY;
+		state->sourceEnded = false;
+		state->sampleRate = 0;
+		state->frac = 0;
+		state->step = 0;
+	}
+
+	// Decode more source samples, wrapping around to the loop start if the stream is looping.
+	void decodeSource(SoundStream* stream)
+	{
+		SoundStreamState* state = &stream->state;
+		if (state->sourceEnded || state->sourceCount >= STREAM_SOURCE_SIZE) { return; }
+
+		const bool looping = stream->looping.load(std::memory_order_relaxed);
+		u32 count = stream->decoder->decode(state->source + state->sourceCount, STREAM_SOURCE_SIZE - state->sourceCount, looping);
+		if (!count && looping)
+		{
+			stream->decoder->rewind(true);
+			count = stream->decoder->decode(state->source + state->sourceCount, STREAM_SOURCE_SIZE - state->sourceCount, looping);
+		}
+		if (!count)
+		{
+			state->sourceEnded = true;
+			// Pad the end of the data so the filter footprint can be read.
+			memset(state->source + state->sourceCount, 0, sizeof(f32) * (RESAMPLE_LOOKAHEAD + 1));
+		}
+		state->sourceCount += count;
+
+		const u32 sampleRate = stream->decoder->getSampleRate();
+		if (sampleRate && sampleRate != state->sampleRate)
+		{
+			state->sampleRate = sampleRate;
+			state->step = TFE_AudioMixer::getResampleStep(sampleRate, s_outputSampleRate);
+		}
+	}
+
+	// Convert up to 'maxFrames' frames to the output sample rate, returns 0 once the source data has been used up.
+	u32 produceFrames(SoundStream* stream, f32* out, u32 maxFrames)
+	{
+		SoundStreamState* state = &stream->state;
+		// Source positions that can be read, including the filter footprint.
+		u32 usable = 0;
+		while (true)
+		{
+			const u32 available = state->sourceCount - RESAMPLE_HISTORY;
+			usable = state->sourceEnded ? available : (available > RESAMPLE_LOOKAHEAD + 1 ? available - RESAMPLE_LOOKAHEAD - 1 : 0);
+			if (state->sourceEnded || state->sourceCount >= STREAM_SOURCE_SIZE / 2) { break; }
+			decodeSource(stream);
+		}
+		if (!usable || !state->step) { return 0; }
+
+		u32 frames;
+		const f32* src = state->source + RESAMPLE_HISTORY;
+		if (state->step == (1ull << 32ull) && !state->frac)
+		{
+			// The source already matches the output sample rate.
+			frames = std::min(usable, maxFrames);
+			memcpy(out, src, sizeof(f32) * frames);
+		}
+		else
+		{
+			const u64 end = u64(usable) << 32ull;
+			if (end <= state->frac) { return 0; }
+			frames = u32(std::min((end - state->frac + state->step - 1) / state->step, u64(maxFrames)));
+			TFE_AudioMixer::resample(TFE_RESAMPLER_SINC, src, state->frac, state->step, frames, out);
+		}
+
+		// Advance the source position, keeping the filter history.
+		const u64 pos = u64(state->frac) + state->step * u64(frames);
+		const u32 consumed = u32(pos >> 32ull);
+		state->frac = u32(pos & 0xffffffffull);
+		memmove(state->source, state->source + consumed, sizeof(f32) * (state->sourceCount - consumed + (state->sourceEnded ? RESAMPLE_LOOKAHEAD + 1 : 0)));
+		state->sourceCount -= consumed;
+		return frames;
+	}
+
+	void fillStream(SoundStream* stream)
+	{
+		// Handle restart requests from the audio thread, which doesn't read the ring buffer until the request is acknowledged.
+		const u32 request = stream->restartRequest.load(std::memory_order_acquire);
+		if (request != stream->restartAck.load(std::memory_order_relaxed))
+		{
+			stream->decoder->rewind(false);
+			resetState(stream);
+			stream->ended.store(false, std::memory_order_relaxed);
+			stream->writePos.store(stream->readPos.load(std::memory_order_acquire), std::memory_order_relaxed);
+			stream->restartAck.store(request, std::memory_order_release);
+		}
+		if (stream->ended.load(std::memory_order_relaxed)) { return; }
+
+		f32 frames[STREAM_CHUNK_SIZE];
+		u32 writePos = stream->writePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			const u32 space = STREAM_RING_SIZE - (writePos - stream->readPos.load(std::memory_order_acquire));
+			if (space < c_minWriteFrames) { break; }
+
+			const u32 count = produceFrames(stream, frames, std::min(space, (u32)STREAM_CHUNK_SIZE));
+			if (!count)
+			{
+				if (stream->state.sourceEnded)
+				{
+					stream->ended.store(true, std::memory_order_release);
+				}
+				break;
+			}
+
+			const u32 index = writePos & STREAM_RING_MASK;
+			const u32 first = std::min(count, STREAM_RING_SIZE - index);
+			memcpy(stream->ring + index, frames, sizeof(f32) * first);
+			memcpy(stream->ring, frames + first, sizeof(f32) * (count - first));
+			writePos += count;
+			stream->writePos.store(writePos, std::memory_order_release);
+		}
+	}
+}
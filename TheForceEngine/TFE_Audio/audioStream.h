@@ -0,0 +1,55 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Audio Streaming
+// Long sounds can be streamed instead of being fully decoded into
+// memory. A background thread decodes each stream a little at a time,
+// converts it to the output sample rate and writes it into a small
+// ring buffer that the mixer reads from.
+//
+// A stream is exposed as a SoundBuffer of type SOUND_DATA_STREAM, so
+// it is played using the regular source API. Since a stream has a
+// single read position, it should only be played by one source at a
+// time.
+//////////////////////////////////////////////////////////////////////
+
+#include <TFE_System/types.h>
+#include "audioSystem.h"
+
+struct SoundStream;
+
+// Produces source samples for a stream, called from the streaming thread (and once from create()).
+class SoundStreamDecoder
+{
+public:
+	virtual ~SoundStreamDecoder() {}
+
+	// Decode up to 'count' samples in the [-1, 1] range, returns 0 once the end of the data has been reached.
+	// If 'looping' is true, the end of the loop section is treated as the end of the data.
+	virtual u32 decode(f32* out, u32 count, bool looping) = 0;
+	// Restart decoding from the beginning of the data, or from the loop start if 'loop' is true.
+	virtual void rewind(bool loop) = 0;
+	// Sample rate of the decoded data, may be 0 until the first samples have been decoded.
+	virtual u32 getSampleRate() = 0;
+};
+
+namespace TFE_AudioStream
+{
+	bool init(u32 outputSampleRate);
+	void shutdown();
+
+	// Create a stream that takes ownership of the decoder, the beginning of the stream is decoded before returning.
+	SoundBuffer* create(SoundStreamDecoder* decoder);
+	// Stops any sources still playing the stream, the stream is freed once the audio thread no longer references it.
+	void close(SoundBuffer* buffer);
+
+	// Audio thread.
+	// Start reading from the beginning of the stream.
+	void restart(SoundStream* stream, bool looping);
+	// Read up to 'count' frames, returns the number of frames read. 'finished' is set once the end of the stream has been read.
+	u32  read(SoundStream* stream, f32* out, u32 count, bool* finished);
+	// The audio thread no longer references the stream.
+	void release(SoundStream* stream);
+
+	// Number of times the mixer had to wait on the streaming thread.
+	u32 getUnderrunCount();
+}
@@ -1,44 +1,26 @@
 #include "audioSystem.h"
 #include "audioDevice.h"
+#include "audioMixer.h"
+#include "audioStream.h"
 #include <TFE_System/system.h>
 #include <TFE_System/math.h>
+#include <TFE_System/profiler.h>
+#include <TFE_System/Threads/spscQueue.h>
 #include <TFE_Settings/settings.h>
 #include <TFE_Game/gameHud.h>
 #include <TFE_FrontEndUI/console.h>
 #include <assert.h>
 #include <algorithm>
+#include <vector>
 
-// TODO: Add a command queue to avoid locking on the audio thread.
-// Commands for adding/removing sources, changing volume, etc.
-/*
-#include <atomic>
-typedef std::atomic_int  s32_atomic;
-typedef std::atomic_uint u32_atomic;
-#define atomicFetchAdd(a,b)   std::atomic_fetch_add(a,b)
-#define atomicWrite(a, value) std::atomic_store(a, value)
-#define atomicRead(a)         std::atomic_load(a)
-
-u32 writeBuffer;
-u32_atomic readBuffer;	// just keep incrementing and fixup after read.
-
-writeBuffer = 0;
-atomicWrite(&readBuffer, BUFFER_COUNT - 1);
-
-// Write data to [writeBuffer]
-// ...
-// Mark the readBuffer = writeBuffer
-atomicWrite(&readBuffer, writeBuffer);
-// Increment writeBuffer for next frame.
-writeBuffer = (writeBuffer + 1) % BUFFER_COUNT;
-
-// Read current buffer index in the audio thread.
-u32 index = atomicRead(&readBuffer);
-*/
-
-// Comment out the desired sigmoid function and comment all of the others.
-//#define AUDIO_SIGMOID_CLIP 1
-#define AUDIO_SIGMOID_TANH 1
-//#define AUDIO_SIGMOID_RCP_SQRT 1
+// Threading model:
+// The game thread owns the SoundSource array - allocation, positional audio and client queries all happen there.
+// The audio thread owns the MixVoice array, which holds the state required to mix each source.
+// The game thread never touches the voices directly, instead it sends commands through a lock-free queue
+// which are executed at the beginning of each audio callback. Voices that finish playing are sent back to
+// the game thread through a second queue, which is processed during update() (and before allocating new sources).
+// This way the audio thread never has to wait on the game thread. The game thread only waits on the audio thread
+// when a command must not be lost and the queue is full, and in stopAllSounds() so that buffers can be freed afterward.
 
 enum SoundSourceFlags
 {
@@ -49,14 +31,23 @@ enum SoundSourceFlags
 	SND_FLAG_FINISHED = (1 << 4),
 };
 
+// Game thread sound source.
 struct SoundSource
 {
 	SoundType type;
 	f32 baseVolume;
 	f32 volume;
 	f32 seperation;		//stereo seperation.
-	u32 sampleIndex;
 	u32 flags;
+	u32 slot;			// Index of the source and its matching mixer voice.
+	u32 generation;		// Incremented every time the slot is reused, so stale messages from the audio thread can be discarded.
+	u32 listIndex;		// Index in the active source list while allocated, otherwise the next source in the free list.
+	u8  category;
+	u8  priority;
+
+	// Last values sent to the mixer, used to avoid sending redundant commands.
+	f32 mixVolume;
+	f32 mixSeperation;
 
 	// Sound data.
 	const SoundBuffer* buffer;
@@ -72,47 +63,184 @@ struct SoundSource
 	s32 finishedArg = 0;
 };
 
+// Audio thread mixer voice, one per SoundSource.
+struct MixVoice
+{
+	const SoundBuffer* buffer;
+	u32 sampleIndex;
+	u32 frac;			// Fractional part of the source position when resampling (0.32 fixed point).
+	u64 step;			// Source step per output sample (32.32 fixed point), 0 if the buffer matches the output sample rate.
+	u32 flags;			// SND_FLAG_ACTIVE is set while the voice is in the active voice list.
+	u32 generation;
+	f32 volume;
+	f32 seperation;
+};
+
+enum AudioCommandType
+{
+	ACMD_PLAY = 0,			// Start playing from the beginning using the buffer, volume and seperation in the command.
+	ACMD_STOP,				// Stop playing, the voice can be restarted with ACMD_PLAY.
+	ACMD_FREE,				// The game thread has released the source.
+	ACMD_SET_VOLUME,
+	ACMD_SET_SEPERATION,
+	ACMD_SET_BUFFER,		// Change the buffer and restart from the beginning.
+	ACMD_STOP_ALL,
+	ACMD_SET_RENDER_CALLBACK,
+	ACMD_RELEASE_STREAM,	// Stop any voices using the stream buffer, the stream is no longer referenced afterward.
+	ACMD_COUNT
+};
+
+struct AudioCommand
+{
+	u16 type;
+	u16 slot;
+	u32 generation;
+	const SoundBuffer* buffer;
+	f32 volume;
+	f32 seperation;
+	u32 looping;
+	// ACMD_SET_RENDER_CALLBACK only.
+	AudioRenderCallback renderCallback;
+	void* renderUserData;
+};
+
+// Sent from the audio thread to the game thread when a voice reaches the end of its buffer.
+struct AudioFinishedMsg
+{
+	u32 slot;
+	u32 generation;
+};
+
 namespace TFE_Audio
 {
 	#define MAX_SOUND_SOURCES 128
+	#define AUDIO_COMMAND_COUNT 4096
+	#define AUDIO_FINISHED_COUNT 512
+	// Number of source samples that can be resampled at once.
+	#define MIX_SOURCE_SIZE (4 * MIX_BLOCK_SIZE)
 	// This assumes 2 channel support only. This will do for the initial release.
 	// TODO: Support surround sound setups (5.1, 7.1, etc).
 	// TODO: Support proper HRTF data (optional).
 	static const f32 c_stereoSwing   = 0.45f;	// 0.0 = mono positional audio (sound equal in both speakers), 0.5 = full swing (i.e. sound to the left is ONLY heard in the left speaker).
-	static const f32 c_channelLimit  = 1.0f;
 	static const f32 c_soundHeadroom = 0.35f;	// approximately 1 / sqrt(8); assuming 8 uncorrelated sounds playing at full volume.
+	// Parameter updates (volume, seperation) are resent every update if they are dropped, so they are only queued
+	// while the queue is less than half full. This leaves room for commands that must not be lost (play, stop, free).
+	static const u32 c_paramCommandLimit = AUDIO_COMMAND_COUNT / 2;
+	// Maximum time stopAllSounds() waits for the audio thread, in seconds.
+	static const f64 c_stopAllTimeout = 1.0;
 
 	// Client volume controls, ranging from [0, 1]
 	static f32 s_soundFxVolume = 1.0f;
 	// Internal sound scale based on the client volume and headroom.
 	static f32 s_soundFxScale = s_soundFxVolume * c_soundHeadroom;	// actual volume scale based on client set volume and headroom.
 
-	static u32 s_sourceCount;
+	#define SOURCE_LIST_END 0xffffffff
+	// Default voice limits per category, general sounds can use every voice.
+	static const u32 c_defaultCategoryLimit[SOUND_CATEGORY_COUNT] =
+	{
+		MAX_SOUND_SOURCES,	// SOUND_CATEGORY_GENERAL
+		32,					// SOUND_CATEGORY_WEAPON
+		48,					// SOUND_CATEGORY_AMBIENT
+		8,					// SOUND_CATEGORY_VOICE
+	};
+
+	// Game thread data.
 	static Vec3f s_listener;
-	// TODO: This will need to be buffered to avoid locks.
 	static SoundSource s_sources[MAX_SOUND_SOURCES];
-	static Mutex s_mutex;
+	// Allocated sources are kept in a compact list, free sources are linked through SoundSource::listIndex.
+	static u32 s_sourceCount;
+	static u32 s_activeSources[MAX_SOUND_SOURCES];
+	static u32 s_freeSource;
+	static u32 s_categoryCount[SOUND_CATEGORY_COUNT];
+	static u32 s_categoryLimit[SOUND_CATEGORY_COUNT];
+	static bool s_commandOverflow = false;
+	// Streams that could not be released because the command queue was full, retried each update.
+	static std::vector<SoundBuffer*> s_pendingStreamRelease;
+	// Sequence number of the last stop all sent, the audio thread stores it in s_stopAllDone once the voices are stopped.
+	static u32 s_stopAllSequence = 0;
+	static atomic_u32 s_stopAllDone;
+
+	// Output format, set once during init() before the audio thread starts.
+	static u32 s_outputSampleRate = 11025;
+	static TFE_AudioResampler s_resampler = TFE_RESAMPLER_LINEAR;
+	// Fractional frames not yet mixed when the output uses the game clock.
+	static f64 s_pendingFrames = 0.0;
+
+	// Audio thread data.
+	static MixVoice s_voices[MAX_SOUND_SOURCES];
+	// Compact list of voices that are playing or waiting to report that they finished.
+	static u32 s_activeCount;
+	static u32 s_activeVoices[MAX_SOUND_SOURCES];
+	// Mixing buffers.
+	static f32 s_convertBuffer[MIX_BLOCK_SIZE];
+	static f32 s_sourceBuffer[MIX_SOURCE_SIZE];
+	static f32 s_busLeft[MIX_BLOCK_SIZE];
+	static f32 s_busRight[MIX_BLOCK_SIZE];
+	static AudioRenderCallback s_renderCallback = nullptr;
+	static void* s_renderUserData = nullptr;
+
+	// Queues shared between the threads.
+	static SpscQueue<AudioCommand, AUDIO_COMMAND_COUNT> s_commandQueue;			// game thread -> audio thread.
+	static SpscQueue<AudioFinishedMsg, AUDIO_FINISHED_COUNT> s_finishedQueue;	// audio thread -> game thread.
 
 	s32 audioCallback(void *outputBuffer, void* inputBuffer, u32 bufferSize, f64 streamTime, u32 status, void* userData);
 	void setSoundVolumeConsole(const ConsoleArgList& args);
 	void getSoundVolumeConsole(const ConsoleArgList& args);
-				
+	void audioBenchmarkConsole(const ConsoleArgList& args);
+	void processFinishedSounds();
+	void retryStreamRelease();
+	bool pushCommand(const AudioCommand& cmd);
+	void pushCommandWait(const AudioCommand& cmd);
+	void executeCommands();
+	bool sendCommand(AudioCommandType type, SoundSource* source);
+	void sendParameters(SoundSource* source);
+	void resetSourceLists();
+	void releaseSource(SoundSource* source);
+	f32  computeVolume(const Vec3f* pos, f32 baseVolume, const Vec3f* listenerPos);
+
 	bool init()
 	{
 		TFE_System::logWrite(LOG_MSG, "Startup", "TFE_AudioSystem::init");
-		s_sourceCount = 0u;
+		s_activeCount = 0u;
 		s_listener = { 0 };
-
-		MUTEX_INITIALIZE(&s_mutex);
+		for (u32 s = 0; s < MAX_SOUND_SOURCES; s++)
+		{
+			s_sources[s] = {};
+			s_sources[s].slot = s;
+			s_voices[s] = {};
+		}
+		for (u32 c = 0; c < SOUND_CATEGORY_COUNT; c++)
+		{
+			s_categoryLimit[c] = c_defaultCategoryLimit[c];
+		}
+		resetSourceLists();
 
 		CCMD("setSoundVolume", setSoundVolumeConsole, 1, "Sets the sound volume, range is 0.0 to 1.0");
 		CCMD("getSoundVolume", getSoundVolumeConsole, 0, "Get the current sound volume.");
+		CCMD("audioBenchmark", audioBenchmarkConsole, 0, "Measure the mixer cost with 8-bit, 16-bit and float sources - audioBenchmark [sourceCount] [frameCount]");
 
 		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
 		setVolume(soundSettings->soundFxVolume);
-		
-		bool res = TFE_AudioDevice::init();
-		res |= TFE_AudioDevice::startOutput(audioCallback, nullptr, 2u, 11025u);
+		s_outputSampleRate = soundSettings->outputSampleRate ? soundSettings->outputSampleRate : 11025u;
+		s_resampler = soundSettings->resampler;
+		TFE_AudioMixer::init();
+
+		// The capture path is relative to the user documents directory unless it is a full path.
+		char capturePath[TFE_MAX_PATH];
+		const char* capture = soundSettings->audioCapturePath;
+		if (capture[0] == '/' || capture[0] == '\\' || (capture[0] && capture[1] == ':'))
+		{
+			strcpy(capturePath, capture);
+		}
+		else
+		{
+			TFE_Paths::appendPath(PATH_USER_DOCUMENTS, capture, capturePath);
+		}
+		s_pendingFrames = 0.0;
+
+		TFE_AudioStream::init(s_outputSampleRate);
+		bool res = TFE_AudioDevice::init(256u, soundSettings->audioOutput, soundSettings->audioClock, capturePath);
+		res |= TFE_AudioDevice::startOutput(audioCallback, nullptr, 2u, s_outputSampleRate);
 		return res;
 	}
 
@@ -122,15 +250,48 @@ namespace TFE_Audio
 		stopAllSounds();
 
 		TFE_AudioDevice::destroy();
-		MUTEX_DESTROY(&s_mutex);
+		// The audio thread is gone, so streams still waiting for the queue can be released directly.
+		for (size_t i = 0; i < s_pendingStreamRelease.size(); i++)
+		{
+			TFE_AudioStream::release((SoundStream*)s_pendingStreamRelease[i]->data);
+		}
+		s_pendingStreamRelease.clear();
+		TFE_AudioStream::shutdown();
 	}
 
 	void stopAllSounds()
 	{
-		MUTEX_LOCK(&s_mutex);
-		s_sourceCount = 0u;
-		memset(s_sources, 0, sizeof(SoundSource) * MAX_SOUND_SOURCES);
-		MUTEX_UNLOCK(&s_mutex);
+		// Bump the generation so that any finished messages already in flight are ignored.
+		for (u32 s = 0; s < s_sourceCount; s++)
+		{
+			SoundSource* snd = &s_sources[s_activeSources[s]];
+			snd->flags = 0u;
+			snd->generation++;
+		}
+		resetSourceLists();
+
+		// Callers free sound buffers right after this, so wait until the audio thread has stopped every voice.
+		AudioCommand cmd = {};
+		cmd.type = ACMD_STOP_ALL;
+		cmd.generation = ++s_stopAllSequence;
+		pushCommandWait(cmd);
+		if (!TFE_AudioDevice::isOutputThreadRunning())
+		{
+			executeCommands();
+			return;
+		}
+
+		const u64 start = TFE_System::getCurrentTimeInTicks();
+		while (s_stopAllDone.load(std::memory_order_acquire) != s_stopAllSequence)
+		{
+			// Don't hang if the audio device has stopped calling back.
+			if (TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start) > c_stopAllTimeout)
+			{
+				TFE_System::logWrite(LOG_ERROR, "Audio", "The audio thread did not respond to stopAllSounds() within %0.1f seconds.", c_stopAllTimeout);
+				break;
+			}
+			TFE_System::sleep(1);
+		}
 	}
 
 	void setVolume(f32 volume)
@@ -144,30 +305,70 @@ namespace TFE_Audio
 		return s_soundFxVolume;
 	}
 
-	// Issue - too many locks, wasted time looping over inactive sources.
-	// TODO: Reduce audio thread cost and remove locks:
-	// 1. SoundSource base array.
-	// 2. SoundSource active array, only contains active sounds, sounds with data, etc.
-	// 3. Add small queue with finished sounds; do cleanup during main thread update().
-	//
-	// Better:
-	// Keep threads data seperate.
-	// Add command buffer.
-	// Add/Remove from main thread (add sound when play is called, set volume, etc.)
-	// Setup finished queue to handle sounds finishing.
+	u32 getOutputSampleRate()
+	{
+		return s_outputSampleRate;
+	}
+
+	bool resampleBuffer(SoundBuffer* buffer, u32 sampleRate)
+	{
+		if (!buffer || !buffer->data || !buffer->size || !buffer->sampleRate || !sampleRate) { return false; }
+		if (buffer->sampleRate == sampleRate) { return true; }
+
+		const bool looping = (buffer->flags & SBUFFER_FLAG_LOOPING) && buffer->loopStart < buffer->size;
+		const u64 step = TFE_AudioMixer::getResampleStep(buffer->sampleRate, sampleRate);
+		const u32 newSize = u32((u64(buffer->size) * sampleRate + buffer->sampleRate - 1) / buffer->sampleRate);
+
+		// Convert to float with room for the filter footprint, looping sounds wrap around to the loop start so the seam is filtered correctly.
+		const u32 padding = RESAMPLE_LOOKAHEAD + 1;
+		std::vector<f32> src(RESAMPLE_HISTORY + buffer->size + padding, 0.0f);
+		f32* srcData = src.data() + RESAMPLE_HISTORY;
+		TFE_AudioMixer::convertToFloat(buffer->type, buffer->data, 0, buffer->size, srcData);
+		if (looping)
+		{
+			for (u32 i = 0; i < padding; i++)
+			{
+				srcData[buffer->size + i] = srcData[buffer->loopStart + i % (buffer->size - buffer->loopStart)];
+			}
+		}
+
+		std::vector<f32> dst(newSize);
+		TFE_AudioMixer::resample(TFE_RESAMPLER_SINC, srcData, 0u, step, newSize, dst.data());
+
+		// Store as unsigned 16-bit to match the other integer formats.
+		u16* data = (u16*)malloc(sizeof(u16) * newSize);
+		if (!data) { return false; }
+		for (u32 i = 0; i < newSize; i++)
+		{
+			const f32 value = std::max(-1.0f, std::min(dst[i], 1.0f));
+			data[i] = u16((value + 1.0f) * 32767.5f);
+		}
+
+		// Sound buffer data is allocated with malloc/realloc by the assets.
+		free(buffer->data);
+		buffer->data = (u8*)data;
+		buffer->type = SOUND_DATA_16BIT;
+		buffer->loopStart = u32(u64(buffer->loopStart) * sampleRate / buffer->sampleRate);
+		buffer->loopEnd   = std::min(u32(u64(buffer->loopEnd) * sampleRate / buffer->sampleRate), newSize);
+		buffer->size = newSize;
+		buffer->sampleRate = sampleRate;
+		return true;
+	}
 
 	void update(const Vec3f* listenerPos, const Vec3f* listenerDir)
 	{
+		processFinishedSounds();
+		retryStreamRelease();
+
 		// Currently positional audio only accounts for the "horizontal plane"
 		// TODO: Support proper HRTF as an option, though we want to keep the "old school" handling in for the classic mode.
 		Vec2f listDirXZ = { listenerDir->x, listenerDir->z };
 		listDirXZ = TFE_Math::normalize(&listDirXZ);
+		s_listener = *listenerPos;
 
-		SoundSource* snd = s_sources;
-		for (u32 s = 0; s < s_sourceCount; s++, snd++)
+		for (u32 s = 0; s < s_sourceCount; s++)
 		{
-			if (!(snd->flags & SND_FLAG_ACTIVE)) { continue; }
-
+			SoundSource* snd = &s_sources[s_activeSources[s]];
 			if (snd->type == SOUND_2D)
 			{
 				snd->volume = snd->baseVolume;
@@ -175,28 +376,12 @@ namespace TFE_Audio
 			else
 			{
 				// Compute attentuation and channel seperation.
-				const Vec3f offset = { snd->pos->x - listenerPos->x, snd->pos->y - listenerPos->y, snd->pos->z - listenerPos->z };
-				const f32 distSq = TFE_Math::dot(&offset, &offset);
-
-				if (distSq >= c_clipDistance * c_clipDistance)
-				{
-					snd->volume = 0.0f;
-				}
-				else if (distSq < c_closeDistance * c_closeDistance)
-				{
-					snd->volume = snd->baseVolume;
-				}
-				else
-				{
-					const f32 dist = sqrtf(distSq);
-					const f32 atten = 1.0f - (dist - c_closeDistance) / (c_clipDistance - c_closeDistance);
-					snd->volume = snd->baseVolume * atten * atten;
-				}
-
+				snd->volume = computeVolume(snd->pos, snd->baseVolume, listenerPos);
 				snd->seperation = 0.5f;
 				if (snd->volume > FLT_EPSILON)
 				{
 					// Spatialization is done on the XZ plane.
+					const Vec3f offset = { snd->pos->x - listenerPos->x, snd->pos->y - listenerPos->y, snd->pos->z - listenerPos->z };
 					const Vec2f offsetXZ = { offset.x, offset.z };
 					const Vec2f dir = TFE_Math::normalize(&offsetXZ);
 					// Sin of the angle between the listener direction and direction from listener to sound effect.
@@ -205,33 +390,153 @@ namespace TFE_Audio
 					snd->seperation -= c_stereoSwing * sinAngle;
 				}
 			}
+
+			if (snd->flags & SND_FLAG_PLAYING)
+			{
+				sendParameters(snd);
+			}
+		}
+
+		// Mix on this thread when the output is driven by the game clock.
+		if (TFE_AudioDevice::usesGameClock())
+		{
+			s_pendingFrames += TFE_System::getDeltaTime() * f64(s_outputSampleRate);
+			const u32 frameCount = u32(s_pendingFrames);
+			s_pendingFrames -= f64(frameCount);
+			TFE_AudioDevice::advance(frameCount);
 		}
 	}
 
-	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
-	// Note that looping one shots are valid.
-	bool playOneShot(SoundType type, f32 volume, f32 stereoSeperation, const SoundBuffer* buffer, bool looping, const Vec3f* pos, bool copyPosition, SoundFinishedCallback finishedCallback, void* cbUserData, s32 cbArg)
+	// Distance attenuated volume of a 3D source.
+	f32 computeVolume(const Vec3f* pos, f32 baseVolume, const Vec3f* listenerPos)
 	{
-		if (!buffer) { return false; }
+		const Vec3f offset = { pos->x - listenerPos->x, pos->y - listenerPos->y, pos->z - listenerPos->z };
+		const f32 distSq = TFE_Math::dot(&offset, &offset);
+
+		if (distSq >= c_clipDistance * c_clipDistance)
+		{
+			return 0.0f;
+		}
+		else if (distSq < c_closeDistance * c_closeDistance)
+		{
+			return baseVolume;
+		}
+		const f32 dist = sqrtf(distSq);
+		const f32 atten = 1.0f - (dist - c_closeDistance) / (c_clipDistance - c_closeDistance);
+		return baseVolume * atten * atten;
+	}
 
-		MUTEX_LOCK(&s_mutex);
-		// Find the first inactive source.
-		SoundSource* snd = s_sources;
-		SoundSource* newSource = nullptr;
-		for (u32 s = 0; s < s_sourceCount; s++, snd++)
+	void resetSourceLists()
+	{
+		s_sourceCount = 0u;
+		s_freeSource = 0u;
+		for (u32 s = 0; s < MAX_SOUND_SOURCES; s++)
 		{
-			if (!(snd->flags&SND_FLAG_ACTIVE))
+			s_sources[s].listIndex = s + 1 < MAX_SOUND_SOURCES ? s + 1 : SOURCE_LIST_END;
+		}
+		for (u32 c = 0; c < SOUND_CATEGORY_COUNT; c++)
+		{
+			s_categoryCount[c] = 0u;
+		}
+	}
+
+	// Stealing is weighted by how audible the sound is, so a distant sound is stolen before a nearby sound with the same priority.
+	f32 getStealScore(SoundPriority priority, f32 volume)
+	{
+		return f32(priority) * volume;
+	}
+
+	// Find the one shot with the lowest score, optionally restricted to a category. Returns nullptr if no source scores below 'score'.
+	SoundSource* findSourceToSteal(f32 score, s32 category)
+	{
+		SoundSource* steal = nullptr;
+		f32 lowestScore = score;
+		for (u32 s = 0; s < s_sourceCount; s++)
+		{
+			SoundSource* snd = &s_sources[s_activeSources[s]];
+			// Client held sources can't be stolen since the client still references them.
+			if (!(snd->flags & SND_FLAG_ONE_SHOT) || snd->priority == SOUND_PRIORITY_CRITICAL) { continue; }
+			if (category >= 0 && snd->category != category) { continue; }
+
+			const f32 volume = snd->type == SOUND_3D ? computeVolume(snd->pos, snd->baseVolume, &s_listener) : snd->baseVolume;
+			const f32 sourceScore = getStealScore(SoundPriority(snd->priority), volume);
+			if (sourceScore < lowestScore)
 			{
-				newSource = snd;
-				break;
+				lowestScore = sourceScore;
+				steal = snd;
 			}
 		}
-		if (!newSource && s_sourceCount < MAX_SOUND_SOURCES)
+		return steal;
+	}
+
+	void stealSource(SoundSource* source)
+	{
+		sendCommand(ACMD_STOP, source);
+		// As far as the client is concerned, the sound has finished.
+		if (source->finishedCallback)
+		{
+			source->finishedCallback(source->finishedUserData, source->finishedArg);
+		}
+		releaseSource(source);
+	}
+
+	SoundSource* allocateSource(SoundType type, f32 volume, const Vec3f* pos, SoundCategory category, SoundPriority priority)
+	{
+		// Release any sources that finished playing since the last update, so they can be reused.
+		processFinishedSounds();
+
+		const bool categoryFull = s_categoryCount[category] >= s_categoryLimit[category];
+		if (categoryFull || s_freeSource == SOURCE_LIST_END)
 		{
-			newSource = &s_sources[s_sourceCount];
-			s_sourceCount++;
+			// Try to make room by stopping a less important one shot, within the same category if the category is full.
+			const f32 audibleVolume = (type == SOUND_3D && pos) ? computeVolume(pos, volume, &s_listener) : volume;
+			const f32 score = priority == SOUND_PRIORITY_CRITICAL ? FLT_MAX : getStealScore(priority, audibleVolume);
+			SoundSource* steal = findSourceToSteal(score, categoryFull ? s32(category) : -1);
+			if (!steal) { return nullptr; }
+			stealSource(steal);
 		}
 
+		// Pop the first source from the free list.
+		SoundSource* newSource = &s_sources[s_freeSource];
+		s_freeSource = newSource->listIndex;
+
+		newSource->flags = SND_FLAG_ACTIVE;
+		newSource->listIndex = s_sourceCount;
+		newSource->category = u8(category);
+		newSource->priority = u8(priority);
+		newSource->generation++;
+		s_activeSources[s_sourceCount++] = newSource->slot;
+		s_categoryCount[category]++;
+		return newSource;
+	}
+
+	void releaseSource(SoundSource* source)
+	{
+		if (!(source->flags & SND_FLAG_ACTIVE)) { return; }
+		source->flags = 0u;
+		// Any messages from the audio thread for the old generation will be discarded.
+		source->generation++;
+		s_categoryCount[source->category]--;
+
+		// Remove from the active list by swapping with the last active source.
+		const u32 index = source->listIndex;
+		const u32 last = s_activeSources[--s_sourceCount];
+		s_activeSources[index] = last;
+		s_sources[last].listIndex = index;
+
+		// Push onto the free list.
+		source->listIndex = s_freeSource;
+		s_freeSource = source->slot;
+	}
+
+	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
+	// Note that looping one shots are valid.
+	bool playOneShot(SoundType type, f32 volume, f32 stereoSeperation, const SoundBuffer* buffer, bool looping, const Vec3f* pos, bool copyPosition, SoundFinishedCallback finishedCallback, void* cbUserData, s32 cbArg,
+					 SoundCategory category, SoundPriority priority)
+	{
+		if (!buffer) { return false; }
+
+		SoundSource* newSource = allocateSource(type, volume, pos, category, priority);
 		if (newSource)
 		{
 			newSource->type = type;
@@ -243,7 +548,6 @@ namespace TFE_Audio
 			newSource->volume = type == SOUND_3D ? 0.0f : volume;
 			newSource->baseVolume = volume;
 			newSource->buffer = buffer;
-			newSource->sampleIndex = 0u;
 			if (copyPosition)
 			{
 				newSource->localPos = *pos;
@@ -257,35 +561,28 @@ namespace TFE_Audio
 			newSource->finishedCallback = finishedCallback;
 			newSource->finishedUserData = cbUserData;
 			newSource->finishedArg = cbArg;
+
+			if (!sendCommand(ACMD_PLAY, newSource))
+			{
+				releaseSource(newSource);
+				newSource = nullptr;
+			}
 		}
-		MUTEX_UNLOCK(&s_mutex);
 
 		return newSource != nullptr;
 	}
 
+	bool playOneShot(SoundType type, f32 volume, f32 stereoSeperation, const SoundBuffer* buffer, SoundCategory category, SoundPriority priority)
+	{
+		return playOneShot(type, volume, stereoSeperation, buffer, false, nullptr, false, nullptr, nullptr, 0, category, priority);
+	}
+
 	// Sound source that the client holds onto.
-	SoundSource* createSoundSource(SoundType type, f32 volume, f32 stereoSeperation, const SoundBuffer* buffer, const Vec3f* pos)
+	SoundSource* createSoundSource(SoundType type, f32 volume, f32 stereoSeperation, const SoundBuffer* buffer, const Vec3f* pos, SoundCategory category, SoundPriority priority)
 	{
 		if (!buffer) { return nullptr; }
 
-		MUTEX_LOCK(&s_mutex);
-		// Find the first inactive source.
-		SoundSource* snd = s_sources;
-		SoundSource* newSource = nullptr;
-		for (u32 s = 0; s < s_sourceCount; s++, snd++)
-		{
-			if (!(snd->flags&SND_FLAG_ACTIVE))
-			{
-				newSource = snd;
-				break;
-			}
-		}
-		if (!newSource && s_sourceCount < MAX_SOUND_SOURCES)
-		{
-			newSource = &s_sources[s_sourceCount];
-			s_sourceCount++;
-		}
-
+		SoundSource* newSource = allocateSource(type, volume, pos, category, priority);
 		if (newSource)
 		{
 			newSource->type = type;
@@ -293,38 +590,51 @@ namespace TFE_Audio
 			newSource->volume = type == SOUND_2D ? volume : 0.0f;
 			newSource->baseVolume = volume;
 			newSource->buffer = buffer;
-			newSource->sampleIndex = 0u;
 			newSource->pos = pos;
 			newSource->seperation = stereoSeperation;
 			newSource->finishedCallback = nullptr;
 			newSource->finishedUserData = nullptr;
 		}
-		MUTEX_UNLOCK(&s_mutex);
 
 		return newSource;
 	}
 
 	void playSource(SoundSource* source, bool looping)
 	{
+		processFinishedSounds();
 		if (!source || (source->flags & SND_FLAG_PLAYING))
 		{
 			return;
 		}
-		
+
 		source->flags |= SND_FLAG_PLAYING;
 		if (looping) { source->flags |= SND_FLAG_LOOPING; }
-		source->sampleIndex = 0u;
+		if (!sendCommand(ACMD_PLAY, source))
+		{
+			source->flags &= ~SND_FLAG_PLAYING;
+		}
 	}
 
 	void stopSource(SoundSource* source)
 	{
+		if (!(source->flags & SND_FLAG_PLAYING)) { return; }
 		source->flags &= ~SND_FLAG_PLAYING;
+		// The stop is sent with the current generation so the voice accepts it, then the generation is bumped
+		// so that a finished message from this playback cannot stop the next ACMD_PLAY.
+		sendCommand(ACMD_STOP, source);
+		source->generation++;
 	}
 
 	void freeSource(SoundSource* source)
 	{
-		stopSource(source);
-		source->flags &= ~SND_FLAG_ACTIVE;
+		if (!(source->flags & SND_FLAG_ACTIVE)) { return; }
+		// The slot is reused right away, so the free can't be dropped or a looping voice would keep playing.
+		AudioCommand cmd = {};
+		cmd.type = ACMD_FREE;
+		cmd.slot = u16(source->slot);
+		cmd.generation = source->generation;
+		pushCommandWait(cmd);
+		releaseSource(source);
 	}
 
 	void setSourceVolume(SoundSource* source, f32 volume)
@@ -335,19 +645,32 @@ namespace TFE_Audio
 	void setSourceStereoSeperation(SoundSource* source, f32 stereoSeperation)
 	{
 		source->seperation = std::max(0.0f, std::min(stereoSeperation, 1.0f));
+		if (source->flags & SND_FLAG_PLAYING)
+		{
+			sendParameters(source);
+		}
 	}
 
 	// This will restart the sound and change the buffer.
 	void setSourceBuffer(SoundSource* source, const SoundBuffer* buffer)
 	{
-		MUTEX_LOCK(&s_mutex);
-		source->sampleIndex = 0u;
 		source->buffer = buffer;
-		MUTEX_UNLOCK(&s_mutex);
+		sendCommand(ACMD_SET_BUFFER, source);
+	}
+
+	void setCategoryLimit(SoundCategory category, u32 limit)
+	{
+		s_categoryLimit[category] = std::min(limit, (u32)MAX_SOUND_SOURCES);
+	}
+
+	u32 getCategoryLimit(SoundCategory category)
+	{
+		return s_categoryLimit[category];
 	}
 
 	bool isSourcePlaying(SoundSource* source)
 	{
+		processFinishedSounds();
 		return (source->flags & SND_FLAG_PLAYING) != 0u;
 	}
 
@@ -356,122 +679,571 @@ namespace TFE_Audio
 		return source->volume;
 	}
 
-	// Internal
-	static const f32 c_scale[] = { 2.0f / 255.0f, 2.0f / 65535.0f, 1.0f };
-	static const f32 c_offset[] = { -1.0f, -1.0f, 0.0f };
+	// Mix 'sourceCount' looping sources of each data type, with and without resampling, and report the mixing cost.
+	// The output is stopped while the benchmark runs so that the mixer can be called directly on this thread.
+	// The sources and voices are saved and restored, so the sounds already playing continue afterward.
+	void runBenchmark(u32 sourceCount, u32 frameCount)
+	{
+		struct BenchmarkCase
+		{
+			const char* name;
+			SoundDataType type;
+			bool resample;
+		};
+		const BenchmarkCase c_cases[] =
+		{
+			{ "8-bit",              SOUND_DATA_8BIT,  false },
+			{ "16-bit",             SOUND_DATA_16BIT, false },
+			{ "float",              SOUND_DATA_FLOAT, false },
+			{ "8-bit (resampled)",  SOUND_DATA_8BIT,  true },
+			{ "16-bit (resampled)", SOUND_DATA_16BIT, true },
+			{ "float (resampled)",  SOUND_DATA_FLOAT, true },
+		};
+		const u32 c_benchmarkBlockSize = 1024;
+
+		sourceCount = std::max(1u, std::min(sourceCount, (u32)MAX_SOUND_SOURCES));
+		frameCount = std::max(frameCount, c_benchmarkBlockSize);
+		TFE_AudioDevice::stopOutput();
+		// With the output stopped, this thread owns the voices: apply the queued commands and save the state.
+		processFinishedSounds();
+		retryStreamRelease();
+		executeCommands();
+		const std::vector<SoundSource> savedSources(s_sources, s_sources + MAX_SOUND_SOURCES);
+		const std::vector<u32> savedActiveSources(s_activeSources, s_activeSources + MAX_SOUND_SOURCES);
+		const std::vector<MixVoice> savedVoices(s_voices, s_voices + MAX_SOUND_SOURCES);
+		const std::vector<u32> savedActiveVoices(s_activeVoices, s_activeVoices + MAX_SOUND_SOURCES);
+		const std::vector<u32> savedCategoryCount(s_categoryCount, s_categoryCount + SOUND_CATEGORY_COUNT);
+		const u32 savedSourceCount = s_sourceCount;
+		const u32 savedFreeSource = s_freeSource;
+		const u32 savedActiveCount = s_activeCount;
+		stopAllSounds();
+		// Only measure the sound mixer, music rendering is disabled while the output is stopped.
+		const AudioRenderCallback renderCallback = s_renderCallback;
+		s_renderCallback = nullptr;
+
+		// One second of a sine wave in each format.
+		const u32 length = s_outputSampleRate;
+		std::vector<u8>  data8(length);
+		std::vector<u16> data16(length);
+		std::vector<f32> dataFloat(length);
+		for (u32 i = 0; i < length; i++)
+		{
+			const f32 value = sinf(f32(i) * 2.0f * PI * 440.0f / f32(length)) * 0.5f;
+			data8[i] = u8((value + 1.0f) * 127.5f);
+			data16[i] = u16((value + 1.0f) * 32767.5f);
+			dataFloat[i] = value;
+		}
+		u8* data[] = { data8.data(), (u8*)data16.data(), (u8*)dataFloat.data() };
+		std::vector<f32> output(c_benchmarkBlockSize * 2);
+
+		char res[256];
+		sprintf(res, "Audio Benchmark: %u sources, %u frames at %u Hz, %s resampler.", sourceCount, frameCount, s_outputSampleRate, c_tfeResamplerStrings[s_resampler]);
+		TFE_System::logWrite(LOG_MSG, "Audio", "%s", res);
+		TFE_Console::addToHistory(res);
+		for (size_t c = 0; c < TFE_ARRAYSIZE(c_cases); c++)
+		{
+			SoundBuffer buffer = {};
+			buffer.type = c_cases[c].type;
+			buffer.size = length;
+			buffer.sampleRate = c_cases[c].resample ? s_outputSampleRate * 3 / 4 : s_outputSampleRate;
+			buffer.data = data[c_cases[c].type];
+			for (u32 s = 0; s < sourceCount; s++)
+			{
+				playOneShot(SOUND_2D, 1.0f, f32(s) / f32(sourceCount), &buffer, true, nullptr, false, nullptr, nullptr, 0, SOUND_CATEGORY_GENERAL, SOUND_PRIORITY_CRITICAL);
+			}
+			// The first callback starts the voices.
+			audioCallback(output.data(), nullptr, c_benchmarkBlockSize, 0.0, 0u, nullptr);
 
-	void cleanupSources()
+			const u64 start = TFE_System::getCurrentTimeInTicks();
+			for (u32 frame = 0; frame < frameCount; frame += c_benchmarkBlockSize)
+			{
+				audioCallback(output.data(), nullptr, c_benchmarkBlockSize, 0.0, 0u, nullptr);
+			}
+			const f64 seconds = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start);
+			const u32 mixedFrames = (frameCount + c_benchmarkBlockSize - 1) / c_benchmarkBlockSize * c_benchmarkBlockSize;
+			const f64 usPer1k = seconds * 1.0e9 / f64(mixedFrames);
+
+			sprintf(res, "  %-20s %8.2f us per 1k frames, %7.1fx realtime", c_cases[c].name, usPer1k, (f64(mixedFrames) / f64(s_outputSampleRate)) / std::max(seconds, 1.0e-9));
+			TFE_System::logWrite(LOG_MSG, "Audio", "%s", res);
+			TFE_Console::addToHistory(res);
+
+			// Stop the voices before the buffer goes out of scope.
+			stopAllSounds();
+			audioCallback(output.data(), nullptr, c_benchmarkBlockSize, 0.0, 0u, nullptr);
+		}
+
+		std::copy(savedSources.begin(), savedSources.end(), s_sources);
+		std::copy(savedActiveSources.begin(), savedActiveSources.end(), s_activeSources);
+		std::copy(savedVoices.begin(), savedVoices.end(), s_voices);
+		std::copy(savedActiveVoices.begin(), savedActiveVoices.end(), s_activeVoices);
+		std::copy(savedCategoryCount.begin(), savedCategoryCount.end(), s_categoryCount);
+		s_sourceCount = savedSourceCount;
+		s_freeSource = savedFreeSource;
+		s_activeCount = savedActiveCount;
+
+		s_renderCallback = renderCallback;
+		TFE_AudioDevice::startOutput(audioCallback, nullptr, 2u, s_outputSampleRate);
+	}
+
+	void setRenderCallback(AudioRenderCallback callback, void* userData)
 	{
-		// call any finished callbacks.
-		for (u32 s = 0; s < s_sourceCount; s++)
+		AudioCommand cmd = {};
+		cmd.type = ACMD_SET_RENDER_CALLBACK;
+		cmd.renderCallback = callback;
+		cmd.renderUserData = userData;
+		pushCommand(cmd);
+	}
+
+	void releaseStream(SoundBuffer* buffer)
+	{
+		AudioCommand cmd = {};
+		cmd.type = ACMD_RELEASE_STREAM;
+		cmd.buffer = buffer;
+		// The stream can't be freed while the audio thread may still be reading it, so try again on the next update.
+		if (!s_pendingStreamRelease.empty() || !pushCommand(cmd))
+		{
+			s_pendingStreamRelease.push_back(buffer);
+		}
+	}
+
+	void retryStreamRelease()
+	{
+		size_t released = 0;
+		for (; released < s_pendingStreamRelease.size(); released++)
+		{
+			AudioCommand cmd = {};
+			cmd.type = ACMD_RELEASE_STREAM;
+			cmd.buffer = s_pendingStreamRelease[released];
+			if (!pushCommand(cmd)) { break; }
+		}
+		s_pendingStreamRelease.erase(s_pendingStreamRelease.begin(), s_pendingStreamRelease.begin() + released);
+	}
+
+	/////////////////////////////////////////////
+	// Game thread -> audio thread communication.
+	/////////////////////////////////////////////
+	bool pushCommand(const AudioCommand& cmd)
+	{
+		if (!s_commandQueue.push(cmd))
+		{
+			// Only log once per overflow, the audio thread may not be running at all.
+			if (!s_commandOverflow)
+			{
+				TFE_System::logWrite(LOG_WARNING, "Audio", "Audio command queue is full, commands are being dropped.");
+				s_commandOverflow = true;
+			}
+			return false;
+		}
+		s_commandOverflow = false;
+		return true;
+	}
+
+	// For commands that must not be lost: wait for the audio thread to make room, or execute the queued commands
+	// directly if there is no audio thread to do it.
+	void pushCommandWait(const AudioCommand& cmd)
+	{
+		while (!pushCommand(cmd))
 		{
-			if (s_sources[s].flags&SND_FLAG_FINISHED)
+			if (TFE_AudioDevice::isOutputThreadRunning())
+			{
+				TFE_System::sleep(1);
+			}
+			else
 			{
-				s_sources[s].flags &= ~SND_FLAG_FINISHED;
-				if (s_sources[s].finishedCallback)
+				executeCommands();
+			}
+		}
+	}
+
+	bool sendCommand(AudioCommandType type, SoundSource* source)
+	{
+		AudioCommand cmd = {};
+		cmd.type = u16(type);
+		if (source)
+		{
+			cmd.slot = u16(source->slot);
+			cmd.generation = source->generation;
+			cmd.buffer = source->buffer;
+			cmd.volume = source->volume;
+			cmd.seperation = source->seperation;
+			cmd.looping = (source->flags & SND_FLAG_LOOPING) ? 1u : 0u;
+
+			if (type == ACMD_PLAY)
+			{
+				source->mixVolume = source->volume;
+				source->mixSeperation = source->seperation;
+			}
+		}
+		return pushCommand(cmd);
+	}
+
+	// Send any changed parameters, these are skipped when the queue is getting full and resent during the next update.
+	void sendParameters(SoundSource* source)
+	{
+		if (s_commandQueue.getCount() >= c_paramCommandLimit) { return; }
+
+		if (source->volume != source->mixVolume && sendCommand(ACMD_SET_VOLUME, source))
+		{
+			source->mixVolume = source->volume;
+		}
+		if (source->seperation != source->mixSeperation && sendCommand(ACMD_SET_SEPERATION, source))
+		{
+			source->mixSeperation = source->seperation;
+		}
+	}
+
+	// Handle sounds that the audio thread has finished playing.
+	void processFinishedSounds()
+	{
+		AudioFinishedMsg msg;
+		while (s_finishedQueue.pop(&msg))
+		{
+			SoundSource* snd = &s_sources[msg.slot];
+			// The source has been stopped, freed or reused since the message was sent.
+			if (snd->generation != msg.generation || !(snd->flags & SND_FLAG_PLAYING)) { continue; }
+
+			snd->flags &= ~SND_FLAG_PLAYING;
+			if (snd->finishedCallback)
+			{
+				snd->finishedCallback(snd->finishedUserData, snd->finishedArg);
+			}
+			// If this is a one shot, it can now be reused.
+			if (snd->flags & SND_FLAG_ONE_SHOT)
+			{
+				releaseSource(snd);
+			}
+		}
+	}
+
+	/////////////////////////////////////////////
+	// Audio thread
+	/////////////////////////////////////////////
+	void addActiveVoice(u32 slot)
+	{
+		MixVoice* voice = &s_voices[slot];
+		if (voice->flags & SND_FLAG_ACTIVE) { return; }
+
+		voice->flags |= SND_FLAG_ACTIVE;
+		s_activeVoices[s_activeCount++] = slot;
+	}
+
+	void setVoiceBuffer(MixVoice* voice, const SoundBuffer* buffer)
+	{
+		voice->buffer = buffer;
+		voice->sampleIndex = 0u;
+		voice->frac = 0u;
+		// Buffers without a sample rate are assumed to match the output.
+		const u32 sampleRate = buffer->sampleRate ? buffer->sampleRate : s_outputSampleRate;
+		voice->step = sampleRate != s_outputSampleRate ? TFE_AudioMixer::getResampleStep(sampleRate, s_outputSampleRate) : 0ull;
+		// Streams are always converted to the output sample rate and restart from the beginning.
+		if (buffer->type == SOUND_DATA_STREAM)
+		{
+			voice->step = 0ull;
+			TFE_AudioStream::restart((SoundStream*)buffer->data, (voice->flags & SND_FLAG_LOOPING) != 0u);
+		}
+	}
+
+	void executeCommands()
+	{
+		AudioCommand cmd;
+		while (s_commandQueue.pop(&cmd))
+		{
+			if (cmd.type == ACMD_STOP_ALL)
+			{
+				for (u32 v = 0; v < s_activeCount; v++)
 				{
-					s_sources[s].finishedCallback(s_sources[s].finishedUserData, s_sources[s].finishedArg);
+					s_voices[s_activeVoices[v]].flags = 0u;
 				}
+				s_activeCount = 0u;
+				// No voice references the old buffers from here on.
+				s_stopAllDone.store(cmd.generation, std::memory_order_release);
+				continue;
+			}
+			else if (cmd.type == ACMD_SET_RENDER_CALLBACK)
+			{
+				s_renderCallback = cmd.renderCallback;
+				s_renderUserData = cmd.renderUserData;
+				continue;
+			}
+			else if (cmd.type == ACMD_RELEASE_STREAM)
+			{
+				for (u32 v = 0; v < s_activeCount; v++)
+				{
+					// Report the voice as finished so that one shots are released on the game thread.
+					MixVoice* voice = &s_voices[s_activeVoices[v]];
+					if (voice->buffer == cmd.buffer && (voice->flags & SND_FLAG_PLAYING))
+					{
+						voice->flags = (voice->flags & ~SND_FLAG_PLAYING) | SND_FLAG_FINISHED;
+					}
+				}
+				TFE_AudioStream::release((SoundStream*)cmd.buffer->data);
+				continue;
+			}
+
+			assert(cmd.slot < MAX_SOUND_SOURCES);
+			MixVoice* voice = &s_voices[cmd.slot];
+			if (cmd.type == ACMD_PLAY)
+			{
+				// Keep the active flag so the voice isn't added to the active list twice.
+				voice->flags = (voice->flags & SND_FLAG_ACTIVE) | SND_FLAG_PLAYING | (cmd.looping ? u32(SND_FLAG_LOOPING) : 0u);
+				setVoiceBuffer(voice, cmd.buffer);
+				voice->generation = cmd.generation;
+				voice->volume = cmd.volume;
+				voice->seperation = cmd.seperation;
+				addActiveVoice(cmd.slot);
+				continue;
+			}
+			// Ignore commands meant for a previous use of the voice.
+			if (voice->generation != cmd.generation) { continue; }
+
+			switch (cmd.type)
+			{
+				case ACMD_STOP:
+				case ACMD_FREE:
+				{
+					// The voice is removed from the active list during cleanup.
+					voice->flags &= SND_FLAG_ACTIVE;
+				} break;
+				case ACMD_SET_VOLUME:
+				{
+					voice->volume = cmd.volume;
+				} break;
+				case ACMD_SET_SEPERATION:
+				{
+					voice->seperation = cmd.seperation;
+				} break;
+				case ACMD_SET_BUFFER:
+				{
+					setVoiceBuffer(voice, cmd.buffer);
+				} break;
 			}
 		}
+	}
 
-		const s32 end = (s32)s_sourceCount - 1;
-		//shrink the number of sources until an active source is found.
-		for (s32 s = end; s >= 0; s--)
+	void cleanupVoices()
+	{
+		for (u32 i = 0; i < s_activeCount;)
 		{
-			if (s_sources[s].flags&SND_FLAG_ACTIVE)
+			const u32 slot = s_activeVoices[i];
+			MixVoice* voice = &s_voices[slot];
+			// Notify the game thread of finished voices, if the queue is full try again next callback.
+			if ((voice->flags & SND_FLAG_FINISHED) && s_finishedQueue.push({ slot, voice->generation }))
 			{
+				voice->flags &= ~SND_FLAG_FINISHED;
+			}
+
+			// Remove voices that are no longer playing, swapping with the last active voice to keep the list compact.
+			if (!(voice->flags & (SND_FLAG_PLAYING | SND_FLAG_FINISHED)))
+			{
+				voice->flags = 0u;
+				s_activeCount--;
+				s_activeVoices[i] = s_activeVoices[s_activeCount];
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+	void finishVoice(MixVoice* voice)
+	{
+		voice->flags &= ~SND_FLAG_PLAYING;
+		voice->flags |= SND_FLAG_FINISHED;
+		voice->sampleIndex = 0u;
+		voice->frac = 0u;
+	}
+
+	// Fill 'count' source samples starting at 'start', which may be before the beginning or past the end of the buffer.
+	// Samples before the beginning are silent, samples past the end wrap to the loop start if the voice is looping.
+	void gatherSourceSamples(const MixVoice* voice, s64 start, u32 count, f32* out)
+	{
+		const SoundBuffer* buffer = voice->buffer;
+		const bool looping = (voice->flags & SND_FLAG_LOOPING) && buffer->loopStart < buffer->size;
+		while (count)
+		{
+			u32 samples;
+			s64 index = start;
+			if (index >= s64(buffer->size) && looping)
+			{
+				index = buffer->loopStart + (index - buffer->size) % (buffer->size - buffer->loopStart);
+			}
+
+			if (index < 0)
+			{
+				samples = u32(std::min(s64(count), -index));
+				memset(out, 0, sizeof(f32) * samples);
+			}
+			else if (index >= s64(buffer->size))
+			{
+				memset(out, 0, sizeof(f32) * count);
+				return;
+			}
+			else
+			{
+				samples = std::min(count, buffer->size - u32(index));
+				TFE_AudioMixer::convertToFloat(buffer->type, buffer->data, u32(index), samples, out);
+			}
+			out   += samples;
+			start += samples;
+			count -= samples;
+		}
+	}
+
+	// Render 'count' frames of a voice that matches the output sample rate into the bus, handling loops and the end of the buffer.
+	void mixVoiceDirect(MixVoice* voice, u32 count, f32 gainLeft, f32 gainRight, f32* busLeft, f32* busRight)
+	{
+		const SoundBuffer* buffer = voice->buffer;
+		u32 offset = 0;
+		while (offset < count)
+		{
+			const u32 frames = voice->sampleIndex < buffer->size ? std::min(count - offset, buffer->size - voice->sampleIndex) : 0u;
+			// Empty buffers or invalid loop points.
+			if (!frames)
+			{
+				finishVoice(voice);
 				break;
 			}
-			s_sourceCount--;
+
+			// Float data can be accumulated directly.
+			const f32* samples = (const f32*)buffer->data + voice->sampleIndex;
+			if (buffer->type != SOUND_DATA_FLOAT)
+			{
+				TFE_AudioMixer::convertToFloat(buffer->type, buffer->data, voice->sampleIndex, frames, s_convertBuffer);
+				samples = s_convertBuffer;
+			}
+			TFE_AudioMixer::accumulate(samples, frames, gainLeft, gainRight, busLeft + offset, busRight + offset);
+
+			offset += frames;
+			voice->sampleIndex += frames;
+			if (voice->sampleIndex >= buffer->size)
+			{
+				if (voice->flags&SND_FLAG_LOOPING)
+				{
+					voice->sampleIndex = buffer->loopStart;
+				}
+				else
+				{
+					finishVoice(voice);
+					break;
+				}
+			}
 		}
 	}
-		
-	f32 sampleBuffer(u32 index, SoundDataType type, const u8* data)
+
+	// Render 'count' frames of a voice with a different sample rate, the source position is advanced using a 32.32 fixed point step.
+	void mixVoiceResampled(MixVoice* voice, u32 count, f32 gainLeft, f32 gainRight, f32* busLeft, f32* busRight)
 	{
-		f32 sampleValue;
-		switch (type)
+		const SoundBuffer* buffer = voice->buffer;
+		// Limit the number of output frames so the source samples, including the filter footprint, fit in the source buffer.
+		const u64 maxSourceSpan = MIX_SOURCE_SIZE - RESAMPLE_HISTORY - RESAMPLE_LOOKAHEAD - 1;
+		const u32 maxFrames = u32(std::max(std::min(u64(MIX_BLOCK_SIZE), (maxSourceSpan << 32ull) / voice->step), u64(1)));
+
+		u32 offset = 0;
+		while (offset < count)
 		{
-			case SOUND_DATA_8BIT:  { sampleValue = (f32)data[index]; } break;
-			case SOUND_DATA_16BIT: { sampleValue = (f32)(*((u16*)data + index)); } break;
-			case SOUND_DATA_FLOAT: { sampleValue = *((f32*)data + index); } break;
-		};
+			if (voice->sampleIndex >= buffer->size)
+			{
+				finishVoice(voice);
+				break;
+			}
+
+			const u32 frames = std::min(count - offset, maxFrames);
+			const u64 lastPos = u64(voice->frac) + voice->step * u64(frames - 1);
+			const u32 span = u32(lastPos >> 32ull) + RESAMPLE_HISTORY + RESAMPLE_LOOKAHEAD + 1;
+			gatherSourceSamples(voice, s64(voice->sampleIndex) - RESAMPLE_HISTORY, span, s_sourceBuffer);
+			TFE_AudioMixer::resample(s_resampler, s_sourceBuffer + RESAMPLE_HISTORY, voice->frac, voice->step, frames, s_convertBuffer);
+			TFE_AudioMixer::accumulate(s_convertBuffer, frames, gainLeft, gainRight, busLeft + offset, busRight + offset);
+			offset += frames;
 
-		return sampleValue * c_scale[type] + c_offset[type];
+			// Advance the source position.
+			const u64 pos = u64(voice->frac) + voice->step * u64(frames);
+			u64 index = u64(voice->sampleIndex) + (pos >> 32ull);
+			voice->frac = u32(pos & 0xffffffffull);
+			if (index >= buffer->size)
+			{
+				if ((voice->flags&SND_FLAG_LOOPING) && buffer->loopStart < buffer->size)
+				{
+					index = buffer->loopStart + (index - buffer->size) % (buffer->size - buffer->loopStart);
+				}
+				else
+				{
+					finishVoice(voice);
+					break;
+				}
+			}
+			voice->sampleIndex = u32(index);
+		}
 	}
-		
+
+	// Render 'count' frames from a stream, which is already at the output sample rate.
+	void mixVoiceStream(MixVoice* voice, u32 count, f32 gainLeft, f32 gainRight, f32* busLeft, f32* busRight)
+	{
+		bool finished;
+		const u32 frames = TFE_AudioStream::read((SoundStream*)voice->buffer->data, s_convertBuffer, count, &finished);
+		TFE_AudioMixer::accumulate(s_convertBuffer, frames, gainLeft, gainRight, busLeft, busRight);
+		if (finished)
+		{
+			finishVoice(voice);
+		}
+	}
+
+	void mixVoice(MixVoice* voice, u32 count, f32* busLeft, f32* busRight)
+	{
+		assert(voice->buffer->data);
+
+		// Stereo Seperation, the gains are constant for the whole block.
+		const f32 sepSq = voice->seperation*voice->seperation;
+		const f32 invSepSq = (1.0f - voice->seperation) * (1.0f - voice->seperation);
+		const f32 gainLeft  = std::max(voice->volume - sepSq, 0.0f) * s_soundFxScale;
+		const f32 gainRight = std::max(voice->volume - invSepSq, 0.0f) * s_soundFxScale;
+
+		if (voice->buffer->type == SOUND_DATA_STREAM)
+		{
+			mixVoiceStream(voice, count, gainLeft, gainRight, busLeft, busRight);
+		}
+		else if (voice->step)
+		{
+			mixVoiceResampled(voice, count, gainLeft, gainRight, busLeft, busRight);
+		}
+		else
+		{
+			mixVoiceDirect(voice, count, gainLeft, gainRight, busLeft, busRight);
+		}
+	}
+
 	// Audio callback
 	s32 audioCallback(void *outputBuffer, void* inputBuffer, u32 bufferSize, f64 streamTime, u32 status, void* userData)
 	{
+		TFE_ZONE("Audio Mix");
 		f32* buffer = (f32*)outputBuffer;
-	
-		MUTEX_LOCK(&s_mutex);
-		for (u32 i = 0; i < bufferSize; i++, buffer += 2)
-		{
-			f32 valueLeft  = 0.0f;
-			f32 valueRight = 0.0f;
-			
-			SoundSource* snd = s_sources;
-			for (u32 s = 0; s < s_sourceCount; s++, snd++)
-			{
-				if (!(snd->flags&SND_FLAG_PLAYING)) { continue; }
-				assert(snd->buffer->data);
-
-				// Compute the sample value.
-				const f32 sampleValue = sampleBuffer(snd->sampleIndex, snd->buffer->type, snd->buffer->data) * s_soundFxScale;
-				// Stereo Seperation.
-				const f32 sepSq = snd->seperation*snd->seperation;
-				const f32 invSepSq = (1.0f - snd->seperation) * (1.0f - snd->seperation);
-				valueLeft  += std::max(snd->volume - sepSq, 0.0f) * sampleValue;
-				valueRight += std::max(snd->volume - invSepSq, 0.0f) * sampleValue;
-
-				snd->sampleIndex++;
-				if (snd->sampleIndex >= snd->buffer->size)
-				{
-					if (snd->flags&SND_FLAG_LOOPING)
-					{
-						snd->sampleIndex = snd->buffer->loopStart;
-					}
-					else
-					{
-						snd->flags &= ~SND_FLAG_PLAYING;
-						snd->flags |= SND_FLAG_FINISHED;
-						snd->sampleIndex = 0u;
-						// If this is a one shot, flag for later removal.
-						if (snd->flags&SND_FLAG_ONE_SHOT)
-						{
-							snd->flags &= ~SND_FLAG_ACTIVE;
-						}
-					}
-				}
+		executeCommands();
+
+		// Mix in blocks of up to MIX_BLOCK_SIZE frames.
+		for (u32 frame = 0; frame < bufferSize; frame += MIX_BLOCK_SIZE, buffer += 2 * MIX_BLOCK_SIZE)
+		{
+			const u32 count = std::min(bufferSize - frame, (u32)MIX_BLOCK_SIZE);
+			memset(s_busLeft,  0, sizeof(f32) * count);
+			memset(s_busRight, 0, sizeof(f32) * count);
+
+			for (u32 i = 0; i < s_activeCount; i++)
+			{
+				MixVoice* voice = &s_voices[s_activeVoices[i]];
+				if (!(voice->flags&SND_FLAG_PLAYING)) { continue; }
+				mixVoice(voice, count, s_busLeft, s_busRight);
+			}
+			if (s_renderCallback)
+			{
+				s_renderCallback(s_busLeft, s_busRight, count, s_renderUserData);
 			}
 
-			// Audio outside of the [-1, 1] range will cause overflow, which is a major artifact.
-			// Instead the audio needs to be limited in range, which can be done in several ways.
-			// Sigmoid functions map an arbitrary range into [-1, 1] generall along an S-Curve, allowing us to avoid overflow.
-		#if defined(AUDIO_SIGMOID_CLIP)		// Not really a Sigmoid function but acts in a similar way, naively mapping to the required range.
-			valueLeft  = std::max(-c_channelLimit, std::min(valueLeft,  c_channelLimit));
-			valueRight = std::max(-c_channelLimit, std::min(valueRight, c_channelLimit));
-		#elif defined(AUDIO_SIGMOID_TANH)	// Considered one of the most "musical sounding" sigmoid functions, it avoids hard clipping.
-			// Note the usable range is approximately -4.8 to 4.8 so the volumes should be adjusted to stay within those ranges when possible.
-			// Still much better than the effect -1 to 1 range with hard clipping and cheaper than the more accurate library tanh(). :)
-			valueLeft  = TFE_Math::tanhf_series(valueLeft);
-			valueRight = TFE_Math::tanhf_series(valueRight);
-		#elif defined(AUDIO_SIGMOID_RCP_SQRT)
-			valueLeft  = valueLeft  / sqrtf(1.0f + valueLeft  * valueLeft);
-			valueRight = valueRight / sqrtf(1.0f + valueRight * valueRight);
-		#endif
-
-			//stereo output.
-			buffer[0] = valueLeft;
-			buffer[1] = valueRight;
-		}
-		cleanupSources();
-		MUTEX_UNLOCK(&s_mutex);
+			TFE_AudioMixer::limitAndInterleave(s_busLeft, s_busRight, count, buffer);
+		}
+		cleanupVoices();
 
 		return 0;
 	}
-		
+
 	// Console functions.
 	void setSoundVolumeConsole(const ConsoleArgList& args)
 	{
@@ -491,4 +1263,11 @@ namespace TFE_Audio
 		sprintf(res, "Sound Volume: %2.3f", s_soundFxVolume);
 		TFE_Console::addToHistory(res);
 	}
+
+	void audioBenchmarkConsole(const ConsoleArgList& args)
+	{
+		const u32 sourceCount = args.size() >= 2 ? (u32)TFE_Console::getFloatArg(args[1]) : 32u;
+		const u32 frameCount  = args.size() >= 3 ? (u32)TFE_Console::getFloatArg(args[2]) : 1024u * 1024u;
+		runBenchmark(sourceCount, frameCount);
+	}
 }
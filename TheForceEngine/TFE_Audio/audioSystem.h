@@ -8,6 +8,7 @@ enum SoundDataType
 	SOUND_DATA_8BIT = 0,
 	SOUND_DATA_16BIT,
 	SOUND_DATA_FLOAT,
+	SOUND_DATA_STREAM,	// The data is a SoundStream, see audioStream.h
 };
 
 // Optional sound buffer flags, not used by the audio system directly but may be set by the assets - 
@@ -40,9 +41,31 @@ enum SoundType
 	SOUND_3D,		// 3D positional sound effect.
 };
 
+// Sound categories, each category has a voice limit so that one type of sound can't use up all of the voices.
+enum SoundCategory
+{
+	SOUND_CATEGORY_GENERAL = 0,
+	SOUND_CATEGORY_WEAPON,
+	SOUND_CATEGORY_AMBIENT,
+	SOUND_CATEGORY_VOICE,
+	SOUND_CATEGORY_COUNT
+};
+
+// When no voices are available, a one shot with a lower priority (weighted by its distance attenuated volume) is stopped.
+// Critical sounds are never stopped to make room for other sounds.
+enum SoundPriority
+{
+	SOUND_PRIORITY_LOW      = 32,
+	SOUND_PRIORITY_NORMAL   = 64,
+	SOUND_PRIORITY_HIGH     = 128,
+	SOUND_PRIORITY_CRITICAL = 255,
+};
+
 #define MONO_SEPERATION 0.5f
 
 typedef void (*SoundFinishedCallback)(void* userData, s32 arg);
+// Called on the audio thread for each mix block, the callback adds 'frameCount' frames to the stereo bus before it is limited.
+typedef void (*AudioRenderCallback)(f32* left, f32* right, u32 frameCount, void* userData);
 
 namespace TFE_Audio
 {
@@ -59,6 +82,21 @@ namespace TFE_Audio
 
 	void setVolume(f32 volume);
 	f32  getVolume();
+	u32  getOutputSampleRate();
+
+	// Resample the buffer data to 'sampleRate' using the windowed-sinc filter, the result is stored as 16-bit data.
+	// This is done at load time so the buffer can be played without resampling during mixing.
+	bool resampleBuffer(SoundBuffer* buffer, u32 sampleRate);
+
+	// Mix 'sourceCount' sources of 8-bit, 16-bit and float data for 'frameCount' frames and report the time per 1k frames.
+	// This is done on the calling thread, normal output is paused while the benchmark runs.
+	void runBenchmark(u32 sourceCount, u32 frameCount);
+
+	// Set the render callback used to mix additional audio such as software synthesized music, pass nullptr to clear it.
+	// The change takes effect at the start of the next audio callback.
+	void setRenderCallback(AudioRenderCallback callback, void* userData);
+	// Stops any sources playing the stream and releases it once the audio thread is done with it, use TFE_AudioStream::close().
+	void releaseStream(SoundBuffer* buffer);
 
 	// Update position audio and other audio effects.
 	void update(const Vec3f* listenerPos, const Vec3f* listenerDir);
@@ -66,10 +104,14 @@ namespace TFE_Audio
 	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
 	// Note that looping one shots are valid though may generate too many sound sources if not used carefully.
 	bool playOneShot(SoundType type, f32 volume, f32 stereoSeperation, const SoundBuffer* buffer, bool looping, const Vec3f* pos = nullptr, bool copyPosition = false,
-					 SoundFinishedCallback finishedCallback = nullptr, void* cbUserData = nullptr, s32 cbArg = 0);
+					 SoundFinishedCallback finishedCallback = nullptr, void* cbUserData = nullptr, s32 cbArg = 0,
+					 SoundCategory category = SOUND_CATEGORY_GENERAL, SoundPriority priority = SOUND_PRIORITY_NORMAL);
+	// Non-looping, positionless one shot with a category and priority.
+	bool playOneShot(SoundType type, f32 volume, f32 stereoSeperation, const SoundBuffer* buffer, SoundCategory category, SoundPriority priority = SOUND_PRIORITY_NORMAL);
 
-	// Sound source that the client holds onto.
-	SoundSource* createSoundSource(SoundType type, f32 volume, f32 stereoSeperation, const SoundBuffer* buffer, const Vec3f* pos = nullptr);
+	// Sound source that the client holds onto. These sources are never stolen by other sounds.
+	SoundSource* createSoundSource(SoundType type, f32 volume, f32 stereoSeperation, const SoundBuffer* buffer, const Vec3f* pos = nullptr,
+								   SoundCategory category = SOUND_CATEGORY_GENERAL, SoundPriority priority = SOUND_PRIORITY_NORMAL);
 	void playSource(SoundSource* source, bool looping = false);
 	void stopSource(SoundSource* source);
 	void freeSource(SoundSource* source);
@@ -78,6 +120,10 @@ namespace TFE_Audio
 	// This will restart the sound and change the buffer.
 	void setSourceBuffer(SoundSource* source, const SoundBuffer* buffer);
 
+	// Set the maximum number of sources that can be allocated in a category.
+	void setCategoryLimit(SoundCategory category, u32 limit);
+	u32  getCategoryLimit(SoundCategory category);
+
 	bool isSourcePlaying(SoundSource* source);
 	f32  getSourceVolume(SoundSource* source);
 }
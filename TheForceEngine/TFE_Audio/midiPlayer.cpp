@@ -1,11 +1,20 @@
 #include "midiPlayer.h"
 #include "midiDevice.h"
+#include "midiSynth.h"
+#include "soundFont.h"
+#include "audioSystem.h"
+#include "audioMixer.h"
 #include <TFE_Asset/gmidAsset.h>
+#include <TFE_Asset/wavWriter.h>
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/paths.h>
 #include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
 #include <TFE_System/Threads/thread.h>
 #include <TFE_Settings/settings.h>
 #include <TFE_FrontEndUI/console.h>
 #include <algorithm>
+#include <math.h>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN 1
@@ -28,6 +37,11 @@ namespace TFE_MidiPlayer
 		const GMidiAsset* asset;
 		MidiRuntimeTrack tracks[8];
 		bool loop;
+		// Messages are sent to the software synthesizer if set, otherwise to the midi device.
+		MidiSynth* synth;
+		// Offline rendering finishes at the loop end rather than looping forever and ignores the music volume.
+		bool offline;
+		u8 channelSrcVolume[16];
 	};
 
 	enum Transition
@@ -40,6 +54,9 @@ namespace TFE_MidiPlayer
 	};
 
 	static const f32 c_musicVolumeScale = 0.5f;
+	// Offline rendering always uses CD quality, regardless of the output sample rate.
+	static const u32 c_offlineSampleRate = 44100;
+	static const u32 c_offlineBlockSize = 1024;
 	static MidiRuntime s_runtime;
 	static atomic_bool s_isPlaying;
 	static atomic_bool s_changeVolume;
@@ -51,40 +68,68 @@ namespace TFE_MidiPlayer
 	static atomic_bool s_runMusicThread;
 	static atomic_bool s_resetThreadLocalTime;
 
-	static u8 s_channelSrcVolume[16] = { 0 };
+	// Software synthesizer, when enabled the sequencer runs in the audio callback instead of the midi thread.
+	static SoundFont s_soundFont;
+	static bool s_soundFontLoaded = false;
+	static MidiSynth* s_synth = nullptr;
+	static atomic_bool s_synthPaused;
+	static bool s_synthWasPlaying = false;
 		
 	TFE_THREADRET midiUpdateFunc(void* userData);
-	void stopAllNotes();
-	void changeVolume();
+	void renderMusic(f32* left, f32* right, u32 frameCount, void* userData);
+	bool loadSoundFont();
+	void stopAllNotes(MidiRuntime* runtime);
+	void changeVolume(MidiRuntime* runtime);
+	void resetRuntime(MidiRuntime* runtime, const GMidiAsset* gmidAsset, bool loop);
 
 	// Console Functions
 	void setMusicVolumeConsole(const ConsoleArgList& args);
 	void getMusicVolumeConsole(const ConsoleArgList& args);
+	void renderMusicConsole(const ConsoleArgList& args);
 
 	bool init()
 	{
 		TFE_System::logWrite(LOG_MSG, "Startup", "TFE_MidiPlayer::init");
 
 		bool res = TFE_MidiDevice::init();
-		TFE_MidiDevice::selectDevice(0);
 		s_runMusicThread.store(true);
 		s_isPlaying.store(false);
 		s_transition.store(TRANSITION_NONE);
 		s_resetThreadLocalTime.store(true);
+		s_synthPaused.store(false);
 
-		s_thread = Thread::create("MidiThread", midiUpdateFunc, nullptr);
-		if (s_thread)
+		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
+		const bool hasDevice = TFE_MidiDevice::getDeviceCount() > 0;
+		if ((soundSettings->softwareSynth || !hasDevice) && loadSoundFont())
+		{
+			s_synth = TFE_MidiSynth::create(&s_soundFont, TFE_Audio::getOutputSampleRate(), std::max(soundSettings->synthMaxVoices, 1u));
+		}
+
+		if (s_synth)
+		{
+			TFE_System::logWrite(LOG_MSG, "MidiPlayer", "Using the software synthesizer.");
+			s_runtime.synth = s_synth;
+			TFE_Audio::setRenderCallback(renderMusic, nullptr);
+			res = true;
+		}
+		else
 		{
-			s_thread->run();
+			TFE_MidiDevice::selectDevice(0);
+			s_thread = Thread::create("MidiThread", midiUpdateFunc, nullptr);
+			if (s_thread)
+			{
+				s_thread->run();
+			}
+			res = res && s_thread;
 		}
 
 		CCMD("setMusicVolume", setMusicVolumeConsole, 1, "Sets the music volume, range is 0.0 to 1.0");
 		CCMD("getMusicVolume", getMusicVolumeConsole, 0, "Get the current music volume where 0 = silent, 1 = maximum.");
+		CCMD("renderMusic", renderMusicConsole, 1, "Render a song to a WAV file in the user documents folder using the software synthesizer - renderMusic \"song.gmd\" [maxSeconds]");
 
-		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
 		setVolume(soundSettings->musicVolume);
 
-		return res && s_thread;
+		return res;
 	}
 
 	void destroy()
@@ -93,40 +138,36 @@ namespace TFE_MidiPlayer
 		// Destroy the thread before shutting down the Midi Device.
 		stop();
 		s_runMusicThread.store(false);
-		if (s_thread->isPaused())
+		if (s_thread)
 		{
-			s_thread->resume();
+			if (s_thread->isPaused())
+			{
+				s_thread->resume();
+			}
+			s_thread->waitOnExit();
+			delete s_thread;
+			s_thread = nullptr;
 		}
-		s_thread->waitOnExit();
 
-		delete s_thread;
+		// The audio system has already been shutdown, so the render callback is no longer called.
+		TFE_MidiSynth::destroy(s_synth);
+		s_synth = nullptr;
+		TFE_SoundFont::free(&s_soundFont);
+		s_soundFontLoaded = false;
+
 		TFE_MidiDevice::destroy();
 	}
 
 	void playSong(const GMidiAsset* gmidAsset, bool loop)
 	{
-		s_runtime.asset = gmidAsset;
-		s_runtime.loop = loop;
-		for (u32 i = 0; i < gmidAsset->trackCount; i++)
-		{
-			s_runtime.tracks[i].curTick   = 0;
-			s_runtime.tracks[i].lastEvent = -1;
-			s_runtime.tracks[i].msPerTick = gmidAsset->tracks[i].msPerTick;
-		}
-
-		for (u32 i = 0; i < 16; i++)
-		{
-			s_channelSrcVolume[i] = CHANNEL_MAX_VOLUME;
-		}
-		changeVolume();
+		resetRuntime(&s_runtime, gmidAsset, loop);
+		// The volume is sent by the thread that owns the midi output.
+		s_changeVolume.store(true);
 
 		s_isPlaying.store(true);
 		s_resetThreadLocalTime.store(true);
 
-		if (s_thread->isPaused())
-		{
-			s_thread->resume();
-		}
+		resume();
 	}
 	
 	void setVolume(f32 volume)
@@ -142,7 +183,11 @@ namespace TFE_MidiPlayer
 
 	void pause()
 	{
-		if (!s_thread->isPaused())
+		if (s_synth)
+		{
+			s_synthPaused.store(true);
+		}
+		else if (!s_thread->isPaused())
 		{
 			s_thread->pause();
 		}
@@ -150,7 +195,11 @@ namespace TFE_MidiPlayer
 
 	void resume()
 	{
-		if (s_thread->isPaused())
+		if (s_synth)
+		{
+			s_synthPaused.store(false);
+		}
+		else if (s_thread->isPaused())
 		{
 			s_thread->resume();
 		}
@@ -161,28 +210,265 @@ namespace TFE_MidiPlayer
 		s_isPlaying.store(false);
 	}
 
-	void changeVolume()
+	bool loadSoundFont()
+	{
+		if (s_soundFontLoaded) { return true; }
+
+		// The SoundFont path is relative to the program directory unless it is a full path.
+		const char* soundFont = TFE_Settings::getSoundSettings()->soundFont;
+		char path[TFE_MAX_PATH];
+		if (FileUtil::exists(soundFont))
+		{
+			strcpy(path, soundFont);
+		}
+		else
+		{
+			TFE_Paths::appendPath(PATH_PROGRAM, soundFont, path);
+		}
+
+		s_soundFontLoaded = TFE_SoundFont::load(path, &s_soundFont);
+		return s_soundFontLoaded;
+	}
+
+	void resetRuntime(MidiRuntime* runtime, const GMidiAsset* gmidAsset, bool loop)
+	{
+		runtime->asset = gmidAsset;
+		runtime->loop = loop;
+		for (u32 i = 0; i < gmidAsset->trackCount; i++)
+		{
+			runtime->tracks[i].curTick   = 0;
+			runtime->tracks[i].lastEvent = -1;
+			runtime->tracks[i].msPerTick = gmidAsset->tracks[i].msPerTick;
+		}
+		for (u32 i = 0; i < 16; i++)
+		{
+			runtime->channelSrcVolume[i] = CHANNEL_MAX_VOLUME;
+		}
+	}
+
+	f32 getVolumeScale(const MidiRuntime* runtime)
+	{
+		return runtime->offline ? c_musicVolumeScale : s_masterVolumeScaled;
+	}
+
+	void sendMessage(MidiRuntime* runtime, u8 arg0, u8 arg1, u8 arg2 = 0)
+	{
+		if (runtime->synth)
+		{
+			TFE_MidiSynth::sendMessage(runtime->synth, arg0, arg1, arg2);
+		}
+		else
+		{
+			TFE_ZONE("MIDI Device Send");
+			TFE_MidiDevice::sendMessage(arg0, arg1, arg2);
+		}
+	}
+
+	void changeVolume(MidiRuntime* runtime)
 	{
 		for (u32 i = 0; i < 16; i++)
 		{
-			TFE_MidiDevice::sendMessage(MID_CONTROL_CHANGE + i, MID_VOLUME_MSB, u8(s_channelSrcVolume[i] * s_masterVolumeScaled));
+			sendMessage(runtime, MID_CONTROL_CHANGE + i, MID_VOLUME_MSB, u8(runtime->channelSrcVolume[i] * getVolumeScale(runtime)));
 		}
 	}
 
-	void stopAllNotes()
+	void stopAllNotes(MidiRuntime* runtime)
 	{
 		for (u32 i = 0; i < 16; i++)
 		{
-			TFE_MidiDevice::sendMessage(MID_CONTROL_CHANGE + i, MID_ALL_NOTES_OFF);
+			sendMessage(runtime, MID_CONTROL_CHANGE + i, MID_ALL_NOTES_OFF);
 		}
 	}
-		
+
+	// Advance the sequence by 'dt' seconds, sending all of the events in that time range.
+	// Returns false once the song has finished.
+	bool advanceSequence(MidiRuntime* runtime, f64 dt)
+	{
+		const u32 trackCount = runtime->asset->trackCount;
+		if (!trackCount) { return false; }
+
+		const u32 i = 0;
+		const Track* track = &runtime->asset->tracks[i];
+		MidiRuntimeTrack* runtimeTrack = &runtime->tracks[i];
+		if ((u32)runtimeTrack->curTick >= track->length)
+		{
+			return false;
+		}
+
+		const f64 prevTick = runtimeTrack->curTick;
+		f64 nextTick = prevTick + dt * 1000.0 / runtimeTrack->msPerTick;
+
+		u32 start = (u32)prevTick;
+		u32 end   = (u32)nextTick;
+
+		const u32 evtCount = (u32)track->eventList.size();
+		const MidiTrackEvent* evt = track->eventList.data();
+		bool breakFromLoop = false;
+		for (u32 e = u32(runtimeTrack->lastEvent + 1); e < evtCount && !breakFromLoop; e++)
+		{
+			if (evt[e].tick >= start && evt[e].tick <= end)
+			{
+				runtimeTrack->lastEvent = e;
+				switch (evt[e].type)
+				{
+					case MTK_TEMPO:
+						runtimeTrack->msPerTick = track->tempoEvents[evt[e].index].msPerTick;
+						break;
+					case MTK_MARKER:
+					{
+						const MidiMarker* marker = &track->markers[evt[e].index];
+						TFE_System::logWrite(LOG_MSG, "iMuse", "Marker Track %d, \"%s\"", i, marker->name);
+					} break;
+					case MTK_MIDI:
+					{
+						const MidiEvent* midiEvt = &track->midiEvents[evt[e].index];
+						const u8 type = midiEvt->channel >= 0 ? midiEvt->type + midiEvt->channel : midiEvt->type;
+						// TODO: Track notes on and off so that hanging notes can be handled manually.
+						//       Apparently not all midi devices support MID_ALL_NOTES_OFF.
+						if ((midiEvt->type&0xf0) == MID_CONTROL_CHANGE && midiEvt->data[0] == MID_VOLUME_MSB)
+						{
+							const s32 channelIndex = midiEvt->type & 0x0f;
+							runtime->channelSrcVolume[channelIndex] = midiEvt->data[1];
+							sendMessage(runtime, type, midiEvt->data[0], u8(runtime->channelSrcVolume[channelIndex] * getVolumeScale(runtime)));
+						}
+						else
+						{
+							sendMessage(runtime, type, midiEvt->data[0], midiEvt->data[1]);
+						}
+					} break;
+					case MTK_IMUSE:
+					{
+						const iMuseEvent* imuse = &track->imuseEvents[evt[e].index];
+						switch (imuse->cmd)
+						{
+							case IMUSE_START_NEW:
+							{
+							} break;
+							case IMUSE_STALK_TRANS:
+							{
+							} break;
+							case IMUSE_FIGHT_TRANS:
+							{
+							} break;
+							case IMUSE_ENGAGE_TRANS:
+							{
+							} break;
+							case IMUSE_FROM_FIGHT:
+							{
+							} break;
+							case IMUSE_FROM_STALK:
+							{
+							} break;
+							case IMUSE_FROM_BOSS:
+							{
+							} break;
+							case IMUSE_CLEAR_CALLBACK:
+							{
+								//clearCallback();
+							} break;
+							case IMUSE_TO:
+							{
+								//setCallback();
+							} break;
+							case IMUSE_LOOP_START:
+							{
+							} break;
+							case IMUSE_LOOP_END:
+							{
+								if (runtime->offline)
+								{
+									stopAllNotes(runtime);
+									runtimeTrack->curTick = f64(track->length);
+									return false;
+								}
+								nextTick = imuse->arg[0].nArg;
+								runtimeTrack->lastEvent = -1;
+								breakFromLoop = true;
+								stopAllNotes(runtime);
+							} break;
+						};
+					} break;
+				}
+			}
+			else if (evt[e].tick > end)
+			{
+				break;
+			}
+		}
+
+		runtimeTrack->curTick = nextTick;
+		return true;
+	}
+
+	// Time in seconds until the next event is sent by advanceSequence().
+	f64 getTimeToNextEvent(const MidiRuntime* runtime)
+	{
+		const f64 never = 1.0e9;
+		if (!runtime->asset->trackCount) { return never; }
+
+		const Track* track = &runtime->asset->tracks[0];
+		const MidiRuntimeTrack* runtimeTrack = &runtime->tracks[0];
+		const u32 nextEvent = u32(runtimeTrack->lastEvent + 1);
+		if (nextEvent >= (u32)track->eventList.size()) { return never; }
+
+		const f64 ticks = f64(track->eventList[nextEvent].tick) - runtimeTrack->curTick;
+		return std::max(ticks, 0.0) * runtimeTrack->msPerTick * 0.001;
+	}
+
+	// Render the synthesizer output while sequencing, the output is split at event boundaries so that events are sample accurate.
+	// Returns false once the song has finished.
+	bool renderSequence(MidiRuntime* runtime, f32* left, f32* right, u32 frameCount)
+	{
+		const u32 sampleRate = TFE_MidiSynth::getSampleRate(runtime->synth);
+		bool playing = true;
+		for (u32 frame = 0; frame < frameCount;)
+		{
+			// Always render at least one frame so that events behind the current position can't stall the sequence.
+			const f64 eventFrames = ceil(getTimeToNextEvent(runtime) * f64(sampleRate));
+			const u32 count = u32(std::max(1.0, std::min(eventFrames, f64(frameCount - frame))));
+
+			TFE_MidiSynth::render(runtime->synth, left + frame, right + frame, count);
+			playing = advanceSequence(runtime, f64(count) / f64(sampleRate));
+			frame += count;
+		}
+		return playing;
+	}
+
+	// Render callback, called by the audio thread when using the software synthesizer.
+	void renderMusic(f32* left, f32* right, u32 frameCount, void* userData)
+	{
+		if (s_synthPaused.load()) { return; }
+
+		if (!s_isPlaying.load())
+		{
+			if (s_synthWasPlaying)
+			{
+				stopAllNotes(&s_runtime);
+				s_synthWasPlaying = false;
+			}
+			// Let released notes finish.
+			TFE_MidiSynth::render(s_synth, left, right, frameCount);
+			return;
+		}
+		s_synthWasPlaying = true;
+
+		if (s_resetThreadLocalTime.exchange(false))
+		{
+			TFE_MidiSynth::reset(s_synth);
+		}
+		if (s_changeVolume.exchange(false))
+		{
+			changeVolume(&s_runtime);
+		}
+		renderSequence(&s_runtime, left, right, frameCount);
+	}
+
 	// Thread Function
 	TFE_THREADRET midiUpdateFunc(void* userData)
 	{
+		TFE_PROFILE_THREAD("MIDI");
 		bool runThread = true;
 		bool wasPlaying = false;
-		s32 loopStart = -1;
 		u64 localTime = 0;
 		while (runThread)
 		{
@@ -191,9 +477,8 @@ namespace TFE_MidiPlayer
 				if (wasPlaying)
 				{
 					// Stop all of the notes.
-					stopAllNotes();
+					stopAllNotes(&s_runtime);
 					wasPlaying = false;
-					loopStart = -1;
 				}
 				runThread = s_runMusicThread.load();
 				if (runThread) { TFE_System::sleep(16); }
@@ -203,130 +488,19 @@ namespace TFE_MidiPlayer
 
 			if (s_changeVolume.exchange(false))
 			{
-				changeVolume();
+				changeVolume(&s_runtime);
 			}
 
 			// Returns the current value while atomically updating the variable.
 			bool resetLocalTime = s_resetThreadLocalTime.exchange(false);
 			if (resetLocalTime)
 			{
-				stopAllNotes();
+				stopAllNotes(&s_runtime);
 				localTime = 0u;
-				loopStart = -1;
 			}
 			const f64 dt = TFE_System::updateThreadLocal(&localTime);
-			const u32 transition = s_transition.load();
-
-			const u32 trackCount = s_runtime.asset->trackCount;
-			bool allTracksFinished = true;
-			if (trackCount)
-			{
-				const u32 i = 0;
-				const Track* track = &s_runtime.asset->tracks[i];
-				MidiRuntimeTrack* runtimeTrack = &s_runtime.tracks[i];
-				if ((u32)runtimeTrack->curTick >= track->length)
-				{
-					continue;
-				}
-
-				allTracksFinished = false;
-				const f64 prevTick = runtimeTrack->curTick;
-				f64 nextTick = prevTick + dt * 1000.0 / runtimeTrack->msPerTick;
-
-				u32 start = (u32)prevTick;
-				u32 end   = (u32)nextTick;
-
-				const u32 evtCount = (u32)track->eventList.size();
-				const MidiTrackEvent* evt = track->eventList.data();
-				bool breakFromLoop = false;
-				for (u32 e = u32(runtimeTrack->lastEvent + 1); e < evtCount && !breakFromLoop; e++)
-				{
-					if (evt[e].tick >= start && evt[e].tick <= end)
-					{
-						runtimeTrack->lastEvent = e;
-						switch (evt[e].type)
-						{
-							case MTK_TEMPO:
-								runtimeTrack->msPerTick = track->tempoEvents[evt[e].index].msPerTick;
-								break;
-							case MTK_MARKER:
-							{
-								const MidiMarker* marker = &track->markers[evt[e].index];
-								TFE_System::logWrite(LOG_MSG, "iMuse", "Marker Track %d, \"%s\"", i, marker->name);
-							} break;
-							case MTK_MIDI:
-							{
-								const MidiEvent* midiEvt = &track->midiEvents[evt[e].index];
-								const u8 type = midiEvt->channel >= 0 ? midiEvt->type + midiEvt->channel : midiEvt->type;
-								// TODO: Track notes on and off so that hanging notes can be handled manually.
-								//       Apparently not all midi devices support MID_ALL_NOTES_OFF.
-								if ((midiEvt->type&0xf0) == MID_CONTROL_CHANGE && midiEvt->data[0] == MID_VOLUME_MSB)
-								{
-									const s32 channelIndex = midiEvt->type & 0x0f;
-									s_channelSrcVolume[channelIndex] = midiEvt->data[1];
-									TFE_MidiDevice::sendMessage(type, midiEvt->data[0], u8(s_channelSrcVolume[channelIndex] * s_masterVolumeScaled));
-								}
-								else
-								{
-									TFE_MidiDevice::sendMessage(type, midiEvt->data[0], midiEvt->data[1]);
-								}
-							} break;
-							case MTK_IMUSE:
-							{
-								const iMuseEvent* imuse = &track->imuseEvents[evt[e].index];
-								switch (imuse->cmd)
-								{
-									case IMUSE_START_NEW:
-									{
-									} break;
-									case IMUSE_STALK_TRANS:
-									{
-									} break;
-									case IMUSE_FIGHT_TRANS:
-									{
-									} break;
-									case IMUSE_ENGAGE_TRANS:
-									{
-									} break;
-									case IMUSE_FROM_FIGHT:
-									{
-									} break;
-									case IMUSE_FROM_STALK:
-									{
-									} break;
-									case IMUSE_FROM_BOSS:
-									{
-									} break;
-									case IMUSE_CLEAR_CALLBACK:
-									{
-										//clearCallback();
-									} break;
-									case IMUSE_TO:
-									{
-										//setCallback();
-									} break;
-									case IMUSE_LOOP_START:
-									{
-									} break;
-									case IMUSE_LOOP_END:
-									{
-										nextTick = imuse->arg[0].nArg;
-										runtimeTrack->lastEvent = -1;
-										breakFromLoop = true;
-										stopAllNotes();
-									} break;
-								};
-							} break;
-						}
-					}
-					else if (evt[e].tick > end)
-					{
-						break;
-					}
-				}
+			advanceSequence(&s_runtime, dt);
 
-				runtimeTrack->curTick = nextTick;
-			}
 			runThread = s_runMusicThread.load();
 			// Give other threads a chance to run...
 			//if (runThread) { TFE_System::sleep(0); }
@@ -335,6 +509,55 @@ namespace TFE_MidiPlayer
 		return (TFE_THREADRET)0;
 	}
 
+	bool renderSong(const GMidiAsset* gmidAsset, const char* path, f32 maxSeconds)
+	{
+		if (!loadSoundFont()) { return false; }
+
+		// Offline rendering uses its own synthesizer and sequence, so it doesn't interfere with the music that is playing.
+		MidiSynth* synth = TFE_MidiSynth::create(&s_soundFont, c_offlineSampleRate, std::max(TFE_Settings::getSoundSettings()->synthMaxVoices, 1u));
+		if (!synth) { return false; }
+		if (!TFE_WAV::startWav(path, c_offlineSampleRate, 2))
+		{
+			TFE_MidiSynth::destroy(synth);
+			return false;
+		}
+
+		MidiRuntime runtime = {};
+		resetRuntime(&runtime, gmidAsset, false);
+		runtime.synth = synth;
+		runtime.offline = true;
+		changeVolume(&runtime);
+
+		f32 left[c_offlineBlockSize], right[c_offlineBlockSize];
+		f32 output[c_offlineBlockSize * 2];
+		const u32 maxFrames = u32(maxSeconds * f32(c_offlineSampleRate));
+		// Render until the song is finished, followed by any notes still releasing.
+		bool playing = true;
+		for (u32 frame = 0; frame < maxFrames && (playing || TFE_MidiSynth::getActiveVoiceCount(synth)); frame += c_offlineBlockSize)
+		{
+			memset(left,  0, sizeof(f32) * c_offlineBlockSize);
+			memset(right, 0, sizeof(f32) * c_offlineBlockSize);
+			if (playing)
+			{
+				playing = renderSequence(&runtime, left, right, c_offlineBlockSize);
+				if (!playing) { stopAllNotes(&runtime); }
+			}
+			else
+			{
+				TFE_MidiSynth::render(synth, left, right, c_offlineBlockSize);
+			}
+
+			for (u32 block = 0; block < c_offlineBlockSize; block += MIX_BLOCK_SIZE)
+			{
+				TFE_AudioMixer::limitAndInterleave(left + block, right + block, MIX_BLOCK_SIZE, output + block * 2);
+			}
+			TFE_WAV::addSamples(output, c_offlineBlockSize);
+		}
+
+		TFE_MidiSynth::destroy(synth);
+		return TFE_WAV::write();
+	}
+
 	// Console Functions
 	void setMusicVolumeConsole(const ConsoleArgList& args)
 	{
@@ -355,4 +578,35 @@ namespace TFE_MidiPlayer
 		sprintf(res, "Sound Volume: %2.3f", s_masterVolume);
 		TFE_Console::addToHistory(res);
 	}
+
+	void renderMusicConsole(const ConsoleArgList& args)
+	{
+		if (args.size() < 2) { return; }
+
+		GMidiAsset* song = TFE_GmidAsset::get(args[1].c_str());
+		if (!song)
+		{
+			TFE_Console::addToHistory("Cannot load the song.");
+			return;
+		}
+		const f32 maxSeconds = args.size() >= 3 ? TFE_Console::getFloatArg(args[2]) : 600.0f;
+
+		char name[TFE_MAX_PATH];
+		char fileName[TFE_MAX_PATH];
+		char path[TFE_MAX_PATH];
+		FileUtil::getFileNameFromPath(song->name, name);
+		sprintf(fileName, "%s.wav", name);
+		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, fileName, path);
+
+		char res[TFE_MAX_PATH + 64];
+		if (renderSong(song, path, maxSeconds))
+		{
+			sprintf(res, "Rendered to \"%s\"", path);
+		}
+		else
+		{
+			sprintf(res, "Failed to render the song, the software synthesizer requires a SoundFont with embedded samples.");
+		}
+		TFE_Console::addToHistory(res);
+	}
 }
@@ -15,4 +15,7 @@ namespace TFE_MidiPlayer
 	void pause();
 	void resume();
 	void stop();
+
+	// Render the song offline to a WAV file using the software synthesizer, stopping at the loop end or after 'maxSeconds'.
+	bool renderSong(const GMidiAsset* gmidAsset, const char* path, f32 maxSeconds);
 };
@@ -0,0 +1,564 @@
+#include "midiSynth.h"
+#include "soundFont.h"
+#include "audioMixer.h"
+#include "midi.h"
+#include <TFE_System/system.h>
+#include <assert.h>
+#include <algorithm>
+#include <vector>
+#include <math.h>
+#include <string.h>
+
+// The envelope and gains are updated once per sub-block and ramped linearly in between.
+#define SYNTH_BLOCK_SIZE 32
+// Maximum pitch shift up, this limits the number of source samples per sub-block.
+#define SYNTH_MAX_STEP 16
+#define SYNTH_SOURCE_SIZE (SYNTH_BLOCK_SIZE * SYNTH_MAX_STEP + 2)
+#define SYNTH_CHANNEL_COUNT 16
+#define SYNTH_DRUM_CHANNEL 9
+#define SYNTH_DRUM_BANK 128
+
+enum SynthEnvelopeStage
+{
+	ENV_DELAY = 0,
+	ENV_ATTACK,
+	ENV_HOLD,
+	ENV_DECAY,
+	ENV_SUSTAIN,
+	ENV_RELEASE,
+	ENV_FINISHED,
+};
+
+struct SynthVoice
+{
+	const SoundFontRegion* region;
+	u8  channel;
+	u8  key;
+	u8  stage;
+	u8  sustained;		// The key has been released but the sustain pedal is down.
+	u32 age;			// Note-on counter value when started, used to steal the oldest voice.
+
+	u64 pos;			// Absolute sample position (32.32 fixed point).
+	u64 step;
+	f32 pitch;			// Pitch in semitones relative to the root key, excluding pitch bend.
+	f32 gain;			// Velocity and region attenuation.
+
+	f32 envLevel;
+	f32 envTime;		// Time spent in the current stage.
+	f32 releaseScale;	// Per-second multiplier during release.
+
+	// Gains applied at the end of the previous sub-block.
+	f32 gainLeft;
+	f32 gainRight;
+};
+
+struct SynthChannel
+{
+	const SoundFontPreset* preset;
+	u16 bank;
+	u8  program;
+	u8  sustain;
+	f32 volume;
+	f32 expression;
+	f32 pan;			// [-0.5, 0.5]
+	f32 bend;			// Semitones.
+	s32 bendValue;		// [-8192, 8191]
+	f32 bendRange;		// Semitones.
+	u8  rpnMsb, rpnLsb;
+};
+
+struct MidiSynth
+{
+	const SoundFont* font;
+	u32 sampleRate;
+	u32 maxVoices;
+	u32 noteCounter;
+
+	SynthChannel channels[SYNTH_CHANNEL_COUNT];
+	std::vector<SynthVoice> voices;
+	// Compact list of playing voices followed by the free voices, so allocation and removal are O(1).
+	std::vector<u32> voiceList;
+	u32 activeCount;
+
+	alignas(16) f32 source[SYNTH_SOURCE_SIZE];
+	alignas(16) f32 resampled[SYNTH_BLOCK_SIZE];
+};
+
+namespace TFE_MidiSynth
+{
+	// Headroom so that several loud voices don't immediately saturate the limiter.
+	static const f32 c_synthGain = 0.5f;
+	// -96 dB, the envelope decay and release times are the time to reach this level.
+	static const f32 c_envelopeSilence = 1.58489e-5f;
+	static const f32 c_halfPi = 1.57079632679f;
+
+	void resetChannels(MidiSynth* synth);
+	void noteOn(MidiSynth* synth, u8 channel, u8 key, u8 velocity);
+	void noteOff(MidiSynth* synth, u8 channel, u8 key);
+	void controlChange(MidiSynth* synth, u8 channel, u8 controller, u8 value);
+	void updatePitch(MidiSynth* synth, SynthVoice* voice);
+	void releaseVoice(SynthVoice* voice, f32 releaseTime);
+
+	MidiSynth* create(const SoundFont* font, u32 sampleRate, u32 maxVoices)
+	{
+		if (!font || font->regions.empty() || !sampleRate || !maxVoices) { return nullptr; }
+
+		MidiSynth* synth = new MidiSynth();
+		synth->font = font;
+		synth->sampleRate = sampleRate;
+		synth->maxVoices = maxVoices;
+		synth->noteCounter = 0;
+		synth->voices.resize(maxVoices);
+		synth->voiceList.resize(maxVoices);
+		for (u32 v = 0; v < maxVoices; v++)
+		{
+			synth->voiceList[v] = v;
+		}
+		synth->activeCount = 0;
+		resetChannels(synth);
+		return synth;
+	}
+
+	void destroy(MidiSynth* synth)
+	{
+		delete synth;
+	}
+
+	void reset(MidiSynth* synth)
+	{
+		synth->activeCount = 0;
+		resetChannels(synth);
+	}
+
+	u32 getSampleRate(const MidiSynth* synth)
+	{
+		return synth->sampleRate;
+	}
+
+	u32 getActiveVoiceCount(const MidiSynth* synth)
+	{
+		return synth->activeCount;
+	}
+
+	void sendMessage(MidiSynth* synth, u8 arg0, u8 arg1, u8 arg2)
+	{
+		const u8 channel = arg0 & 0x0f;
+		switch (arg0 & 0xf0)
+		{
+			case MID_NOTE_OFF:
+			{
+				noteOff(synth, channel, arg1);
+			} break;
+			case MID_NOTE_ON:
+			{
+				if (arg2) { noteOn(synth, channel, arg1, arg2); }
+				else { noteOff(synth, channel, arg1); }
+			} break;
+			case MID_CONTROL_CHANGE:
+			{
+				controlChange(synth, channel, arg1, arg2);
+			} break;
+			case MID_PROGRAM_CHANGE:
+			{
+				SynthChannel* chan = &synth->channels[channel];
+				chan->program = arg1;
+				chan->preset = nullptr;
+			} break;
+			case MID_PITCH_BEND:
+			{
+				SynthChannel* chan = &synth->channels[channel];
+				chan->bendValue = s32(arg1 | (arg2 << 7)) - 8192;
+				chan->bend = f32(chan->bendValue) / 8192.0f * chan->bendRange;
+				for (u32 i = 0; i < synth->activeCount; i++)
+				{
+					SynthVoice* voice = &synth->voices[synth->voiceList[i]];
+					if (voice->channel == channel) { updatePitch(synth, voice); }
+				}
+			} break;
+		}
+	}
+
+	////////////////////////////////////////
+	//////////// Channels //////////////////
+	////////////////////////////////////////
+	void resetController(SynthChannel* chan)
+	{
+		chan->sustain = 0;
+		chan->expression = 1.0f;
+		chan->bend = 0.0f;
+		chan->bendValue = 0;
+		chan->rpnMsb = 0x7f;
+		chan->rpnLsb = 0x7f;
+	}
+
+	void resetChannels(MidiSynth* synth)
+	{
+		for (u32 c = 0; c < SYNTH_CHANNEL_COUNT; c++)
+		{
+			SynthChannel* chan = &synth->channels[c];
+			chan->preset = nullptr;
+			chan->bank = 0;
+			chan->program = 0;
+			chan->volume = (100.0f * 100.0f) / (127.0f * 127.0f);
+			chan->pan = 0.0f;
+			chan->bendRange = 2.0f;
+			resetController(chan);
+		}
+	}
+
+	// Find the preset lazily, so bank and program changes in any order work.
+	const SoundFontPreset* getChannelPreset(MidiSynth* synth, u8 channel)
+	{
+		SynthChannel* chan = &synth->channels[channel];
+		if (chan->preset) { return chan->preset; }
+
+		const SoundFont* font = synth->font;
+		const u32 bank = channel == SYNTH_DRUM_CHANNEL ? SYNTH_DRUM_BANK : chan->bank;
+		const SoundFontPreset* preset = TFE_SoundFont::getPreset(font, bank, chan->program);
+		// Fallback to the General Midi bank (or the standard drum kit) if the variation doesn't exist.
+		if (!preset) { preset = TFE_SoundFont::getPreset(font, bank == SYNTH_DRUM_BANK ? SYNTH_DRUM_BANK : 0, bank == SYNTH_DRUM_BANK ? 0 : chan->program); }
+		if (!preset && bank != SYNTH_DRUM_BANK) { preset = &font->presets[0]; }
+
+		chan->preset = preset;
+		return preset;
+	}
+
+	void controlChange(MidiSynth* synth, u8 channel, u8 controller, u8 value)
+	{
+		SynthChannel* chan = &synth->channels[channel];
+		switch (controller)
+		{
+			case MID_BANK_SELECT_MSB:
+			{
+				chan->bank = value;
+				chan->preset = nullptr;
+			} break;
+			case MID_VOLUME_MSB:
+			{
+				// Midi volume is roughly a squared curve.
+				chan->volume = f32(value * value) / (127.0f * 127.0f);
+			} break;
+			case MID_EXPRESSION_MSB:
+			{
+				chan->expression = f32(value * value) / (127.0f * 127.0f);
+			} break;
+			case MID_PAN_MSB:
+			{
+				chan->pan = f32(s32(value) - 64) / 128.0f;
+			} break;
+			case MID_SUSTAIN_SWITCH:
+			{
+				chan->sustain = value >= 64 ? 1 : 0;
+				if (chan->sustain) { break; }
+				// Release notes held by the pedal.
+				for (u32 i = 0; i < synth->activeCount; i++)
+				{
+					SynthVoice* voice = &synth->voices[synth->voiceList[i]];
+					if (voice->channel == channel && voice->sustained)
+					{
+						releaseVoice(voice, voice->region->release);
+					}
+				}
+			} break;
+			case MID_RPN_MSB:
+			{
+				chan->rpnMsb = value;
+			} break;
+			case MID_RPN_LSB:
+			{
+				chan->rpnLsb = value;
+			} break;
+			case MID_DATA_ENTRY_MSB:
+			{
+				// RPN 0 is the pitch bend range.
+				if (chan->rpnMsb == 0 && chan->rpnLsb == 0)
+				{
+					chan->bendRange = f32(value);
+					chan->bend = f32(chan->bendValue) / 8192.0f * chan->bendRange;
+				}
+			} break;
+			case MID_ALL_SOUND_OFF:
+			{
+				for (u32 i = 0; i < synth->activeCount; i++)
+				{
+					SynthVoice* voice = &synth->voices[synth->voiceList[i]];
+					if (voice->channel == channel) { voice->stage = ENV_FINISHED; }
+				}
+			} break;
+			case MID_ALL_CTRL_OFF:
+			{
+				resetController(chan);
+			} break;
+			case MID_ALL_NOTES_OFF:
+			{
+				for (u32 i = 0; i < synth->activeCount; i++)
+				{
+					SynthVoice* voice = &synth->voices[synth->voiceList[i]];
+					if (voice->channel == channel) { releaseVoice(voice, voice->region->release); }
+				}
+			} break;
+		}
+	}
+
+	////////////////////////////////////////
+	//////////// Voices ////////////////////
+	////////////////////////////////////////
+	void updatePitch(MidiSynth* synth, SynthVoice* voice)
+	{
+		const f32 semitones = voice->pitch + synth->channels[voice->channel].bend;
+		const f64 ratio = pow(2.0, f64(semitones) / 12.0) * f64(voice->region->sampleRate) / f64(synth->sampleRate);
+		voice->step = u64(std::min(ratio, f64(SYNTH_MAX_STEP)) * 4294967296.0);
+	}
+
+	void releaseVoice(SynthVoice* voice, f32 releaseTime)
+	{
+		if (voice->stage >= ENV_RELEASE) { return; }
+		voice->stage = ENV_RELEASE;
+		voice->sustained = 0;
+		voice->envTime = 0.0f;
+		voice->releaseScale = powf(c_envelopeSilence, 1.0f / std::max(releaseTime, 0.001f));
+	}
+
+	SynthVoice* allocateVoice(MidiSynth* synth)
+	{
+		if (synth->activeCount < synth->maxVoices)
+		{
+			return &synth->voices[synth->voiceList[synth->activeCount++]];
+		}
+
+		// Steal the quietest released voice, otherwise the oldest voice.
+		SynthVoice* steal = nullptr;
+		f32 quietest = 2.0f;
+		for (u32 i = 0; i < synth->activeCount; i++)
+		{
+			SynthVoice* voice = &synth->voices[synth->voiceList[i]];
+			if (voice->stage >= ENV_RELEASE && voice->envLevel < quietest)
+			{
+				quietest = voice->envLevel;
+				steal = voice;
+			}
+		}
+		if (!steal)
+		{
+			u32 oldest = 0;
+			for (u32 i = 0; i < synth->activeCount; i++)
+			{
+				SynthVoice* voice = &synth->voices[synth->voiceList[i]];
+				const u32 age = synth->noteCounter - voice->age;
+				if (!steal || age > oldest)
+				{
+					oldest = age;
+					steal = voice;
+				}
+			}
+		}
+		return steal;
+	}
+
+	void noteOn(MidiSynth* synth, u8 channel, u8 key, u8 velocity)
+	{
+		const SoundFontPreset* preset = getChannelPreset(synth, channel);
+		if (!preset) { return; }
+
+		// Retriggering a key releases the previous note.
+		noteOff(synth, channel, key);
+
+		const SoundFontRegion* region = &synth->font->regions[preset->firstRegion];
+		for (u32 r = 0; r < preset->regionCount; r++, region++)
+		{
+			if (key < region->keyLo || key > region->keyHi || velocity < region->velLo || velocity > region->velHi) { continue; }
+
+			// Exclusive classes (such as open and closed hi-hats) cut each other off.
+			if (region->exclusiveClass)
+			{
+				for (u32 i = 0; i < synth->activeCount; i++)
+				{
+					SynthVoice* voice = &synth->voices[synth->voiceList[i]];
+					if (voice->channel == channel && voice->region->exclusiveClass == region->exclusiveClass)
+					{
+						releaseVoice(voice, 0.005f);
+					}
+				}
+			}
+
+			SynthVoice* voice = allocateVoice(synth);
+			voice->region = region;
+			voice->channel = channel;
+			voice->key = key;
+			voice->stage = ENV_DELAY;
+			voice->sustained = 0;
+			voice->age = synth->noteCounter++;
+			voice->pos = u64(region->start) << 32ull;
+			voice->pitch = f32(s32(key) - region->rootKey) * region->scaleTuning + region->tune;
+			voice->gain = region->attenuation * f32(velocity * velocity) / (127.0f * 127.0f);
+			voice->envLevel = 0.0f;
+			voice->envTime = 0.0f;
+			voice->releaseScale = 0.0f;
+			voice->gainLeft = 0.0f;
+			voice->gainRight = 0.0f;
+			updatePitch(synth, voice);
+		}
+	}
+
+	void noteOff(MidiSynth* synth, u8 channel, u8 key)
+	{
+		const bool sustain = synth->channels[channel].sustain != 0;
+		for (u32 i = 0; i < synth->activeCount; i++)
+		{
+			SynthVoice* voice = &synth->voices[synth->voiceList[i]];
+			if (voice->channel != channel || voice->key != key || voice->stage >= ENV_RELEASE || voice->sustained) { continue; }
+
+			if (sustain) { voice->sustained = 1; }
+			else { releaseVoice(voice, voice->region->release); }
+		}
+	}
+
+	// Advance the envelope by 'dt' seconds and return the new level.
+	f32 updateEnvelope(SynthVoice* voice, f32 dt)
+	{
+		const SoundFontRegion* region = voice->region;
+		voice->envTime += dt;
+		switch (voice->stage)
+		{
+			case ENV_DELAY:
+			{
+				if (voice->envTime < region->delay) { break; }
+				voice->envTime -= region->delay;
+				voice->stage = ENV_ATTACK;
+			} // Fall through
+			case ENV_ATTACK:
+			{
+				if (voice->envTime < region->attack)
+				{
+					voice->envLevel = voice->envTime / region->attack;
+					break;
+				}
+				voice->envTime -= region->attack;
+				voice->envLevel = 1.0f;
+				voice->stage = ENV_HOLD;
+			} // Fall through
+			case ENV_HOLD:
+			{
+				if (voice->envTime < region->hold) { break; }
+				voice->envTime -= region->hold;
+				voice->stage = ENV_DECAY;
+			} // Fall through
+			case ENV_DECAY:
+			{
+				// Exponential decay towards the sustain level, 'decay' is the time to reach -96 dB.
+				voice->envLevel = powf(c_envelopeSilence, voice->envTime / std::max(region->decay, 0.001f));
+				if (voice->envLevel > region->sustain) { break; }
+				voice->envLevel = region->sustain;
+				voice->stage = ENV_SUSTAIN;
+			} // Fall through
+			case ENV_SUSTAIN:
+			{
+				if (voice->envLevel <= c_envelopeSilence) { voice->stage = ENV_FINISHED; }
+			} break;
+			case ENV_RELEASE:
+			{
+				voice->envLevel *= powf(voice->releaseScale, dt);
+				if (voice->envLevel <= c_envelopeSilence) { voice->stage = ENV_FINISHED; }
+			} break;
+		}
+		return voice->stage == ENV_FINISHED ? 0.0f : voice->envLevel;
+	}
+
+	bool isVoiceLooping(const SynthVoice* voice)
+	{
+		const u32 loopMode = voice->region->loopMode;
+		return loopMode == SF_LOOP_CONTINUOUS || (loopMode == SF_LOOP_UNTIL_RELEASE && voice->stage < ENV_RELEASE);
+	}
+
+	// Copy 'count' source samples starting at 'index', wrapping at the loop end or padding with silence at the end of the sample.
+	void gatherSamples(const MidiSynth* synth, const SynthVoice* voice, u32 index, u32 count, f32* out)
+	{
+		const SoundFontRegion* region = voice->region;
+		const f32* samples = synth->font->samples.data();
+		const bool looping = isVoiceLooping(voice);
+		const u32 end = looping ? region->loopEnd : region->end;
+
+		while (count)
+		{
+			if (index >= end)
+			{
+				if (!looping)
+				{
+					memset(out, 0, sizeof(f32) * count);
+					return;
+				}
+				index = region->loopStart + (index - region->loopStart) % (region->loopEnd - region->loopStart);
+			}
+			const u32 copyCount = std::min(count, end - index);
+			memcpy(out, samples + index, sizeof(f32) * copyCount);
+			out += copyCount;
+			index += copyCount;
+			count -= copyCount;
+		}
+	}
+
+	// Render up to SYNTH_BLOCK_SIZE frames, returns false when the voice has finished.
+	bool renderVoice(MidiSynth* synth, SynthVoice* voice, u32 count, f32* left, f32* right)
+	{
+		const SoundFontRegion* region = voice->region;
+		const SynthChannel* chan = &synth->channels[voice->channel];
+
+		// Target gains at the end of the sub-block.
+		const f32 level = updateEnvelope(voice, f32(count) / f32(synth->sampleRate));
+		const f32 pan = std::max(-0.5f, std::min(region->pan + chan->pan, 0.5f));
+		const f32 gain = level * voice->gain * chan->volume * chan->expression * c_synthGain;
+		const f32 gainLeft  = gain * cosf((pan + 0.5f) * c_halfPi);
+		const f32 gainRight = gain * sinf((pan + 0.5f) * c_halfPi);
+
+		// Linear interpolation reads one sample past the last position.
+		const u32 index = u32(voice->pos >> 32ull);
+		const u32 frac  = u32(voice->pos & 0xffffffffull);
+		const u64 endPos = u64(frac) + voice->step * u64(count);
+		const u32 sourceCount = u32((endPos - voice->step) >> 32ull) + 2;
+		assert(sourceCount <= SYNTH_SOURCE_SIZE);
+		gatherSamples(synth, voice, index, sourceCount, synth->source);
+		TFE_AudioMixer::resample(TFE_RESAMPLER_LINEAR, synth->source, frac, voice->step, count, synth->resampled);
+
+		const f32 scale = 1.0f / f32(count);
+		TFE_AudioMixer::accumulateRamp(synth->resampled, count, voice->gainLeft, voice->gainRight,
+			(gainLeft - voice->gainLeft) * scale, (gainRight - voice->gainRight) * scale, left, right);
+		voice->gainLeft  = gainLeft;
+		voice->gainRight = gainRight;
+
+		// Advance the sample position.
+		u64 newIndex = u64(index) + (endPos >> 32ull);
+		if (isVoiceLooping(voice))
+		{
+			if (newIndex >= region->loopEnd)
+			{
+				newIndex = region->loopStart + (newIndex - region->loopStart) % (region->loopEnd - region->loopStart);
+			}
+		}
+		else if (newIndex >= region->end)
+		{
+			return false;
+		}
+		voice->pos = (newIndex << 32ull) | (endPos & 0xffffffffull);
+		return voice->stage != ENV_FINISHED;
+	}
+
+	void render(MidiSynth* synth, f32* left, f32* right, u32 frameCount)
+	{
+		for (u32 frame = 0; frame < frameCount; frame += SYNTH_BLOCK_SIZE)
+		{
+			const u32 count = std::min(frameCount - frame, (u32)SYNTH_BLOCK_SIZE);
+			for (u32 i = 0; i < synth->activeCount;)
+			{
+				SynthVoice* voice = &synth->voices[synth->voiceList[i]];
+				if (voice->stage == ENV_FINISHED || !renderVoice(synth, voice, count, left + frame, right + frame))
+				{
+					// Swap with the last active voice, which moves this voice to the front of the free list.
+					synth->activeCount--;
+					std::swap(synth->voiceList[i], synth->voiceList[synth->activeCount]);
+					continue;
+				}
+				i++;
+			}
+		}
+	}
+}
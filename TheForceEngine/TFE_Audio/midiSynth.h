@@ -0,0 +1,32 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Software Midi Synthesizer
+// Renders midi messages using a SoundFont, so music can be played
+// without a system midi device and rendered offline.
+//
+// The synthesizer is not thread safe, messages must be sent from the
+// same thread that calls render(). The midi player does this by
+// sequencing from the audio callback, which also makes the event
+// timing sample accurate.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+struct SoundFont;
+struct MidiSynth;
+
+namespace TFE_MidiSynth
+{
+	// Voices beyond 'maxVoices' steal the quietest released voice, or the oldest voice if none are released.
+	MidiSynth* create(const SoundFont* font, u32 sampleRate, u32 maxVoices);
+	void destroy(MidiSynth* synth);
+
+	void sendMessage(MidiSynth* synth, u8 arg0, u8 arg1, u8 arg2 = 0);
+	// Stop all voices immediately and reset the channel state.
+	void reset(MidiSynth* synth);
+
+	// Render 'frameCount' frames, the output is added to 'left' and 'right'.
+	void render(MidiSynth* synth, f32* left, f32* right, u32 frameCount);
+
+	u32 getSampleRate(const MidiSynth* synth);
+	u32 getActiveVoiceCount(const MidiSynth* synth);
+}
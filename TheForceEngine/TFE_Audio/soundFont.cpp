@@ -0,0 +1,438 @@
+#include "soundFont.h"
+#include <TFE_System/system.h>
+#include <TFE_FileSystem/filestream.h>
+#include <assert.h>
+#include <algorithm>
+#include <string.h>
+#include <math.h>
+
+namespace TFE_SoundFont
+{
+	// Generators, the values match the SoundFont 2.01 specification.
+	enum Generator
+	{
+		GEN_START_OFFSET = 0,
+		GEN_END_OFFSET = 1,
+		GEN_LOOP_START_OFFSET = 2,
+		GEN_LOOP_END_OFFSET = 3,
+		GEN_START_COARSE_OFFSET = 4,
+		GEN_END_COARSE_OFFSET = 12,
+		GEN_PAN = 17,
+		GEN_DELAY_VOL_ENV = 33,
+		GEN_ATTACK_VOL_ENV = 34,
+		GEN_HOLD_VOL_ENV = 35,
+		GEN_DECAY_VOL_ENV = 36,
+		GEN_SUSTAIN_VOL_ENV = 37,
+		GEN_RELEASE_VOL_ENV = 38,
+		GEN_INSTRUMENT = 41,
+		GEN_KEY_RANGE = 43,
+		GEN_VEL_RANGE = 44,
+		GEN_LOOP_START_COARSE_OFFSET = 45,
+		GEN_INITIAL_ATTENUATION = 48,
+		GEN_LOOP_END_COARSE_OFFSET = 50,
+		GEN_COARSE_TUNE = 51,
+		GEN_FINE_TUNE = 52,
+		GEN_SAMPLE_ID = 53,
+		GEN_SAMPLE_MODES = 54,
+		GEN_SCALE_TUNING = 56,
+		GEN_EXCLUSIVE_CLASS = 57,
+		GEN_OVERRIDING_ROOT_KEY = 58,
+		GEN_COUNT = 61
+	};
+
+	// Sample type flag for samples stored in ROM rather than the file.
+	#define SF_SAMPLE_ROM 0x8000
+	// The specification requires at least 46 zero samples after each sample, this pads the end of the data in the same way.
+	#define SF_SAMPLE_PADDING 46
+
+	#pragma pack(push)
+	#pragma pack(1)
+	struct SfPresetHeader
+	{
+		char name[20];
+		u16 preset;
+		u16 bank;
+		u16 bagIndex;
+		u32 library;
+		u32 genre;
+		u32 morphology;
+	};
+
+	struct SfBag
+	{
+		u16 genIndex;
+		u16 modIndex;
+	};
+
+	struct SfGenerator
+	{
+		u16 oper;
+		union
+		{
+			s16 amount;
+			u16 uAmount;
+			struct { u8 lo, hi; } range;
+		};
+	};
+
+	struct SfInstrument
+	{
+		char name[20];
+		u16 bagIndex;
+	};
+
+	struct SfSampleHeader
+	{
+		char name[20];
+		u32 start;
+		u32 end;
+		u32 loopStart;
+		u32 loopEnd;
+		u32 sampleRate;
+		u8  originalPitch;
+		s8  pitchCorrection;
+		u16 sampleLink;
+		u16 sampleType;
+	};
+	#pragma pack(pop)
+
+	// Raw chunk data while loading.
+	struct SfChunks
+	{
+		const s16* smpl = nullptr;
+		u32 smplCount = 0;
+
+		const SfPresetHeader* phdr = nullptr;
+		const SfBag* pbag = nullptr;
+		const SfGenerator* pgen = nullptr;
+		const SfInstrument* inst = nullptr;
+		const SfBag* ibag = nullptr;
+		const SfGenerator* igen = nullptr;
+		const SfSampleHeader* shdr = nullptr;
+		u32 phdrCount = 0, pbagCount = 0, pgenCount = 0;
+		u32 instCount = 0, ibagCount = 0, igenCount = 0;
+		u32 shdrCount = 0;
+	};
+
+	// A zone's generators, 'set' tracks which have been specified.
+	struct ZoneGenerators
+	{
+		s32 value[GEN_COUNT];
+		bool set[GEN_COUNT];
+	};
+
+	static u32 s_romSampleCount;
+
+	void parseChunks(const u8* data, const u8* end, SfChunks* chunks);
+	void buildPreset(const SfChunks* chunks, u32 presetIndex, SoundFont* font);
+
+	bool load(const char* path, SoundFont* font)
+	{
+		FileStream file;
+		if (!file.open(path, FileStream::MODE_READ))
+		{
+			TFE_System::logWrite(LOG_ERROR, "SoundFont", "Cannot open SoundFont \"%s\"", path);
+			return false;
+		}
+		std::vector<u8> buffer(file.getSize());
+		file.readBuffer(buffer.data(), (u32)buffer.size());
+		file.close();
+
+		const u8* data = buffer.data();
+		if (buffer.size() < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "sfbk", 4) != 0)
+		{
+			TFE_System::logWrite(LOG_ERROR, "SoundFont", "\"%s\" is not a valid SoundFont 2 file.", path);
+			return false;
+		}
+
+		SfChunks chunks;
+		parseChunks(data + 12, data + buffer.size(), &chunks);
+		if (chunks.phdrCount < 2 || chunks.instCount < 2 || chunks.shdrCount < 2 || !chunks.pbag || !chunks.pgen || !chunks.ibag || !chunks.igen)
+		{
+			TFE_System::logWrite(LOG_ERROR, "SoundFont", "\"%s\" is missing preset data.", path);
+			return false;
+		}
+
+		// Convert the samples to float.
+		font->samples.resize(chunks.smplCount + SF_SAMPLE_PADDING);
+		for (u32 i = 0; i < chunks.smplCount; i++)
+		{
+			font->samples[i] = f32(chunks.smpl[i]) * (1.0f / 32768.0f);
+		}
+		for (u32 i = chunks.smplCount; i < chunks.smplCount + SF_SAMPLE_PADDING; i++)
+		{
+			font->samples[i] = 0.0f;
+		}
+
+		// The last header is the terminal record.
+		s_romSampleCount = 0;
+		font->presets.clear();
+		font->regions.clear();
+		for (u32 p = 0; p < chunks.phdrCount - 1; p++)
+		{
+			buildPreset(&chunks, p, font);
+		}
+
+		if (s_romSampleCount)
+		{
+			TFE_System::logWrite(LOG_WARNING, "SoundFont", "\"%s\" references %u ROM sample zones, which are not supported and will be silent.", path, s_romSampleCount);
+		}
+		if (font->regions.empty())
+		{
+			TFE_System::logWrite(LOG_ERROR, "SoundFont", "\"%s\" contains no playable samples.", path);
+			free(font);
+			return false;
+		}
+
+		TFE_System::logWrite(LOG_MSG, "SoundFont", "Loaded \"%s\": %u presets, %u regions, %u samples.", path, (u32)font->presets.size(), (u32)font->regions.size(), chunks.smplCount);
+		return true;
+	}
+
+	void free(SoundFont* font)
+	{
+		font->samples.clear();
+		font->presets.clear();
+		font->regions.clear();
+	}
+
+	const SoundFontPreset* getPreset(const SoundFont* font, u32 bank, u32 program)
+	{
+		const size_t count = font->presets.size();
+		const SoundFontPreset* preset = font->presets.data();
+		for (size_t i = 0; i < count; i++, preset++)
+		{
+			if (preset->bank == bank && preset->program == program)
+			{
+				return preset;
+			}
+		}
+		return nullptr;
+	}
+
+	////////////////////////////////////////
+	//////////// Internal //////////////////
+	////////////////////////////////////////
+	u32 readU32(const u8* data)
+	{
+		return data[0] | (data[1] << 8u) | (data[2] << 16u) | (data[3] << 24u);
+	}
+
+	template <typename T>
+	void setChunk(const u8* data, u32 size, const T** ptr, u32* count)
+	{
+		*ptr = (const T*)data;
+		*count = size / sizeof(T);
+	}
+
+	void parseChunks(const u8* data, const u8* end, SfChunks* chunks)
+	{
+		while (data + 8 <= end)
+		{
+			const u8* id = data;
+			const u32 size = readU32(data + 4);
+			const u8* chunkData = data + 8;
+			if (chunkData + size > end) { break; }
+
+			if (memcmp(id, "LIST", 4) == 0)
+			{
+				// Skip the list type (INFO, sdta, pdta) and parse the sub-chunks.
+				parseChunks(chunkData + 4, chunkData + size, chunks);
+			}
+			else if (memcmp(id, "smpl", 4) == 0) { setChunk(chunkData, size, &chunks->smpl, &chunks->smplCount); }
+			else if (memcmp(id, "phdr", 4) == 0) { setChunk(chunkData, size, &chunks->phdr, &chunks->phdrCount); }
+			else if (memcmp(id, "pbag", 4) == 0) { setChunk(chunkData, size, &chunks->pbag, &chunks->pbagCount); }
+			else if (memcmp(id, "pgen", 4) == 0) { setChunk(chunkData, size, &chunks->pgen, &chunks->pgenCount); }
+			else if (memcmp(id, "inst", 4) == 0) { setChunk(chunkData, size, &chunks->inst, &chunks->instCount); }
+			else if (memcmp(id, "ibag", 4) == 0) { setChunk(chunkData, size, &chunks->ibag, &chunks->ibagCount); }
+			else if (memcmp(id, "igen", 4) == 0) { setChunk(chunkData, size, &chunks->igen, &chunks->igenCount); }
+			else if (memcmp(id, "shdr", 4) == 0) { setChunk(chunkData, size, &chunks->shdr, &chunks->shdrCount); }
+
+			// Chunks are padded to an even size.
+			data = chunkData + size + (size & 1);
+		}
+	}
+
+	void setInstrumentDefaults(ZoneGenerators* gen)
+	{
+		memset(gen, 0, sizeof(ZoneGenerators));
+		gen->value[GEN_DELAY_VOL_ENV]   = -12000;
+		gen->value[GEN_ATTACK_VOL_ENV]  = -12000;
+		gen->value[GEN_HOLD_VOL_ENV]    = -12000;
+		gen->value[GEN_DECAY_VOL_ENV]   = -12000;
+		gen->value[GEN_RELEASE_VOL_ENV] = -12000;
+		gen->value[GEN_KEY_RANGE] = 127 << 8;
+		gen->value[GEN_VEL_RANGE] = 127 << 8;
+		gen->value[GEN_SCALE_TUNING] = 100;
+		gen->value[GEN_OVERRIDING_ROOT_KEY] = -1;
+	}
+
+	void setPresetDefaults(ZoneGenerators* gen)
+	{
+		// Preset generators are relative, so everything starts at zero except for the ranges.
+		memset(gen, 0, sizeof(ZoneGenerators));
+		gen->value[GEN_KEY_RANGE] = 127 << 8;
+		gen->value[GEN_VEL_RANGE] = 127 << 8;
+	}
+
+	// Apply the generators from a bag range, returns true if the zone contains the terminal generator 'terminal'.
+	bool applyZone(const SfGenerator* gens, u32 genCount, u32 first, u32 last, u16 terminal, ZoneGenerators* out)
+	{
+		bool hasTerminal = false;
+		for (u32 g = first; g < last && g < genCount; g++)
+		{
+			const u16 oper = gens[g].oper;
+			if (oper >= GEN_COUNT) { continue; }
+
+			if (oper == GEN_KEY_RANGE || oper == GEN_VEL_RANGE)
+			{
+				out->value[oper] = gens[g].range.lo | (gens[g].range.hi << 8);
+			}
+			else if (oper == GEN_SAMPLE_ID || oper == GEN_INSTRUMENT || oper == GEN_SAMPLE_MODES)
+			{
+				out->value[oper] = gens[g].uAmount;
+			}
+			else
+			{
+				out->value[oper] = gens[g].amount;
+			}
+			out->set[oper] = true;
+			hasTerminal |= (oper == terminal);
+		}
+		return hasTerminal;
+	}
+
+	f32 timecentsToSeconds(s32 timecents)
+	{
+		return powf(2.0f, f32(timecents) / 1200.0f);
+	}
+
+	f32 centibelsToGain(s32 centibels)
+	{
+		return powf(10.0f, -f32(std::max(centibels, 0)) / 200.0f);
+	}
+
+	void addRegion(const SfChunks* chunks, const ZoneGenerators* inst, const ZoneGenerators* preset, SoundFont* font)
+	{
+		const u32 sampleId = inst->value[GEN_SAMPLE_ID];
+		// The last sample header is the terminal record.
+		if (sampleId >= chunks->shdrCount - 1) { return; }
+		const SfSampleHeader* sample = &chunks->shdr[sampleId];
+		if (sample->sampleType & SF_SAMPLE_ROM)
+		{
+			s_romSampleCount++;
+			return;
+		}
+
+		// Key and velocity ranges are the intersection of the preset and instrument ranges.
+		SoundFontRegion region;
+		region.keyLo = (u8)std::max(inst->value[GEN_KEY_RANGE] & 0xff, preset->value[GEN_KEY_RANGE] & 0xff);
+		region.keyHi = (u8)std::min(inst->value[GEN_KEY_RANGE] >> 8,   preset->value[GEN_KEY_RANGE] >> 8);
+		region.velLo = (u8)std::max(inst->value[GEN_VEL_RANGE] & 0xff, preset->value[GEN_VEL_RANGE] & 0xff);
+		region.velHi = (u8)std::min(inst->value[GEN_VEL_RANGE] >> 8,   preset->value[GEN_VEL_RANGE] >> 8);
+		if (region.keyLo > region.keyHi || region.velLo > region.velHi) { return; }
+
+		// Everything else is the instrument value plus the preset offset.
+		s32 gen[GEN_COUNT];
+		for (u32 g = 0; g < GEN_COUNT; g++)
+		{
+			gen[g] = inst->value[g] + preset->value[g];
+		}
+
+		// Sample addresses are only valid at the instrument level.
+		const s64 start     = s64(sample->start)     + inst->value[GEN_START_OFFSET]      + 32768 * inst->value[GEN_START_COARSE_OFFSET];
+		const s64 end       = s64(sample->end)       + inst->value[GEN_END_OFFSET]        + 32768 * inst->value[GEN_END_COARSE_OFFSET];
+		const s64 loopStart = s64(sample->loopStart) + inst->value[GEN_LOOP_START_OFFSET] + 32768 * inst->value[GEN_LOOP_START_COARSE_OFFSET];
+		const s64 loopEnd   = s64(sample->loopEnd)   + inst->value[GEN_LOOP_END_OFFSET]   + 32768 * inst->value[GEN_LOOP_END_COARSE_OFFSET];
+		if (start < 0 || end <= start || end > s64(chunks->smplCount) || !sample->sampleRate) { return; }
+
+		region.start = u32(start);
+		region.end   = u32(end);
+		region.loopMode = inst->value[GEN_SAMPLE_MODES] & 3;
+		// Mode 2 is "unused" and treated as no loop.
+		if (region.loopMode == 2 || loopStart < start || loopEnd > end || loopEnd <= loopStart)
+		{
+			region.loopMode = SF_LOOP_NONE;
+		}
+		region.loopStart = u32(std::max(loopStart, start));
+		region.loopEnd   = u32(std::min(loopEnd, end));
+		region.sampleRate = sample->sampleRate;
+		region.exclusiveClass = inst->value[GEN_EXCLUSIVE_CLASS];
+
+		region.rootKey = inst->value[GEN_OVERRIDING_ROOT_KEY] >= 0 ? inst->value[GEN_OVERRIDING_ROOT_KEY] : sample->originalPitch;
+		region.scaleTuning = f32(gen[GEN_SCALE_TUNING]) / 100.0f;
+		region.tune = f32(gen[GEN_COARSE_TUNE]) + f32(gen[GEN_FINE_TUNE] + sample->pitchCorrection) / 100.0f;
+
+		region.attenuation = centibelsToGain(gen[GEN_INITIAL_ATTENUATION]);
+		region.pan = std::max(-0.5f, std::min(f32(gen[GEN_PAN]) / 1000.0f, 0.5f));
+
+		region.delay   = timecentsToSeconds(gen[GEN_DELAY_VOL_ENV]);
+		region.attack  = timecentsToSeconds(gen[GEN_ATTACK_VOL_ENV]);
+		region.hold    = timecentsToSeconds(gen[GEN_HOLD_VOL_ENV]);
+		region.decay   = timecentsToSeconds(gen[GEN_DECAY_VOL_ENV]);
+		region.sustain = centibelsToGain(gen[GEN_SUSTAIN_VOL_ENV]);
+		region.release = timecentsToSeconds(gen[GEN_RELEASE_VOL_ENV]);
+
+		font->regions.push_back(region);
+	}
+
+	void buildInstrument(const SfChunks* chunks, u32 instIndex, const ZoneGenerators* preset, SoundFont* font)
+	{
+		// The last instrument is the terminal record.
+		if (instIndex >= chunks->instCount - 1) { return; }
+		const u32 firstBag = chunks->inst[instIndex].bagIndex;
+		const u32 lastBag  = std::min((u32)chunks->inst[instIndex + 1].bagIndex, chunks->ibagCount - 1);
+
+		ZoneGenerators global;
+		setInstrumentDefaults(&global);
+		for (u32 b = firstBag; b < lastBag; b++)
+		{
+			ZoneGenerators zone = global;
+			const bool hasSample = applyZone(chunks->igen, chunks->igenCount, chunks->ibag[b].genIndex, chunks->ibag[b + 1].genIndex, GEN_SAMPLE_ID, &zone);
+			if (hasSample)
+			{
+				addRegion(chunks, &zone, preset, font);
+			}
+			else if (b == firstBag)
+			{
+				// The first zone without a sample is the global zone.
+				global = zone;
+			}
+		}
+	}
+
+	void buildPreset(const SfChunks* chunks, u32 presetIndex, SoundFont* font)
+	{
+		const SfPresetHeader* header = &chunks->phdr[presetIndex];
+		const u32 firstBag = header->bagIndex;
+		const u32 lastBag  = std::min((u32)chunks->phdr[presetIndex + 1].bagIndex, chunks->pbagCount - 1);
+
+		SoundFontPreset preset;
+		memcpy(preset.name, header->name, 20);
+		preset.name[20] = 0;
+		preset.bank = header->bank;
+		preset.program = header->preset;
+		preset.firstRegion = (u32)font->regions.size();
+
+		ZoneGenerators global;
+		setPresetDefaults(&global);
+		for (u32 b = firstBag; b < lastBag; b++)
+		{
+			ZoneGenerators zone = global;
+			const bool hasInstrument = applyZone(chunks->pgen, chunks->pgenCount, chunks->pbag[b].genIndex, chunks->pbag[b + 1].genIndex, GEN_INSTRUMENT, &zone);
+			if (hasInstrument)
+			{
+				buildInstrument(chunks, zone.value[GEN_INSTRUMENT], &zone, font);
+			}
+			else if (b == firstBag)
+			{
+				global = zone;
+			}
+		}
+
+		preset.regionCount = (u32)font->regions.size() - preset.firstRegion;
+		if (preset.regionCount)
+		{
+			font->presets.push_back(preset);
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine SoundFont 2 loader
+// Loads SoundFont 2 (.sf2) files for the software synthesizer.
+// Preset and instrument zones are flattened into regions at load time
+// so that note-on only has to find the matching regions.
+//
+// Only samples stored in the file are supported, ROM samples
+// (such as the AWE32 "1MGM" ROM referenced by SYNTHGM.sf2) are skipped.
+// Modulators and the filter generators are currently ignored.
+//////////////////////////////////////////////////////////////////////
+
+#include <TFE_System/types.h>
+#include <vector>
+
+enum SoundFontLoopMode
+{
+	SF_LOOP_NONE = 0,
+	SF_LOOP_CONTINUOUS,		// Loop until the voice is finished.
+	SF_LOOP_UNTIL_RELEASE,	// Loop until the key is released, then play to the end of the sample.
+};
+
+struct SoundFontRegion
+{
+	u8  keyLo, keyHi;
+	u8  velLo, velHi;
+
+	// Sample data range, as absolute indices into SoundFont::samples.
+	u32 start, end;
+	u32 loopStart, loopEnd;
+	u32 sampleRate;
+	u32 loopMode;
+	u32 exclusiveClass;
+
+	// Pitch.
+	s32 rootKey;
+	f32 scaleTuning;	// Semitones per key.
+	f32 tune;			// Coarse, fine and sample pitch correction in semitones.
+
+	// Amplitude.
+	f32 attenuation;	// Linear gain.
+	f32 pan;			// [-0.5, 0.5]
+
+	// Volume envelope, times in seconds.
+	f32 delay;
+	f32 attack;
+	f32 hold;
+	f32 decay;
+	f32 sustain;		// Linear gain.
+	f32 release;
+};
+
+struct SoundFontPreset
+{
+	char name[21];
+	u16 bank;
+	u16 program;
+	u32 firstRegion;
+	u32 regionCount;
+};
+
+struct SoundFont
+{
+	// All sample data converted to float, padded with silence so interpolation may read past the end of a sample.
+	std::vector<f32> samples;
+	std::vector<SoundFontPreset> presets;
+	std::vector<SoundFontRegion> regions;
+};
+
+namespace TFE_SoundFont
+{
+	bool load(const char* path, SoundFont* font);
+	void free(SoundFont* font);
+
+	// Returns the preset for bank/program or nullptr if it doesn't exist.
+	const SoundFontPreset* getPreset(const SoundFont* font, u32 bank, u32 program);
+}
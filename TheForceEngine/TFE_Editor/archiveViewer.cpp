@@ -76,6 +76,8 @@ namespace ArchiveViewer
 	static Sprite* s_curSprite = nullptr;
 	static Font* s_curFont = nullptr;
 	static Model* s_curModel = nullptr;
+	// VOC files are streamed from the archive when previewed, so they don't stay in memory.
+	static SoundBuffer* s_vocStream = nullptr;
 	
 	static f32 s_mapZoom = 1.0f;
 	static f32 s_renderCenter[2] = { 0.0f, 0.0f };
@@ -288,6 +290,8 @@ namespace ArchiveViewer
 	void unloadAssets()
 	{
 		TFE_Audio::stopAllSounds();
+		TFE_VocAsset::closeStream(s_vocStream);
+		s_vocStream = nullptr;
 
 		// Free all assets
 		TFE_Palette::freeAll();
@@ -512,7 +516,9 @@ namespace ArchiveViewer
 				else if (strcasecmp(extension, "VOC") == 0 || strcasecmp(extension, "VOIC") == 0)
 				{
 					s_fileType = TYPE_VOC;
-					const SoundBuffer* sound = TFE_VocAsset::get(s_items[s_currentFile]);
+					TFE_VocAsset::closeStream(s_vocStream);
+					s_vocStream = TFE_VocAsset::openStream(s_items[s_currentFile]);
+					const SoundBuffer* sound = s_vocStream ? s_vocStream : TFE_VocAsset::get(s_items[s_currentFile]);
 
 					TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, sound, false);
 				}
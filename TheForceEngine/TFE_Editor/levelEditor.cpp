@@ -4289,6 +4289,7 @@ namespace LevelEditor
 		if (layer != sector->layer)
 		{
 			sector->layer = layer;
+			LevelEditorData::updateSectors();
 			// Adjust layer range.
 			s_levelData->layerMin = std::min(s_levelData->layerMin, (s8)layer);
 			s_levelData->layerMax = std::max(s_levelData->layerMax, (s8)layer);
@@ -14,6 +14,7 @@
 #include <TFE_FileSystem/paths.h>
 #include <TFE_RenderBackend/renderBackend.h>
 #include <TFE_Game/geometry.h>
+#include <TFE_Game/sectorGrid.h>
 #include <TFE_Game/renderCommon.h>
 #include <TFE_System/math.h>
 #include <TFE_System/memoryPool.h>
@@ -32,10 +33,15 @@ namespace LevelEditorData
 	static std::vector<u32> s_textureBuffer;
 
 	static const Palette256* s_pal = nullptr;
+	// Point location acceleration, kept in sync by updateSectors().
+	static SectorGrid s_sectorGrid;
 
 	void convertInfToEditor(const InfData* infData);
 	void convertObjectsToEditor(const LevelObjectData* objData);
 	void determineSectorTypes();
+	void buildSectorGrid();
+	void updateSectorGrid(s32 sectorId);
+	bool pointInSector(s32 sectorId, const Vec2f* pos);
 	EditorInfItem* findInfItem(const EditorSector* sector, s32 wall);
 
 	EditorTexture* getEditorTexture(const char* srcName)
@@ -562,6 +568,7 @@ namespace LevelEditorData
 			triangulateSector(dst, &dst->triangles);
 			dst->needsUpdate = false;
 		}
+		buildSectorGrid();
 
 		convertInfToEditor(infData);
 		convertObjectsToEditor(objData);
@@ -586,6 +593,9 @@ namespace LevelEditorData
 	void updateSectors()
 	{
 		const size_t sectorCount = s_editorLevel.sectors.size();
+		// Sectors have been added or removed, which may also change the sector ids.
+		const bool rebuildGrid = sectorCount != s_sectorGrid.layers.size();
+
 		EditorSector* sector = s_editorLevel.sectors.data();
 		for (size_t s = 0; s < sectorCount; s++, sector++)
 		{
@@ -596,8 +606,19 @@ namespace LevelEditorData
 
 				triangulateSector(sector, &sector->triangles);
 				sector->needsUpdate = false;
+				if (!rebuildGrid) { updateSectorGrid(s32(s)); }
+			}
+			else if (!rebuildGrid && s_sectorGrid.layers[s] != sector->layer)
+			{
+				// The sector layer was changed.
+				updateSectorGrid(s32(s));
 			}
 		}
+
+		if (rebuildGrid)
+		{
+			buildSectorGrid();
+		}
 	}
 
 	s32 loadRuntimeTexture(const char* name, LevelData* output)
@@ -1163,26 +1184,27 @@ namespace LevelEditorData
 	s32 findSector(s32 layer, const Vec2f* pos)
 	{
 		if (s_editorLevel.sectors.empty()) { return -1; }
+		if (s_editorLevel.sectors.size() != s_sectorGrid.layers.size()) { buildSectorGrid(); }
 
-		const s32 sectorCount = (s32)s_editorLevel.sectors.size();
-		const EditorSector* sectors = s_editorLevel.sectors.data();
-
-		for (s32 i = 0; i < sectorCount; i++)
+		// Use the lowest sector id if sectors overlap, which matches searching through the sectors in order.
+		u32 candidateCount;
+		const s32* candidates = TFE_SectorGrid::getCandidates(&s_sectorGrid, layer, pos, &candidateCount);
+		s32 sectorId = -1;
+		for (u32 c = 0; c < candidateCount; c++)
 		{
-			if (sectors[i].layer != layer) { continue; }
-			if (Geometry::pointInSector(pos, (u32)sectors[i].vertices.size(), sectors[i].vertices.data(), (u32)sectors[i].walls.size(), (u8*)sectors[i].walls.data(), sizeof(EditorWall)))
+			if ((sectorId < 0 || candidates[c] < sectorId) && pointInSector(candidates[c], pos))
 			{
-				return i;
+				sectorId = candidates[c];
 			}
 		}
-		return -1;
+		return sectorId;
 	}
 
 	#define HEIGHT_EPS 0.5f
 
 	s32 findSector(const Vec3f* pos)
 	{
-		const s32 sectorCount = (s32)s_editorLevel.sectors.size();
+		if (s_editorLevel.sectors.size() != s_sectorGrid.layers.size()) { buildSectorGrid(); }
 		const EditorSector* sectors = s_editorLevel.sectors.data();
 
 		const Vec2f mapPos = { pos->x, pos->z };
@@ -1190,16 +1212,22 @@ namespace LevelEditorData
 		s32 insideIndices[256];
 
 		// sometimes objects can be in multiple valid sectors, so pick the best one.
-		for (s32 i = 0; i < sectorCount; i++)
+		for (s32 layer = s_sectorGrid.layerMin; layer < s_sectorGrid.layerMin + s_sectorGrid.layerCount; layer++)
 		{
-			if (Geometry::pointInSector(&mapPos, (u32)sectors[i].vertices.size(), sectors[i].vertices.data(), (u32)sectors[i].walls.size(), (u8*)sectors[i].walls.data(), sizeof(EditorWall)))
+			u32 candidateCount;
+			const s32* candidates = TFE_SectorGrid::getCandidates(&s_sectorGrid, layer, &mapPos, &candidateCount);
+			for (u32 c = 0; c < candidateCount && insideCount < 256; c++)
 			{
-				assert(insideCount < 256);
-				insideIndices[insideCount++] = i;
+				if (pointInSector(candidates[c], &mapPos))
+				{
+					insideIndices[insideCount++] = candidates[c];
+				}
 			}
 		}
 		// if the object isn't inside a sector than return.
 		if (!insideCount) { return -1; }
+		// Keep the sector order so ties are resolved the same way as a linear search.
+		std::sort(insideIndices, insideIndices + insideCount);
 
 		// First see if its actually inside any sectors based on height.
 		// If so, pick the sector where it is closest to the floor.
@@ -1538,6 +1566,57 @@ namespace LevelEditorData
 		return hitInfo->hitSectorId >= 0;
 	}
 
+	void buildSectorGrid()
+	{
+		TFE_SectorGrid::clear(&s_sectorGrid);
+		const s32 sectorCount = (s32)s_editorLevel.sectors.size();
+		if (!sectorCount) { return; }
+
+		// The editor can add sectors on new layers, so use the range actually in use.
+		const EditorSector* sectors = s_editorLevel.sectors.data();
+		SectorGridBounds levelBounds = { { FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX } };
+		s32 layerMin = s_editorLevel.layerMin, layerMax = s_editorLevel.layerMax;
+		for (s32 s = 0; s < sectorCount; s++)
+		{
+			SectorGridBounds bounds;
+			TFE_SectorGrid::computeBounds(sectors[s].vertices.data(), (u32)sectors[s].vertices.size(), &bounds);
+			levelBounds.min.x = std::min(levelBounds.min.x, bounds.min.x);
+			levelBounds.min.z = std::min(levelBounds.min.z, bounds.min.z);
+			levelBounds.max.x = std::max(levelBounds.max.x, bounds.max.x);
+			levelBounds.max.z = std::max(levelBounds.max.z, bounds.max.z);
+			layerMin = std::min(layerMin, s32(sectors[s].layer));
+			layerMax = std::max(layerMax, s32(sectors[s].layer));
+		}
+
+		TFE_SectorGrid::init(&s_sectorGrid, &levelBounds, layerMin, layerMax, (u32)sectorCount);
+		for (s32 s = 0; s < sectorCount; s++)
+		{
+			updateSectorGrid(s);
+		}
+	}
+
+	void updateSectorGrid(s32 sectorId)
+	{
+		const EditorSector* sector = &s_editorLevel.sectors[sectorId];
+		if (sector->layer < s_sectorGrid.layerMin || sector->layer >= s_sectorGrid.layerMin + s_sectorGrid.layerCount)
+		{
+			// Moved to a layer outside of the grid.
+			buildSectorGrid();
+			return;
+		}
+
+		SectorGridBounds bounds;
+		TFE_SectorGrid::computeBounds(sector->vertices.data(), (u32)sector->vertices.size(), &bounds);
+		TFE_SectorGrid::setSector(&s_sectorGrid, sectorId, sector->layer, &bounds);
+	}
+
+	bool pointInSector(s32 sectorId, const Vec2f* pos)
+	{
+		const EditorSector* sector = &s_editorLevel.sectors[sectorId];
+		return TFE_SectorGrid::insideBounds(&s_sectorGrid, sectorId, pos) &&
+			Geometry::pointInSector(pos, (u32)sector->vertices.size(), sector->vertices.data(), (u32)sector->walls.size(), (u8*)sector->walls.data(), sizeof(EditorWall));
+	}
+
 	void convertObjectsToEditor(const LevelObjectData* objData)
 	{
 		const u32 count = objData->objectCount;
@@ -61,6 +61,18 @@ void FileStream::seek(u32 offset, Origin origin/*=ORIGIN_START*/)
 	}
 }
 
+void FileStream::seekFromStart(u64 offset)
+{
+	if (m_file)
+	{
+	#ifdef _WIN32
+		_fseeki64(m_file, s64(offset), SEEK_SET);
+	#else
+		fseeko(m_file, off_t(offset), SEEK_SET);
+	#endif
+	}
+}
+
 size_t FileStream::getLoc()
 {
 	if (!m_file)
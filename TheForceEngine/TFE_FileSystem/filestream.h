@@ -22,6 +22,8 @@ public:
 	
 	//derived functions.
 	void seek(u32 offset, Origin origin=ORIGIN_START) override;
+	// Seek relative to the start of the file, offsets may be past 4GB.
+	void seekFromStart(u64 offset);
 	size_t getLoc() override;
 	size_t getSize() override;
 	bool   isOpen()  const;
@@ -3,22 +3,33 @@
 #include <TFE_RenderBackend/renderBackend.h>
 #include <TFE_System/system.h>
 #include <TFE_System/profiler.h>
+#include <TFE_System/frameStats.h>
 #include <TFE_FileSystem/fileutil.h>
 #include <TFE_FileSystem/paths.h>
 #include <TFE_Archive/archive.h>
 #include <TFE_Ui/ui.h>
 #include <TFE_Ui/markdown.h>
 #include <TFE_System/parser.h>
+#include <TFE_ScriptSystem/scriptProfiler.h>
+#include <TFE_FrontEndUI/console.h>
 
 #include <TFE_Ui/imGUI/imgui.h>
 #include <algorithm>
+#include <time.h>
 
 namespace TFE_ProfilerView
 {
+	static const f64 c_defaultTraceSeconds = 5.0;
 	static bool s_open = false;
 
+	void profilerTraceConsole(const ConsoleArgList& args);
+	void profilerTraceWriteConsole(const ConsoleArgList& args);
+	bool writeTrace(f64 seconds, char* path);
+
 	bool init()
 	{
+		CCMD("profilerTrace", profilerTraceConsole, 1, "Record a timeline of the profiler zones on all threads - profilerTrace true/false");
+		CCMD("profilerTraceWrite", profilerTraceWriteConsole, 0, "Write the recorded timeline as a Chrome trace (chrome://tracing or ui.perfetto.dev) to the user documents folder - profilerTraceWrite [seconds]");
 		return true;
 	}
 
@@ -34,6 +45,33 @@ namespace TFE_ProfilerView
 		ImGui::SetNextWindowSize(ImVec2(800, 768));
 		ImGui::Begin("Profiler View", &s_open);
 
+		bool traceEnabled = TFE_Profiler::isTraceEnabled();
+		if (ImGui::Checkbox("Record Timeline", &traceEnabled))
+		{
+			TFE_Profiler::enableTrace(traceEnabled);
+		}
+		if (traceEnabled)
+		{
+			ImGui::SameLine(f32(180));
+			if (ImGui::Button("Write Trace"))
+			{
+				char path[TFE_MAX_PATH];
+				writeTrace(c_defaultTraceSeconds, path);
+			}
+		}
+
+		FrameTimeStats frameStats;
+		TFE_FrameStats::getStats(&frameStats);
+		ImGui::LabelText("##Label", "Frame Time (last %u frames)", frameStats.frameCount);
+		ImGui::Separator();
+		ImGui::Indent();
+		ImGui::Text("Min %0.3fms  Ave %0.3fms  Max %0.3fms", frameStats.minTime * 1000.0, frameStats.aveTime * 1000.0, frameStats.maxTime * 1000.0);
+		ImGui::Text("P50 %0.3fms  P95 %0.3fms  P99 %0.3fms  1%% Low %0.1f fps", frameStats.p50 * 1000.0, frameStats.p95 * 1000.0, frameStats.p99 * 1000.0, frameStats.low1Fps);
+		ImGui::Text("CPU %0.3fms  Render %0.3fms  Swap %0.3fms  Sim Ticks %0.2f", frameStats.cpuTimeAve * 1000.0, frameStats.renderTimeAve * 1000.0,
+			frameStats.swapTimeAve * 1000.0, frameStats.simTicksAve);
+		ImGui::Unindent();
+
+		ImGui::Spacing();
 		ImGui::LabelText("##Label", "Counters");
 		ImGui::Separator();
 		u32 counterCount = TFE_Profiler::getCounterCount();
@@ -58,11 +96,19 @@ namespace TFE_ProfilerView
 		ImGui::Text("Frame");
 
 		u32 zoneCount = TFE_Profiler::getZoneCount();
+		u32 thread = NULL_ZONE;
 		ImGui::Indent();
 		for (u32 z = 0; z < zoneCount; z++)
 		{
 			TFE_ZoneInfo info;
 			TFE_Profiler::getZoneInfo(z, &info);
+			if (info.thread != thread)
+			{
+				thread = info.thread;
+				ImGui::Unindent();
+				ImGui::Text("%s", TFE_Profiler::getThreadName(thread));
+				ImGui::Indent();
+			}
 
 			for (u32 l = 0; l < info.level; l++)
 			{
@@ -71,7 +117,7 @@ namespace TFE_ProfilerView
 
 			ImGui::Text("%0.3fms (%6.03f%%)", info.timeInZoneAve * 1000.0, info.fractOfParentAve * 100.0);
 			ImGui::SameLine(f32(180 + 16*(info.level + 1)));
-			ImGui::Text("%s  [%s:%u]", info.name, info.func, info.lineNumber);
+			ImGui::Text("%s  x%u  [%s:%u]", info.name, info.callCount, info.func, info.lineNumber);
 
 			for (u32 l = 0; l < info.level; l++)
 			{
@@ -81,6 +127,45 @@ namespace TFE_ProfilerView
 		ImGui::Unindent();
 		ImGui::Unindent();
 
+		ImGui::Spacing();
+		ImGui::LabelText("##Label", "Scripts");
+		ImGui::Separator();
+
+		bool profileScripts = TFE_ScriptProfiler::isEnabled();
+		bool lineTiming = TFE_ScriptProfiler::isLineTimingEnabled();
+		if (ImGui::Checkbox("Profile Scripts", &profileScripts))
+		{
+			TFE_ScriptProfiler::enable(profileScripts);
+		}
+		ImGui::SameLine(f32(180));
+		if (ImGui::Checkbox("Line Timing (slow)", &lineTiming))
+		{
+			TFE_ScriptProfiler::enableLineTiming(lineTiming);
+		}
+
+		const u32 functionCount = TFE_ScriptProfiler::getFunctionCount();
+		ImGui::Indent();
+		if (functionCount)
+		{
+			ImGui::Text("Time"); ImGui::SameLine(f32(96));
+			ImGui::Text("Self"); ImGui::SameLine(f32(192));
+			ImGui::Text("Calls"); ImGui::SameLine(f32(256));
+			ImGui::Text("Function");
+		}
+		for (u32 f = 0; f < functionCount; f++)
+		{
+			ScriptProfileInfo info;
+			TFE_ScriptProfiler::getFunctionInfo(f, &info);
+
+			ImGui::Text("%0.3fms", info.timeAve * 1000.0); ImGui::SameLine(f32(96));
+			if (lineTiming) { ImGui::Text("%0.3fms", info.selfTimeAve * 1000.0); }
+			else { ImGui::Text("-"); }
+			ImGui::SameLine(f32(192));
+			ImGui::Text("%u", info.calls); ImGui::SameLine(f32(256));
+			ImGui::Text("%s  [%s]", info.func, info.module);
+		}
+		ImGui::Unindent();
+
 		ImGui::End();
 	}
 
@@ -89,6 +174,42 @@ namespace TFE_ProfilerView
 		return s_open;
 	}
 
+	// Traces are named by the time they are written so earlier captures are kept.
+	bool writeTrace(f64 seconds, char* path)
+	{
+		char fileName[TFE_MAX_PATH];
+		const time_t curTime = time(nullptr);
+		strftime(fileName, TFE_MAX_PATH, "tfe_trace_%Y%m%d_%H%M%S.json", localtime(&curTime));
+		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, fileName, path);
+
+		const bool res = TFE_Profiler::writeTrace(path, seconds);
+		if (res) { TFE_System::logWrite(LOG_MSG, "Profiler", "Wrote the profiler trace to \"%s\"", path); }
+		else { TFE_System::logWrite(LOG_ERROR, "Profiler", "Cannot write the profiler trace to \"%s\"", path); }
+		return res;
+	}
+
+	void profilerTraceConsole(const ConsoleArgList& args)
+	{
+		if (args.size() < 2) { return; }
+		TFE_Profiler::enableTrace(TFE_Console::getBoolArg(args[1]));
+	}
+
+	void profilerTraceWriteConsole(const ConsoleArgList& args)
+	{
+		if (!TFE_Profiler::isTraceEnabled())
+		{
+			TFE_Console::addToHistory("The timeline is not being recorded, use \"profilerTrace true\" first.");
+			return;
+		}
+
+		const f64 seconds = args.size() >= 2 ? f64(TFE_Console::getFloatArg(args[1])) : c_defaultTraceSeconds;
+		char path[TFE_MAX_PATH];
+		char res[TFE_MAX_PATH + 64];
+		if (writeTrace(seconds, path)) { sprintf(res, "Wrote the trace to \"%s\"", path); }
+		else { sprintf(res, "Cannot write the trace to \"%s\"", path); }
+		TFE_Console::addToHistory(res);
+	}
+
 	void enable(bool enable)
 	{
 		s_open = enable;
@@ -11,6 +11,8 @@
 #include <TFE_Game/player.h>
 #include <TFE_Game/level.h>
 #include <TFE_Game/gameObject.h>
+#include <TFE_Game/soundEmitters.h>
+#include <TFE_Game/objectGrid.h>
 #include <TFE_Game/gameControlMapping.h>
 #include <TFE_Audio/midiPlayer.h>
 #include <TFE_System/system.h>
@@ -91,7 +93,6 @@ namespace TFE_GameLoop
 	static TFE_Renderer* s_renderer = nullptr;
 	
 	void updateObjects();
-	void updateSoundObjects(const Vec3f* listenerPos);
 
 	void startRenderer(TFE_Renderer* renderer, s32 w, s32 h)
 	{
@@ -242,6 +243,7 @@ namespace TFE_GameLoop
 
 		TFE_Physics::init(s_level);
 		TFE_Level::startLevel(level, levelObj);
+		TFE_SoundEmitters::build(level);
 		s_motion = 0.0f;
 		s_motionTime = 0.0f;
 		s_fallHeight = 0.0f;
@@ -342,6 +344,7 @@ namespace TFE_GameLoop
 
 		TFE_Physics::init(s_level);
 		TFE_Level::startLevel(level, s_levelObjects);
+		TFE_SoundEmitters::build(level);
 		TFE_InfSystem::setupLevel(TFE_InfAsset::getInfData(), level);
 
 		// for now only overriding the start position is supported.
@@ -420,6 +423,7 @@ namespace TFE_GameLoop
 	void endLevel()
 	{
 		s_level = nullptr;
+		TFE_SoundEmitters::clear();
 		TFE_Level::endLevel();
 
 		TFE_Audio::stopAllSounds();
@@ -577,6 +581,7 @@ namespace TFE_GameLoop
 	{
 		// Handle Game UI
 		GameTransition trans = TRANS_NONE;
+		TFE_ObjectGrid::resetStats();
 				
 		const bool escMenuOpen = TFE_GameUi::isEscMenuOpen();
 		const bool shouldDrawGame = TFE_GameUi::shouldDrawGame();
@@ -867,7 +872,7 @@ namespace TFE_GameLoop
 		{
 			s_jump = true;
 			s_player.vel.y += c_jumpImpulse;
-			TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, s_playerSounds.jump, false);
+			TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, s_playerSounds.jump, SOUND_CATEGORY_GENERAL, SOUND_PRIORITY_HIGH);
 		}
 
 		// Gravity.
@@ -891,7 +896,7 @@ namespace TFE_GameLoop
 				{
 					// Is this water?
 					const bool isWater = s_level->sectors[s_player.m_sectorId].secAlt > 0.0f;
-					TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, isWater ? s_playerSounds.landWater : s_playerSounds.land, false);
+					TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, isWater ? s_playerSounds.landWater : s_playerSounds.land, SOUND_CATEGORY_GENERAL, SOUND_PRIORITY_HIGH);
 				}
 
 				// Clear Velocity and fall height.
@@ -917,7 +922,7 @@ namespace TFE_GameLoop
 			}
 			if (s_fallHeight < c_yellThreshold && s_fallHeight + dy >= c_yellThreshold)
 			{
-				TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, s_playerSounds.fall, false);
+				TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, s_playerSounds.fall, SOUND_CATEGORY_GENERAL, SOUND_PRIORITY_HIGH);
 			}
 			s_fallHeight += dy;
 		}
@@ -970,7 +975,7 @@ namespace TFE_GameLoop
 
 		// Update objects based on their physics settings (to handle explosions, gravity, bouncing, etc.).
 		updateObjects();
-		updateSoundObjects(&s_cameraPos);
+		TFE_SoundEmitters::update(&s_cameraPos);
 
 		if (getAction(ACTION_SHOOT_PRIMARY) && s_inputDelay <= 0)
 		{
@@ -1016,82 +1021,63 @@ namespace TFE_GameLoop
 	void updateObjects()
 	{
 		GameObject* objects = LevelGameObjects::getGameObjectList()->data();
-		SectorObjectList* sectorObjects = LevelGameObjects::getSectorObjectList();
-		const u32 secCount = (u32)s_level->sectors.size();
+		std::vector<u32>* awakeObjects = LevelGameObjects::getAwakeObjectList();
+		const Sector* sectors = s_level->sectors.data();
 
 		s_accum += (f32)TFE_System::getDeltaTime();
 		while (s_accum >= c_step)
 		{
-			Sector* sector = s_level->sectors.data();
-			for (u32 s = 0; s < secCount; s++, sector++)
+			// Only objects that may be falling are simulated, objects at rest are put back to sleep.
+			// Iterate backwards so that sleeping objects (swap-remove) don't need to be revisited.
+			for (s32 i = (s32)awakeObjects->size() - 1; i >= 0; i--)
 			{
-				const std::vector<u32>& list = (*sectorObjects)[s].list;
-				const u32 objCount = (u32)list.size();
-				const u32* indices = list.data();
-				for (u32 i = 0; i < objCount; i++)
+				const u32 objectIndex = (*awakeObjects)[i];
+				GameObject* obj = &objects[objectIndex];
+				// Is the object affected by gravity and still in the level?
+				if (!(obj->physicsFlags&PHYSICS_GRAVITY) || obj->sectorSlot == SECTOR_SLOT_NONE)
 				{
-					GameObject* obj = &objects[indices[i]];
-					// Is the object affected by gravity?
-					if (!(obj->physicsFlags&PHYSICS_GRAVITY)) { obj->verticalVel = 0.0f; continue; }
-
-					// Is the object close enough to stick to the floor or second alt?
-					const f32 dFloor = fabsf(obj->position.y - sector->floorAlt);
-					const f32 dSec   = fabsf(obj->position.y - sector->floorAlt - std::min(sector->secAlt, 0.0f));
-					if (dSec < 0.1f && sector->secAlt < 0.0f) { obj->position.y = sector->floorAlt + sector->secAlt; obj->verticalVel = 0.0f; continue; }
-					else if (dFloor < 0.1f) { obj->position.y = sector->floorAlt; obj->verticalVel = 0.0f; continue; }
-
-					// The object should fall towards the floor or second height.
-					const bool aboveSecHeight = sector->secAlt < 0.0f && obj->position.y < sector->floorAlt + sector->secAlt + 0.1f;
-					const f32 floorHeight = aboveSecHeight ? sector->floorAlt + sector->secAlt : sector->floorAlt;
-
-					obj->position.y += obj->verticalVel * c_step;
-					if (obj->position.y >= floorHeight)
-					{
-						obj->verticalVel = 0.0f;
-						obj->position.y = floorHeight;
-					}
-					else
-					{
-						obj->verticalVel += c_gravityAccelStep;
-					}
-					obj->update = true;
+					obj->verticalVel = 0.0f;
+					LevelGameObjects::sleepObject(objectIndex);
+					continue;
 				}
-			}
-
-			s_accum -= c_step;
-		}
-	}
+				const Sector* sector = &sectors[obj->sectorId];
 
-	// Go through level objects and add or remove sound sources based on proximity to the listener.
-	void updateSoundObjects(const Vec3f* listenerPos)
-	{
-		const u32 count = (u32)LevelGameObjects::getGameObjectList()->size();
-		const f32 borderSq = 16.0f * 16.0f;
-		const f32 soundMaxDistSq = TFE_Audio::c_clipDistance * TFE_Audio::c_clipDistance;
-
-		GameObject* object = LevelGameObjects::getGameObjectList()->data();
-		for (u32 i = 0; i < count; i++, object++)
-		{
-			if (object->oclass != CLASS_SOUND || !object->buffer) { continue; }
+				// Is the object close enough to stick to the floor or second alt?
+				const f32 dFloor = fabsf(obj->position.y - sector->floorAlt);
+				const f32 dSec   = fabsf(obj->position.y - sector->floorAlt - std::min(sector->secAlt, 0.0f));
+				if (dSec < 0.1f && sector->secAlt < 0.0f)
+				{
+					obj->position.y = sector->floorAlt + sector->secAlt;
+					obj->verticalVel = 0.0f;
+					LevelGameObjects::sleepObject(objectIndex);
+					continue;
+				}
+				else if (dFloor < 0.1f)
+				{
+					obj->position.y = sector->floorAlt;
+					obj->verticalVel = 0.0f;
+					LevelGameObjects::sleepObject(objectIndex);
+					continue;
+				}
 
-			const Vec3f offset = { object->position.x - listenerPos->x, object->position.y - listenerPos->y, object->position.z - listenerPos->z };
-			const f32 distSq = TFE_Math::dot(&offset, &offset);
+				// The object should fall towards the floor or second height.
+				const bool aboveSecHeight = sector->secAlt < 0.0f && obj->position.y < sector->floorAlt + sector->secAlt + 0.1f;
+				const f32 floorHeight = aboveSecHeight ? sector->floorAlt + sector->secAlt : sector->floorAlt;
 
-			if (distSq <= soundMaxDistSq && !object->source)
-			{
-				// Add a new looping 3D source.
-				object->source = TFE_Audio::createSoundSource(SOUND_3D, 1.0f, MONO_SEPERATION, object->buffer, &object->position);
-				if (object->source)
+				obj->position.y += obj->verticalVel * c_step;
+				if (obj->position.y >= floorHeight)
 				{
-					TFE_Audio::playSource(object->source, true);
+					obj->verticalVel = 0.0f;
+					obj->position.y = floorHeight;
 				}
+				else
+				{
+					obj->verticalVel += c_gravityAccelStep;
+				}
+				obj->update = true;
 			}
-			else if (distSq > soundMaxDistSq + borderSq && object->source)
-			{
-				// Remove the looping 3D source. Note a border area is added so we aren't constantly adding and removing sounds with small movements.
-				TFE_Audio::freeSource(object->source);
-				object->source = nullptr;
-			}
+
+			s_accum -= c_step;
 		}
 	}
 }
@@ -3,6 +3,7 @@
 #include "player.h"
 #include <TFE_Game/GameUI/gameUi.h>
 #include <TFE_System/system.h>
+#include <TFE_System/frameStats.h>
 #include <TFE_Renderer/renderer.h>
 #include <TFE_RenderBackend/renderBackend.h>
 #include <TFE_FileSystem/paths.h>
@@ -150,7 +151,9 @@ namespace TFE_GameMain
 	GameTransition loop(bool consoleOpen)
 	{
 		GameTransition trans = TFE_GameLoop::update(consoleOpen, s_gameState, s_gameOverlay);
+		const u64 drawStart = TFE_System::getCurrentTimeInTicks();
 		TFE_GameLoop::draw();
+		TFE_FrameStats::addRenderTime(TFE_System::getCurrentTimeInTicks() - drawStart);
 
 		// Update the current state.
 		trans = applyTransition(trans);
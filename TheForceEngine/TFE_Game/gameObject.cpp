@@ -4,11 +4,13 @@
 // This is the player object, someday there may be more than one. :)
 //////////////////////////////////////////////////////////////////////
 #include "gameObject.h"
+#include <assert.h>
 
 namespace LevelGameObjects
 {
 	static GameObjectList s_objects;
 	static SectorObjectList s_sectorObjects;
+	static std::vector<u32> s_awakeObjects;
 
 	GameObjectList* getGameObjectList()
 	{
@@ -19,4 +21,94 @@ namespace LevelGameObjects
 	{
 		return &s_sectorObjects;
 	}
+
+	void addToSector(u32 objectIndex, s32 sectorId)
+	{
+		GameObject* obj = &s_objects[objectIndex];
+		assert(obj->sectorSlot == SECTOR_SLOT_NONE);
+
+		std::vector<u32>& list = s_sectorObjects[sectorId].list;
+		obj->sectorId = sectorId;
+		obj->sectorSlot = (u32)list.size();
+		list.push_back(objectIndex);
+	}
+
+	void removeFromSector(u32 objectIndex)
+	{
+		GameObject* obj = &s_objects[objectIndex];
+		if (obj->sectorSlot == SECTOR_SLOT_NONE) { return; }
+
+		// Swap-remove, the last object in the list takes the slot.
+		std::vector<u32>& list = s_sectorObjects[obj->sectorId].list;
+		assert(obj->sectorSlot < list.size() && list[obj->sectorSlot] == objectIndex);
+		const u32 last = list.back();
+		list[obj->sectorSlot] = last;
+		s_objects[last].sectorSlot = obj->sectorSlot;
+		list.pop_back();
+
+		obj->sectorSlot = SECTOR_SLOT_NONE;
+	}
+
+	void moveToSector(u32 objectIndex, s32 sectorId)
+	{
+		const GameObject* obj = &s_objects[objectIndex];
+		if (obj->sectorId == sectorId && obj->sectorSlot != SECTOR_SLOT_NONE) { return; }
+
+		removeFromSector(objectIndex);
+		addToSector(objectIndex, sectorId);
+	}
+
+	void wakeObject(u32 objectIndex)
+	{
+		GameObject* obj = &s_objects[objectIndex];
+		if (obj->awakeSlot != AWAKE_SLOT_NONE || !(obj->physicsFlags & PHYSICS_GRAVITY)) { return; }
+
+		obj->awakeSlot = (u32)s_awakeObjects.size();
+		s_awakeObjects.push_back(objectIndex);
+	}
+
+	void wakeSectorObjects(s32 sectorId)
+	{
+		if (sectorId < 0 || sectorId >= (s32)s_sectorObjects.size()) { return; }
+
+		const std::vector<u32>& list = s_sectorObjects[sectorId].list;
+		const u32 count = (u32)list.size();
+		for (u32 i = 0; i < count; i++)
+		{
+			wakeObject(list[i]);
+		}
+	}
+
+	void sleepObject(u32 objectIndex)
+	{
+		GameObject* obj = &s_objects[objectIndex];
+		if (obj->awakeSlot == AWAKE_SLOT_NONE) { return; }
+
+		// Swap-remove, the last awake object takes the slot.
+		assert(obj->awakeSlot < s_awakeObjects.size() && s_awakeObjects[obj->awakeSlot] == objectIndex);
+		const u32 last = s_awakeObjects.back();
+		s_awakeObjects[obj->awakeSlot] = last;
+		s_objects[last].awakeSlot = obj->awakeSlot;
+		s_awakeObjects.pop_back();
+
+		obj->awakeSlot = AWAKE_SLOT_NONE;
+	}
+
+	void clearAwakeObjects()
+	{
+		const u32 count = (u32)s_awakeObjects.size();
+		for (u32 i = 0; i < count; i++)
+		{
+			if (s_awakeObjects[i] < s_objects.size())
+			{
+				s_objects[s_awakeObjects[i]].awakeSlot = AWAKE_SLOT_NONE;
+			}
+		}
+		s_awakeObjects.clear();
+	}
+
+	std::vector<u32>* getAwakeObjectList()
+	{
+		return &s_awakeObjects;
+	}
 }
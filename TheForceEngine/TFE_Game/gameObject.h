@@ -29,6 +29,9 @@ enum PhysicsFlags
 	PHYSICS_BOUNCE  = (1 << 1),		// The object will bounce when it hits a surface.
 };
 
+#define SECTOR_SLOT_NONE 0xffffffffu
+#define AWAKE_SLOT_NONE  0xffffffffu
+
 struct GameObject
 {
 	ObjectClass oclass;
@@ -48,6 +51,8 @@ struct GameObject
 	// General
 	u32 objectId;
 	s32 sectorId;
+	u32 sectorSlot = SECTOR_SLOT_NONE;	// index of the object in the sector object list, SECTOR_SLOT_NONE if not in a list.
+	u32 awakeSlot = AWAKE_SLOT_NONE;	// index of the object in the awake list, AWAKE_SLOT_NONE if the object is at rest.
 	f32 verticalVel;
 	f32 zbias;
 	Vec3f position;
@@ -83,8 +88,12 @@ struct GameObject
 
 	// Sound Source.
 	SoundSource* source;
+	// CLASS_SOUND only: VOC streamed while the emitter is in range instead of 'buffer', see TFE_VocAsset::getStreamIndex().
+	s32 soundStream = -1;
 };
 
+// Objects in a sector, in no particular order.
+// Use the LevelGameObjects functions to add and remove objects so that GameObject::sectorSlot stays valid.
 struct SectorObjects
 {
 	std::vector<u32> list;
@@ -97,4 +106,19 @@ namespace LevelGameObjects
 {
 	GameObjectList* getGameObjectList();
 	SectorObjectList* getSectorObjectList();
+
+	// Sector membership, objects are referenced by their index in the game object list.
+	// These are O(1) and do not allocate once the sector lists have grown to their working size.
+	void addToSector(u32 objectIndex, s32 sectorId);
+	void removeFromSector(u32 objectIndex);
+	void moveToSector(u32 objectIndex, s32 sectorId);
+
+	// Objects affected by gravity that may not be at rest, only these are simulated each physics step.
+	// Objects are woken when spawned, pushed or when the floor or second height of their sector changes,
+	// and are put back to sleep by the physics update once they settle.
+	void wakeObject(u32 objectIndex);
+	void wakeSectorObjects(s32 sectorId);
+	void sleepObject(u32 objectIndex);
+	void clearAwakeObjects();
+	std::vector<u32>* getAwakeObjectList();
 }
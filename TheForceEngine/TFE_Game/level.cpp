@@ -1,6 +1,7 @@
 #include "level.h"
 #include "geometry.h"
 #include "gameObject.h"
+#include "objectGrid.h"
 #include "player.h"
 #include <TFE_Game/physics.h>
 #include <TFE_System/system.h>
@@ -42,8 +43,12 @@ namespace TFE_Level
 
 	GameObjectList* s_objects;
 	SectorObjectList* s_sectorObjects;
+	// Adjoined sectors whose vertices move with the sector in moveWalls() and rotate().
+	static std::vector<s32> s_adjoinedSectors;
 
 	void updateSectorCenter(Sector* sector);
+	void updateSectorBounds(s32 sectorId);
+	void addAdjoinedSector(s32 sectorId);
 
 	bool init()
 	{
@@ -93,6 +98,7 @@ namespace TFE_Level
 		s_objects = LevelGameObjects::getGameObjectList();
 		s_sectorObjects = LevelGameObjects::getSectorObjectList();
 
+		LevelGameObjects::clearAwakeObjects();
 		s_sectorObjects->resize(sectorCount);
 		for (u32 i = 0; i < sectorCount; i++)
 		{
@@ -110,6 +116,9 @@ namespace TFE_Level
 			{
 				const ObjectClass oclass = object[i].oclass;
 				GameObject* secobject = &(*s_objects)[i];
+				// The object may be reused from the previous level, the sector lists have already been cleared.
+				secobject->sectorSlot = SECTOR_SLOT_NONE;
+				secobject->awakeSlot = AWAKE_SLOT_NONE;
 				// Get the position and sector.
 				Vec3f pos = object[i].pos;
 
@@ -147,8 +156,7 @@ namespace TFE_Level
 
 				if (oclass != CLASS_SPRITE && oclass != CLASS_FRAME && oclass != CLASS_3D && oclass != CLASS_SOUND) { continue; }
 				
-				std::vector<u32>& list = (*s_sectorObjects)[sectorId].list;
-				list.push_back(i);
+				LevelGameObjects::addToSector(i, sectorId);
 				
 				if (!object[i].logics.empty() && (object[i].logics[0].type == LOGIC_LIFE || (object[i].logics[0].type >= LOGIC_BLUE && object[i].logics[0].type <= LOGIC_PILE)))
 				{
@@ -194,12 +202,16 @@ namespace TFE_Level
 				}
 				else if (oclass == CLASS_SOUND)
 				{
-					// Cheat and just start up a one shot here...
-					secobject->buffer = TFE_VocAsset::get(levelObj->sounds[object[i].dataOffset].c_str());
+					// Long sounds are streamed by the sound emitters while in range, so they aren't loaded here.
+					const char* soundName = levelObj->sounds[object[i].dataOffset].c_str();
+					secobject->soundStream = TFE_VocAsset::getStreamIndex(soundName);
+					secobject->buffer = secobject->soundStream < 0 ? TFE_VocAsset::get(soundName) : nullptr;
 				}
 
 				// Register the object logic.
 				TFE_LogicSystem::registerObjectLogics(secobject, object[i].logics, object[i].generators);
+				// Let the object settle onto the floor, it goes to sleep once at rest.
+				LevelGameObjects::wakeObject(i);
 			}
 		}
 
@@ -268,6 +280,7 @@ namespace TFE_Level
 				obj->position.x += move->x;
 				obj->position.z += move->z;
 				obj->update = true;
+				TFE_ObjectGrid::updateObject(indices[i]);
 			}
 		}
 	}
@@ -302,6 +315,7 @@ namespace TFE_Level
 				obj->position.z = -sa*x + ca*z + center->z;
 				obj->angles.y += angleDelta * PI / 180.0f;
 				obj->update = true;
+				TFE_ObjectGrid::updateObject(indices[i]);
 			}
 		}
 	}
@@ -390,6 +404,26 @@ namespace TFE_Level
 		sector->center.z *= scale;
 	}
 
+	// Keep the physics point location data in sync with the moved vertices.
+	void updateSectorBounds(s32 sectorId)
+	{
+		TFE_Physics::updateSector(sectorId);
+		const size_t adjoinedCount = s_adjoinedSectors.size();
+		for (size_t i = 0; i < adjoinedCount; i++)
+		{
+			TFE_Physics::updateSector(s_adjoinedSectors[i]);
+		}
+	}
+
+	// Sectors usually share several moving walls, only update each once.
+	void addAdjoinedSector(s32 sectorId)
+	{
+		if (std::find(s_adjoinedSectors.begin(), s_adjoinedSectors.end(), sectorId) == s_adjoinedSectors.end())
+		{
+			s_adjoinedSectors.push_back(sectorId);
+		}
+	}
+
 	// Floor, ceiling, second height
 	void setFloorHeight(s32 sectorId, f32 height, bool addSectorMotion)
 	{
@@ -404,6 +438,7 @@ namespace TFE_Level
 
 		// Go through list of objects that are standing on the floor of the sector and add the motion to them.
 		setObjectFloorHeight(sectorId, height);
+		LevelGameObjects::wakeSectorObjects(sectorId);
 
 		s_levelData->sectors[sectorId].floorAlt = height;
 		s_levelData->sectors[sectorId].center.y = (s_levelData->sectors[sectorId].floorAlt + s_levelData->sectors[sectorId].ceilAlt) * 0.5f;
@@ -445,6 +480,7 @@ namespace TFE_Level
 
 		// Go through list of objects that are standing on the floor of the sector and add the motion to them.
 		setObjectSecAlt(sectorId, height);
+		LevelGameObjects::wakeSectorObjects(sectorId);
 
 		s_levelData->sectors[sectorId].secAlt = height;
 		s_levelData->sectors[sectorId].dirty = true;
@@ -493,6 +529,7 @@ namespace TFE_Level
 		// gather vertex indices.
 		u32 indices[1024];
 		u32 indexCount = 0;
+		s_adjoinedSectors.clear();
 
 		Sector* sector = &s_levelData->sectors[sectorId];
 		SectorWall* walls = s_levelData->walls.data();
@@ -511,6 +548,7 @@ namespace TFE_Level
 					if (adjoined->flags[0] & WF1_WALL_MORPHS)
 					{
 						indices[indexCount++] = adjoined->i0 + adjoinedSec->vtxOffset;
+						addAdjoinedSector(wall->adjoin);
 						adjoinedSec->dirty = true;
 					}
 				}
@@ -540,6 +578,7 @@ namespace TFE_Level
 		}
 
 		updateSectorCenter(sector);
+		updateSectorBounds(sectorId);
 	}
 
 	void rotate(s32 sectorId, f32 angle, f32 angleDelta, const Vec2f* center, bool addSectorMotion, bool addSecMotionSecondAlt, bool useVertexCache)
@@ -570,6 +609,7 @@ namespace TFE_Level
 		// gather vertex indices.
 		u32 indices[1024];
 		u32 indexCount = 0;
+		s_adjoinedSectors.clear();
 
 		Sector* sector = &s_levelData->sectors[sectorId];
 		SectorWall* walls = s_levelData->walls.data();
@@ -588,6 +628,7 @@ namespace TFE_Level
 					if (adjoined->flags[0] & WF1_WALL_MORPHS)
 					{
 						indices[indexCount++] = adjoined->i0 + adjoinedSec->vtxOffset;
+						addAdjoinedSector(wall->adjoin);
 						adjoinedSec->dirty = true;
 					}
 				}
@@ -623,6 +664,7 @@ namespace TFE_Level
 		}
 
 		updateSectorCenter(sector);
+		updateSectorBounds(sectorId);
 	}
 
 	// Handle 1024 texel texture / 8 for world scale.
@@ -1087,6 +1129,8 @@ namespace TFE_Level
 
 		sectors[sector1].dirty = true;
 		sectors[sector2].dirty = true;
+		TFE_Physics::updateSector(sector1);
+		TFE_Physics::updateSector(sector2);
 
 		// Add direct setting to Classic Renderer
 		/*
@@ -0,0 +1,238 @@
+#include "objectGrid.h"
+#include "gameObject.h"
+#include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <assert.h>
+#include <algorithm>
+#include <vector>
+
+namespace TFE_ObjectGrid
+{
+	// Most objects are smaller than a cell so they usually end up in one to four cells.
+	static const f32 c_cellSize = 8.0f;
+	static const s32 c_maxGridDim = 256;
+
+	struct ObjectCells
+	{
+		s32 x0, z0, x1, z1;	// cell range, x0 < 0 if the object is not in the grid.
+		u32 queryId;		// last query that tested the object.
+		// Position of the object within each cell of its range (row major), so it can be removed without a search.
+		std::vector<u32> cellPos;
+	};
+
+	struct CellEntry
+	{
+		u32 objectIndex;
+		u32 rangeIndex;		// index of the cell in the object's range, used to fix up ObjectCells::cellPos.
+	};
+
+	static std::vector<std::vector<CellEntry>> s_cells;
+	static std::vector<ObjectCells> s_objectCells;
+	static Vec2f s_origin = { 0 };
+	static f32 s_invCellSize = 1.0f;
+	static s32 s_width = 0;
+	static s32 s_height = 0;
+	static u32 s_queryId = 0;
+	static bool s_overflowReported = false;
+
+	// Stats
+	static s32 s_candidatePairs = 0;
+	static s32 s_queryCount = 0;
+
+	s32  getCell(f32 value, f32 origin, s32 dim);
+	void getCellRange(const Vec2f* pos, f32 radius, s32* x0, s32* z0, s32* x1, s32* z1);
+	u32  query(const Vec2f* pos, f32 radius, const f32* heightRange, u32* results, u32 maxCount);
+
+	void init(const SectorGridBounds* levelBounds)
+	{
+		clear();
+
+		const f32 extentX = std::max(levelBounds->max.x - levelBounds->min.x, 1.0f);
+		const f32 extentZ = std::max(levelBounds->max.z - levelBounds->min.z, 1.0f);
+		// Grow the cells for very large levels.
+		const f32 cellSize = std::max(c_cellSize, std::max(extentX, extentZ) / f32(c_maxGridDim));
+
+		s_origin = levelBounds->min;
+		s_invCellSize = 1.0f / cellSize;
+		s_width  = std::min(s32(extentX * s_invCellSize) + 1, c_maxGridDim);
+		s_height = std::min(s32(extentZ * s_invCellSize) + 1, c_maxGridDim);
+		s_cells.resize(size_t(s_width * s_height));
+
+		TFE_COUNTER(s_candidatePairs, "Object Candidate Pairs");
+		TFE_COUNTER(s_queryCount, "Object Grid Queries");
+	}
+
+	void clear()
+	{
+		s_cells.clear();
+		s_objectCells.clear();
+		s_width = 0;
+		s_height = 0;
+		s_queryId = 0;
+		s_overflowReported = false;
+	}
+
+	void updateObject(u32 objectIndex)
+	{
+		if (s_cells.empty()) { return; }
+
+		const GameObject* obj = &(*LevelGameObjects::getGameObjectList())[objectIndex];
+		if (obj->collisionFlags == COLLIDE_NONE || obj->collisionRadius <= 0.0f || obj->collisionHeight <= 0.0f || obj->sectorSlot == SECTOR_SLOT_NONE)
+		{
+			removeObject(objectIndex);
+			return;
+		}
+
+		if (objectIndex >= s_objectCells.size())
+		{
+			s_objectCells.resize(objectIndex + 1, { -1, -1, -1, -1, 0, {} });
+		}
+		ObjectCells* objCells = &s_objectCells[objectIndex];
+
+		const Vec2f posXZ = { obj->position.x, obj->position.z };
+		s32 x0, z0, x1, z1;
+		getCellRange(&posXZ, obj->collisionRadius, &x0, &z0, &x1, &z1);
+		// Most updates are small moves that stay within the same cells.
+		if (x0 == objCells->x0 && z0 == objCells->z0 && x1 == objCells->x1 && z1 == objCells->z1) { return; }
+
+		removeObject(objectIndex);
+		objCells->x0 = x0;
+		objCells->z0 = z0;
+		objCells->x1 = x1;
+		objCells->z1 = z1;
+		objCells->cellPos.resize(size_t((x1 - x0 + 1) * (z1 - z0 + 1)));
+		u32 rangeIndex = 0;
+		for (s32 z = z0; z <= z1; z++)
+		{
+			for (s32 x = x0; x <= x1; x++, rangeIndex++)
+			{
+				std::vector<CellEntry>& cell = s_cells[z * s_width + x];
+				objCells->cellPos[rangeIndex] = (u32)cell.size();
+				cell.push_back({ objectIndex, rangeIndex });
+			}
+		}
+	}
+
+	void removeObject(u32 objectIndex)
+	{
+		if (objectIndex >= s_objectCells.size()) { return; }
+		ObjectCells* objCells = &s_objectCells[objectIndex];
+		if (objCells->x0 < 0) { return; }
+
+		// Swap remove, the object moved into the hole has its position in that cell updated.
+		u32 rangeIndex = 0;
+		for (s32 z = objCells->z0; z <= objCells->z1; z++)
+		{
+			for (s32 x = objCells->x0; x <= objCells->x1; x++, rangeIndex++)
+			{
+				std::vector<CellEntry>& cell = s_cells[z * s_width + x];
+				const u32 pos = objCells->cellPos[rangeIndex];
+				assert(pos < cell.size() && cell[pos].objectIndex == objectIndex);
+
+				const CellEntry moved = cell.back();
+				cell[pos] = moved;
+				s_objectCells[moved.objectIndex].cellPos[moved.rangeIndex] = pos;
+				cell.pop_back();
+			}
+		}
+		objCells->x0 = -1;
+	}
+
+	u32 queryRadius(const Vec2f* pos, f32 radius, u32* results, u32 maxCount)
+	{
+		return query(pos, radius, nullptr, results, maxCount);
+	}
+
+	u32 queryCylinder(const Vec3f* pos, f32 radius, f32 height, u32* results, u32 maxCount)
+	{
+		const Vec2f posXZ = { pos->x, pos->z };
+		const f32 heightRange[] = { pos->y, pos->y - height };
+		return query(&posXZ, radius, heightRange, results, maxCount);
+	}
+
+	s32 getCandidatePairCount()
+	{
+		return s_candidatePairs;
+	}
+
+	void resetStats()
+	{
+		s_candidatePairs = 0;
+		s_queryCount = 0;
+	}
+
+	//////////////////////////////////////////////
+	// Internal
+	//////////////////////////////////////////////
+	s32 getCell(f32 value, f32 origin, s32 dim)
+	{
+		const f32 cell = (value - origin) * s_invCellSize;
+		if (cell <= 0.0f) { return 0; }
+		return std::min(s32(cell), dim - 1);
+	}
+
+	void getCellRange(const Vec2f* pos, f32 radius, s32* x0, s32* z0, s32* x1, s32* z1)
+	{
+		*x0 = getCell(pos->x - radius, s_origin.x, s_width);
+		*z0 = getCell(pos->z - radius, s_origin.z, s_height);
+		*x1 = getCell(pos->x + radius, s_origin.x, s_width);
+		*z1 = getCell(pos->z + radius, s_origin.z, s_height);
+	}
+
+	// heightRange is { bottom, top } or null to ignore heights.
+	u32 query(const Vec2f* pos, f32 radius, const f32* heightRange, u32* results, u32 maxCount)
+	{
+		if (s_cells.empty()) { return 0; }
+		s_queryCount++;
+
+		// Objects that span several cells are only tested once per query.
+		s_queryId++;
+		if (!s_queryId)
+		{
+			for (size_t i = 0; i < s_objectCells.size(); i++) { s_objectCells[i].queryId = 0; }
+			s_queryId = 1;
+		}
+
+		const GameObject* objects = LevelGameObjects::getGameObjectList()->data();
+		s32 x0, z0, x1, z1;
+		getCellRange(pos, radius, &x0, &z0, &x1, &z1);
+
+		u32 count = 0;
+		for (s32 z = z0; z <= z1; z++)
+		{
+			for (s32 x = x0; x <= x1; x++)
+			{
+				const std::vector<CellEntry>& cell = s_cells[z * s_width + x];
+				const u32 cellCount = (u32)cell.size();
+				for (u32 i = 0; i < cellCount; i++)
+				{
+					const u32 objectIndex = cell[i].objectIndex;
+					if (s_objectCells[objectIndex].queryId == s_queryId) { continue; }
+					s_objectCells[objectIndex].queryId = s_queryId;
+					s_candidatePairs++;
+
+					const GameObject* obj = &objects[objectIndex];
+					const f32 dx = obj->position.x - pos->x;
+					const f32 dz = obj->position.z - pos->z;
+					const f32 r = radius + obj->collisionRadius;
+					if (dx*dx + dz*dz >= r*r) { continue; }
+					if (heightRange && !(heightRange[0] > obj->position.y - obj->collisionHeight && obj->position.y > heightRange[1])) { continue; }
+
+					if (count >= maxCount)
+					{
+						// The caller's buffer is too small, the remaining objects are missed.
+						assert(0);
+						if (!s_overflowReported)
+						{
+							TFE_System::logWrite(LOG_WARNING, "ObjectGrid", "More than %u objects overlap the query at (%f, %f), the remaining objects are ignored.", maxCount, pos->x, pos->z);
+							s_overflowReported = true;
+						}
+						return count;
+					}
+					results[count++] = objectIndex;
+				}
+			}
+		}
+		return count;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Object Grid
+// Collision broadphase for game objects: a uniform grid on the XZ plane
+// holding every object with collision (flags, radius and height set).
+// Each object is stored in the cells overlapped by its collision
+// circle, so queries only have to test the objects in nearby cells
+// instead of every object in a sector.
+//
+// The grid is updated incrementally, call updateObject() whenever the
+// XZ position or collision settings of an object change. Vertical
+// motion does not change the cells and does not require an update.
+//////////////////////////////////////////////////////////////////////
+
+#include <TFE_System/types.h>
+#include "sectorGrid.h"
+
+namespace TFE_ObjectGrid
+{
+	// Setup an empty grid covering 'levelBounds', objects outside of the bounds are clamped to the edge cells.
+	void init(const SectorGridBounds* levelBounds);
+	void clear();
+
+	// Insert, move or remove an object based on its current position and collision.
+	void updateObject(u32 objectIndex);
+	void removeObject(u32 objectIndex);
+
+	// Objects whose collision circle overlaps the circle at 'pos', returns the number of objects written to 'results'.
+	// If more than 'maxCount' objects overlap, the rest are skipped and a warning is logged.
+	u32 queryRadius(const Vec2f* pos, f32 radius, u32* results, u32 maxCount);
+	// Objects whose collision cylinder overlaps the vertical cylinder of 'radius' and 'height' standing at 'pos'
+	// (covering [pos->y - height, pos->y] since up is -y).
+	u32 queryCylinder(const Vec3f* pos, f32 radius, f32 height, u32* results, u32 maxCount);
+
+	// Number of objects tested by queries since the last reset (see the "Object Candidate Pairs" profiler counter).
+	s32 getCandidatePairCount();
+	void resetStats();
+}
@@ -1,17 +1,27 @@
 #include "physics.h"
 #include "geometry.h"
 #include "gameObject.h"
+#include "sectorGrid.h"
+#include "objectGrid.h"
+#include <TFE_System/system.h>
 #include <TFE_System/math.h>
 #include <TFE_LogicSystem/logicSystem.h>
 #include <TFE_InfSystem/infSystem.h>
 #include <assert.h>
 #include <algorithm>
 
+// SSE2 is always available on x64, other targets use the scalar paths.
+#if defined(_M_X64) || defined(__SSE2__)
+#define PHYSICS_SSE2 1
+#include <emmintrin.h>
+#endif
+
 namespace TFE_Physics
 {
 	#define MOVE_ITER_END 4
 	#define HEIGHT_EPS 0.5f
 	#define MAX_COLLISION_RAY_ITER 256
+	#define MAX_COLLISION_OBJECTS 256
 
 	const f32 c_stepUpSize = 3.5f;
 	const f32 c_minHeight = 3.0f;
@@ -24,8 +34,36 @@ namespace TFE_Physics
 	static f32 s_height;
 	static const Sector* s_overlapSectors[256];
 	static const Sector* s_searchSectors[256];
+	// Point location acceleration.
+	static SectorGrid s_sectorGrid;
+	// Collision cache: wall segments (start, edge vector and squared length) indexed like LevelData::walls.
+	// Updated per sector by updateSector() when the level geometry changes, so the collision queries and ray tests
+	// don't have to go through the wall vertex indices and recompute the edges on every query.
+	static std::vector<f32> s_wallX0;
+	static std::vector<f32> s_wallZ0;
+	static std::vector<f32> s_wallDX;
+	static std::vector<f32> s_wallDZ;
+	static std::vector<f32> s_wallLenSq;
+	static std::vector<u32> s_rayOrder;
+	// Set for sectors that share area with another sector (stacked, on another layer or badly formed), only these
+	// need the full search in findSector(pos, hint). Touching sectors are not flagged.
+	static std::vector<u8> s_sectorOverlaps;
+	static std::vector<s32> s_overlapCandidates;
+	// Object broadphase results.
+	static u32 s_collisionObjects[MAX_COLLISION_OBJECTS];
 	
 	bool canCrossWall(f32 yPos, const SectorWall* wall);
+	void buildSectorGrid();
+	void updateSectorCache(s32 sectorId);
+	void updateSectorOverlap(s32 sectorId, bool flagOthers);
+	bool sectorsOverlap(s32 sectorA, s32 sectorB);
+	bool pointStrictlyInSector(s32 sectorId, const Vec2f* pos);
+	bool pointOnSectorWall(s32 sectorId, const Vec2f* pos);
+	bool pointInSector(s32 sectorId, const Vec2f* pos);
+	u32  findSectorsOnLayer(s32 layer, const Vec2f* pos, s32* insideIndices, u32 insideCount, u32 maxCount);
+	s32  findClosestWallHit(const Vec2f* p0, const Vec2f* p1, const Sector* sector, s32 windowId, s32 prevSector, f32* closestHit);
+	f32  getWallDistSq(u32 wallIndex, const Vec2f* pos, Vec2f* point);
+	bool circleOverlapsSector(const Sector* sector, const Vec2f* pos, f32 radius);
 
 	bool init(LevelData* level)
 	{
@@ -33,12 +71,86 @@ namespace TFE_Physics
 		s_overlapSectorCnt = 0;
 		s_searchIndex = 0;
 		s_height = 0.0f;
+		buildSectorGrid();
+
+		// Objects are added to the broadphase as their collision is setup.
+		SectorGridBounds levelBounds = {};
+		if (level)
+		{
+			TFE_SectorGrid::computeBounds(level->vertices.data(), (u32)level->vertices.size(), &levelBounds);
+		}
+		TFE_ObjectGrid::init(&levelBounds);
 
 		return (level != nullptr);
 	}
 
 	void shutdown()
 	{
+		TFE_SectorGrid::clear(&s_sectorGrid);
+		TFE_ObjectGrid::clear();
+	}
+
+	void buildSectorGrid()
+	{
+		TFE_SectorGrid::clear(&s_sectorGrid);
+		if (!s_level || s_level->sectors.empty()) { return; }
+
+		const size_t wallCount = s_level->walls.size();
+		s_wallX0.resize(wallCount);
+		s_wallZ0.resize(wallCount);
+		s_wallDX.resize(wallCount);
+		s_wallDZ.resize(wallCount);
+		s_wallLenSq.resize(wallCount);
+
+		SectorGridBounds levelBounds;
+		TFE_SectorGrid::computeBounds(s_level->vertices.data(), (u32)s_level->vertices.size(), &levelBounds);
+		const u32 sectorCount = (u32)s_level->sectors.size();
+		TFE_SectorGrid::init(&s_sectorGrid, &levelBounds, s_level->layerMin, s_level->layerMax, sectorCount);
+		for (u32 s = 0; s < sectorCount; s++)
+		{
+			updateSectorCache(s);
+		}
+
+		u32 overlapCount = 0;
+		s_sectorOverlaps.resize(sectorCount);
+		for (u32 s = 0; s < sectorCount; s++)
+		{
+			updateSectorOverlap(s, false);
+			overlapCount += s_sectorOverlaps[s];
+		}
+		TFE_System::logWrite(LOG_MSG, "Physics", "%u of %u sectors overlap other sectors.", overlapCount, sectorCount);
+	}
+
+	void updateSector(s32 sectorId)
+	{
+		updateSectorCache(sectorId);
+		// Sectors that the moved sector now overlaps are flagged as well. Sectors it moved away from keep their
+		// flag until they are updated themselves, which only costs them the fast path.
+		updateSectorOverlap(sectorId, true);
+	}
+
+	void updateSectorCache(s32 sectorId)
+	{
+		const Sector* sector = &s_level->sectors[sectorId];
+		const Vec2f* vtx = s_level->vertices.data() + sector->vtxOffset;
+		SectorGridBounds bounds;
+		TFE_SectorGrid::computeBounds(vtx, sector->vtxCount, &bounds);
+		TFE_SectorGrid::setSector(&s_sectorGrid, sectorId, sector->layer, &bounds);
+
+		const SectorWall* walls = s_level->walls.data() + sector->wallOffset;
+		for (u32 w = 0; w < sector->wallCount; w++)
+		{
+			const Vec2f* v0 = &vtx[walls[w].i0];
+			const Vec2f* v1 = &vtx[walls[w].i1];
+			const u32 index = sector->wallOffset + w;
+			s_wallX0[index] = v0->x;
+			s_wallZ0[index] = v0->z;
+			s_wallDX[index] = v1->x - v0->x;
+			s_wallDZ[index] = v1->z - v0->z;
+			// Degenerate walls are treated as a point.
+			const f32 lenSq = s_wallDX[index] * s_wallDX[index] + s_wallDZ[index] * s_wallDZ[index];
+			s_wallLenSq[index] = fabsf(lenSq) < FLT_EPSILON ? 0.0f : lenSq;
+		}
 	}
 
 	bool addSectorToSearchList(const Sector* sector)
@@ -88,30 +200,21 @@ namespace TFE_Physics
 		for (u32 w = 0; w < wallCount; w++)
 		{
 			Vec2f point;
-			Geometry::closestPointOnLineSegment(vertices[walls[w].i0], vertices[walls[w].i1], newPosXZ, &point);
-			Vec2f offset = { point.x - newPosXZ.x, point.z - newPosXZ.z };
-			f32 distSq = TFE_Math::dot(&offset, &offset);
-			if (distSq < rSq)
+			if (getWallDistSq(curSector->wallOffset + w, &newPosXZ, &point) < rSq)
 			{
 				return false;
 			}
 		}
 
-		// Then check collision against objects.
-		const GameObjectList* objectList = LevelGameObjects::getGameObjectList();
-		const GameObject* object = objectList->data();
-		const SectorObjectList* secObjs = LevelGameObjects::getSectorObjectList();
-		const size_t objCount = (*secObjs)[sectorId].list.size();
-		const u32* indices = (*secObjs)[sectorId].list.data();
+		// Then check collision against nearby objects in the sector, the broadphase already checked the heights.
+		const GameObject* object = LevelGameObjects::getGameObjectList()->data();
+		const u32 objCount = TFE_ObjectGrid::queryCylinder(newPos, radius, 6.0f, s_collisionObjects, MAX_COLLISION_OBJECTS);
 
 		bool collided = false;
-		for (size_t i = 0; i < objCount; i++)
+		for (u32 i = 0; i < objCount; i++)
 		{
-			const GameObject* curObj = &object[indices[i]];
-			if (curObj->collisionFlags == COLLIDE_NONE || curObj->collisionRadius <= 0.0f || curObj->collisionHeight <= 0.0f)
-			{
-				continue;
-			}
+			const GameObject* curObj = &object[s_collisionObjects[i]];
+			if (curObj->sectorId != sectorId) { continue; }
 			
 			if (curObj->collisionFlags & COLLIDE_PLAYER)
 			{
@@ -119,19 +222,13 @@ namespace TFE_Physics
 				const Vec2f objPosXZ = { curObj->position.x, curObj->position.z };
 				if (TFE_Math::distanceSq(&newPosXZ, &objPosXZ) < rSq + curObj->collisionRadius*curObj->collisionRadius)
 				{
-					// do heights overlap?
-					f32 h0[] = { newPos->y, newPos->y - 6.0f };
-					f32 h1[] = { curObj->position.y, curObj->position.y - curObj->collisionHeight };
-					if (h0[0] > h1[1] && h1[0] > h0[1])
+					if (curObj->collisionFlags & COLLIDE_TRIGGER)
 					{
-						if (curObj->collisionFlags & COLLIDE_TRIGGER)
-						{
-							TFE_LogicSystem::sendPlayerCollisionTrigger(curObj);
-						}
-						else
-						{
-							collided = true;
-						}
+						TFE_LogicSystem::sendPlayerCollisionTrigger(curObj);
+					}
+					else
+					{
+						collided = true;
 					}
 				}
 			}
@@ -157,13 +254,17 @@ namespace TFE_Physics
 		}
 		if (!foundInSector) { return false; }
 
+		// Nearby objects, these are checked per sector below.
+		const GameObject* object = LevelGameObjects::getGameObjectList()->data();
+		const u32 objCount = TFE_ObjectGrid::queryCylinder(newPos, radius, 6.0f, s_collisionObjects, MAX_COLLISION_OBJECTS);
+
 		bool collided = false;
 		for (u32 s = 0; s < s_overlapSectorCnt; s++)
 		{
 			const Sector* curSector = s_overlapSectors[s];
 			const SectorWall* walls = s_level->walls.data() + curSector->wallOffset;
-			const Vec2f* vertices = s_level->vertices.data() + curSector->vtxOffset;
-			const u32 wallCount = curSector->wallCount;
+			// Skip the walls if none of them can be in range, objects are still checked below.
+			const u32 wallCount = circleOverlapsSector(curSector, &newPosXZ, radius) ? curSector->wallCount : 0;
 
 			// If it is the same sector, check collision against objects and walls.
 			const f32 rSq = radius * radius + FLT_EPSILON;
@@ -172,29 +273,17 @@ namespace TFE_Physics
 				if (canCrossWall(newPos->y, &walls[w])) { continue; }
 
 				Vec2f point;
-				Geometry::closestPointOnLineSegment(vertices[walls[w].i0], vertices[walls[w].i1], newPosXZ, &point);
-				Vec2f offset = { point.x - newPosXZ.x, point.z - newPosXZ.z };
-				f32 distSq = TFE_Math::dot(&offset, &offset);
-				if (distSq < rSq)
+				if (getWallDistSq(curSector->wallOffset + w, &newPosXZ, &point) < rSq)
 				{
 					return false;
 				}
 			}
 
-			// Then check collision against objects.
-			const GameObjectList* objectList = LevelGameObjects::getGameObjectList();
-			const GameObject* object = objectList->data();
-			const SectorObjectList* secObjs = LevelGameObjects::getSectorObjectList();
-			const size_t objCount = (*secObjs)[curSector->id].list.size();
-			const u32* indices = (*secObjs)[curSector->id].list.data();
-
-			for (size_t i = 0; i < objCount; i++)
+			// Then check collision against objects in the sector.
+			for (u32 i = 0; i < objCount; i++)
 			{
-				const GameObject* curObj = &object[indices[i]];
-				if (curObj->collisionFlags == COLLIDE_NONE || curObj->collisionRadius <= 0.0f || curObj->collisionHeight <= 0.0f)
-				{
-					continue;
-				}
+				const GameObject* curObj = &object[s_collisionObjects[i]];
+				if (curObj->sectorId != (s32)curSector->id) { continue; }
 
 				if (curObj->collisionFlags & COLLIDE_PLAYER)
 				{
@@ -202,19 +291,13 @@ namespace TFE_Physics
 					const Vec2f objPosXZ = { curObj->position.x, curObj->position.z };
 					if (TFE_Math::distanceSq(&newPosXZ, &objPosXZ) < rSq + curObj->collisionRadius*curObj->collisionRadius)
 					{
-						// do heights overlap?
-						f32 h0[] = { newPos->y, newPos->y - 6.0f };
-						f32 h1[] = { curObj->position.y, curObj->position.y - curObj->collisionHeight };
-						if (h0[0] > h1[1] && h1[0] > h0[1])
+						if (curObj->collisionFlags & COLLIDE_TRIGGER)
 						{
-							if (curObj->collisionFlags & COLLIDE_TRIGGER)
-							{
-								TFE_LogicSystem::sendPlayerCollisionTrigger(curObj);
-							}
-							else
-							{
-								collided = true;
-							}
+							TFE_LogicSystem::sendPlayerCollisionTrigger(curObj);
+						}
+						else
+						{
+							collided = true;
 						}
 					}
 				}
@@ -250,7 +333,6 @@ namespace TFE_Physics
 	void gatherAllOverlappingSectors(const Sector* start, const Vec3f* pos, f32 radius, bool incBlockedAdjoins)
 	{
 		// If not successful, try a "slide move"
-		const Sector* sectors = s_level->sectors.data();
 		s_searchIndex = 0;
 		for (u32 s = 0; s < s_overlapSectorCnt; s++)
 		{
@@ -264,7 +346,8 @@ namespace TFE_Physics
 			s_searchIndex--;
 			const Sector* curSector = s_searchSectors[s_searchIndex];
 			const SectorWall* walls = s_level->walls.data() + curSector->wallOffset;
-			const Vec2f* vertices = s_level->vertices.data() + curSector->vtxOffset;
+			// None of the walls can be in range.
+			if (!circleOverlapsSector(curSector, &posXZ, radius)) { continue; }
 
 			const u32 wallCount = curSector->wallCount;
 			for (u32 w = 0; w < wallCount; w++)
@@ -273,10 +356,7 @@ namespace TFE_Physics
 				if ((!incBlockedAdjoins && !passable) || walls[w].adjoin < 0) { continue; }
 
 				Vec2f point;
-				Geometry::closestPointOnLineSegment(vertices[walls[w].i0], vertices[walls[w].i1], posXZ, &point);
-				const Vec2f offset = { point.x - posXZ.x, point.z - posXZ.z };
-				const f32 distSq = TFE_Math::dot(&offset, &offset);
-				if (distSq >= rSq) { continue; }
+				if (getWallDistSq(curSector->wallOffset + w, &posXZ, &point) >= rSq) { continue; }
 
 				const Sector* nextSector = s_level->sectors.data() + walls[w].adjoin;
 				if (addSectorToSearchList(nextSector))
@@ -297,16 +377,13 @@ namespace TFE_Physics
 		{
 			const Sector* curSector = s_overlapSectors[s];
 			const SectorWall* walls = s_level->walls.data() + curSector->wallOffset;
-			const Vec2f* vertices = s_level->vertices.data() + curSector->vtxOffset;
+			if (!circleOverlapsSector(curSector, &posXZ, radius)) { continue; }
 
 			const u32 wallCount = curSector->wallCount;
 			for (u32 w = 0; w < wallCount; w++)
 			{
 				Vec2f point;
-				Geometry::closestPointOnLineSegment(vertices[walls[w].i0], vertices[walls[w].i1], posXZ, &point);
-				const Vec2f offset = { point.x - posXZ.x, point.z - posXZ.z };
-				const f32 distSq = TFE_Math::dot(&offset, &offset);
-				if (distSq >= rSq) { continue; }
+				if (getWallDistSq(curSector->wallOffset + w, &posXZ, &point) >= rSq) { continue; }
 
 				// If includePassable = false then do not include any passable walls.
 				if (!includePassable && canCrossWall(pos->y, &walls[w])) { continue; }
@@ -422,13 +499,12 @@ namespace TFE_Physics
 			u32 sectorId = lines[l] & 0xffffu;
 			u32 wallId = lines[l] >> 16u;
 			const Sector* sector = s_level->sectors.data() + sectorId;
-			const Vec2f* vertices = s_level->vertices.data() + sector->vtxOffset;
-			const SectorWall* wall = s_level->walls.data() + wallId + sector->wallOffset;
+			const u32 wallIndex = wallId + sector->wallOffset;
+			const SectorWall* wall = s_level->walls.data() + wallIndex;
 			if (wall->adjoin < 0) { continue; }
 
-			const Vec2f v0 = vertices[wall->i0];
-			const Vec2f v1 = vertices[wall->i1];
-			Vec2f dir = { v1.x - v0.x, v1.z - v0.z };
+			const Vec2f v0 = { s_wallX0[wallIndex], s_wallZ0[wallIndex] };
+			Vec2f dir = { s_wallDX[wallIndex], s_wallDZ[wallIndex] };
 			// Normal is reversed due to winding order. This way normals point "in" towards the collision.
 			Vec2f nrm = { dir.z, -dir.x };
 
@@ -448,7 +524,6 @@ namespace TFE_Physics
 	bool correctPosition(Vec3f* pos, s32* curSectorId, f32 radius, bool sendInfMsg)
 	{
 		bool correctionNeeded = false;
-		bool invalidSector = false;
 		const Sector* curSector = s_level->sectors.data() + (*curSectorId);
 		
 		// Make sure the sectorId itself is valid first.
@@ -456,7 +531,6 @@ namespace TFE_Physics
 		if (!Geometry::pointInSector(&posXZ, curSector->vtxCount, s_level->vertices.data() + curSector->vtxOffset, curSector->wallCount, s_level->walls.data() + curSector->wallOffset))
 		{
 			correctionNeeded = true;
-			invalidSector = true;
 		}
 
 		// Then go through all of the adjoins and add to the sector list.
@@ -486,17 +560,11 @@ namespace TFE_Physics
 				u32 sectorId = lines[l] & 0xffffu;
 				u32 wallId = lines[l] >> 16u;
 				const Sector* sector = s_level->sectors.data() + sectorId;
-				const Vec2f* vertices = s_level->vertices.data() + sector->vtxOffset;
-				const SectorWall* wall = s_level->walls.data() + wallId + sector->wallOffset;
 
-				const Vec2f v0 = vertices[wall->i0];
-				const Vec2f v1 = vertices[wall->i1];
 				// Get the distance from the wall.
 				Vec2f point;
 				Vec2f posXZ = { pos->x, pos->z };
-				Geometry::closestPointOnLineSegment(v0, v1, posXZ, &point);
-				Vec2f offset = { point.x - posXZ.x, point.z - posXZ.z };
-				const f32 distSq = TFE_Math::dot(&offset, &offset);
+				const f32 distSq = getWallDistSq(wallId + sector->wallOffset, &posXZ, &point);
 				if (distSq >= rSq) { continue; }
 				// Get the "push" normal - current position -> closestPoint
 				Vec2f nrm = { pos->x - point.x, pos->z - point.z };
@@ -818,47 +886,64 @@ namespace TFE_Physics
 		return closestId;
 	}
 		
+	bool pointInSector(s32 sectorId, const Vec2f* pos)
+	{
+		const Sector* sector = &s_level->sectors[sectorId];
+		return TFE_SectorGrid::insideBounds(&s_sectorGrid, sectorId, pos) &&
+			Geometry::pointInSector(pos, sector->vtxCount, s_level->vertices.data() + sector->vtxOffset, sector->wallCount, s_level->walls.data() + sector->wallOffset);
+	}
+
+	// Gather the sectors on 'layer' that contain 'pos', sorted by sector id.
+	u32 findSectorsOnLayer(s32 layer, const Vec2f* pos, s32* insideIndices, u32 insideCount, u32 maxCount)
+	{
+		u32 candidateCount;
+		const s32* candidates = TFE_SectorGrid::getCandidates(&s_sectorGrid, layer, pos, &candidateCount);
+		const u32 start = insideCount;
+		for (u32 c = 0; c < candidateCount && insideCount < maxCount; c++)
+		{
+			if (pointInSector(candidates[c], pos))
+			{
+				insideIndices[insideCount++] = candidates[c];
+			}
+		}
+		std::sort(insideIndices + start, insideIndices + insideCount);
+		return insideCount;
+	}
+
 	s32 findSector(s32 layer, const Vec2f* pos)
 	{
 		if (!s_level) { return -1; }
-		const s32 sectorCount = (s32)s_level->sectors.size();
-		const Sector* sectors = s_level->sectors.data();
-		const SectorWall* walls = s_level->walls.data();
-		const Vec2f* vertices = s_level->vertices.data();
 
-		for (s32 i = 0; i < sectorCount; i++)
+		// Use the lowest sector id if sectors overlap, which matches searching through the sectors in order.
+		u32 candidateCount;
+		const s32* candidates = TFE_SectorGrid::getCandidates(&s_sectorGrid, layer, pos, &candidateCount);
+		s32 sectorId = -1;
+		for (u32 c = 0; c < candidateCount; c++)
 		{
-			if (sectors[i].layer != layer) { continue; }
-			if (Geometry::pointInSector(pos, sectors[i].vtxCount, vertices + sectors[i].vtxOffset, sectors[i].wallCount, walls + sectors[i].wallOffset))
+			if ((sectorId < 0 || candidates[c] < sectorId) && pointInSector(candidates[c], pos))
 			{
-				return i;
+				sectorId = candidates[c];
 			}
 		}
-		return -1;
+		return sectorId;
 	}
 		
 	s32 findSector(const Vec3f* pos)
 	{
-		const s32 sectorCount = (s32)s_level->sectors.size();
 		const Sector* sectors = s_level->sectors.data();
-		const SectorWall* walls = s_level->walls.data();
-		const Vec2f* vertices = s_level->vertices.data();
-
 		const Vec2f mapPos = { pos->x, pos->z };
 		s32 insideCount = 0;
 		s32 insideIndices[256];
 
 		// sometimes objects can be in multiple valid sectors, so pick the best one.
-		for (s32 i = 0; i < sectorCount; i++)
+		for (s32 layer = s_level->layerMin; layer <= s_level->layerMax; layer++)
 		{
-			if (Geometry::pointInSector(&mapPos, sectors[i].vtxCount, vertices + sectors[i].vtxOffset, sectors[i].wallCount, walls + sectors[i].wallOffset))
-			{
-				assert(insideCount < 256);
-				insideIndices[insideCount++] = i;
-			}
+			insideCount = (s32)findSectorsOnLayer(layer, &mapPos, insideIndices, insideCount, 256);
 		}
 		// if the object isn't inside a sector than return.
 		if (!insideCount) { return -1; }
+		// Keep the sector order so ties are resolved the same way regardless of layer.
+		std::sort(insideIndices, insideIndices + insideCount);
 
 		// First see if its actually inside any sectors based on height.
 		// If so, pick the sector where it is closest to the floor.
@@ -897,6 +982,51 @@ namespace TFE_Physics
 		//assert(0);
 		return closestFit;
 	}
+
+	s32 findSector(const Vec3f* pos, s32 hintSectorId)
+	{
+		if (!s_level || hintSectorId < 0 || hintSectorId >= (s32)s_level->sectors.size())
+		{
+			return findSector(pos);
+		}
+
+		// Most of the time objects are still in the same sector or have moved into a direct neighbor.
+		// Only accept the result if it is unambiguous - inside the sector horizontally, within the height range and
+		// the sector doesn't overlap any other sector, otherwise use the full search so the result matches findSector(pos).
+		// A point exactly on a wall shared with a neighbor stays in the hint sector.
+		const Sector* sectors = s_level->sectors.data();
+		const Sector* hint = &sectors[hintSectorId];
+		const SectorWall* walls = s_level->walls.data() + hint->wallOffset;
+		const Vec2f mapPos = { pos->x, pos->z };
+
+		s32 sectorId = -1;
+		if (pointInSector(hintSectorId, &mapPos))
+		{
+			sectorId = hintSectorId;
+		}
+		else
+		{
+			for (u32 w = 0; w < hint->wallCount; w++)
+			{
+				const s32 adjoin = walls[w].adjoin;
+				if (adjoin >= 0 && adjoin != sectorId && pointInSector(adjoin, &mapPos))
+				{
+					// The point is inside of more than one neighbor.
+					if (sectorId >= 0) { return findSector(pos); }
+					sectorId = adjoin;
+				}
+			}
+		}
+		if (sectorId < 0) { return findSector(pos); }
+
+		// Overlapping sectors (stacked or on other layers) are resolved by the full search.
+		const Sector* sector = &sectors[sectorId];
+		if (s_sectorOverlaps[sectorId] || pos->y < sector->ceilAlt - HEIGHT_EPS || pos->y > sector->floorAlt + HEIGHT_EPS)
+		{
+			return findSector(pos);
+		}
+		return sectorId;
+	}
 		
 	#define MAX_SPRITES_COLLIDE 256
 	s32 s_spritesToCheck[MAX_SPRITES_COLLIDE];
@@ -962,50 +1092,21 @@ namespace TFE_Physics
 		Vec2f p0xz = { origin.x, origin.z };
 		Vec2f p1xz = { p0xz.x + ray->dir.x * maxDist, p0xz.z + ray->dir.z * maxDist };
 
-		const s32 sectorCount   = (s32)s_level->sectors.size();
 		const Sector* sectors   = s_level->sectors.data();
 		const SectorWall* walls = s_level->walls.data();
-		const Vec2f* vertices   = s_level->vertices.data();
 
 		s32 nextSector = ray->originSectorId;
 		s32 windowId = -1, prevSector = -1;
-		bool hitFound = false;
 		while (nextSector >= 0 && hitInfo->hitCount < 16)
 		{
 			const s32 sectorId = nextSector;
 			const Sector* curSector = &sectors[sectorId];
 			const SectorWall* curWalls = walls + curSector->wallOffset;
-			const Vec2f* curVtx = vertices + curSector->vtxOffset;
-			const s32 wallCount = (s32)curSector->wallCount;
 			nextSector = -1;
 
 			// Check the ray against all of the walls and take the closest hit, if any.
-			f32 closestHit = FLT_MAX;
-			s32 closestWallId = -1;
-			for (s32 w = 0; w < wallCount; w++)
-			{
-				// skip if this is the portal we just went through.
-				// TODO: Figure out why this doesn't always work.
-				if (curWalls[w].adjoin >= 0 && curWalls[w].mirror == windowId && curWalls[w].adjoin == prevSector)
-				{
-					continue;
-				}
-
-				const s32 i0 = curWalls[w].i0;
-				const s32 i1 = curWalls[w].i1;
-				const Vec2f* v0 = &curVtx[i0];
-				const Vec2f* v1 = &curVtx[i1];
-
-				f32 s, t;
-				if (Geometry::lineSegmentIntersect(&p0xz, &p1xz, v0, v1, &s, &t))
-				{
-					if (s < closestHit)
-					{
-						closestHit = s;
-						closestWallId = w;
-					}
-				}
-			}
+			f32 closestHit;
+			s32 closestWallId = findClosestWallHit(&p0xz, &p1xz, curSector, windowId, prevSector, &closestHit);
 			if (closestWallId < 0)
 			{
 				break;
@@ -1084,10 +1185,8 @@ namespace TFE_Physics
 		Vec2f p0xz = { origin.x, origin.z };
 		Vec2f p1xz = { p0xz.x + ray->dir.x * maxDist, p0xz.z + ray->dir.z * maxDist };
 		
-		const s32 sectorCount = (s32)s_level->sectors.size();
 		const Sector* sectors = s_level->sectors.data();
 		const SectorWall* walls = s_level->walls.data();
-		const Vec2f* vertices = s_level->vertices.data();
 
 		const GameObject* objects = LevelGameObjects::getGameObjectList()->data();
 		const SectorObjectList* sectorObjects = LevelGameObjects::getSectorObjectList();
@@ -1105,8 +1204,6 @@ namespace TFE_Physics
 			const s32 sectorId = nextSector;
 			const Sector* curSector = &sectors[sectorId];
 			const SectorWall* curWalls = walls + curSector->wallOffset;
-			const Vec2f* curVtx = vertices + curSector->vtxOffset;
-			const s32 wallCount = (s32)curSector->wallCount;
 			nextSector = -1;
 
 			// Add Sprites to check.
@@ -1128,32 +1225,8 @@ namespace TFE_Physics
 			hitInfo->hitSectorId = sectorId;
 
 			// Check the ray against all of the walls and take the closest hit, if any.
-			f32 closestHit = FLT_MAX;
-			s32 closestWallId = -1;
-			for (s32 w = 0; w < wallCount; w++)
-			{
-				// skip if this is the portal we just went through.
-				// TODO: Figure out why this doesn't always work.
-				if (curWalls[w].adjoin >= 0 && curWalls[w].mirror == windowId && curWalls[w].adjoin == prevSector)
-				{
-					continue;
-				}
-
-				const s32 i0 = curWalls[w].i0;
-				const s32 i1 = curWalls[w].i1;
-				const Vec2f* v0 = &curVtx[i0];
-				const Vec2f* v1 = &curVtx[i1];
-
-				f32 s, t;
-				if (Geometry::lineSegmentIntersect(&p0xz, &p1xz, v0, v1, &s, &t))
-				{
-					if (s < closestHit)
-					{
-						closestHit = s;
-						closestWallId = w;
-					}
-				}
-			}
+			f32 closestHit;
+			s32 closestWallId = findClosestWallHit(&p0xz, &p1xz, curSector, windowId, prevSector, &closestHit);
 			if (closestWallId < 0)
 			{
 				closestHit = maxDist;
@@ -1290,6 +1363,29 @@ namespace TFE_Physics
 		return hitFound;
 	}
 
+	u32 traceRays(const Ray* rays, u32 count, RayHitInfo* hitInfo, bool* hitFound)
+	{
+		// Trace the rays starting in the same sector together, so they share the sector walls and objects in the cache.
+		s_rayOrder.resize(count);
+		for (u32 i = 0; i < count; i++)
+		{
+			s_rayOrder[i] = i;
+		}
+		std::sort(s_rayOrder.begin(), s_rayOrder.end(), [rays](u32 a, u32 b)
+		{
+			return rays[a].originSectorId < rays[b].originSectorId || (rays[a].originSectorId == rays[b].originSectorId && a < b);
+		});
+
+		u32 hitCount = 0;
+		for (u32 i = 0; i < count; i++)
+		{
+			const u32 index = s_rayOrder[i];
+			hitFound[index] = traceRay(&rays[index], &hitInfo[index]);
+			hitCount += hitFound[index] ? 1 : 0;
+		}
+		return hitCount;
+	}
+
 	// Traces a ray through the level.
 	// Ignores height and will always pass through walls with adjoins.
 	bool traceRayIgnoreHeight(const RayIgnoreHeight* ray, s32* newSectorId)
@@ -1370,4 +1466,213 @@ namespace TFE_Physics
 		}
 		return false;
 	}
+
+	//////////////////////////////////////////////
+	// Internal
+	//////////////////////////////////////////////
+	// Find the closest wall of 'sector' crossed by the segment p0 -> p1, skipping the portal the ray just came through.
+	// This matches testing each wall with Geometry::lineSegmentIntersect() in order; 'closestHit' is the parametric distance along the segment.
+	s32 findClosestWallHit(const Vec2f* p0, const Vec2f* p1, const Sector* sector, s32 windowId, s32 prevSector, f32* closestHit)
+	{
+		const SectorWall* curWalls = s_level->walls.data() + sector->wallOffset;
+		const f32* wallX0 = s_wallX0.data() + sector->wallOffset;
+		const f32* wallZ0 = s_wallZ0.data() + sector->wallOffset;
+		const f32* wallDX = s_wallDX.data() + sector->wallOffset;
+		const f32* wallDZ = s_wallDZ.data() + sector->wallOffset;
+		const s32 wallCount = (s32)sector->wallCount;
+
+		const f32 ux = p1->x - p0->x;
+		const f32 uz = p1->z - p0->z;
+		f32 closest = FLT_MAX;
+		s32 closestWallId = -1;
+		s32 w = 0;
+	#ifdef PHYSICS_SSE2
+		const __m128 ux4 = _mm_set1_ps(ux);
+		const __m128 uz4 = _mm_set1_ps(uz);
+		const __m128 ax4 = _mm_set1_ps(p0->x);
+		const __m128 az4 = _mm_set1_ps(p0->z);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 eps = _mm_set1_ps(FLT_EPSILON);
+		const __m128 minParam = _mm_set1_ps(-FLT_EPSILON);
+		const __m128 maxParam = _mm_set1_ps(1.0f + FLT_EPSILON);
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		for (; w + 4 <= wallCount; w += 4)
+		{
+			const __m128 vx = _mm_loadu_ps(wallDX + w);
+			const __m128 vz = _mm_loadu_ps(wallDZ + w);
+			const __m128 wx = _mm_sub_ps(ax4, _mm_loadu_ps(wallX0 + w));
+			const __m128 wz = _mm_sub_ps(az4, _mm_loadu_ps(wallZ0 + w));
+
+			const __m128 det = _mm_sub_ps(_mm_mul_ps(vx, uz4), _mm_mul_ps(vz, ux4));
+			const __m128 invDet = _mm_div_ps(one, det);
+			const __m128 s = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(vz, wx), _mm_mul_ps(vx, wz)), invDet);
+			const __m128 t = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(uz4, wx), _mm_mul_ps(ux4, wz)), invDet);
+
+			__m128 mask = _mm_cmpnlt_ps(_mm_and_ps(det, absMask), eps);
+			mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpgt_ps(s, minParam), _mm_cmplt_ps(s, maxParam)));
+			mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpgt_ps(t, minParam), _mm_cmplt_ps(t, maxParam)));
+			const s32 hitMask = _mm_movemask_ps(mask);
+			if (!hitMask) { continue; }
+
+			f32 sLane[4];
+			_mm_storeu_ps(sLane, s);
+			for (s32 l = 0; l < 4; l++)
+			{
+				const SectorWall* wall = &curWalls[w + l];
+				// skip if this is the portal we just went through.
+				// TODO: Figure out why this doesn't always work.
+				if (!(hitMask & (1 << l)) || (wall->adjoin >= 0 && wall->mirror == windowId && wall->adjoin == prevSector)) { continue; }
+				if (sLane[l] < closest)
+				{
+					closest = sLane[l];
+					closestWallId = w + l;
+				}
+			}
+		}
+	#endif
+		for (; w < wallCount; w++)
+		{
+			const SectorWall* wall = &curWalls[w];
+			if (wall->adjoin >= 0 && wall->mirror == windowId && wall->adjoin == prevSector) { continue; }
+
+			const f32 vx = wallDX[w], vz = wallDZ[w];
+			const f32 wx = p0->x - wallX0[w], wz = p0->z - wallZ0[w];
+			f32 det = vx*uz - vz*ux;
+			if (fabsf(det) < FLT_EPSILON) { continue; }
+			det = 1.0f / det;
+
+			const f32 s = (vz*wx - vx*wz) * det;
+			const f32 t = (uz*wx - ux*wz) * det;
+			if (s > -FLT_EPSILON && s < 1.0f + FLT_EPSILON && t > -FLT_EPSILON && t < 1.0f + FLT_EPSILON && s < closest)
+			{
+				closest = s;
+				closestWallId = w;
+			}
+		}
+
+		*closestHit = closest;
+		return closestWallId;
+	}
+
+	// Squared distance from 'pos' to the closest point on the wall, which is returned in 'point'.
+	// Matches Geometry::closestPointOnLineSegment() using the cached wall edge.
+	f32 getWallDistSq(u32 wallIndex, const Vec2f* pos, Vec2f* point)
+	{
+		const f32 x0 = s_wallX0[wallIndex], z0 = s_wallZ0[wallIndex];
+		const f32 dx = s_wallDX[wallIndex], dz = s_wallDZ[wallIndex];
+		const f32 lenSq = s_wallLenSq[wallIndex];
+
+		f32 s = 0.0f;
+		if (lenSq > 0.0f)
+		{
+			s = std::max(0.0f, std::min(1.0f, ((pos->x - x0) * dx + (pos->z - z0) * dz) / lenSq));
+		}
+		point->x = x0 + s * dx;
+		point->z = z0 + s * dz;
+
+		const f32 offsetX = point->x - pos->x;
+		const f32 offsetZ = point->z - pos->z;
+		return offsetX * offsetX + offsetZ * offsetZ;
+	}
+
+	// Conservative test to skip all of the walls of a sector: false if the circle cannot touch any wall.
+	bool circleOverlapsSector(const Sector* sector, const Vec2f* pos, f32 radius)
+	{
+		const SectorGridBounds* bounds = &s_sectorGrid.bounds[sector->id];
+		const f32 r = radius + 0.01f;
+		return pos->x + r >= bounds->min.x && pos->x - r <= bounds->max.x && pos->z + r >= bounds->min.z && pos->z - r <= bounds->max.z;
+	}
+
+	// Flag the sector if it shares area with any other sector whose bounds overlap its own.
+	void updateSectorOverlap(s32 sectorId, bool flagOthers)
+	{
+		if (sectorId >= (s32)s_sectorOverlaps.size())
+		{
+			s_sectorOverlaps.resize(sectorId + 1, 0);
+		}
+
+		TFE_SectorGrid::getSectorsInBounds(&s_sectorGrid, &s_sectorGrid.bounds[sectorId], &s_overlapCandidates);
+		u8 overlaps = 0;
+		const size_t count = s_overlapCandidates.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			const s32 other = s_overlapCandidates[i];
+			if (other == sectorId || !sectorsOverlap(sectorId, other)) { continue; }
+
+			overlaps = 1;
+			if (!flagOthers) { break; }
+			s_sectorOverlaps[other] = 1;
+		}
+		s_sectorOverlaps[sectorId] = overlaps;
+	}
+
+	// Conservative area overlap test between two sectors: sectors that only touch along walls or at vertices
+	// do not overlap, any other case that shares area is reported, along with a few touching cases that are unclear.
+	bool sectorsOverlap(s32 sectorA, s32 sectorB)
+	{
+		const f32 eps = 0.001f;
+		const SectorGridBounds* boundsA = &s_sectorGrid.bounds[sectorA];
+		const SectorGridBounds* boundsB = &s_sectorGrid.bounds[sectorB];
+		if (boundsA->max.x - eps <= boundsB->min.x || boundsB->max.x - eps <= boundsA->min.x ||
+			boundsA->max.z - eps <= boundsB->min.z || boundsB->max.z - eps <= boundsA->min.z)
+		{
+			return false;
+		}
+
+		const Sector* a = &s_level->sectors[sectorA];
+		const Sector* b = &s_level->sectors[sectorB];
+		// Walls that cross in the middle of both walls.
+		for (u32 wa = a->wallOffset; wa < a->wallOffset + a->wallCount; wa++)
+		{
+			for (u32 wb = b->wallOffset; wb < b->wallOffset + b->wallCount; wb++)
+			{
+				const f32 det = s_wallDX[wa] * s_wallDZ[wb] - s_wallDZ[wa] * s_wallDX[wb];
+				if (fabsf(det) < FLT_EPSILON) { continue; }
+
+				const f32 offsetX = s_wallX0[wb] - s_wallX0[wa];
+				const f32 offsetZ = s_wallZ0[wb] - s_wallZ0[wa];
+				const f32 sa = (offsetX * s_wallDZ[wb] - offsetZ * s_wallDX[wb]) / det;
+				const f32 sb = (offsetX * s_wallDZ[wa] - offsetZ * s_wallDX[wa]) / det;
+				if (sa > eps && sa < 1.0f - eps && sb > eps && sb < 1.0f - eps) { return true; }
+			}
+		}
+
+		// Vertices or wall midpoints of one sector inside of the other, this also catches one sector fully inside of another.
+		// Sectors where every vertex lies on the walls of the other are either coincident (stacked) or one covers part of
+		// the other, so they are reported as well.
+		const s32 sectorIds[] = { sectorA, sectorB };
+		for (s32 i = 0; i < 2; i++)
+		{
+			const Sector* sector = &s_level->sectors[sectorIds[i]];
+			const s32 otherId = sectorIds[1 - i];
+			bool allOnWalls = true;
+			for (u32 w = sector->wallOffset; w < sector->wallOffset + sector->wallCount; w++)
+			{
+				const Vec2f vertex = { s_wallX0[w], s_wallZ0[w] };
+				const Vec2f midpoint = { s_wallX0[w] + s_wallDX[w] * 0.5f, s_wallZ0[w] + s_wallDZ[w] * 0.5f };
+				if (pointStrictlyInSector(otherId, &vertex) || pointStrictlyInSector(otherId, &midpoint)) { return true; }
+				allOnWalls = allOnWalls && pointOnSectorWall(otherId, &vertex);
+			}
+			if (allOnWalls) { return true; }
+		}
+		return false;
+	}
+
+	bool pointOnSectorWall(s32 sectorId, const Vec2f* pos)
+	{
+		const f32 epsSq = 0.001f * 0.001f;
+		const Sector* sector = &s_level->sectors[sectorId];
+		for (u32 w = sector->wallOffset; w < sector->wallOffset + sector->wallCount; w++)
+		{
+			Vec2f point;
+			if (getWallDistSq(w, pos, &point) <= epsSq) { return true; }
+		}
+		return false;
+	}
+
+	// Inside the sector and not on any of its walls.
+	bool pointStrictlyInSector(s32 sectorId, const Vec2f* pos)
+	{
+		return pointInSector(sectorId, pos) && !pointOnSectorWall(sectorId, pos);
+	}
 }
@@ -78,6 +78,10 @@ namespace TFE_Physics
 
 	s32 findSector(s32 layer, const Vec2f* pos);
 	s32 findSector(const Vec3f* pos);
+	// Same result as findSector(pos) but checks 'hintSectorId' and its adjoins first, which is usually where the point ends up.
+	s32 findSector(const Vec3f* pos, s32 hintSectorId);
+	// Update the point location data after the vertices of a sector have changed.
+	void updateSector(s32 sectorId);
 
 	// Find the closest wall to 'pos' that lies within sector 'sectorId'
 	// Only accept walls within 'maxDist' and in sectors on layer 'layer'
@@ -88,6 +92,11 @@ namespace TFE_Physics
 	// Traces a ray through the level.
 	// Returns true if the ray hit something.
 	bool traceRay(const Ray* ray, RayHitInfo* hitInfo);
+	// Traces 'count' rays, filling in hitInfo[i] and hitFound[i] for each ray as if traceRay() was called on it.
+	// Rays starting in the same sector are traced together. Returns the number of rays that hit something.
+	// Only the wall tests use SIMD, the floor, ceiling and sprite tests are scalar and each ray still walks
+	// its own adjoins. Callers with a single ray per event (hitscan fire) should call traceRay() directly.
+	u32 traceRays(const Ray* rays, u32 count, RayHitInfo* hitInfo, bool* hitFound);
 
 	// Traces a ray through the level.
 	// Ignores height and will always pass through walls with adjoins.
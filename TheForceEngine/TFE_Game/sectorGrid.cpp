@@ -0,0 +1,178 @@
+#include "sectorGrid.h"
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <algorithm>
+
+namespace TFE_SectorGrid
+{
+	static const s32 c_maxGridDim = 128;
+	static const f32 c_minCellSize = 4.0f;
+
+	void getCellRange(const SectorGrid* grid, const SectorGridBounds* bounds, s32* x0, s32* z0, s32* x1, s32* z1);
+	s32  getCell(f32 value, f32 origin, f32 invCellSize, s32 dim);
+	void removeSector(SectorGrid* grid, s32 sectorId);
+
+	void init(SectorGrid* grid, const SectorGridBounds* levelBounds, s32 layerMin, s32 layerMax, u32 sectorCount)
+	{
+		clear(grid);
+
+		const f32 extentX = std::max(levelBounds->max.x - levelBounds->min.x, 1.0f);
+		const f32 extentZ = std::max(levelBounds->max.z - levelBounds->min.z, 1.0f);
+		// Aim for roughly one sector per cell, most sectors are small so the big ones end up in many cells.
+		f32 cellSize = std::max(sqrtf(extentX * extentZ / f32(std::max(sectorCount, 1u))), c_minCellSize);
+		cellSize = std::max(cellSize, std::max(extentX, extentZ) / f32(c_maxGridDim));
+
+		grid->layerMin = layerMin;
+		grid->layerCount = std::max(layerMax - layerMin + 1, 1);
+		grid->origin = levelBounds->min;
+		grid->invCellSize = 1.0f / cellSize;
+		grid->width  = std::min(s32(extentX * grid->invCellSize) + 1, c_maxGridDim);
+		grid->height = std::min(s32(extentZ * grid->invCellSize) + 1, c_maxGridDim);
+		grid->cells.resize(size_t(grid->layerCount) * size_t(grid->width * grid->height));
+		grid->bounds.resize(sectorCount);
+		grid->layers.assign(sectorCount, INT_MIN);
+	}
+
+	void clear(SectorGrid* grid)
+	{
+		grid->cells.clear();
+		grid->bounds.clear();
+		grid->layers.clear();
+		grid->layerCount = 0;
+		grid->width = 0;
+		grid->height = 0;
+	}
+
+	void setSector(SectorGrid* grid, s32 sectorId, s32 layer, const SectorGridBounds* bounds)
+	{
+		if (sectorId < 0) { return; }
+		if (sectorId >= (s32)grid->layers.size())
+		{
+			grid->bounds.resize(sectorId + 1);
+			grid->layers.resize(sectorId + 1, INT_MIN);
+		}
+		removeSector(grid, sectorId);
+
+		grid->bounds[sectorId] = *bounds;
+		const s32 layerIndex = layer - grid->layerMin;
+		if (layerIndex < 0 || layerIndex >= grid->layerCount) { return; }
+		grid->layers[sectorId] = layer;
+
+		s32 x0, z0, x1, z1;
+		getCellRange(grid, bounds, &x0, &z0, &x1, &z1);
+		std::vector<s32>* cells = grid->cells.data() + layerIndex * grid->width * grid->height;
+		for (s32 z = z0; z <= z1; z++)
+		{
+			for (s32 x = x0; x <= x1; x++)
+			{
+				cells[z * grid->width + x].push_back(sectorId);
+			}
+		}
+	}
+
+	const s32* getCandidates(const SectorGrid* grid, s32 layer, const Vec2f* pos, u32* count)
+	{
+		const s32 layerIndex = layer - grid->layerMin;
+		if (layerIndex < 0 || layerIndex >= grid->layerCount || grid->cells.empty())
+		{
+			*count = 0;
+			return nullptr;
+		}
+
+		const s32 x = getCell(pos->x, grid->origin.x, grid->invCellSize, grid->width);
+		const s32 z = getCell(pos->z, grid->origin.z, grid->invCellSize, grid->height);
+		const std::vector<s32>& cell = grid->cells[(layerIndex * grid->height + z) * grid->width + x];
+		*count = (u32)cell.size();
+		return cell.data();
+	}
+
+	void getSectorsInBounds(const SectorGrid* grid, const SectorGridBounds* bounds, std::vector<s32>* sectors)
+	{
+		sectors->clear();
+		if (grid->cells.empty()) { return; }
+
+		s32 x0, z0, x1, z1;
+		getCellRange(grid, bounds, &x0, &z0, &x1, &z1);
+		for (s32 layerIndex = 0; layerIndex < grid->layerCount; layerIndex++)
+		{
+			const std::vector<s32>* cells = grid->cells.data() + layerIndex * grid->width * grid->height;
+			for (s32 z = z0; z <= z1; z++)
+			{
+				for (s32 x = x0; x <= x1; x++)
+				{
+					const std::vector<s32>& cell = cells[z * grid->width + x];
+					sectors->insert(sectors->end(), cell.begin(), cell.end());
+				}
+			}
+		}
+		std::sort(sectors->begin(), sectors->end());
+		sectors->erase(std::unique(sectors->begin(), sectors->end()), sectors->end());
+	}
+
+	bool insideBounds(const SectorGrid* grid, s32 sectorId, const Vec2f* pos)
+	{
+		const SectorGridBounds* bounds = &grid->bounds[sectorId];
+		return pos->x >= bounds->min.x && pos->x <= bounds->max.x && pos->z >= bounds->min.z && pos->z <= bounds->max.z;
+	}
+
+	void computeBounds(const Vec2f* vertices, u32 vertexCount, SectorGridBounds* bounds)
+	{
+		if (!vertexCount)
+		{
+			*bounds = {};
+			return;
+		}
+
+		bounds->min = vertices[0];
+		bounds->max = vertices[0];
+		for (u32 v = 1; v < vertexCount; v++)
+		{
+			bounds->min.x = std::min(bounds->min.x, vertices[v].x);
+			bounds->min.z = std::min(bounds->min.z, vertices[v].z);
+			bounds->max.x = std::max(bounds->max.x, vertices[v].x);
+			bounds->max.z = std::max(bounds->max.z, vertices[v].z);
+		}
+	}
+
+	//////////////////////////////////////////////
+	// Internal
+	//////////////////////////////////////////////
+	s32 getCell(f32 value, f32 origin, f32 invCellSize, s32 dim)
+	{
+		const f32 cell = (value - origin) * invCellSize;
+		if (cell <= 0.0f) { return 0; }
+		return std::min(s32(cell), dim - 1);
+	}
+
+	void getCellRange(const SectorGrid* grid, const SectorGridBounds* bounds, s32* x0, s32* z0, s32* x1, s32* z1)
+	{
+		*x0 = getCell(bounds->min.x, grid->origin.x, grid->invCellSize, grid->width);
+		*z0 = getCell(bounds->min.z, grid->origin.z, grid->invCellSize, grid->height);
+		*x1 = getCell(bounds->max.x, grid->origin.x, grid->invCellSize, grid->width);
+		*z1 = getCell(bounds->max.z, grid->origin.z, grid->invCellSize, grid->height);
+	}
+
+	void removeSector(SectorGrid* grid, s32 sectorId)
+	{
+		const s32 layer = grid->layers[sectorId];
+		if (layer == INT_MIN) { return; }
+		grid->layers[sectorId] = INT_MIN;
+
+		s32 x0, z0, x1, z1;
+		getCellRange(grid, &grid->bounds[sectorId], &x0, &z0, &x1, &z1);
+		std::vector<s32>* cells = grid->cells.data() + (layer - grid->layerMin) * grid->width * grid->height;
+		for (s32 z = z0; z <= z1; z++)
+		{
+			for (s32 x = x0; x <= x1; x++)
+			{
+				std::vector<s32>& cell = cells[z * grid->width + x];
+				std::vector<s32>::iterator iSector = std::find(cell.begin(), cell.end(), sectorId);
+				assert(iSector != cell.end());
+				if (iSector == cell.end()) { continue; }
+				*iSector = cell.back();
+				cell.pop_back();
+			}
+		}
+	}
+}
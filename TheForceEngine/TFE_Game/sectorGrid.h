@@ -0,0 +1,56 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Sector Grid
+// Per-layer uniform grid over the sector bounds, used to find the
+// sectors that may contain a point without testing every sector in
+// the level. Each sector is stored in every cell overlapped by its
+// bounds, so the candidates for a point are the sectors in its cell.
+//
+// Sectors can be moved individually when their vertices change
+// (such as INF morphs), points and sectors outside of the grid bounds
+// are clamped to the edge cells.
+//////////////////////////////////////////////////////////////////////
+
+#include <TFE_System/types.h>
+#include <vector>
+
+struct SectorGridBounds
+{
+	Vec2f min;
+	Vec2f max;
+};
+
+struct SectorGrid
+{
+	s32 layerMin = 0;
+	s32 layerCount = 0;
+	s32 width = 0;
+	s32 height = 0;
+	Vec2f origin = {};
+	f32 invCellSize = 1.0f;
+
+	// Candidate sectors per cell, layer major.
+	std::vector<std::vector<s32>> cells;
+	// Bounds and layer of each sector as currently stored in the grid.
+	std::vector<SectorGridBounds> bounds;
+	std::vector<s32> layers;
+};
+
+namespace TFE_SectorGrid
+{
+	// Setup an empty grid covering 'levelBounds', the cell size is chosen based on the sector count.
+	void init(SectorGrid* grid, const SectorGridBounds* levelBounds, s32 layerMin, s32 layerMax, u32 sectorCount);
+	void clear(SectorGrid* grid);
+
+	// Insert or move a sector, sectors on layers outside of the grid range are not stored.
+	void setSector(SectorGrid* grid, s32 sectorId, s32 layer, const SectorGridBounds* bounds);
+
+	// Returns the sectors on 'layer' that may contain 'pos', the caller still has to test if the point is inside.
+	const s32* getCandidates(const SectorGrid* grid, s32 layer, const Vec2f* pos, u32* count);
+	// Gather the sectors on any layer stored in the cells overlapped by 'bounds', sorted by sector id without duplicates.
+	void getSectorsInBounds(const SectorGrid* grid, const SectorGridBounds* bounds, std::vector<s32>* sectors);
+	// Quick rejection using the stored sector bounds.
+	bool insideBounds(const SectorGrid* grid, s32 sectorId, const Vec2f* pos);
+
+	void computeBounds(const Vec2f* vertices, u32 vertexCount, SectorGridBounds* bounds);
+}
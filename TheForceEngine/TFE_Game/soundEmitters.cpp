@@ -0,0 +1,238 @@
+#include "soundEmitters.h"
+#include "gameObject.h"
+#include <TFE_System/system.h>
+#include <TFE_System/math.h>
+#include <TFE_Audio/audioSystem.h>
+#include <TFE_Asset/vocAsset.h>
+#include <assert.h>
+#include <algorithm>
+#include <vector>
+
+namespace TFE_SoundEmitters
+{
+	#define EMITTER_INACTIVE 0xffffffffu
+
+	// Sources are added inside the clip distance and removed outside of clip distance + border, so we aren't constantly
+	// adding and removing sounds with small movements.
+	const f32 c_border = 16.0f;
+	const f32 c_cellSize = TFE_Audio::c_clipDistance * 0.5f;
+	const u32 c_maxGridDim = 256;
+
+	struct SoundEmitter
+	{
+		u32 objectIndex;
+		u32 activeIndex;
+		SoundBuffer* stream;	// open while active if the object sound is streamed.
+	};
+
+	static std::vector<SoundEmitter> s_emitters;
+	static std::vector<u32> s_activeEmitters;
+
+	// Uniform grid on the XZ plane, stored as cell ranges into s_cellEmitters.
+	static std::vector<u32> s_cellStart;
+	static std::vector<u32> s_cellEmitters;
+	static Vec2f s_gridMin;
+	static f32 s_cellScale;
+	static s32 s_gridWidth;
+	static s32 s_gridHeight;
+
+	void getCell(f32 x, f32 z, s32* cx, s32* cz);
+	void stopEmitter(SoundEmitter* emitter, GameObject* object);
+
+	void build(const LevelData* level)
+	{
+		clear();
+		if (!level) { return; }
+
+		GameObjectList* objectList = LevelGameObjects::getGameObjectList();
+		const u32 objectCount = (u32)objectList->size();
+		const GameObject* objects = objectList->data();
+
+		// Gather the emitters and their bounds.
+		Vec2f boundsMin = { FLT_MAX, FLT_MAX };
+		Vec2f boundsMax = { -FLT_MAX, -FLT_MAX };
+		for (u32 i = 0; i < objectCount; i++)
+		{
+			const GameObject* object = &objects[i];
+			if (object->oclass != CLASS_SOUND || (!object->buffer && object->soundStream < 0) || object->sectorId < 0) { continue; }
+
+			SoundEmitter emitter = {};
+			emitter.objectIndex = i;
+			emitter.activeIndex = EMITTER_INACTIVE;
+			s_emitters.push_back(emitter);
+
+			boundsMin.x = std::min(boundsMin.x, object->position.x);
+			boundsMin.z = std::min(boundsMin.z, object->position.z);
+			boundsMax.x = std::max(boundsMax.x, object->position.x);
+			boundsMax.z = std::max(boundsMax.z, object->position.z);
+		}
+		const u32 emitterCount = (u32)s_emitters.size();
+		if (!emitterCount) { return; }
+
+		// Size the grid to cover the emitters, growing the cells if the level is very large.
+		f32 cellSize = c_cellSize;
+		const f32 extent = std::max(boundsMax.x - boundsMin.x, boundsMax.z - boundsMin.z);
+		if (extent / cellSize >= f32(c_maxGridDim))
+		{
+			cellSize = extent / f32(c_maxGridDim - 1);
+		}
+		s_gridMin = boundsMin;
+		s_cellScale = 1.0f / cellSize;
+		s_gridWidth  = s32((boundsMax.x - boundsMin.x) * s_cellScale) + 1;
+		s_gridHeight = s32((boundsMax.z - boundsMin.z) * s_cellScale) + 1;
+
+		// Bucket the emitters by cell (counting sort).
+		const u32 cellCount = u32(s_gridWidth * s_gridHeight);
+		std::vector<u32> emitterCell(emitterCount);
+		s_cellStart.assign(cellCount + 1, 0);
+		for (u32 e = 0; e < emitterCount; e++)
+		{
+			const Vec3f* pos = &objects[s_emitters[e].objectIndex].position;
+			s32 cx, cz;
+			getCell(pos->x, pos->z, &cx, &cz);
+			emitterCell[e] = u32(cz * s_gridWidth + cx);
+			s_cellStart[emitterCell[e] + 1]++;
+		}
+		for (u32 c = 0; c < cellCount; c++)
+		{
+			s_cellStart[c + 1] += s_cellStart[c];
+		}
+		std::vector<u32> cellFill(s_cellStart.begin(), s_cellStart.end() - 1);
+		s_cellEmitters.resize(emitterCount);
+		for (u32 e = 0; e < emitterCount; e++)
+		{
+			s_cellEmitters[cellFill[emitterCell[e]]++] = e;
+		}
+
+		s_activeEmitters.reserve(emitterCount);
+		TFE_System::logWrite(LOG_MSG, "Sound Emitters", "%u emitters, %d x %d grid.", emitterCount, s_gridWidth, s_gridHeight);
+	}
+
+	void clear()
+	{
+		// Streams have to be closed, the sources themselves are released by TFE_Audio::stopAllSounds().
+		// The objects aren't touched since the level objects may already have been replaced.
+		for (size_t i = 0; i < s_activeEmitters.size(); i++)
+		{
+			SoundEmitter* emitter = &s_emitters[s_activeEmitters[i]];
+			if (emitter->stream)
+			{
+				TFE_VocAsset::closeStream(emitter->stream);
+				emitter->stream = nullptr;
+			}
+		}
+		s_emitters.clear();
+		s_activeEmitters.clear();
+		s_cellStart.clear();
+		s_cellEmitters.clear();
+		s_gridWidth = 0;
+		s_gridHeight = 0;
+	}
+
+	void update(const Vec3f* listenerPos)
+	{
+		if (s_emitters.empty()) { return; }
+
+		GameObject* objects = LevelGameObjects::getGameObjectList()->data();
+		const f32 soundMaxDistSq = TFE_Audio::c_clipDistance * TFE_Audio::c_clipDistance;
+		const f32 removeDistSq = (TFE_Audio::c_clipDistance + c_border) * (TFE_Audio::c_clipDistance + c_border);
+
+		// Remove active sources that are now out of range.
+		for (u32 i = 0; i < (u32)s_activeEmitters.size();)
+		{
+			SoundEmitter* emitter = &s_emitters[s_activeEmitters[i]];
+			GameObject* object = &objects[emitter->objectIndex];
+
+			const Vec3f offset = { object->position.x - listenerPos->x, object->position.y - listenerPos->y, object->position.z - listenerPos->z };
+			if (TFE_Math::dot(&offset, &offset) > removeDistSq || !object->source)
+			{
+				stopEmitter(emitter, object);
+				emitter->activeIndex = EMITTER_INACTIVE;
+
+				// Swap-remove.
+				const u32 last = s_activeEmitters.back();
+				s_activeEmitters[i] = last;
+				s_emitters[last].activeIndex = i;
+				s_activeEmitters.pop_back();
+				continue;
+			}
+			i++;
+		}
+
+		// Only cells overlapping the clip distance around the listener can hold emitters that need to start.
+		s32 x0, z0, x1, z1;
+		getCell(listenerPos->x - TFE_Audio::c_clipDistance, listenerPos->z - TFE_Audio::c_clipDistance, &x0, &z0);
+		getCell(listenerPos->x + TFE_Audio::c_clipDistance, listenerPos->z + TFE_Audio::c_clipDistance, &x1, &z1);
+		for (s32 cz = z0; cz <= z1; cz++)
+		{
+			for (s32 cx = x0; cx <= x1; cx++)
+			{
+				const u32 cell = u32(cz * s_gridWidth + cx);
+				const u32 end = s_cellStart[cell + 1];
+				for (u32 c = s_cellStart[cell]; c < end; c++)
+				{
+					const u32 e = s_cellEmitters[c];
+					SoundEmitter* emitter = &s_emitters[e];
+					if (emitter->activeIndex != EMITTER_INACTIVE) { continue; }
+
+					GameObject* object = &objects[emitter->objectIndex];
+					const Vec3f offset = { object->position.x - listenerPos->x, object->position.y - listenerPos->y, object->position.z - listenerPos->z };
+					if (TFE_Math::dot(&offset, &offset) > soundMaxDistSq) { continue; }
+
+					// Add a new looping 3D source, long sounds are streamed while the emitter is active.
+					const SoundBuffer* buffer = object->buffer;
+					if (object->soundStream >= 0)
+					{
+						emitter->stream = TFE_VocAsset::openStreamFromIndex(object->soundStream);
+						// Don't try again every frame if the sound can't be streamed.
+						if (!emitter->stream) { object->soundStream = -1; }
+						buffer = emitter->stream;
+					}
+					object->source = TFE_Audio::createSoundSource(SOUND_3D, 1.0f, MONO_SEPERATION, buffer, &object->position, SOUND_CATEGORY_AMBIENT, SOUND_PRIORITY_LOW);
+					if (!object->source)
+					{
+						stopEmitter(emitter, object);
+						continue;
+					}
+
+					TFE_Audio::playSource(object->source, true);
+					emitter->activeIndex = (u32)s_activeEmitters.size();
+					s_activeEmitters.push_back(e);
+				}
+			}
+		}
+	}
+
+	u32 getEmitterCount()
+	{
+		return (u32)s_emitters.size();
+	}
+
+	u32 getActiveEmitterCount()
+	{
+		return (u32)s_activeEmitters.size();
+	}
+
+	//////////////////////////////////////////////
+	// Internal
+	//////////////////////////////////////////////
+	void stopEmitter(SoundEmitter* emitter, GameObject* object)
+	{
+		if (object->source)
+		{
+			TFE_Audio::freeSource(object->source);
+			object->source = nullptr;
+		}
+		if (emitter->stream)
+		{
+			TFE_VocAsset::closeStream(emitter->stream);
+			emitter->stream = nullptr;
+		}
+	}
+
+	void getCell(f32 x, f32 z, s32* cx, s32* cz)
+	{
+		*cx = std::max(0, std::min(s32((x - s_gridMin.x) * s_cellScale), s_gridWidth  - 1));
+		*cz = std::max(0, std::min(s32((z - s_gridMin.z) * s_cellScale), s_gridHeight - 1));
+	}
+}
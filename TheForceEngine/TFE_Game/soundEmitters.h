@@ -0,0 +1,24 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Sound Emitters
+// Spatial index of the level sound objects (CLASS_SOUND) so the
+// per-frame update only has to look at emitters near the listener
+// instead of walking the whole object list.
+//////////////////////////////////////////////////////////////////////
+
+#include <TFE_System/types.h>
+#include <TFE_Asset/levelAsset.h>
+
+namespace TFE_SoundEmitters
+{
+	// Build the index from the current level game objects, call after TFE_Level::startLevel().
+	void build(const LevelData* level);
+	// Clear the index, the sound sources themselves are released by TFE_Audio::stopAllSounds().
+	void clear();
+
+	// Start or stop looping sources based on proximity to the listener.
+	void update(const Vec3f* listenerPos);
+
+	u32 getEmitterCount();
+	u32 getActiveEmitterCount();
+}
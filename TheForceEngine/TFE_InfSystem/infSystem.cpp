@@ -2,6 +2,7 @@
 #include <TFE_System/system.h>
 #include <TFE_System/memoryPool.h>
 #include <TFE_System/math.h>
+#include <TFE_System/profiler.h>
 #include <TFE_Game/level.h>
 #include <TFE_Game/physics.h>
 #include <TFE_Game/player.h>
@@ -27,6 +28,10 @@ namespace TFE_InfSystem
 	// this can be roughly 16x larger - this gives about 0.5Mb. So bumping it up to 1Mb just to be sure.
 #define TFE_RUNTIME_INF_POOL (1 * 1024 * 1024)
 #define MAX_FUNC_IN_FLIGHT 1024
+// Timer wheel slots, waiting elevators are stored in slot (wakeTick & INF_TIMER_WHEEL_MASK).
+#define INF_TIMER_WHEEL_SIZE 256
+#define INF_TIMER_WHEEL_MASK (INF_TIMER_WHEEL_SIZE - 1)
+#define INF_TIMER_NONE 0xffffffffu
 
 	struct FuncQueue
 	{
@@ -76,7 +81,15 @@ namespace TFE_InfSystem
 
 		s32 curStop;
 		s32 nextStop;
-		f32 delay;
+		f32 delay;			// remaining delay when the wait was (re)started.
+		u32 waitStart;		// INF tick the wait was (re)started on.
+		u32 wakeTick;		// INF tick the wait ends on, INF_TIMER_NONE if not scheduled.
+	};
+
+	struct InfTimer
+	{
+		const InfClassData* classData;
+		u32 wakeTick;
 	};
 
 	struct SectorLineId
@@ -105,6 +118,16 @@ namespace TFE_InfSystem
 
 	static bool s_useVertexCache;
 
+	// Only items with moving (or stopless) elevators are updated each step, sorted by item index to keep the update order.
+	static std::vector<u32> s_activeItems;
+	static u8* s_itemActive;
+	static u32* s_stateItem;	// item index for each state.
+	static bool s_activeItemsDirty;
+	// Waiting elevators, keyed by the INF tick their delay runs out on.
+	static std::vector<InfTimer> s_timerWheel[INF_TIMER_WHEEL_SIZE];
+	static u32 s_infTick = 0;
+	static s32 s_activeItemCount = 0;
+
 	Sector* getSlaveSector(const InfClassData* classData, u32 index);
 	void executeFunctions(u32 funcCount, InfFunction* func, u32 evt = 0);
 	NudgeType activateLineOrSector(InfClassData* classData);
@@ -112,6 +135,13 @@ namespace TFE_InfSystem
 	void startMovingSound(Sector* sector, const InfClassData* classData);
 	void stopMovingSound(Sector* sector, const InfClassData* classData);
 
+	void wakeItem(const InfClassData* classData);
+	bool itemNeedsUpdate(const InfItem* item);
+	void tickItem(InfItem* item);
+	void startWait(const InfClassData* classData, ItemState* state);
+	void pauseWait(ItemState* state);
+	void updateTimers();
+
 	bool init()
 	{
 		TFE_System::logWrite(LOG_MSG, "Startup", "TFE_InfSystem::init");
@@ -124,6 +154,7 @@ namespace TFE_InfSystem
 		// Set the warning watermark at 75% capacity.
 		s_memoryPool->setWarningWatermark(TFE_RUNTIME_INF_POOL * 3 / 4);
 
+		TFE_COUNTER(s_activeItemCount, "INF Active Items");
 		return true;
 	}
 
@@ -182,6 +213,7 @@ namespace TFE_InfSystem
 				if (classData->iclass == INF_CLASS_ELEVATOR && itemState->state == INF_STATE_HOLDING)
 				{
 					itemState->state = INF_STATE_MOVING;
+					wakeItem(classData);
 					itemState->nextStop = (itemState->curStop + 1) % classData->stopCount;
 				}
 				else if (classData->iclass == INF_CLASS_TRIGGER && itemState->state == INF_STATE_HOLDING)
@@ -220,6 +252,7 @@ namespace TFE_InfSystem
 					if (classData->iclass == INF_CLASS_ELEVATOR && itemState->state == INF_STATE_HOLDING)
 					{
 						itemState->state = INF_STATE_MOVING;
+						wakeItem(classData);
 						itemState->nextStop = arg[0].iValue;
 					}
 				}
@@ -246,6 +279,7 @@ namespace TFE_InfSystem
 				if (classData->iclass == INF_CLASS_ELEVATOR && itemState->state == INF_STATE_HOLDING)
 				{
 					itemState->state = INF_STATE_MOVING;
+					wakeItem(classData);
 					itemState->nextStop = (itemState->curStop + 1) % classData->stopCount;
 				}
 			}
@@ -266,6 +300,7 @@ namespace TFE_InfSystem
 				if (classData->iclass == INF_CLASS_ELEVATOR && itemState->state == INF_STATE_HOLDING)
 				{
 					itemState->state = INF_STATE_MOVING;
+					wakeItem(classData);
 					itemState->nextStop = itemState->curStop > 0 ? itemState->curStop - 1 : classData->stopCount - 1;
 				}
 			}
@@ -279,7 +314,16 @@ namespace TFE_InfSystem
 				if (argCount > 0 && arg[0].iValue != 0 && !(classData->var.event_mask & arg[0].iValue)) { continue; }
 				if (evt != 0 && !(classData->var.event_mask & evt)) { continue; }
 
+				// Resume the delay of waiting elevators.
+				ItemState* state = &s_infState[classData->stateIndex];
+				const bool resumeWait = !classData->var.master && classData->iclass == INF_CLASS_ELEVATOR && state->state == INF_STATE_WAITING;
+
 				classData->var.master = true;
+				if (resumeWait)
+				{
+					startWait(classData, state);
+				}
+				wakeItem(classData);
 			}
 			break;
 		case INF_MSG_MASTER_OFF:
@@ -297,6 +341,11 @@ namespace TFE_InfSystem
 					TFE_Audio::freeSource(state->moveSound);
 					state->moveSound = nullptr;
 				}
+				// The delay of waiting elevators does not count down while the master is off.
+				if (classData->var.master && classData->iclass == INF_CLASS_ELEVATOR && state->state == INF_STATE_WAITING)
+				{
+					pauseWait(state);
+				}
 
 				classData->var.master = false;
 			}
@@ -364,6 +413,7 @@ namespace TFE_InfSystem
 					if (classData->iclass == INF_CLASS_ELEVATOR && itemState->state == INF_STATE_HOLDING)
 					{
 						itemState->state = INF_STATE_MOVING;
+						wakeItem(classData);
 						itemState->nextStop = (itemState->curStop + 1) % classData->stopCount;
 					}
 				}
@@ -403,7 +453,7 @@ namespace TFE_InfSystem
 			}
 			break;
 		case INF_MSG_PAGE:
-			TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, TFE_VocAsset::getFromIndex(arg[0].iValue), false);
+			TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, TFE_VocAsset::getFromIndex(arg[0].iValue), SOUND_CATEGORY_VOICE, SOUND_PRIORITY_HIGH);
 			break;
 		case INF_MSG_TEXT:
 			if (argCount >= 1 && arg)
@@ -754,6 +804,7 @@ namespace TFE_InfSystem
 			{
 				curState->state = INF_STATE_WAITING;
 				curState->delay = std::max(stop1->time, c_minInfDelay);
+				startWait(classData, curState);
 			}
 
 			// Only execute functions if the elevator has not been terminated.
@@ -787,7 +838,7 @@ namespace TFE_InfSystem
 		if (classData->var.sound[1] >= 0 && !state->moveSound)
 		{
 			// Start the looping middle sound...
-			state->moveSound = TFE_Audio::createSoundSource(SOUND_3D, 1.0f, MONO_SEPERATION, TFE_VocAsset::getFromIndex(classData->var.sound[1]), &sector->center);
+			state->moveSound = TFE_Audio::createSoundSource(SOUND_3D, 1.0f, MONO_SEPERATION, TFE_VocAsset::getFromIndex(classData->var.sound[1]), &sector->center, SOUND_CATEGORY_AMBIENT);
 			TFE_Audio::playSource(state->moveSound, true);
 		}
 	}
@@ -816,6 +867,7 @@ namespace TFE_InfSystem
 		// If stop 0 is a hold stop, this will be setup after the initial execution.
 		ItemState* itemState = &s_infState[classData->stateIndex];
 		itemState->state = INF_STATE_MOVING;
+		wakeItem(classData);
 		itemState->curStop = -1;
 		itemState->nextStop = 0;
 
@@ -844,7 +896,7 @@ namespace TFE_InfSystem
 
 		if (classData->var.sound[1] >= 0 && !itemState->moveSound)
 		{
-			itemState->moveSound = TFE_Audio::createSoundSource(SOUND_3D, 1.0f, MONO_SEPERATION, TFE_VocAsset::getFromIndex(classData->var.sound[1]), &sector->center);
+			itemState->moveSound = TFE_Audio::createSoundSource(SOUND_3D, 1.0f, MONO_SEPERATION, TFE_VocAsset::getFromIndex(classData->var.sound[1]), &sector->center, SOUND_CATEGORY_AMBIENT);
 			TFE_Audio::playSource(itemState->moveSound, true);
 		}
 
@@ -941,6 +993,13 @@ namespace TFE_InfSystem
 		s_memoryPool->clear();
 		s_frame = 0;
 		s_funcQueueCount = 0;
+		s_infTick = 0;
+		s_activeItems.clear();
+		s_activeItemsDirty = false;
+		for (u32 t = 0; t < INF_TIMER_WHEEL_SIZE; t++)
+		{
+			s_timerWheel[t].clear();
+		}
 		Sector* sectors = s_levelData->sectors.data();
 
 		// Map between sectors and items.
@@ -1010,6 +1069,19 @@ namespace TFE_InfSystem
 		s_infState = (ItemState*)s_memoryPool->allocate(sizeof(ItemState) * s_stateCount);
 		memset(s_infState, 0, sizeof(ItemState)*s_stateCount);
 
+		s_itemActive = (u8*)s_memoryPool->allocate(count);
+		s_stateItem = (u32*)s_memoryPool->allocate(sizeof(u32) * s_stateCount);
+		memset(s_itemActive, 0, count);
+		for (u32 i = 0; i < count; i++)
+		{
+			InfItem* item = &infData->item[i];
+			for (u32 c = 0; c < item->classCount; c++)
+			{
+				s_stateItem[item->classData[c].stateIndex] = i;
+				s_infState[item->classData[c].stateIndex].wakeTick = INF_TIMER_NONE;
+			}
+		}
+
 		for (u32 i = 0; i < count; i++)
 		{
 			InfItem* item = &infData->item[i];
@@ -1036,6 +1108,7 @@ namespace TFE_InfSystem
 				if (classData->stopCount == 0)
 				{
 					state->state = INF_STATE_MOVING;
+					wakeItem(classData);
 					continue;
 				}
 				prepareForFirstStop(classData, sector);
@@ -1120,6 +1193,7 @@ namespace TFE_InfSystem
 			if (itemState->state == INF_STATE_HOLDING)
 			{
 				itemState->state = INF_STATE_MOVING;
+				wakeItem(classData);
 				itemState->nextStop = (itemState->curStop + 1) % classData->stopCount;
 			}
 		}
@@ -1351,6 +1425,7 @@ namespace TFE_InfSystem
 			if (classData->iclass == INF_CLASS_ELEVATOR && itemState->state == INF_STATE_HOLDING)
 			{
 				itemState->state = INF_STATE_MOVING;
+				wakeItem(classData);
 				itemState->nextStop = (itemState->curStop + 1) % classData->stopCount;
 			}
 		}
@@ -1404,12 +1479,13 @@ namespace TFE_InfSystem
 				if (classData->iclass == INF_CLASS_ELEVATOR && itemState->state == INF_STATE_HOLDING)
 				{
 					itemState->state = INF_STATE_MOVING;
+					wakeItem(classData);
 					itemState->nextStop = (itemState->curStop + 1) % classData->stopCount;
 				}
 			}
 
 			SoundBuffer* buffer = TFE_VocAsset::get("COMPLETE.VOC");
-			TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, buffer, false);
+			TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, buffer, SOUND_CATEGORY_GENERAL, SOUND_PRIORITY_CRITICAL);
 		}
 	}
 
@@ -1451,7 +1527,7 @@ namespace TFE_InfSystem
 							TFE_GameHud::setMessage(TFE_GameMessages::getMessage(msgId));
 
 							const SoundBuffer* buffer = TFE_VocAsset::get("LOCKED-1.VOC");
-							TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, buffer, false);
+							TFE_Audio::playOneShot(SOUND_2D, 1.0f, MONO_SEPERATION, buffer, SOUND_CATEGORY_GENERAL, SOUND_PRIORITY_HIGH);
 						}
 						continue;
 					}
@@ -1461,6 +1537,7 @@ namespace TFE_InfSystem
 					if (itemState->state == INF_STATE_HOLDING)
 					{
 						itemState->state = INF_STATE_MOVING;
+						wakeItem(classData);
 						itemState->nextStop = (itemState->curStop + 1) % classData->stopCount;
 					}
 				}
@@ -1569,6 +1646,7 @@ namespace TFE_InfSystem
 					if (itemState->state == INF_STATE_HOLDING)
 					{
 						itemState->state = INF_STATE_MOVING;
+						wakeItem(classData);
 						itemState->nextStop = (itemState->curStop + 1) % classData->stopCount;
 					}
 				}
@@ -1627,100 +1705,205 @@ namespace TFE_InfSystem
 		if (!s_levelData) { return; }
 
 		f32 dt = (f32)TFE_System::getDeltaTime();
-		Sector* sectors = s_levelData->sectors.data();
 				
 		// Update INF at a fixed framerate.
 		s_accum += dt;
 		while (s_accum >= c_step)
 		{
 			s_accum -= c_step;
+			s_infTick++;
 
-			const u32 count = s_infData->itemCount;
-			for (u32 i = 0; i < count; i++)
+			// Items activated since the last step are merged in item order.
+			if (s_activeItemsDirty)
 			{
-				InfItem* item = &s_infData->item[i];
-				const u32 sectorId = item->id & 0xffff;
-				const u32 wallId = item->id >> 16u;
-				if (sectorId == 0xffff) { continue; }
-				Sector* sector = &sectors[sectorId];
-
-				const u32 classCount = item->classCount;
+				std::sort(s_activeItems.begin(), s_activeItems.end());
+				s_activeItemsDirty = false;
+			}
 
-				f32 sectorAngle = 0.0f;
-				Vec2f sectorMove = { 0 };
+			// Items woken while updating are picked up on the next step.
+			const u32 activeCount = (u32)s_activeItems.size();
+			for (u32 i = 0; i < activeCount; i++)
+			{
+				tickItem(&s_infData->item[s_activeItems[i]]);
+			}
 
-				s_useVertexCache = true;
-				for (u32 c = 0; c < classCount; c++)
+			// Remove items that are now holding, terminated or waiting.
+			u32 keepCount = 0;
+			for (u32 i = 0; i < activeCount; i++)
+			{
+				const u32 itemIndex = s_activeItems[i];
+				if (itemNeedsUpdate(&s_infData->item[itemIndex]))
 				{
-					InfClassData* classData = &item->classData[c];
-					// Switches don't need constant updates and just wait to be activated.
-					// Do not update classes with master = off.
-					if (classData->iclass != INF_CLASS_ELEVATOR) { continue; }
+					s_activeItems[keepCount++] = itemIndex;
+				}
+				else
+				{
+					s_itemActive[itemIndex] = 0;
+				}
+			}
+			s_activeItems.erase(s_activeItems.begin() + keepCount, s_activeItems.begin() + activeCount);
+			s_activeItemCount = (s32)s_activeItems.size();
 
-					ItemState* curState = &s_infState[classData->stateIndex];
-					if (!classData->var.master)
-					{
-						// Moving and rotating sector types start from cached data and then apply one transform after the other.
-						// For this to work, transforms must be applied even when the item is not active in case other classes are active on the same item.
-						// Note that other types, such as moving floors or scrolling do not require this treatment.
-						if (isSlidingOrRotatingElevator(classData->isubclass))
-						{
-							for (u32 i = 0; i < classData->slaveCount; i++)
-							{
-								applyValueToSector(classData, curState, getSlaveSector(classData, i)->id, curState->slaveState[i].curValue, 0.0f, i);
-							}
-							applyValueToSector(classData, curState, sector->id, curState->curValue, 0.0f, -1);
-						}
-						continue;
-					}
+			// Elevators whose delay ran out start moving on the next step.
+			updateTimers();
+
+			// Execute queued functions.
+			for (u32 f = 0; f < s_funcQueueCount; f++)
+			{
+				executeFunctions(s_funcQueue[f].funcCount, s_funcQueue[f].func, s_funcQueue[f].evt);
+			}
+			s_funcQueueCount = 0;
+
+			s_frame++;
+		}
+	}
+
+	//////////////////////////////////////////////
+	// Internal
+	//////////////////////////////////////////////
+	void wakeItem(const InfClassData* classData)
+	{
+		const u32 itemIndex = s_stateItem[classData->stateIndex];
+		if (s_itemActive[itemIndex]) { return; }
+		if ((s_infData->item[itemIndex].id & 0xffff) == 0xffff) { return; }
+
+		s_itemActive[itemIndex] = 1;
+		s_activeItems.push_back(itemIndex);
+		s_activeItemsDirty = true;
+	}
+
+	bool itemNeedsUpdate(const InfItem* item)
+	{
+		const u32 classCount = item->classCount;
+		for (u32 c = 0; c < classCount; c++)
+		{
+			const InfClassData* classData = &item->classData[c];
+			if (classData->iclass != INF_CLASS_ELEVATOR) { continue; }
+			// Sliding and rotating elevators re-apply their cached transforms every step, even when not moving (see tickItem()).
+			if (isSlidingOrRotatingElevator(classData->isubclass)) { return true; }
+			if (!classData->var.master) { continue; }
+
+			const ItemState* curState = &s_infState[classData->stateIndex];
+			if (classData->stopCount == 0 || curState->state == INF_STATE_MOVING) { return true; }
+		}
+		return false;
+	}
+
+	void tickItem(InfItem* item)
+	{
+		Sector* sectors = s_levelData->sectors.data();
+		const u32 sectorId = item->id & 0xffff;
+		const u32 wallId = item->id >> 16u;
+		if (sectorId == 0xffff) { return; }
+		Sector* sector = &sectors[sectorId];
+
+		const u32 classCount = item->classCount;
+		s_useVertexCache = true;
+		for (u32 c = 0; c < classCount; c++)
+		{
+			InfClassData* classData = &item->classData[c];
+			// Switches don't need constant updates and just wait to be activated.
+			// Do not update classes with master = off.
+			if (classData->iclass != INF_CLASS_ELEVATOR) { continue; }
 
-					if (classData->iclass == INF_CLASS_ELEVATOR && classData->stopCount == 0)
+			ItemState* curState = &s_infState[classData->stateIndex];
+			if (!classData->var.master)
+			{
+				// Moving and rotating sector types start from cached data and then apply one transform after the other.
+				// For this to work, transforms must be applied even when the item is not active in case other classes are active on the same item.
+				// Note that other types, such as moving floors or scrolling do not require this treatment.
+				if (isSlidingOrRotatingElevator(classData->isubclass))
+				{
+					for (u32 i = 0; i < classData->slaveCount; i++)
 					{
-						// Elevators without stops keep going forever - useful for things like flowing water.
-						executeStopless(classData, curState, sector, wallId < 0xffff ? wallId : -1);
+						applyValueToSector(classData, curState, getSlaveSector(classData, i)->id, curState->slaveState[i].curValue, 0.0f, i);
 					}
-					else if (classData->iclass == INF_CLASS_ELEVATOR && classData->stopCount)
-					{
-						const bool applyCurValue = curState->state != INF_STATE_MOVING && isSlidingOrRotatingElevator(classData->isubclass);
+					applyValueToSector(classData, curState, sector->id, curState->curValue, 0.0f, -1);
+				}
+				continue;
+			}
 
-						// Otherwise update the elevator state
-						if (curState->state == INF_STATE_MOVING)
-						{
-							executeStopMove(classData, curState, sector, wallId < 0xffff ? wallId : -1);
-						}
-						else if (curState->state == INF_STATE_WAITING)
-						{
-							curState->delay -= c_step;
-							if (curState->delay <= 0.0f)
-							{
-								curState->delay = 0.0f;
-								curState->state = INF_STATE_MOVING;
-							}
-						}
+			if (classData->stopCount == 0)
+			{
+				// Elevators without stops keep going forever - useful for things like flowing water.
+				executeStopless(classData, curState, sector, wallId < 0xffff ? wallId : -1);
+			}
+			else
+			{
+				// Waiting elevators are handled by the timer wheel, see updateTimers().
+				const bool applyCurValue = curState->state != INF_STATE_MOVING && isSlidingOrRotatingElevator(classData->isubclass);
+				if (curState->state == INF_STATE_MOVING)
+				{
+					executeStopMove(classData, curState, sector, wallId < 0xffff ? wallId : -1);
+				}
 
-						// Moving and rotating sector types start from cached data and then apply one transform after the other.
-						// For this to work, transforms must be applied even when waiting.
-						// Note that other types, such as moving floors or scrolling do not require this treatment.
-						if (applyCurValue)
-						{
-							for (u32 i = 0; i < classData->slaveCount; i++)
-							{
-								applyValueToSector(classData, curState, getSlaveSector(classData, i)->id, curState->slaveState[i].curValue, 0.0f, i);
-							}
-							applyValueToSector(classData, curState, sector->id, curState->curValue, 0.0f, -1);
-						}
+				// Moving and rotating sector types start from cached data and then apply one transform after the other.
+				// For this to work, transforms must be applied even when waiting.
+				// Note that other types, such as moving floors or scrolling do not require this treatment.
+				if (applyCurValue)
+				{
+					for (u32 i = 0; i < classData->slaveCount; i++)
+					{
+						applyValueToSector(classData, curState, getSlaveSector(classData, i)->id, curState->slaveState[i].curValue, 0.0f, i);
 					}
+					applyValueToSector(classData, curState, sector->id, curState->curValue, 0.0f, -1);
 				}
 			}
+		}
+	}
 
-			// Execute queued functions.
-			for (u32 f = 0; f < s_funcQueueCount; f++)
+	// The delay counted down by one step per INF tick, starting on the tick after the wait starts.
+	// The number of ticks is computed the same way so the elevator starts moving on exactly the same step.
+	void startWait(const InfClassData* classData, ItemState* state)
+	{
+		u32 ticks = 0;
+		f32 delay = state->delay;
+		do
+		{
+			delay -= c_step;
+			ticks++;
+		} while (delay > 0.0f);
+
+		state->waitStart = s_infTick;
+		state->wakeTick = s_infTick + ticks;
+		s_timerWheel[state->wakeTick & INF_TIMER_WHEEL_MASK].push_back({ classData, state->wakeTick });
+	}
+
+	void pauseWait(ItemState* state)
+	{
+		const u32 elapsed = s_infTick - state->waitStart;
+		for (u32 t = 0; t < elapsed; t++)
+		{
+			state->delay -= c_step;
+		}
+		// Invalidate the timer, it is rescheduled when the master is turned back on.
+		state->wakeTick = INF_TIMER_NONE;
+	}
+
+	void updateTimers()
+	{
+		std::vector<InfTimer>& slot = s_timerWheel[s_infTick & INF_TIMER_WHEEL_MASK];
+		u32 keepCount = 0;
+		const u32 count = (u32)slot.size();
+		for (u32 i = 0; i < count; i++)
+		{
+			const InfTimer timer = slot[i];
+			// Timers further out stay in the slot until their turn comes around.
+			if (timer.wakeTick != s_infTick)
 			{
-				executeFunctions(s_funcQueue[f].funcCount, s_funcQueue[f].func, s_funcQueue[f].evt);
+				slot[keepCount++] = timer;
+				continue;
 			}
-			s_funcQueueCount = 0;
 
-			s_frame++;
+			// Skip stale timers, the elevator may have been paused or moved on since.
+			ItemState* state = &s_infState[timer.classData->stateIndex];
+			if (state->state != INF_STATE_WAITING || state->wakeTick != timer.wakeTick || !timer.classData->var.master) { continue; }
+
+			state->delay = 0.0f;
+			state->wakeTick = INF_TIMER_NONE;
+			state->state = INF_STATE_MOVING;
+			wakeItem(timer.classData);
 		}
+		slot.resize(keepCount);
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,232 @@
+#include "logicScheduler.h"
+#include <TFE_Game/gameObject.h>
+#include <TFE_Game/player.h>
+#include <TFE_Asset/levelAsset.h>
+#include <TFE_Asset/levelObjectsAsset.h>
+#include <TFE_FrontEndUI/console.h>
+#include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+namespace TFE_LogicScheduler
+{
+	// Tick interval, in logic steps, for each LOD (suspended objects do not tick).
+	static const u32 c_lodInterval[LOGIC_LOD_COUNT] = { 1, 2, 8, 0 };
+	// Objects within this distance of the player always tick at full rate.
+	static const f32 c_fullRateDist = 128.0f;
+	// Sectors further away than this along the adjoins are considered unreachable.
+	static const f32 c_reachDist = 512.0f;
+	// Time an alerted object ticks at full rate.
+	static const f32 c_alertTime = 5.0f;
+	// Limit the time delivered in a single tick, so objects that have been suspended for a long time don't jump ahead.
+	static const f32 c_maxTickTime = 0.5f;
+
+	struct LogicSchedule
+	{
+		u32 lod;
+		u32 countdown;		// steps until the next tick.
+		f32 accumTime;		// time since the last tick.
+		f32 alertTime;
+	};
+
+	static std::vector<LogicSchedule> s_schedule;
+	// Path distance from the player sector through the adjoins, FLT_MAX if unreachable.
+	static std::vector<f32> s_sectorReach;
+	static std::vector<s32> s_reachQueue;
+	static s32 s_reachSectorId = -1;
+	static f32 s_step = 0.0f;
+	static s32 s_budgetLeft = 0;
+	static u32 s_firstDeferred = 0;
+	static bool s_deferred = false;
+
+	// Settings
+	static bool s_lodEnabled = true;
+	static s32  s_tickBudget = 0;
+
+	// Stats
+	static s32 s_tickCount = 0;
+	static s32 s_deferredCount = 0;
+	static s32 s_suspendedCount = 0;
+
+	void buildSectorReach(const LevelData* level, s32 sectorId);
+	u32  getLod(const GameObject* obj, const LogicSchedule* sched, const Player* player);
+
+	void init()
+	{
+		clear();
+
+		CVAR_BOOL(s_lodEnabled, "g_logicLod", 0, "Tick far away and unreachable logics less often.");
+		CVAR_INT(s_tickBudget, "g_logicTickBudget", 0, "Maximum reduced rate logic ticks per frame, 0 = no limit. Logics near the player are not limited.");
+
+		TFE_COUNTER(s_tickCount, "Logic Ticks");
+		TFE_COUNTER(s_deferredCount, "Logic Ticks Deferred");
+		TFE_COUNTER(s_suspendedCount, "Logic Objects Suspended");
+	}
+
+	void clear()
+	{
+		s_schedule.clear();
+		s_sectorReach.clear();
+		s_reachSectorId = -1;
+		s_deferred = false;
+	}
+
+	void update(const Player* player, u32 objectCount)
+	{
+		s_tickCount = 0;
+		s_deferredCount = 0;
+		s_suspendedCount = 0;
+		s_budgetLeft = s_tickBudget > 0 ? s_tickBudget : INT_MAX;
+
+		if (objectCount > (u32)s_schedule.size())
+		{
+			s_schedule.resize(objectCount, { LOGIC_LOD_FULL, 1, 0.0f, 0.0f });
+		}
+
+		const LevelData* level = TFE_LevelAsset::getLevelData();
+		if (level && player->m_sectorId != s_reachSectorId)
+		{
+			buildSectorReach(level, player->m_sectorId);
+		}
+
+		const GameObjectList* objectList = LevelGameObjects::getGameObjectList();
+		const u32 gameObjCount = std::min(objectCount, (u32)objectList->size());
+		const f32 dt = (f32)TFE_System::getDeltaTime();
+		for (u32 i = 0; i < gameObjCount; i++)
+		{
+			LogicSchedule* sched = &s_schedule[i];
+			sched->alertTime = std::max(sched->alertTime - dt, 0.0f);
+
+			const u32 lod = getLod(&(*objectList)[i], sched, player);
+			if (lod == LOGIC_LOD_SUSPENDED) { s_suspendedCount++; }
+			if (lod == sched->lod) { continue; }
+
+			// Objects waking up tick on the next step, otherwise keep the phase so the objects stay spread over the steps.
+			sched->countdown = sched->lod == LOGIC_LOD_SUSPENDED ? 1 : std::min(sched->countdown, std::max(c_lodInterval[lod], 1u));
+			sched->lod = lod;
+		}
+	}
+
+	u32 beginStep(f32 step, u32 objectCount)
+	{
+		s_step = step;
+		const u32 start = (s_deferred && s_firstDeferred < objectCount) ? s_firstDeferred : 0;
+		s_deferred = false;
+		return start;
+	}
+
+	bool shouldTick(u32 objectIndex, f32* dt)
+	{
+		if (objectIndex >= (u32)s_schedule.size())
+		{
+			*dt = s_step;
+			return true;
+		}
+
+		LogicSchedule* sched = &s_schedule[objectIndex];
+		sched->accumTime += s_step;
+		if (sched->lod == LOGIC_LOD_SUSPENDED) { return false; }
+		if (sched->countdown > 1)
+		{
+			sched->countdown--;
+			return false;
+		}
+
+		// Reduced rate objects are limited by the budget, deferred objects stay due and try again on the next step.
+		if (sched->lod != LOGIC_LOD_FULL)
+		{
+			if (s_budgetLeft <= 0)
+			{
+				if (!s_deferred)
+				{
+					s_firstDeferred = objectIndex;
+					s_deferred = true;
+				}
+				s_deferredCount++;
+				return false;
+			}
+			s_budgetLeft--;
+		}
+
+		*dt = std::min(sched->accumTime, c_maxTickTime);
+		sched->accumTime = 0.0f;
+		sched->countdown = c_lodInterval[sched->lod];
+		s_tickCount++;
+		return true;
+	}
+
+	void alert(u32 objectIndex)
+	{
+		if (objectIndex >= (u32)s_schedule.size()) { return; }
+
+		LogicSchedule* sched = &s_schedule[objectIndex];
+		sched->alertTime = c_alertTime;
+		if (sched->lod != LOGIC_LOD_FULL)
+		{
+			sched->countdown = 1;
+			sched->lod = LOGIC_LOD_FULL;
+		}
+	}
+
+	//////////////////////////////////////////////
+	// Internal
+	//////////////////////////////////////////////
+	u32 getLod(const GameObject* obj, const LogicSchedule* sched, const Player* player)
+	{
+		if (!s_lodEnabled || sched->alertTime > 0.0f || obj->sectorId < 0 || obj->sectorId >= (s32)s_sectorReach.size())
+		{
+			return LOGIC_LOD_FULL;
+		}
+
+		const f32 dx = obj->position.x - player->pos.x;
+		const f32 dz = obj->position.z - player->pos.z;
+		if (dx*dx + dz*dz <= c_fullRateDist*c_fullRateDist)
+		{
+			return LOGIC_LOD_FULL;
+		}
+		if (s_sectorReach[obj->sectorId] < FLT_MAX)
+		{
+			return LOGIC_LOD_NEAR;
+		}
+		return (obj->commonFlags & LCF_PAUSE) ? LOGIC_LOD_SUSPENDED : LOGIC_LOD_FAR;
+	}
+
+	// Walk the adjoins from the player sector accumulating the distance between sector centers.
+	void buildSectorReach(const LevelData* level, s32 sectorId)
+	{
+		const Sector* sectors = level->sectors.data();
+		const SectorWall* walls = level->walls.data();
+		const s32 sectorCount = (s32)level->sectors.size();
+
+		s_reachSectorId = sectorId;
+		s_sectorReach.assign(sectorCount, FLT_MAX);
+		if (sectorId < 0 || sectorId >= sectorCount) { return; }
+
+		s_reachQueue.clear();
+		s_reachQueue.push_back(sectorId);
+		s_sectorReach[sectorId] = 0.0f;
+		for (size_t q = 0; q < s_reachQueue.size(); q++)
+		{
+			const s32 curId = s_reachQueue[q];
+			const Sector* sector = &sectors[curId];
+			const SectorWall* wall = &walls[sector->wallOffset];
+			for (u32 w = 0; w < sector->wallCount; w++, wall++)
+			{
+				const s32 next = wall->adjoin;
+				if (next < 0 || next >= sectorCount) { continue; }
+
+				const f32 cx = sectors[next].center.x - sector->center.x;
+				const f32 cz = sectors[next].center.z - sector->center.z;
+				const f32 d = s_sectorReach[curId] + sqrtf(cx*cx + cz*cz);
+				if (d > c_reachDist || d >= s_sectorReach[next]) { continue; }
+
+				s_sectorReach[next] = d;
+				s_reachQueue.push_back(next);
+			}
+		}
+	}
+}
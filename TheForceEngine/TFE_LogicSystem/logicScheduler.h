@@ -0,0 +1,43 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Logic Scheduler
+// Decides which script objects tick on each logic step. Objects near
+// the player tick every step, objects further away or outside of the
+// sectors reachable from the player tick less often and paused
+// (LCF_PAUSE) enemies in unreachable sectors are suspended.
+//
+// Skipped steps are not lost, the time since the last tick is handed
+// to the object on its next tick (exposed to scripts as 'timeStep').
+//////////////////////////////////////////////////////////////////////
+
+#include <TFE_System/types.h>
+
+class Player;
+
+enum LogicLod
+{
+	LOGIC_LOD_FULL = 0,		// every step.
+	LOGIC_LOD_NEAR,			// reachable but not close to the player.
+	LOGIC_LOD_FAR,			// not reachable from the player sector.
+	LOGIC_LOD_SUSPENDED,	// paused enemies that cannot be reached, does not tick until woken.
+	LOGIC_LOD_COUNT
+};
+
+namespace TFE_LogicScheduler
+{
+	// Registers the settings and counters, called once.
+	void init();
+	// Resets the per-level state, called whenever a level is loaded.
+	void clear();
+
+	// Assign the tick rate of each object based on the player position, called once per frame before the logic steps.
+	void update(const Player* player, u32 objectCount);
+	// Called at the start of each logic step, returns the object index to start ticking from
+	// so objects deferred by the tick budget on the previous step go first.
+	u32  beginStep(f32 step, u32 objectCount);
+	// Returns true if the object should tick this step, 'dt' is set to the time since its previous tick.
+	bool shouldTick(u32 objectIndex, f32* dt);
+
+	// The object has been damaged or otherwise alerted and should tick at full rate for a while.
+	void alert(u32 objectIndex);
+}
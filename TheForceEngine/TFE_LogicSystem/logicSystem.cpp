@@ -1,4 +1,5 @@
 #include "logicSystem.h"
+#include "logicScheduler.h"
 #include <TFE_Asset/spriteAsset.h>
 #include <TFE_Asset/modelAsset.h>
 #include <TFE_Asset/gameMessages.h>
@@ -7,11 +8,15 @@
 #include <TFE_Game/gameConstants.h>
 #include <TFE_ScriptSystem/scriptSystem.h>
 #include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <TFE_System/frameStats.h>
+#include <TFE_FrontEndUI/console.h>
 #include <TFE_FileSystem/filestream.h>
 #include <TFE_FileSystem/paths.h>
 #include <TFE_Game/gameObject.h>
 #include <TFE_Game/player.h>
 #include <TFE_Game/physics.h>
+#include <TFE_Game/objectGrid.h>
 #include <TFE_Game/geometry.h>
 #include <TFE_InfSystem/infSystem.h>
 #include <TFE_Audio/audioSystem.h>
@@ -19,6 +24,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <assert.h>
 #include <algorithm>
 
@@ -145,6 +151,9 @@ namespace TFE_LogicSystem
 		SCRIPT_FUNC_PTR stop;
 		SCRIPT_FUNC_PTR tick;
 		SCRIPT_FUNC_PTR handleMessage;
+		// Native implementation, replaces the script tick if set.
+		NativeLogicFunc nativeTick;
+		u32 tickBatch;
 
 		// Logic Parameters, these come from the level data or spawn.
 		Logic param;
@@ -160,6 +169,7 @@ namespace TFE_LogicSystem
 		SCRIPT_FUNC_PTR stop;
 		SCRIPT_FUNC_PTR tick;
 		SCRIPT_FUNC_PTR handleMessage;
+		u32 tickBatch;
 
 		// Logic Parameters, these come from the level data or spawn.
 		EnemyGenerator param;
@@ -185,23 +195,60 @@ namespace TFE_LogicSystem
 	};
 	std::vector<LogicToAdd> s_logicsToAdd;
 
+	struct NativeLogic
+	{
+		NativeLogicFunc start;
+		NativeLogicFunc tick;
+	};
+
+	// Logics due on the current step that share the same tick function.
+	struct TickBatchItem
+	{
+		u32 objectIndex;
+		u32 logicIndex;
+		f32 dt;
+	};
+
+	struct TickBatch
+	{
+		SCRIPT_FUNC_PTR tick;
+		bool generator;
+		std::vector<TickBatchItem> items;
+	};
+
 	static GameObject* s_self = nullptr;
 	static Logic* s_param = nullptr;
 	static EnemyGenerator* s_genParam = nullptr;
 	static bool s_initialized = false;
 	static std::vector<ScriptObject> s_scriptObjects;
+	static std::vector<TickBatch> s_tickBatches;
+	static NativeLogic s_nativeLogic[LOGIC_COUNT] = {};
+	static bool s_nativeLogicsEnabled = true;
 
 	static Player* s_player;
 
 	static f32 s_accum = 0.0f;
+	// Time since the current object last ticked, exposed to scripts as 'timeStep'.
+	static f32 s_tickTime = c_step;
 
 	void registerKeyTypes();
 	void registerLogicTypes();
+	void registerNativeLogics();
+	u32  getTickBatch(SCRIPT_FUNC_PTR tick, bool generator);
+	void setupTickBatchItem(u32 index, void* userData);
+	void executeTickBatches();
 
 	void clearObjectLogics()
 	{
 		s_scriptObjects.clear();
 		s_logicsToAdd.clear();
+		s_tickBatches.clear();
+	}
+
+	void registerNativeLogic(s32 logicType, NativeLogicFunc start, NativeLogicFunc tick)
+	{
+		if (logicType < 0 || logicType >= LOGIC_COUNT) { return; }
+		s_nativeLogic[logicType] = { start, tick };
 	}
 
 	bool registerObjectLogics(GameObject* gameObject, const std::vector<Logic>& logics, const std::vector<EnemyGenerator>& generators)
@@ -225,6 +272,26 @@ namespace TFE_LogicSystem
 		{
 			const LogicType type = logics[i].type;
 			scriptLogic->name = c_logicScriptName[type];
+
+			// Native logics replace the whole script, so the module doesn't need to be loaded.
+			const NativeLogic* native = &s_nativeLogic[type];
+			if (s_nativeLogicsEnabled && (native->start || native->tick))
+			{
+				scriptLogic->param = logics[i];
+				scriptLogic->start = nullptr;
+				scriptLogic->stop  = nullptr;
+				scriptLogic->tick  = nullptr;
+				scriptLogic->handleMessage = nullptr;
+				scriptLogic->nativeTick = native->tick;
+				scriptLogic->tickBatch = 0;
+				if (native->start)
+				{
+					native->start(gameObject, &scriptLogic->param, 0.0f);
+				}
+				continue;
+			}
+
+			scriptLogic->nativeTick = nullptr;
 			if (TFE_ScriptSystem::loadScriptModule(SCRIPT_TYPE_LOGIC, scriptLogic->name.c_str()))
 			{
 				scriptLogic->param = logics[i];
@@ -232,6 +299,10 @@ namespace TFE_LogicSystem
 				scriptLogic->stop  = TFE_ScriptSystem::getScriptFunction(scriptLogic->name.c_str(), "void stop()");
 				scriptLogic->tick  = TFE_ScriptSystem::getScriptFunction(scriptLogic->name.c_str(), "void tick()");
 				scriptLogic->handleMessage = TFE_ScriptSystem::getScriptFunction(scriptLogic->name.c_str(), "void handleMessage(int, int, int)");
+				// Many logics (such as pickups) have empty functions, skip them instead of running them every tick.
+				if (TFE_ScriptSystem::isScriptFunctionEmpty(scriptLogic->tick)) { scriptLogic->tick = nullptr; }
+				if (TFE_ScriptSystem::isScriptFunctionEmpty(scriptLogic->handleMessage)) { scriptLogic->handleMessage = nullptr; }
+				scriptLogic->tickBatch = getTickBatch(scriptLogic->tick, false);
 
 				// Execute the start function if it exists.
 				if (scriptLogic->start)
@@ -255,6 +326,8 @@ namespace TFE_LogicSystem
 				scriptGen->stop = TFE_ScriptSystem::getScriptFunction(scriptGen->name.c_str(), "void stop()");
 				scriptGen->tick = TFE_ScriptSystem::getScriptFunction(scriptGen->name.c_str(), "void tick()");
 				scriptGen->handleMessage = TFE_ScriptSystem::getScriptFunction(scriptGen->name.c_str(), "void handleMessage(int, int, int)");
+				if (TFE_ScriptSystem::isScriptFunctionEmpty(scriptGen->tick)) { scriptGen->tick = nullptr; }
+				scriptGen->tickBatch = getTickBatch(scriptGen->tick, true);
 
 				// Execute the start function if it exists.
 				if (scriptGen->start)
@@ -272,6 +345,7 @@ namespace TFE_LogicSystem
 	void damageObject(GameObject* gameObject, s32 damage, DamageType type)
 	{
 		if (gameObject->objectId >= s_scriptObjects.size()) { return; }
+		TFE_LogicScheduler::alert(gameObject->objectId);
 
 		ScriptObject* obj = &s_scriptObjects[gameObject->objectId];
 		size_t count = obj->logic.size();
@@ -289,6 +363,7 @@ namespace TFE_LogicSystem
 					gameObject->position.y -= 0.2f;
 					gameObject->verticalVel -= 32.0f;
 					gameObject->update = true;
+					LevelGameObjects::wakeObject(gameObject->objectId);
 				}
 			}
 		}
@@ -396,8 +471,8 @@ namespace TFE_LogicSystem
 			s32 newSectorId = ray.originalSectorId;
 			if (TFE_Physics::traceRayIgnoreHeight(&ray, &newSectorId))
 			{
-				// We hit something... which is bad. Now we have to search for the correct sector...
-				s32 findSectorId = TFE_Physics::findSector(&newPos);
+				// We hit something... which is bad. Now we have to search for the correct sector, starting near where the ray stopped.
+				s32 findSectorId = TFE_Physics::findSector(&newPos, newSectorId);
 				if (findSectorId >= 0)
 				{
 					newSectorId = findSectorId;
@@ -417,33 +492,16 @@ namespace TFE_LogicSystem
 			}
 			if (!objInside)
 			{
-				s32 findSectorId = TFE_Physics::findSector(&newPos);
+				s32 findSectorId = TFE_Physics::findSector(&newPos, newSectorId);
 				if (findSectorId >= 0)
 				{
 					newSectorId = findSectorId;
 				}
 			}
 
-			const s32 prevSectorId = obj->gameObj->sectorId;
-			if (prevSectorId != newSectorId)
+			if (obj->gameObj->sectorId != newSectorId)
 			{
-				SectorObjectList* secList = LevelGameObjects::getSectorObjectList();
-
-				// Remove from the old sector.
-				std::vector<u32>& prevlist = (*secList)[prevSectorId].list;
-				const size_t prevCount = prevlist.size();
-				for (u32 i = 0; i < prevCount; i++)
-				{
-					if (prevlist[i] == obj->gameObj->objectId)
-					{
-						prevlist.erase(prevlist.begin() + i);
-						break;
-					}
-				}
-
-				// Add to the new sector.
-				std::vector<u32>& newlist = (*secList)[newSectorId].list;
-				newlist.push_back(obj->gameObj->objectId);
+				LevelGameObjects::moveToSector(obj->gameObj->objectId, newSectorId);
 			}
 			obj->gameObj->sectorId = newSectorId;
 
@@ -453,6 +511,8 @@ namespace TFE_LogicSystem
 			obj->gameObj->vueTransform = &newTransform->rotScale;
 
 			obj->gameObj->update = true;
+			LevelGameObjects::wakeObject(obj->gameObj->objectId);
+			TFE_ObjectGrid::updateObject(obj->gameObj->objectId);
 		}
 	}
 	
@@ -494,6 +554,7 @@ namespace TFE_LogicSystem
 		obj->gameObj->collisionRadius = radius;
 		obj->gameObj->collisionHeight = height;
 		obj->gameObj->collisionFlags  = collisionFlags;
+		TFE_ObjectGrid::updateObject(obj->gameObj->objectId);
 	}
 
 	void TFE_SetPhysics(s32 objectId, u32 physicsFlags)
@@ -503,6 +564,7 @@ namespace TFE_LogicSystem
 
 		obj->gameObj->physicsFlags = physicsFlags;
 		obj->gameObj->verticalVel = 0.0f;
+		LevelGameObjects::wakeObject(obj->gameObj->objectId);
 	}
 
 	void TFE_Hide(s32 objectId)
@@ -532,7 +594,6 @@ namespace TFE_LogicSystem
 	s32 TFE_SpawnObject(Vec3f pos, Vec3f angles, s32 sectorId, s32 objectClass, std::string& objectName)
 	{
 		GameObjectList* gameObjList = LevelGameObjects::getGameObjectList();
-		SectorObjectList* sectorObjList = LevelGameObjects::getSectorObjectList();
 
 		// Add a new game object.
 		s32 objectId = (s32)gameObjList->size();
@@ -575,7 +636,8 @@ namespace TFE_LogicSystem
 
 		TFE_JediRenderer::addObject(objectName.c_str(), objectId, sectorId);
 
-		(*sectorObjList)[sectorId].list.push_back(objectId);
+		LevelGameObjects::addToSector(objectId, sectorId);
+		LevelGameObjects::wakeObject(objectId);
 		return objectId;
 	}
 		
@@ -633,11 +695,17 @@ namespace TFE_LogicSystem
 	bool init(Player* player)
 	{
 		clearObjectLogics();
+		TFE_LogicScheduler::clear();
 		s_accum = 0.0f;
+		s_tickTime = c_step;
 		s_player = player;
 
 		if (s_initialized) { return true; }
 		s_initialized = true;
+
+		TFE_LogicScheduler::init();
+		CVAR_BOOL(s_nativeLogicsEnabled, "g_nativeLogics", 0, "Use the built-in native versions of simple logics (anim, scenery, update) instead of their scripts. Disable to run modified scripts.");
+		registerNativeLogics();
 		// register script functions.
 
 		// register types.
@@ -772,7 +840,7 @@ namespace TFE_LogicSystem
 		registerLogicTypes();
 			   
 		// Register global constants.
-		SCRIPT_GLOBAL_PROPERTY_CONST(float, timeStep, c_step);
+		SCRIPT_GLOBAL_PROPERTY_CONST(float, timeStep, s_tickTime);
 
 		return true;
 	}
@@ -783,6 +851,7 @@ namespace TFE_LogicSystem
 		
 	void update()
 	{
+		TFE_ZONE("Logic Update");
 		s_accum += (f32)TFE_System::getDeltaTime();
 		const size_t count = s_scriptObjects.size();
 
@@ -799,25 +868,37 @@ namespace TFE_LogicSystem
 		}
 		s_logicsToAdd.clear();
 		
+		// Objects far from the player or in unreachable sectors tick less often.
+		TFE_LogicScheduler::update(s_player, (u32)count);
 		while (s_accum >= c_step)
 		{
-			ScriptObject* obj = s_scriptObjects.data();
-			
-			for (size_t i = 0; i < count; i++, obj++)
+			const size_t start = TFE_LogicScheduler::beginStep(c_step, (u32)count);
+			for (size_t n = 0; n < count; n++)
 			{
+				const size_t i = (start + n) < count ? start + n : start + n - count;
+				ScriptObject* obj = &s_scriptObjects[i];
 				if (!obj->gameObj) { continue; }
 
+				f32 dt;
+				if (!TFE_LogicScheduler::shouldTick((u32)i, &dt)) { continue; }
+
 				const size_t logicCount = obj->logic.size();
 				const size_t genCount = obj->generator.size();
 
+				// Native logics tick right away, script ticks are grouped by function and executed after all objects are visited.
+				// This differs from the original order, where every logic ticked in object order. It only matters for objects
+				// that mix native and script logics: the native logics only change their own object (animation time and frame,
+				// angles) and scripts only see 'self', so the native tick now always comes before the scripts of that object.
 				ScriptLogic* logic = obj->logic.data();
 				for (size_t l = 0; l < logicCount; l++, logic++)
 				{
-					if (logic->tick)
+					if (logic->nativeTick)
+					{
+						logic->nativeTick(obj->gameObj, &logic->param, dt);
+					}
+					else if (logic->tick)
 					{
-						s_self = obj->gameObj;
-						s_param = &logic->param;
-						TFE_ScriptSystem::executeScriptFunction(SCRIPT_TYPE_LOGIC, logic->tick);
+						s_tickBatches[logic->tickBatch].items.push_back({ (u32)i, (u32)l, dt });
 					}
 				}
 
@@ -826,15 +907,16 @@ namespace TFE_LogicSystem
 				{
 					if (gen->tick)
 					{
-						s_self = obj->gameObj;
-						s_genParam = &gen->param;
-						TFE_ScriptSystem::executeScriptFunction(SCRIPT_TYPE_LOGIC, gen->tick);
+						s_tickBatches[gen->tickBatch].items.push_back({ (u32)i, (u32)l, dt });
 					}
 				}
 			}
+			executeTickBatches();
+			TFE_FrameStats::addSimTicks(1);
 
 			s_accum -= c_step;
 		}
+		s_tickTime = c_step;
 	}
 
 	void registerKeyTypes()
@@ -957,4 +1039,104 @@ namespace TFE_LogicSystem
 		SCRIPT_ENUM_VALUE(LogicType, LOGIC_UPDATE);
 		SCRIPT_ENUM_VALUE(LogicType, LOGIC_KEY);
 	}
+
+	//////////////////////////////////////////////
+	// Batched script ticks
+	//////////////////////////////////////////////
+	u32 getTickBatch(SCRIPT_FUNC_PTR tick, bool generator)
+	{
+		if (!tick) { return 0; }
+
+		const u32 batchCount = (u32)s_tickBatches.size();
+		for (u32 b = 0; b < batchCount; b++)
+		{
+			if (s_tickBatches[b].tick == tick && s_tickBatches[b].generator == generator) { return b; }
+		}
+		s_tickBatches.push_back({ tick, generator });
+		return batchCount;
+	}
+
+	void setupTickBatchItem(u32 index, void* userData)
+	{
+		const TickBatch* batch = (const TickBatch*)userData;
+		const TickBatchItem* item = &batch->items[index];
+		ScriptObject* obj = &s_scriptObjects[item->objectIndex];
+
+		s_self = obj->gameObj;
+		s_tickTime = item->dt;
+		if (batch->generator)
+		{
+			s_genParam = &obj->generator[item->logicIndex].param;
+		}
+		else
+		{
+			s_param = &obj->logic[item->logicIndex].param;
+		}
+	}
+
+	void executeTickBatches()
+	{
+		const size_t batchCount = s_tickBatches.size();
+		for (size_t b = 0; b < batchCount; b++)
+		{
+			TickBatch* batch = &s_tickBatches[b];
+			if (batch->items.empty()) { continue; }
+
+			TFE_ScriptSystem::executeScriptFunctionBatch(SCRIPT_TYPE_LOGIC, batch->tick, (u32)batch->items.size(), setupTickBatchItem, batch);
+			batch->items.clear();
+		}
+	}
+
+	//////////////////////////////////////////////
+	// Native logics
+	// These must match the behavior of the scripts they replace.
+	//////////////////////////////////////////////
+	// logic_scenery.dxs and logic_update.dxs
+	void noPhysicsStart(GameObject* self, Logic* param, f32 dt)
+	{
+		TFE_SetPhysics(self->objectId, PHYSICS_NONE);
+	}
+
+	// logic_anim.dxs
+	void animStart(GameObject* self, Logic* param, f32 dt)
+	{
+		self->time = 0.0f;
+		TFE_SetAnimFrame(self->objectId, 0, 0);
+	}
+
+	void animTick(GameObject* self, Logic* param, f32 dt)
+	{
+		const f32 frameRate = TFE_GetAnimFramerate(self->objectId, 0);
+		const u32 frameCount = TFE_GetAnimFrameCount(self->objectId, 0);
+
+		// Update and loop the animation time.
+		self->time += dt;
+		const f32 animLength = f32(frameCount) / frameRate;
+		if (self->time >= animLength && animLength > 0.0f)
+		{
+			// Several loops may have passed if the logic ticked at a reduced rate.
+			self->time = fmodf(self->time, animLength);
+		}
+		TFE_SetAnimFrame(self->objectId, 0, s32(self->time * frameRate));
+	}
+
+	// logic_update.dxs
+	void updateTick(GameObject* self, Logic* param, f32 dt)
+	{
+		enum { ROTATE_X = 8, ROTATE_Y = 16, ROTATE_Z = 32 };
+		const Vec3f rotation =
+		{
+			(param->flags & ROTATE_X) ? param->rotation.x * dt : 0.0f,
+			(param->flags & ROTATE_Y) ? param->rotation.y * dt : 0.0f,
+			(param->flags & ROTATE_Z) ? param->rotation.z * dt : 0.0f,
+		};
+		TFE_ChangeAngles(self->objectId, rotation);
+	}
+
+	void registerNativeLogics()
+	{
+		registerNativeLogic(LOGIC_SCENERY, noPhysicsStart, nullptr);
+		registerNativeLogic(LOGIC_ANIM, animStart, animTick);
+		registerNativeLogic(LOGIC_UPDATE, noPhysicsStart, updateTick);
+	}
 }
@@ -17,6 +17,9 @@ enum DamageType
 	DMG_EXPLOSION,
 };
 
+// Native logic function, 'dt' is the time since the last tick (0 for start).
+typedef void(*NativeLogicFunc)(GameObject* self, Logic* param, f32 dt);
+
 namespace TFE_LogicSystem
 {
 	bool init(Player* player);
@@ -29,4 +32,8 @@ namespace TFE_LogicSystem
 
 	void damageObject(GameObject* gameObject, s32 damage, DamageType type = DMG_SHOT);
 	void sendPlayerCollisionTrigger(const GameObject* gameObject);
+
+	// Replace the script of a logic type with a native implementation, used for simple logics that tick often
+	// (the per call script overhead is much larger than the logic itself).
+	void registerNativeLogic(s32 logicType, NativeLogicFunc start, NativeLogicFunc tick);
 }
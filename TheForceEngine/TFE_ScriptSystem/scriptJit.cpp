@@ -0,0 +1,1186 @@
+#include "scriptJit.h"
+#include <angelscript.h>
+#include <TFE_ScriptSystem/AngelScript/sdk/angelscript/source/as_context.h>
+#include <TFE_ScriptSystem/AngelScript/sdk/angelscript/source/as_callfunc.h>
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <map>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define SCRIPT_JIT_X64 1
+#endif
+
+namespace TFE_ScriptJit
+{
+	static ScriptJitStats s_stats = {};
+
+#ifdef SCRIPT_JIT_X64
+	enum JitReg
+	{
+		RAX = 0, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+		R8, R9, R10, R11, R12, R13, R14, R15,
+	};
+	// Registers holding the VM state while in native code, all are callee-saved in both calling conventions.
+	static const u8 REG_VM = R12;	// asSVMRegisters*
+	static const u8 REG_FP = R13;	// stack frame pointer, variables are at negative offsets.
+	static const u8 REG_SP = R14;	// stack pointer, grows down.
+	// Argument registers.
+#ifdef _WIN32
+	static const u8 REG_ARG0 = RCX;
+	static const u8 REG_ARG1 = RDX;
+	// Space the caller must reserve for the callee to spill its register arguments.
+	static const s32 c_shadowSpace = 32;
+#else
+	static const u8 REG_ARG0 = RDI;
+	static const u8 REG_ARG1 = RSI;
+	static const s32 c_shadowSpace = 0;
+#endif
+
+	enum JitCond
+	{
+		CC_O = 0, CC_NO, CC_B, CC_AE, CC_E, CC_NE, CC_BE, CC_A,
+		CC_S, CC_NS, CC_P, CC_NP, CC_L, CC_GE, CC_LE, CC_G,
+	};
+
+	// Encoding prefixes.
+	enum JitPrefix
+	{
+		PRE_NONE = 0x00,
+		PRE_16   = 0x66,	// 16-bit operand or packed double.
+		PRE_SD   = 0xf2,	// scalar double.
+		PRE_SS   = 0xf3,	// scalar single.
+	};
+
+	// Offsets of the VM registers.
+	static const s32 c_vmProgramPointer = (s32)offsetof(asSVMRegisters, programPointer);
+	static const s32 c_vmFramePointer   = (s32)offsetof(asSVMRegisters, stackFramePointer);
+	static const s32 c_vmStackPointer   = (s32)offsetof(asSVMRegisters, stackPointer);
+	static const s32 c_vmValue          = (s32)offsetof(asSVMRegisters, valueRegister);
+	static const s32 c_vmObject         = (s32)offsetof(asSVMRegisters, objectRegister);
+	static const s32 c_vmObjectType     = (s32)offsetof(asSVMRegisters, objectType);
+	static const s32 c_vmSuspend        = (s32)offsetof(asSVMRegisters, doProcessSuspend);
+
+	// Executable code blocks start with a header holding the allocation size, the function follows.
+	static const size_t c_codeHeaderSize = 16;
+
+	// Minimal x86-64 encoder, memory operands are always [base + disp].
+	class Emitter
+	{
+	public:
+		std::vector<u8> code;
+
+		size_t pos() const { return code.size(); }
+		void byte(u8 value) { code.push_back(value); }
+		void dword(u32 value)
+		{
+			for (s32 i = 0; i < 4; i++) { code.push_back(u8(value >> (i * 8))); }
+		}
+		void qword(u64 value)
+		{
+			for (s32 i = 0; i < 8; i++) { code.push_back(u8(value >> (i * 8))); }
+		}
+		void patch32(size_t at, u32 value)
+		{
+			for (s32 i = 0; i < 4; i++) { code[at + i] = u8(value >> (i * 8)); }
+		}
+
+		// Instruction with a [base + disp] operand, 'reg' is a register or the opcode extension.
+		void rm(u8 prefix, bool wide, u32 opcode, u8 reg, u8 base, s32 disp)
+		{
+			header(prefix, wide, reg, base, opcode);
+			const u8 mod = (disp == 0 && (base & 7) != RBP) ? 0 : (disp >= -128 && disp <= 127) ? 1 : 2;
+			byte(u8((mod << 6) | ((reg & 7) << 3) | (base & 7)));
+			if ((base & 7) == RSP) { byte(0x24); }
+			if (mod == 1) { byte(u8(disp)); }
+			else if (mod == 2) { dword(u32(disp)); }
+		}
+		// Instruction with a register operand.
+		void rr(u8 prefix, bool wide, u32 opcode, u8 reg, u8 rmReg)
+		{
+			header(prefix, wide, reg, rmReg, opcode);
+			byte(u8(0xc0 | ((reg & 7) << 3) | (rmReg & 7)));
+		}
+
+		void movRI64(u8 reg, u64 value)
+		{
+			byte(u8(0x48 | (reg >> 3)));
+			byte(u8(0xb8 | (reg & 7)));
+			qword(value);
+		}
+		void movRI32(u8 reg, u32 value)
+		{
+			if (reg & 8) { byte(0x41); }
+			byte(u8(0xb8 | (reg & 7)));
+			dword(value);
+		}
+		void push(u8 reg)
+		{
+			if (reg & 8) { byte(0x41); }
+			byte(u8(0x50 | (reg & 7)));
+		}
+		void pop(u8 reg)
+		{
+			if (reg & 8) { byte(0x41); }
+			byte(u8(0x58 | (reg & 7)));
+		}
+
+		// Jumps with a 32-bit displacement, returns the position of the displacement to patch.
+		size_t jmp()
+		{
+			byte(0xe9);
+			dword(0);
+			return pos() - 4;
+		}
+		size_t jcc(JitCond cond)
+		{
+			byte(0x0f);
+			byte(u8(0x80 | cond));
+			dword(0);
+			return pos() - 4;
+		}
+		// Point the jump at 'patchPos' to 'target'.
+		void bind(size_t patchPos, size_t target)
+		{
+			patch32(patchPos, u32(s32(target) - s32(patchPos + 4)));
+		}
+		void bindHere(size_t patchPos)
+		{
+			bind(patchPos, pos());
+		}
+
+	private:
+		void header(u8 prefix, bool wide, u8 reg, u8 base, u32 opcode)
+		{
+			if (prefix) { byte(prefix); }
+			const u8 rex = u8(0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((base & 8) ? 1 : 0));
+			if (rex != 0x40) { byte(rex); }
+			if (opcode > 0xff) { byte(u8(opcode >> 8)); }
+			byte(u8(opcode));
+		}
+	};
+
+	// Common opcodes.
+	enum JitOpcode
+	{
+		OP_ADD = 0x03, OP_OR = 0x0b, OP_AND = 0x23, OP_SUB = 0x2b, OP_XOR = 0x33, OP_CMP = 0x3b,
+		OP_MOVSXD = 0x63, OP_IMUL_IMM = 0x69, OP_GRP1 = 0x81, OP_GRP1_IMM8 = 0x83, OP_TEST = 0x85,
+		OP_MOV_STORE8 = 0x88, OP_MOV_STORE = 0x89, OP_MOV_LOAD = 0x8b, OP_LEA = 0x8d,
+		OP_MOV_IMM = 0xc7, OP_SHIFT_CL = 0xd3, OP_GRP3 = 0xf7, OP_GRP4 = 0xfe, OP_GRP5 = 0xff,
+		OP_SSE_LOAD = 0x0f10, OP_SSE_STORE = 0x0f11, OP_CVTSI2S = 0x0f2a, OP_CVTTS2SI = 0x0f2c, OP_UCOMIS = 0x0f2e,
+		OP_XORPS = 0x0f57, OP_SSE_ADD = 0x0f58, OP_SSE_MUL = 0x0f59, OP_CVTS2S = 0x0f5a, OP_SSE_SUB = 0x0f5c,
+		OP_SSE_DIV = 0x0f5e, OP_MOVD_TO_XMM = 0x0f6e, OP_SETCC = 0x0f90, OP_IMUL = 0x0faf,
+		OP_MOVZX8 = 0x0fb6, OP_MOVZX16 = 0x0fb7, OP_BT_IMM = 0x0fba, OP_MOVSX8 = 0x0fbe, OP_MOVSX16 = 0x0fbf,
+	};
+	// Opcode extensions.
+	enum JitOpExt
+	{
+		EXT_ADD = 0, EXT_OR = 1, EXT_AND = 4, EXT_SUB = 5, EXT_XOR = 6, EXT_CMP = 7,
+		EXT_INC = 0, EXT_DEC = 1, EXT_CALL = 2, EXT_JMP = 4,
+		EXT_NOT = 2, EXT_NEG = 3, EXT_DIV = 6, EXT_IDIV = 7,
+		EXT_SHL = 4, EXT_SHR = 5, EXT_SAR = 7, EXT_BTC = 7,
+	};
+
+	// Compiles a single function.
+	class FunctionCompiler
+	{
+	public:
+		FunctionCompiler(asDWORD* byteCode, asUINT length) : m_bc(byteCode), m_length(length) {}
+
+		bool compile(asJITFunction* output);
+
+	private:
+		asDWORD* m_bc;
+		asUINT m_length;
+		Emitter m_e;
+		std::vector<s32> m_nativeOffset;	// native offset of each bytecode instruction, -1 if not the start of an instruction.
+		std::vector<u8> m_supported;		// 1 if the instruction at the bytecode offset is compiled.
+		std::vector<std::pair<size_t, asUINT>> m_jumps;		// bytecode jump targets to patch.
+		std::map<asUINT, std::vector<size_t>> m_exits;		// exits back to the VM to patch, by bytecode offset.
+
+		bool isSupported(asEBCInstr op);
+		void emitPrologue();
+		void emitEpilogue();
+		void emitInstruction(asUINT i);
+		void emitExitStubs();
+
+		// Return to the VM, which continues at the instruction at bytecode offset 'target'.
+		void exitTo(asUINT target) { m_exits[target].push_back(m_e.jmp()); }
+		void exitIf(JitCond cond, asUINT target) { m_exits[target].push_back(m_e.jcc(cond)); }
+		void jumpTo(asUINT target) { m_jumps.push_back(std::make_pair(m_e.jmp(), target)); }
+		void jumpIf(JitCond cond, asUINT target) { m_jumps.push_back(std::make_pair(m_e.jcc(cond), target)); }
+
+		// Helpers for variables on the stack frame.
+		static s32 var(s16 index) { return -4 * s32(index); }
+		void load32(u8 reg, s16 v)  { m_e.rm(PRE_NONE, false, OP_MOV_LOAD, reg, REG_FP, var(v)); }
+		void load64(u8 reg, s16 v)  { m_e.rm(PRE_NONE, true, OP_MOV_LOAD, reg, REG_FP, var(v)); }
+		void store32(s16 v, u8 reg) { m_e.rm(PRE_NONE, false, OP_MOV_STORE, reg, REG_FP, var(v)); }
+		void store64(s16 v, u8 reg) { m_e.rm(PRE_NONE, true, OP_MOV_STORE, reg, REG_FP, var(v)); }
+		// Helpers for the VM stack.
+		void pushStack32(u8 reg);
+		void pushStack64(u8 reg);
+
+		void emitCompareResult(JitCond greater, JitCond less);
+		void emitFloatCompare();
+		void emitIntDivide(asDWORD* bc, asUINT i, bool wide, bool isSigned, bool remainder);
+		void emitFloatDivide(asDWORD* bc, asUINT i, u8 prefix);
+		void emitTestValue(JitCond cond);
+		void emitCondJump(asDWORD* bc, asUINT i, JitCond cond);
+		void emitCallSystem(asDWORD* bc, asUINT i);
+	};
+
+	void* allocateCode(const std::vector<u8>& code);
+	void  freeCode(void* func);
+	int   callSystemFunction(int id, asSVMRegisters* regs);
+
+	class JitCompiler : public asIJITCompiler
+	{
+	public:
+		int CompileFunction(asIScriptFunction* function, asJITFunction* output) override
+		{
+			*output = nullptr;
+			asUINT length = 0;
+			asDWORD* byteCode = function->GetByteCode(&length);
+			if (!byteCode || !length) { return asERROR; }
+
+			FunctionCompiler compiler(byteCode, length);
+			return compiler.compile(output) ? asSUCCESS : asERROR;
+		}
+
+		void ReleaseJITFunction(asJITFunction func) override
+		{
+			freeCode((void*)func);
+		}
+	};
+#endif
+
+	asIJITCompiler* createCompiler()
+	{
+#ifdef SCRIPT_JIT_X64
+		s_stats = {};
+		return new JitCompiler();
+#else
+		return nullptr;
+#endif
+	}
+
+	void destroyCompiler(asIJITCompiler* compiler)
+	{
+		delete compiler;
+	}
+
+	void getStats(ScriptJitStats* stats)
+	{
+		*stats = s_stats;
+	}
+
+#ifdef SCRIPT_JIT_X64
+	//////////////////////////////////////////////
+	// Internal
+	//////////////////////////////////////////////
+	bool FunctionCompiler::isSupported(asEBCInstr op)
+	{
+		switch (op)
+		{
+			// Script calls, object management and rarely used instructions are left to the VM.
+			case asBC_CALL:
+			case asBC_RET:
+			case asBC_CALLINTF:
+			case asBC_CALLBND:
+			case asBC_CallPtr:
+			case asBC_Thiscall1:
+			case asBC_ALLOC:
+			case asBC_FREE:
+			case asBC_REFCPY:
+			case asBC_RefCpyV:
+			case asBC_COPY:
+			case asBC_Cast:
+			case asBC_JMPP:
+			case asBC_STR:
+			case asBC_AllocMem:
+			case asBC_SetListSize:
+			case asBC_SetListType:
+			case asBC_PshListElmnt:
+			case asBC_MODf:
+			case asBC_MODd:
+			case asBC_u64TOf:
+			case asBC_u64TOd:
+			case asBC_POWi:
+			case asBC_POWu:
+			case asBC_POWf:
+			case asBC_POWd:
+			case asBC_POWdi:
+			case asBC_POWi64:
+			case asBC_POWu64:
+				return false;
+			default:
+				break;
+		}
+		return op <= asBC_Thiscall1;
+	}
+
+	bool FunctionCompiler::compile(asJITFunction* output)
+	{
+		m_nativeOffset.assign(m_length + 1, -1);
+		m_supported.assign(m_length + 1, 0);
+
+		u32 nativeCount = 0, fallbackCount = 0;
+		for (asUINT i = 0; i < m_length;)
+		{
+			const asEBCInstr op = asEBCInstr(*(asBYTE*)&m_bc[i]);
+			m_supported[i] = isSupported(op) ? 1 : 0;
+			if (op != asBC_JitEntry && op != asBC_SUSPEND)
+			{
+				if (m_supported[i]) { nativeCount++; }
+				else { fallbackCount++; }
+			}
+			i += asBCTypeSize[asBCInfo[op].type];
+		}
+		// Nothing worth compiling.
+		if (!nativeCount) { return false; }
+
+		emitPrologue();
+		for (asUINT i = 0; i < m_length;)
+		{
+			m_nativeOffset[i] = s32(m_e.pos());
+			const asEBCInstr op = asEBCInstr(*(asBYTE*)&m_bc[i]);
+			if (m_supported[i])
+			{
+				emitInstruction(i);
+			}
+			else
+			{
+				// The VM executes the instruction and resumes native code at the next JitEntry.
+				exitTo(i);
+			}
+			i += asBCTypeSize[asBCInfo[op].type];
+		}
+		m_nativeOffset[m_length] = s32(m_e.pos());
+		exitTo(m_length);
+
+		emitExitStubs();
+		emitEpilogue();
+
+		for (size_t j = 0; j < m_jumps.size(); j++)
+		{
+			const asUINT target = m_jumps[j].second;
+			assert(target <= m_length && m_nativeOffset[target] >= 0);
+			m_e.bind(m_jumps[j].first, size_t(m_nativeOffset[target]));
+		}
+
+		u8* func = (u8*)allocateCode(m_e.code);
+		if (!func) { return false; }
+
+		// Point the JitEntry instructions at the native code, entries followed by an instruction
+		// left to the VM are kept as nops to avoid a round trip through native code.
+		for (asUINT i = 0; i < m_length;)
+		{
+			const asEBCInstr op = asEBCInstr(*(asBYTE*)&m_bc[i]);
+			const asUINT next = i + asBCTypeSize[asBCInfo[op].type];
+			if (op == asBC_JitEntry)
+			{
+				const bool enter = next < m_length && m_supported[next];
+				asBC_PTRARG(&m_bc[i]) = enter ? asPWORD(func + m_nativeOffset[i]) : 0;
+			}
+			i = next;
+		}
+
+		s_stats.functionCount++;
+		s_stats.nativeInstrCount += nativeCount;
+		s_stats.fallbackInstrCount += fallbackCount;
+		*output = (asJITFunction)func;
+		return true;
+	}
+
+	// Entry: (asSVMRegisters* regs, asPWORD jitArg), jitArg is the address to continue from.
+	void FunctionCompiler::emitPrologue()
+	{
+		m_e.push(REG_VM);
+		m_e.push(REG_FP);
+		m_e.push(REG_SP);
+		// The return address and 3 registers keep the stack 16 byte aligned for calls.
+		if (c_shadowSpace) { m_e.rr(PRE_NONE, true, OP_GRP1, EXT_SUB, RSP); m_e.dword(c_shadowSpace); }
+
+		m_e.rr(PRE_NONE, true, OP_MOV_LOAD, REG_VM, REG_ARG0);
+		m_e.rm(PRE_NONE, true, OP_MOV_LOAD, REG_FP, REG_VM, c_vmFramePointer);
+		m_e.rm(PRE_NONE, true, OP_MOV_LOAD, REG_SP, REG_VM, c_vmStackPointer);
+		m_e.rr(PRE_NONE, false, OP_GRP5, EXT_JMP, REG_ARG1);
+	}
+
+	// Exit: rax = the bytecode address the VM continues from.
+	void FunctionCompiler::emitEpilogue()
+	{
+		m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_VM, c_vmProgramPointer);
+		m_e.rm(PRE_NONE, true, OP_MOV_STORE, REG_FP, REG_VM, c_vmFramePointer);
+		m_e.rm(PRE_NONE, true, OP_MOV_STORE, REG_SP, REG_VM, c_vmStackPointer);
+		if (c_shadowSpace) { m_e.rr(PRE_NONE, true, OP_GRP1, EXT_ADD, RSP); m_e.dword(c_shadowSpace); }
+		m_e.pop(REG_SP);
+		m_e.pop(REG_FP);
+		m_e.pop(REG_VM);
+		m_e.byte(0xc3);	// ret
+	}
+
+	void FunctionCompiler::emitExitStubs()
+	{
+		std::vector<size_t> toEpilogue;
+		std::map<asUINT, std::vector<size_t>>::iterator iExit = m_exits.begin();
+		for (; iExit != m_exits.end(); ++iExit)
+		{
+			const std::vector<size_t>& patches = iExit->second;
+			for (size_t p = 0; p < patches.size(); p++) { m_e.bindHere(patches[p]); }
+
+			m_e.movRI64(RAX, u64(asPWORD(&m_bc[iExit->first])));
+			toEpilogue.push_back(m_e.jmp());
+		}
+		for (size_t p = 0; p < toEpilogue.size(); p++) { m_e.bindHere(toEpilogue[p]); }
+	}
+
+	void FunctionCompiler::pushStack32(u8 reg)
+	{
+		m_e.rr(PRE_NONE, true, OP_GRP1_IMM8, EXT_SUB, REG_SP); m_e.byte(4);
+		m_e.rm(PRE_NONE, false, OP_MOV_STORE, reg, REG_SP, 0);
+	}
+
+	void FunctionCompiler::pushStack64(u8 reg)
+	{
+		m_e.rr(PRE_NONE, true, OP_GRP1_IMM8, EXT_SUB, REG_SP); m_e.byte(8);
+		m_e.rm(PRE_NONE, true, OP_MOV_STORE, reg, REG_SP, 0);
+	}
+
+	// Set the value register to 1, 0 or -1 from the flags of a previous compare.
+	void FunctionCompiler::emitCompareResult(JitCond greater, JitCond less)
+	{
+		m_e.rr(PRE_NONE, false, OP_SETCC | greater, 0, RCX);
+		m_e.rr(PRE_NONE, false, OP_SETCC | less, 0, RDX);
+		m_e.rr(PRE_NONE, false, OP_MOVZX8, RCX, RCX);
+		m_e.rr(PRE_NONE, false, OP_MOVZX8, RDX, RDX);
+		m_e.rr(PRE_NONE, false, OP_SUB, RCX, RDX);
+		m_e.rm(PRE_NONE, false, OP_MOV_STORE, RCX, REG_VM, c_vmValue);
+	}
+
+	// Same as emitCompareResult() for ucomiss/ucomisd, unordered values compare as greater (like the VM).
+	void FunctionCompiler::emitFloatCompare()
+	{
+		m_e.rr(PRE_NONE, false, OP_SETCC | CC_NP, 0, RAX);	// ordered
+		m_e.rr(PRE_NONE, false, OP_SETCC | CC_E, 0, RCX);	// equal or unordered
+		m_e.rr(PRE_NONE, false, OP_SETCC | CC_B, 0, RDX);	// less or unordered
+		m_e.rr(PRE_NONE, false, 0x22, RCX, RAX);				// and cl, al
+		m_e.rr(PRE_NONE, false, 0x22, RDX, RAX);				// and dl, al
+		m_e.rr(PRE_NONE, false, OP_MOVZX8, RCX, RCX);
+		m_e.rr(PRE_NONE, false, OP_MOVZX8, RDX, RDX);
+		m_e.movRI32(RAX, 1);
+		m_e.rr(PRE_NONE, false, OP_SUB, RAX, RCX);
+		m_e.rr(PRE_NONE, false, OP_SUB, RAX, RDX);
+		m_e.rr(PRE_NONE, false, OP_SUB, RAX, RDX);
+		m_e.rm(PRE_NONE, false, OP_MOV_STORE, RAX, REG_VM, c_vmValue);
+	}
+
+	// Division by zero and overflow exit to the VM, which raises the script exception.
+	void FunctionCompiler::emitIntDivide(asDWORD* bc, asUINT i, bool wide, bool isSigned, bool remainder)
+	{
+		const s16 a0 = asBC_SWORDARG0(bc), a1 = asBC_SWORDARG1(bc), a2 = asBC_SWORDARG2(bc);
+		m_e.rm(PRE_NONE, wide, OP_MOV_LOAD, RCX, REG_FP, var(a2));
+		m_e.rr(PRE_NONE, wide, OP_TEST, RCX, RCX);
+		exitIf(CC_E, i);
+		if (isSigned)
+		{
+			m_e.rr(PRE_NONE, wide, OP_GRP1_IMM8, EXT_CMP, RCX); m_e.byte(0xff);
+			const size_t notMinusOne = m_e.jcc(CC_NE);
+			if (wide) { m_e.movRI64(RAX, 0x8000000000000000ull); }
+			else { m_e.movRI32(RAX, 0x80000000u); }
+			m_e.rm(PRE_NONE, wide, OP_CMP, RAX, REG_FP, var(a1));
+			exitIf(CC_E, i);
+			m_e.bindHere(notMinusOne);
+		}
+
+		m_e.rm(PRE_NONE, wide, OP_MOV_LOAD, RAX, REG_FP, var(a1));
+		if (isSigned)
+		{
+			if (wide) { m_e.byte(0x48); }
+			m_e.byte(0x99);	// cdq/cqo
+			m_e.rr(PRE_NONE, wide, OP_GRP3, EXT_IDIV, RCX);
+		}
+		else
+		{
+			m_e.rr(PRE_NONE, false, OP_XOR, RDX, RDX);
+			m_e.rr(PRE_NONE, wide, OP_GRP3, EXT_DIV, RCX);
+		}
+		m_e.rm(PRE_NONE, wide, OP_MOV_STORE, remainder ? RDX : RAX, REG_FP, var(a0));
+	}
+
+	void FunctionCompiler::emitFloatDivide(asDWORD* bc, asUINT i, u8 prefix)
+	{
+		const s16 a0 = asBC_SWORDARG0(bc), a1 = asBC_SWORDARG1(bc), a2 = asBC_SWORDARG2(bc);
+		const u8 cmpPrefix = prefix == PRE_SD ? PRE_16 : PRE_NONE;
+		m_e.rm(prefix, false, OP_SSE_LOAD, 1, REG_FP, var(a2));
+		m_e.rr(PRE_NONE, false, OP_XORPS, 0, 0);
+		m_e.rr(cmpPrefix, false, OP_UCOMIS, 1, 0);
+		const size_t unordered = m_e.jcc(CC_P);
+		exitIf(CC_E, i);
+		m_e.bindHere(unordered);
+		m_e.rm(prefix, false, OP_SSE_LOAD, 0, REG_FP, var(a1));
+		m_e.rr(prefix, false, OP_SSE_DIV, 0, 1);
+		m_e.rm(prefix, false, OP_SSE_STORE, 0, REG_FP, var(a0));
+	}
+
+	// Set the value register to 1 if the condition holds for its low dword, 0 otherwise.
+	void FunctionCompiler::emitTestValue(JitCond cond)
+	{
+		m_e.rm(PRE_NONE, false, OP_GRP1_IMM8, EXT_CMP, REG_VM, c_vmValue); m_e.byte(0);
+		m_e.rr(PRE_NONE, false, OP_SETCC | cond, 0, RAX);
+		m_e.rr(PRE_NONE, false, OP_MOVZX8, RAX, RAX);
+		m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_VM, c_vmValue);
+	}
+
+	void FunctionCompiler::emitCondJump(asDWORD* bc, asUINT i, JitCond cond)
+	{
+		m_e.rm(PRE_NONE, false, OP_GRP1_IMM8, EXT_CMP, REG_VM, c_vmValue); m_e.byte(0);
+		jumpIf(cond, i + 2 + asBC_INTARG(bc));
+	}
+
+	void FunctionCompiler::emitCallSystem(asDWORD* bc, asUINT i)
+	{
+		// Sync the VM registers, the called function may inspect them or raise an exception.
+		m_e.movRI64(RAX, u64(asPWORD(bc)));
+		m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_VM, c_vmProgramPointer);
+		m_e.rm(PRE_NONE, true, OP_MOV_STORE, REG_FP, REG_VM, c_vmFramePointer);
+		m_e.rm(PRE_NONE, true, OP_MOV_STORE, REG_SP, REG_VM, c_vmStackPointer);
+
+		m_e.movRI32(REG_ARG0, u32(asBC_INTARG(bc)));
+		m_e.rr(PRE_NONE, true, OP_MOV_LOAD, REG_ARG1, REG_VM);
+		m_e.movRI64(RAX, u64(asPWORD(&callSystemFunction)));
+		m_e.rr(PRE_NONE, false, OP_GRP5, EXT_CALL, RAX);
+
+		// Pop the arguments, the return value is the number of dwords.
+		m_e.rr(PRE_NONE, true, OP_MOVSXD, RAX, RAX);
+		m_e.rr(PRE_NONE, true, 0xc1, EXT_SHL, RAX); m_e.byte(2);
+		m_e.rr(PRE_NONE, true, OP_ADD, REG_SP, RAX);
+
+		// Exceptions, suspend requests and line callbacks are handled by the VM.
+		m_e.rm(PRE_NONE, false, 0x80, EXT_CMP, REG_VM, c_vmSuspend); m_e.byte(0);
+		exitIf(CC_NE, i + 2);
+	}
+
+	// Emit native code matching the VM (see asCContext::ExecuteNext()).
+	void FunctionCompiler::emitInstruction(asUINT i)
+	{
+		asDWORD* bc = &m_bc[i];
+		const asEBCInstr op = asEBCInstr(*(asBYTE*)bc);
+		const s16 a0 = asBC_SWORDARG0(bc);
+		const s16 a1 = asBC_SWORDARG1(bc);
+		const s16 a2 = asBC_SWORDARG2(bc);
+
+		switch (op)
+		{
+			case asBC_JitEntry:
+				// Resume point, no code.
+				break;
+			case asBC_SUSPEND:
+				m_e.rm(PRE_NONE, false, 0x80, EXT_CMP, REG_VM, c_vmSuspend); m_e.byte(0);
+				exitIf(CC_NE, i);
+				break;
+			case asBC_CALLSYS:
+				emitCallSystem(bc, i);
+				break;
+
+			// Stack
+			case asBC_PopPtr:
+				m_e.rr(PRE_NONE, true, OP_GRP1_IMM8, EXT_ADD, REG_SP); m_e.byte(8);
+				break;
+			case asBC_PshC4:
+			case asBC_TYPEID:
+				m_e.movRI32(RAX, asBC_DWORDARG(bc));
+				pushStack32(RAX);
+				break;
+			case asBC_PshV4:
+				load32(RAX, a0);
+				pushStack32(RAX);
+				break;
+			case asBC_PshG4:
+				m_e.movRI64(RAX, u64(asBC_PTRARG(bc)));
+				m_e.rm(PRE_NONE, false, OP_MOV_LOAD, RAX, RAX, 0);
+				pushStack32(RAX);
+				break;
+			case asBC_PshC8:
+				m_e.movRI64(RAX, asBC_QWORDARG(bc));
+				pushStack64(RAX);
+				break;
+			case asBC_PshV8:
+			case asBC_PshVPtr:
+				load64(RAX, a0);
+				pushStack64(RAX);
+				break;
+			case asBC_PshGPtr:
+				m_e.movRI64(RAX, u64(asBC_PTRARG(bc)));
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, RAX, 0);
+				pushStack64(RAX);
+				break;
+			case asBC_PGA:
+			case asBC_OBJTYPE:
+			case asBC_FuncPtr:
+				m_e.movRI64(RAX, u64(asBC_PTRARG(bc)));
+				pushStack64(RAX);
+				break;
+			case asBC_PshNull:
+				m_e.rr(PRE_NONE, false, OP_XOR, RAX, RAX);
+				pushStack64(RAX);
+				break;
+			case asBC_PSF:
+				m_e.rm(PRE_NONE, true, OP_LEA, RAX, REG_FP, var(a0));
+				pushStack64(RAX);
+				break;
+			case asBC_VAR:
+				m_e.movRI64(RAX, u64(s64(a0)));
+				pushStack64(RAX);
+				break;
+			case asBC_SwapPtr:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_SP, 0);
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RCX, REG_SP, 8);
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RCX, REG_SP, 0);
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_SP, 8);
+				break;
+			case asBC_PopRPtr:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_SP, 0);
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_VM, c_vmValue);
+				m_e.rr(PRE_NONE, true, OP_GRP1_IMM8, EXT_ADD, REG_SP); m_e.byte(8);
+				break;
+			case asBC_PshRPtr:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_VM, c_vmValue);
+				pushStack64(RAX);
+				break;
+			case asBC_RDSPtr:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_SP, 0);
+				m_e.rr(PRE_NONE, true, OP_TEST, RAX, RAX);
+				exitIf(CC_E, i);
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, RAX, 0);
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_SP, 0);
+				break;
+			case asBC_ADDSi:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_SP, 0);
+				m_e.rr(PRE_NONE, true, OP_TEST, RAX, RAX);
+				exitIf(CC_E, i);
+				m_e.rm(PRE_NONE, true, OP_LEA, RAX, RAX, a0);
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_SP, 0);
+				break;
+
+			// Null checks
+			case asBC_CHKREF:
+				m_e.rm(PRE_NONE, true, OP_GRP1_IMM8, EXT_CMP, REG_SP, 0); m_e.byte(0);
+				exitIf(CC_E, i);
+				break;
+			case asBC_ChkRefS:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_SP, 0);
+				m_e.rm(PRE_NONE, true, OP_GRP1_IMM8, EXT_CMP, RAX, 0); m_e.byte(0);
+				exitIf(CC_E, i);
+				break;
+			case asBC_ChkNullV:
+				m_e.rm(PRE_NONE, true, OP_GRP1_IMM8, EXT_CMP, REG_FP, var(a0)); m_e.byte(0);
+				exitIf(CC_E, i);
+				break;
+			case asBC_ChkNullS:
+				m_e.rm(PRE_NONE, true, OP_GRP1_IMM8, EXT_CMP, REG_SP, 4 * s32(asBC_WORDARG0(bc))); m_e.byte(0);
+				exitIf(CC_E, i);
+				break;
+
+			// Object references
+			case asBC_LOADOBJ:
+				load64(RAX, a0);
+				m_e.rm(PRE_NONE, true, OP_MOV_IMM, 0, REG_VM, c_vmObjectType); m_e.dword(0);
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_VM, c_vmObject);
+				m_e.rm(PRE_NONE, true, OP_MOV_IMM, 0, REG_FP, var(a0)); m_e.dword(0);
+				break;
+			case asBC_STOREOBJ:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_VM, c_vmObject);
+				store64(a0, RAX);
+				m_e.rm(PRE_NONE, true, OP_MOV_IMM, 0, REG_VM, c_vmObject); m_e.dword(0);
+				break;
+			case asBC_GETOBJ:
+			case asBC_GETOBJREF:
+			case asBC_GETREF:
+			{
+				// The stack slot holds a variable index, replace it with the variable contents or address.
+				const s32 slot = 4 * s32(asBC_WORDARG0(bc));
+				if (op == asBC_GETREF) { m_e.rm(PRE_NONE, true, OP_MOVSXD, RAX, REG_SP, slot); }
+				else { m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_SP, slot); }
+				m_e.rr(PRE_NONE, true, 0xc1, EXT_SHL, RAX); m_e.byte(2);
+				m_e.rr(PRE_NONE, true, OP_MOV_LOAD, RCX, REG_FP);
+				m_e.rr(PRE_NONE, true, OP_SUB, RCX, RAX);
+				if (op != asBC_GETREF) { m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RDX, RCX, 0); }
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, op == asBC_GETREF ? RCX : RDX, REG_SP, slot);
+				if (op == asBC_GETOBJ) { m_e.rm(PRE_NONE, true, OP_MOV_IMM, 0, RCX, 0); m_e.dword(0); }
+			} break;
+			case asBC_ClrVPtr:
+				m_e.rm(PRE_NONE, true, OP_MOV_IMM, 0, REG_FP, var(a0)); m_e.dword(0);
+				break;
+			case asBC_LoadThisR:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_FP, 0);
+				m_e.rr(PRE_NONE, true, OP_TEST, RAX, RAX);
+				exitIf(CC_E, i);
+				m_e.rm(PRE_NONE, true, OP_LEA, RAX, RAX, a0);
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_VM, c_vmValue);
+				break;
+			case asBC_LoadRObjR:
+				load64(RAX, a0);
+				m_e.rr(PRE_NONE, true, OP_TEST, RAX, RAX);
+				exitIf(CC_E, i);
+				m_e.rm(PRE_NONE, true, OP_LEA, RAX, RAX, a1);
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_VM, c_vmValue);
+				break;
+			case asBC_LoadVObjR:
+				m_e.rm(PRE_NONE, true, OP_LEA, RAX, REG_FP, var(a0) + a1);
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_VM, c_vmValue);
+				break;
+
+			// Variables, globals and the value register
+			case asBC_SetV1:
+			case asBC_SetV2:
+			case asBC_SetV4:
+				m_e.rm(PRE_NONE, false, OP_MOV_IMM, 0, REG_FP, var(a0)); m_e.dword(asBC_DWORDARG(bc));
+				break;
+			case asBC_SetV8:
+				m_e.movRI64(RAX, asBC_QWORDARG(bc));
+				store64(a0, RAX);
+				break;
+			case asBC_CpyVtoV4:
+				load32(RAX, a1);
+				store32(a0, RAX);
+				break;
+			case asBC_CpyVtoV8:
+				load64(RAX, a1);
+				store64(a0, RAX);
+				break;
+			case asBC_CpyVtoR4:
+				load32(RAX, a0);
+				m_e.rm(PRE_NONE, false, OP_MOV_STORE, RAX, REG_VM, c_vmValue);
+				break;
+			case asBC_CpyVtoR8:
+				load64(RAX, a0);
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_VM, c_vmValue);
+				break;
+			case asBC_CpyRtoV4:
+				m_e.rm(PRE_NONE, false, OP_MOV_LOAD, RAX, REG_VM, c_vmValue);
+				store32(a0, RAX);
+				break;
+			case asBC_CpyRtoV8:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_VM, c_vmValue);
+				store64(a0, RAX);
+				break;
+			case asBC_CpyVtoG4:
+				load32(RAX, a0);
+				m_e.movRI64(RCX, u64(asBC_PTRARG(bc)));
+				m_e.rm(PRE_NONE, false, OP_MOV_STORE, RAX, RCX, 0);
+				break;
+			case asBC_CpyGtoV4:
+				m_e.movRI64(RCX, u64(asBC_PTRARG(bc)));
+				m_e.rm(PRE_NONE, false, OP_MOV_LOAD, RAX, RCX, 0);
+				store32(a0, RAX);
+				break;
+			case asBC_SetG4:
+				m_e.movRI64(RCX, u64(asBC_PTRARG(bc)));
+				m_e.rm(PRE_NONE, false, OP_MOV_IMM, 0, RCX, 0); m_e.dword(asBC_DWORDARG(bc + AS_PTR_SIZE));
+				break;
+			case asBC_LdGRdR4:
+				m_e.movRI64(RAX, u64(asBC_PTRARG(bc)));
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_VM, c_vmValue);
+				m_e.rm(PRE_NONE, false, OP_MOV_LOAD, RAX, RAX, 0);
+				store32(a0, RAX);
+				break;
+			case asBC_LDG:
+				m_e.movRI64(RAX, u64(asBC_PTRARG(bc)));
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_VM, c_vmValue);
+				break;
+			case asBC_LDV:
+				m_e.rm(PRE_NONE, true, OP_LEA, RAX, REG_FP, var(a0));
+				m_e.rm(PRE_NONE, true, OP_MOV_STORE, RAX, REG_VM, c_vmValue);
+				break;
+			case asBC_WRTV1:
+			case asBC_WRTV2:
+			case asBC_WRTV4:
+			case asBC_WRTV8:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_VM, c_vmValue);
+				if (op == asBC_WRTV8) { load64(RCX, a0); }
+				else { load32(RCX, a0); }
+				if (op == asBC_WRTV1) { m_e.rm(PRE_NONE, false, OP_MOV_STORE8, RCX, RAX, 0); }
+				else { m_e.rm(op == asBC_WRTV2 ? PRE_16 : PRE_NONE, op == asBC_WRTV8, OP_MOV_STORE, RCX, RAX, 0); }
+				break;
+			case asBC_RDR1:
+			case asBC_RDR2:
+			case asBC_RDR4:
+			case asBC_RDR8:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_VM, c_vmValue);
+				if (op == asBC_RDR1) { m_e.rm(PRE_NONE, false, OP_MOVZX8, RCX, RAX, 0); }
+				else if (op == asBC_RDR2) { m_e.rm(PRE_NONE, false, OP_MOVZX16, RCX, RAX, 0); }
+				else { m_e.rm(PRE_NONE, op == asBC_RDR8, OP_MOV_LOAD, RCX, RAX, 0); }
+				if (op == asBC_RDR8) { store64(a0, RCX); }
+				else { store32(a0, RCX); }
+				break;
+			case asBC_ClrHi:
+				m_e.rm(PRE_NONE, false, OP_GRP1, EXT_AND, REG_VM, c_vmValue); m_e.dword(0xff);
+				break;
+
+			// Increment and decrement through the value register
+			case asBC_INCi8:
+			case asBC_DECi8:
+			case asBC_INCi16:
+			case asBC_DECi16:
+			case asBC_INCi:
+			case asBC_DECi:
+			case asBC_INCi64:
+			case asBC_DECi64:
+			{
+				const bool inc = op == asBC_INCi8 || op == asBC_INCi16 || op == asBC_INCi || op == asBC_INCi64;
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_VM, c_vmValue);
+				if (op == asBC_INCi8 || op == asBC_DECi8) { m_e.rm(PRE_NONE, false, OP_GRP4, inc ? EXT_INC : EXT_DEC, RAX, 0); }
+				else { m_e.rm(op == asBC_INCi16 || op == asBC_DECi16 ? PRE_16 : PRE_NONE, op == asBC_INCi64 || op == asBC_DECi64, OP_GRP5, inc ? EXT_INC : EXT_DEC, RAX, 0); }
+			} break;
+			case asBC_INCf:
+			case asBC_DECf:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_VM, c_vmValue);
+				m_e.rm(PRE_SS, false, OP_SSE_LOAD, 0, RAX, 0);
+				m_e.movRI32(RCX, 0x3f800000u);	// 1.0f
+				m_e.rr(PRE_16, false, OP_MOVD_TO_XMM, 1, RCX);
+				m_e.rr(PRE_SS, false, op == asBC_INCf ? OP_SSE_ADD : OP_SSE_SUB, 0, 1);
+				m_e.rm(PRE_SS, false, OP_SSE_STORE, 0, RAX, 0);
+				break;
+			case asBC_INCd:
+			case asBC_DECd:
+				m_e.rm(PRE_NONE, true, OP_MOV_LOAD, RAX, REG_VM, c_vmValue);
+				m_e.rm(PRE_SD, false, OP_SSE_LOAD, 0, RAX, 0);
+				m_e.movRI64(RCX, 0x3ff0000000000000ull);	// 1.0
+				m_e.rr(PRE_16, true, OP_MOVD_TO_XMM, 1, RCX);
+				m_e.rr(PRE_SD, false, op == asBC_INCd ? OP_SSE_ADD : OP_SSE_SUB, 0, 1);
+				m_e.rm(PRE_SD, false, OP_SSE_STORE, 0, RAX, 0);
+				break;
+			case asBC_IncVi:
+				m_e.rm(PRE_NONE, false, OP_GRP5, EXT_INC, REG_FP, var(a0));
+				break;
+			case asBC_DecVi:
+				m_e.rm(PRE_NONE, false, OP_GRP5, EXT_DEC, REG_FP, var(a0));
+				break;
+
+			// Unary operators in place
+			case asBC_NOT:
+				m_e.rm(PRE_NONE, false, OP_MOVZX8, RAX, REG_FP, var(a0));
+				m_e.rr(PRE_NONE, false, OP_TEST, RAX, RAX);
+				m_e.rr(PRE_NONE, false, OP_SETCC | CC_E, 0, RAX);
+				m_e.rr(PRE_NONE, false, OP_MOVZX8, RAX, RAX);
+				store32(a0, RAX);
+				break;
+			case asBC_NEGi:
+				m_e.rm(PRE_NONE, false, OP_GRP3, EXT_NEG, REG_FP, var(a0));
+				break;
+			case asBC_NEGi64:
+				m_e.rm(PRE_NONE, true, OP_GRP3, EXT_NEG, REG_FP, var(a0));
+				break;
+			case asBC_BNOT:
+				m_e.rm(PRE_NONE, false, OP_GRP3, EXT_NOT, REG_FP, var(a0));
+				break;
+			case asBC_BNOT64:
+				m_e.rm(PRE_NONE, true, OP_GRP3, EXT_NOT, REG_FP, var(a0));
+				break;
+			case asBC_NEGf:
+				m_e.rm(PRE_NONE, false, OP_GRP1, EXT_XOR, REG_FP, var(a0)); m_e.dword(0x80000000u);
+				break;
+			case asBC_NEGd:
+				m_e.rm(PRE_NONE, true, OP_BT_IMM, EXT_BTC, REG_FP, var(a0)); m_e.byte(63);
+				break;
+			case asBC_iTOb:
+				m_e.rm(PRE_NONE, false, OP_MOVZX8, RAX, REG_FP, var(a0));
+				store32(a0, RAX);
+				break;
+			case asBC_iTOw:
+				m_e.rm(PRE_NONE, false, OP_MOVZX16, RAX, REG_FP, var(a0));
+				store32(a0, RAX);
+				break;
+			case asBC_sbTOi:
+			case asBC_swTOi:
+			case asBC_ubTOi:
+			case asBC_uwTOi:
+			{
+				const u32 opcode = op == asBC_sbTOi ? OP_MOVSX8 : op == asBC_swTOi ? OP_MOVSX16 : op == asBC_ubTOi ? OP_MOVZX8 : OP_MOVZX16;
+				m_e.rm(PRE_NONE, false, opcode, RAX, REG_FP, var(a0));
+				store32(a0, RAX);
+			} break;
+
+			// Integer arithmetic
+			case asBC_ADDi:
+			case asBC_SUBi:
+			case asBC_MULi:
+			case asBC_BAND:
+			case asBC_BOR:
+			case asBC_BXOR:
+			case asBC_ADDi64:
+			case asBC_SUBi64:
+			case asBC_MULi64:
+			case asBC_BAND64:
+			case asBC_BOR64:
+			case asBC_BXOR64:
+			{
+				const bool wide = op >= asBC_ADDi64;
+				u32 opcode = OP_ADD;
+				if (op == asBC_SUBi || op == asBC_SUBi64) { opcode = OP_SUB; }
+				else if (op == asBC_MULi || op == asBC_MULi64) { opcode = OP_IMUL; }
+				else if (op == asBC_BAND || op == asBC_BAND64) { opcode = OP_AND; }
+				else if (op == asBC_BOR || op == asBC_BOR64) { opcode = OP_OR; }
+				else if (op == asBC_BXOR || op == asBC_BXOR64) { opcode = OP_XOR; }
+
+				m_e.rm(PRE_NONE, wide, OP_MOV_LOAD, RAX, REG_FP, var(a1));
+				m_e.rm(PRE_NONE, wide, opcode, RAX, REG_FP, var(a2));
+				m_e.rm(PRE_NONE, wide, OP_MOV_STORE, RAX, REG_FP, var(a0));
+			} break;
+			case asBC_ADDIi:
+			case asBC_SUBIi:
+			case asBC_MULIi:
+				load32(RAX, a1);
+				if (op == asBC_MULIi) { m_e.rr(PRE_NONE, false, OP_IMUL_IMM, RAX, RAX); }
+				else { m_e.rr(PRE_NONE, false, OP_GRP1, op == asBC_ADDIi ? EXT_ADD : EXT_SUB, RAX); }
+				m_e.dword(asBC_DWORDARG(bc + 1));
+				store32(a0, RAX);
+				break;
+			case asBC_BSLL:
+			case asBC_BSRL:
+			case asBC_BSRA:
+			case asBC_BSLL64:
+			case asBC_BSRL64:
+			case asBC_BSRA64:
+			{
+				// The shift count is always a 32-bit value.
+				const bool wide = op >= asBC_BSLL64;
+				const u8 ext = (op == asBC_BSLL || op == asBC_BSLL64) ? EXT_SHL : (op == asBC_BSRL || op == asBC_BSRL64) ? EXT_SHR : EXT_SAR;
+				m_e.rm(PRE_NONE, wide, OP_MOV_LOAD, RAX, REG_FP, var(a1));
+				load32(RCX, a2);
+				m_e.rr(PRE_NONE, wide, OP_SHIFT_CL, ext, RAX);
+				m_e.rm(PRE_NONE, wide, OP_MOV_STORE, RAX, REG_FP, var(a0));
+			} break;
+			case asBC_DIVi:   emitIntDivide(bc, i, false, true,  false); break;
+			case asBC_MODi:   emitIntDivide(bc, i, false, true,  true);  break;
+			case asBC_DIVu:   emitIntDivide(bc, i, false, false, false); break;
+			case asBC_MODu:   emitIntDivide(bc, i, false, false, true);  break;
+			case asBC_DIVi64: emitIntDivide(bc, i, true,  true,  false); break;
+			case asBC_MODi64: emitIntDivide(bc, i, true,  true,  true);  break;
+			case asBC_DIVu64: emitIntDivide(bc, i, true,  false, false); break;
+			case asBC_MODu64: emitIntDivide(bc, i, true,  false, true);  break;
+
+			// Floating point arithmetic
+			case asBC_ADDf:
+			case asBC_SUBf:
+			case asBC_MULf:
+			case asBC_ADDd:
+			case asBC_SUBd:
+			case asBC_MULd:
+			{
+				const u8 prefix = op >= asBC_ADDd ? PRE_SD : PRE_SS;
+				const u32 opcode = (op == asBC_ADDf || op == asBC_ADDd) ? OP_SSE_ADD : (op == asBC_SUBf || op == asBC_SUBd) ? OP_SSE_SUB : OP_SSE_MUL;
+				m_e.rm(prefix, false, OP_SSE_LOAD, 0, REG_FP, var(a1));
+				m_e.rm(prefix, false, opcode, 0, REG_FP, var(a2));
+				m_e.rm(prefix, false, OP_SSE_STORE, 0, REG_FP, var(a0));
+			} break;
+			case asBC_DIVf: emitFloatDivide(bc, i, PRE_SS); break;
+			case asBC_DIVd: emitFloatDivide(bc, i, PRE_SD); break;
+			case asBC_ADDIf:
+			case asBC_SUBIf:
+			case asBC_MULIf:
+			{
+				const u32 opcode = op == asBC_ADDIf ? OP_SSE_ADD : op == asBC_SUBIf ? OP_SSE_SUB : OP_SSE_MUL;
+				m_e.rm(PRE_SS, false, OP_SSE_LOAD, 0, REG_FP, var(a1));
+				m_e.movRI32(RAX, asBC_DWORDARG(bc + 1));
+				m_e.rr(PRE_16, false, OP_MOVD_TO_XMM, 1, RAX);
+				m_e.rr(PRE_SS, false, opcode, 0, 1);
+				m_e.rm(PRE_SS, false, OP_SSE_STORE, 0, REG_FP, var(a0));
+			} break;
+
+			// Conversions
+			case asBC_iTOf:
+				m_e.rm(PRE_SS, false, OP_CVTSI2S, 0, REG_FP, var(a0));
+				m_e.rm(PRE_SS, false, OP_SSE_STORE, 0, REG_FP, var(a0));
+				break;
+			case asBC_uTOf:
+				load32(RAX, a0);
+				m_e.rr(PRE_SS, true, OP_CVTSI2S, 0, RAX);
+				m_e.rm(PRE_SS, false, OP_SSE_STORE, 0, REG_FP, var(a0));
+				break;
+			case asBC_fTOi:
+			case asBC_fTOu:
+				m_e.rm(PRE_SS, false, OP_CVTTS2SI, RAX, REG_FP, var(a0));
+				store32(a0, RAX);
+				break;
+			case asBC_dTOi:
+			case asBC_dTOu:
+				m_e.rm(PRE_SD, false, OP_CVTTS2SI, RAX, REG_FP, var(a1));
+				store32(a0, RAX);
+				break;
+			case asBC_dTOf:
+				m_e.rm(PRE_SD, false, OP_CVTS2S, 0, REG_FP, var(a1));
+				m_e.rm(PRE_SS, false, OP_SSE_STORE, 0, REG_FP, var(a0));
+				break;
+			case asBC_fTOd:
+				m_e.rm(PRE_SS, false, OP_CVTS2S, 0, REG_FP, var(a1));
+				m_e.rm(PRE_SD, false, OP_SSE_STORE, 0, REG_FP, var(a0));
+				break;
+			case asBC_iTOd:
+				m_e.rm(PRE_SD, false, OP_CVTSI2S, 0, REG_FP, var(a1));
+				m_e.rm(PRE_SD, false, OP_SSE_STORE, 0, REG_FP, var(a0));
+				break;
+			case asBC_uTOd:
+				load32(RAX, a1);
+				m_e.rr(PRE_SD, true, OP_CVTSI2S, 0, RAX);
+				m_e.rm(PRE_SD, false, OP_SSE_STORE, 0, REG_FP, var(a0));
+				break;
+			case asBC_i64TOi:
+				load32(RAX, a1);
+				store32(a0, RAX);
+				break;
+			case asBC_uTOi64:
+				load32(RAX, a1);
+				store64(a0, RAX);
+				break;
+			case asBC_iTOi64:
+				m_e.rm(PRE_NONE, true, OP_MOVSXD, RAX, REG_FP, var(a1));
+				store64(a0, RAX);
+				break;
+			case asBC_fTOi64:
+			case asBC_fTOu64:
+				m_e.rm(PRE_SS, true, OP_CVTTS2SI, RAX, REG_FP, var(a1));
+				store64(a0, RAX);
+				break;
+			case asBC_dTOi64:
+			case asBC_dTOu64:
+				// Converted in place.
+				m_e.rm(PRE_SD, true, OP_CVTTS2SI, RAX, REG_FP, var(a0));
+				store64(a0, RAX);
+				break;
+			case asBC_i64TOf:
+				m_e.rm(PRE_SS, true, OP_CVTSI2S, 0, REG_FP, var(a1));
+				m_e.rm(PRE_SS, false, OP_SSE_STORE, 0, REG_FP, var(a0));
+				break;
+			case asBC_i64TOd:
+				// Converted in place.
+				m_e.rm(PRE_SD, true, OP_CVTSI2S, 0, REG_FP, var(a0));
+				m_e.rm(PRE_SD, false, OP_SSE_STORE, 0, REG_FP, var(a0));
+				break;
+
+			// Comparisons, the result is written to the value register as -1, 0 or 1
+			case asBC_CMPi:
+			case asBC_CMPu:
+				load32(RAX, a0);
+				m_e.rm(PRE_NONE, false, OP_CMP, RAX, REG_FP, var(a1));
+				emitCompareResult(op == asBC_CMPi ? CC_G : CC_A, op == asBC_CMPi ? CC_L : CC_B);
+				break;
+			case asBC_CMPIi:
+			case asBC_CMPIu:
+				m_e.rm(PRE_NONE, false, OP_GRP1, EXT_CMP, REG_FP, var(a0)); m_e.dword(asBC_DWORDARG(bc));
+				emitCompareResult(op == asBC_CMPIi ? CC_G : CC_A, op == asBC_CMPIi ? CC_L : CC_B);
+				break;
+			case asBC_CMPi64:
+			case asBC_CMPu64:
+			case asBC_CmpPtr:
+				load64(RAX, a0);
+				m_e.rm(PRE_NONE, true, OP_CMP, RAX, REG_FP, var(a1));
+				emitCompareResult(op == asBC_CMPi64 ? CC_G : CC_A, op == asBC_CMPi64 ? CC_L : CC_B);
+				break;
+			case asBC_CMPf:
+				m_e.rm(PRE_SS, false, OP_SSE_LOAD, 0, REG_FP, var(a0));
+				m_e.rm(PRE_NONE, false, OP_UCOMIS, 0, REG_FP, var(a1));
+				emitFloatCompare();
+				break;
+			case asBC_CMPIf:
+				m_e.rm(PRE_SS, false, OP_SSE_LOAD, 0, REG_FP, var(a0));
+				m_e.movRI32(RAX, asBC_DWORDARG(bc));
+				m_e.rr(PRE_16, false, OP_MOVD_TO_XMM, 1, RAX);
+				m_e.rr(PRE_NONE, false, OP_UCOMIS, 0, 1);
+				emitFloatCompare();
+				break;
+			case asBC_CMPd:
+				m_e.rm(PRE_SD, false, OP_SSE_LOAD, 0, REG_FP, var(a0));
+				m_e.rm(PRE_16, false, OP_UCOMIS, 0, REG_FP, var(a1));
+				emitFloatCompare();
+				break;
+
+			// Tests, the result is written to the value register as a bool
+			case asBC_TZ:  emitTestValue(CC_E);  break;
+			case asBC_TNZ: emitTestValue(CC_NE); break;
+			case asBC_TS:  emitTestValue(CC_L);  break;
+			case asBC_TNS: emitTestValue(CC_GE); break;
+			case asBC_TP:  emitTestValue(CC_G);  break;
+			case asBC_TNP: emitTestValue(CC_LE); break;
+
+			// Branches
+			case asBC_JMP:
+				jumpTo(i + 2 + asBC_INTARG(bc));
+				break;
+			case asBC_JZ:  emitCondJump(bc, i, CC_E);  break;
+			case asBC_JNZ: emitCondJump(bc, i, CC_NE); break;
+			case asBC_JS:  emitCondJump(bc, i, CC_L);  break;
+			case asBC_JNS: emitCondJump(bc, i, CC_GE); break;
+			case asBC_JP:  emitCondJump(bc, i, CC_G);  break;
+			case asBC_JNP: emitCondJump(bc, i, CC_LE); break;
+			case asBC_JLowZ:
+			case asBC_JLowNZ:
+				m_e.rm(PRE_NONE, false, 0x80, EXT_CMP, REG_VM, c_vmValue); m_e.byte(0);
+				jumpIf(op == asBC_JLowZ ? CC_E : CC_NE, i + 2 + asBC_INTARG(bc));
+				break;
+
+			default:
+				// Filtered by isSupported().
+				assert(0);
+				exitTo(i);
+				break;
+		}
+	}
+
+	int callSystemFunction(int id, asSVMRegisters* regs)
+	{
+		return CallSystemFunction(id, static_cast<asCContext*>(regs->ctx));
+	}
+
+	void* allocateCode(const std::vector<u8>& code)
+	{
+		const size_t size = c_codeHeaderSize + code.size();
+#ifdef _WIN32
+		u8* mem = (u8*)VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+		if (!mem) { return nullptr; }
+#else
+		u8* mem = (u8*)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mem == (u8*)MAP_FAILED) { return nullptr; }
+#endif
+		*(size_t*)mem = size;
+		memcpy(mem + c_codeHeaderSize, code.data(), code.size());
+
+		// Code pages are never writable and executable at the same time.
+#ifdef _WIN32
+		DWORD oldProtect;
+		if (!VirtualProtect(mem, size, PAGE_EXECUTE_READ, &oldProtect))
+		{
+			VirtualFree(mem, 0, MEM_RELEASE);
+			return nullptr;
+		}
+		FlushInstructionCache(GetCurrentProcess(), mem, size);
+#else
+		if (mprotect(mem, size, PROT_READ | PROT_EXEC) != 0)
+		{
+			munmap(mem, size);
+			return nullptr;
+		}
+#endif
+		return mem + c_codeHeaderSize;
+	}
+
+	void freeCode(void* func)
+	{
+		if (!func) { return; }
+		u8* mem = (u8*)func - c_codeHeaderSize;
+#ifdef _WIN32
+		VirtualFree(mem, 0, MEM_RELEASE);
+#else
+		munmap(mem, *(size_t*)mem);
+#endif
+	}
+#endif
+}
@@ -0,0 +1,34 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Script JIT
+// Compiles AngelScript bytecode to native x86-64 code.
+//
+// Only the common instructions are compiled (arithmetic, comparisons,
+// branches, local/global variable and property access and calls to
+// registered native functions). When the native code reaches any other
+// instruction it returns to the interpreter, which executes it and
+// re-enters the native code at the next JitEntry instruction.
+//
+// The engine must be created with asEP_INCLUDE_JIT_INSTRUCTIONS set
+// and the compiler assigned before any module is built or loaded.
+//////////////////////////////////////////////////////////////////////
+
+#include <TFE_System/types.h>
+
+class asIJITCompiler;
+
+struct ScriptJitStats
+{
+	u32 functionCount;		// functions compiled to native code.
+	u32 nativeInstrCount;	// bytecode instructions compiled.
+	u32 fallbackInstrCount;	// bytecode instructions left to the interpreter.
+};
+
+namespace TFE_ScriptJit
+{
+	// Returns null if the JIT is not supported on the current platform.
+	asIJITCompiler* createCompiler();
+	void destroyCompiler(asIJITCompiler* compiler);
+
+	void getStats(ScriptJitStats* stats);
+}
@@ -0,0 +1,272 @@
+#include "scriptProfiler.h"
+#include <angelscript.h>
+#include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <TFE_FrontEndUI/console.h>
+#include <assert.h>
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace TFE_ScriptProfiler
+{
+	// Key of the profiler record index (+1) stored in the asIScriptFunction user data.
+	static const asPWORD c_userDataType = 0x54465053;	// "TFPS"
+	static const u32 c_maxCallDepth = 32;
+	// Same averaging as TFE_Profiler.
+	static const f64 c_expBlend = 0.99;
+	// Functions whose average drops below this and were not called last frame are not listed.
+	static const f64 c_minListedTime = 1.0e-7;
+
+	struct FunctionRecord
+	{
+		std::string module;
+		std::string decl;
+		u32 zoneId;
+
+		u32 calls;			// this frame.
+		u32 prevCalls;		// last frame.
+		u64 ticks;			// this frame, including called script functions.
+		u64 selfTicks;		// this frame, line timing only.
+		f64 timeAve;
+		f64 selfTimeAve;
+	};
+
+	struct CallFrame
+	{
+		u32 record;
+		u32 zoneId;
+		u64 start;
+		asIScriptFunction* lineFunc;	// function being line timed when the call was made.
+	};
+
+	typedef std::map<std::string, u32> RecordMap;
+
+	static std::vector<FunctionRecord> s_records;
+	static std::vector<u32> s_sorted;
+	static RecordMap s_recordMap;
+	static std::vector<asIScriptContext*> s_contexts;
+
+	static CallFrame s_callStack[c_maxCallDepth];
+	static u32 s_callDepth = 0;
+	static asIScriptFunction* s_lineFunc = nullptr;
+	static u64 s_lineTicks = 0;
+	static bool s_lineTimingActive = false;
+
+	// Settings
+	static bool s_enabled = false;
+	static bool s_lineTiming = false;
+
+	u32  getRecord(asIScriptFunction* func);
+	void flushLineTime(u64 now);
+	void lineCallback(asIScriptContext* context, void* userData);
+	void applyLineTiming();
+
+	void init(asIScriptContext** contexts, u32 contextCount)
+	{
+		s_contexts.assign(contexts, contexts + contextCount);
+
+		CVAR_BOOL(s_enabled, "g_scriptProfiler", 0, "Time script calls by function and module, shown in the profiler view.");
+		CVAR_BOOL(s_lineTiming, "g_scriptProfilerLines", 0, "Also time each script function by itself, including functions called from other scripts. Scripts run much slower while enabled.");
+	}
+
+	void shutdown()
+	{
+		s_enabled = false;
+		applyLineTiming();
+
+		s_contexts.clear();
+		s_records.clear();
+		s_sorted.clear();
+		s_recordMap.clear();
+		s_callDepth = 0;
+	}
+
+	void update()
+	{
+		applyLineTiming();
+
+		s_sorted.clear();
+		if (!s_enabled) { return; }
+
+		const size_t recordCount = s_records.size();
+		for (size_t i = 0; i < recordCount; i++)
+		{
+			FunctionRecord* rec = &s_records[i];
+			const f64 time = TFE_System::convertFromTicksToSeconds(rec->ticks);
+			const f64 selfTime = TFE_System::convertFromTicksToSeconds(rec->selfTicks);
+			rec->timeAve = c_expBlend * rec->timeAve + (1.0 - c_expBlend) * time;
+			rec->selfTimeAve = c_expBlend * rec->selfTimeAve + (1.0 - c_expBlend) * selfTime;
+			rec->prevCalls = rec->calls;
+			rec->calls = 0;
+			rec->ticks = 0;
+			rec->selfTicks = 0;
+
+			if (rec->prevCalls || rec->timeAve >= c_minListedTime || rec->selfTimeAve >= c_minListedTime)
+			{
+				s_sorted.push_back(u32(i));
+			}
+		}
+
+		std::sort(s_sorted.begin(), s_sorted.end(), [](u32 a, u32 b)
+		{
+			const f64 timeA = std::max(s_records[a].timeAve, s_records[a].selfTimeAve);
+			const f64 timeB = std::max(s_records[b].timeAve, s_records[b].selfTimeAve);
+			return timeA > timeB;
+		});
+	}
+
+	void enable(bool enable)
+	{
+		s_enabled = enable;
+	}
+
+	bool isEnabled()
+	{
+		return s_enabled;
+	}
+
+	void enableLineTiming(bool enable)
+	{
+		s_lineTiming = enable;
+	}
+
+	bool isLineTimingEnabled()
+	{
+		return s_lineTiming;
+	}
+
+	bool beginCall(void* func)
+	{
+		if (!s_enabled || s_callDepth >= c_maxCallDepth) { return false; }
+
+		asIScriptFunction* scriptFunc = (asIScriptFunction*)func;
+		CallFrame* frame = &s_callStack[s_callDepth];
+		s_callDepth++;
+
+		frame->record = getRecord(scriptFunc);
+		frame->lineFunc = s_lineFunc;
+#ifdef TFE_PROFILE_ENABLED
+		frame->zoneId = s_records[frame->record].zoneId;
+		TFE_Profiler::beginZone(frame->zoneId);
+#endif
+		frame->start = TFE_System::getCurrentTimeInTicks();
+		if (s_lineTimingActive)
+		{
+			flushLineTime(frame->start);
+			s_lineFunc = scriptFunc;
+		}
+		return true;
+	}
+
+	void endCall(u32 callCount)
+	{
+		assert(s_callDepth > 0);
+		const u64 now = TFE_System::getCurrentTimeInTicks();
+		s_callDepth--;
+		const CallFrame* frame = &s_callStack[s_callDepth];
+
+		FunctionRecord* rec = &s_records[frame->record];
+		rec->calls += callCount;
+		rec->ticks += now - frame->start;
+#ifdef TFE_PROFILE_ENABLED
+		TFE_Profiler::endZone(frame->zoneId, now - frame->start);
+#endif
+		if (s_lineTimingActive)
+		{
+			flushLineTime(now);
+		}
+		s_lineFunc = frame->lineFunc;
+	}
+
+	u32 getFunctionCount()
+	{
+		return (u32)s_sorted.size();
+	}
+
+	void getFunctionInfo(u32 index, ScriptProfileInfo* info)
+	{
+		if (index >= (u32)s_sorted.size()) { return; }
+
+		const FunctionRecord* rec = &s_records[s_sorted[index]];
+		info->module = rec->module.c_str();
+		info->func = rec->decl.c_str();
+		info->calls = rec->prevCalls;
+		info->timeAve = rec->timeAve;
+		info->selfTimeAve = rec->selfTimeAve;
+	}
+
+	//////////////////////////////////////////////
+	// Internal
+	//////////////////////////////////////////////
+	u32 getRecord(asIScriptFunction* func)
+	{
+		const asPWORD cached = (asPWORD)func->GetUserData(c_userDataType);
+		if (cached) { return u32(cached - 1); }
+
+		// Modules are reloaded with each level, so look for a record from a previous copy of the function.
+		const char* module = func->GetModuleName() ? func->GetModuleName() : "";
+		const char* decl = func->GetDeclaration(true, true, false);
+		const std::string key = std::string(module) + ":" + decl;
+
+		u32 index;
+		RecordMap::iterator iRecord = s_recordMap.find(key);
+		if (iRecord != s_recordMap.end())
+		{
+			index = iRecord->second;
+		}
+		else
+		{
+			index = (u32)s_records.size();
+			s_records.push_back({});
+
+			FunctionRecord* rec = &s_records.back();
+			rec->module = module;
+			rec->decl = decl;
+#ifdef TFE_PROFILE_ENABLED
+			// Functions of the same module share a zone.
+			char zoneName[64];
+			snprintf(zoneName, sizeof(zoneName), "Script %s", module);
+			rec->zoneId = TFE_Profiler::registerZone(zoneName, "executeScriptFunction", 0);
+#endif
+			s_recordMap[key] = index;
+		}
+		func->SetUserData((void*)asPWORD(index + 1), c_userDataType);
+		return index;
+	}
+
+	// Add the time since the last line to the function being line timed.
+	void flushLineTime(u64 now)
+	{
+		if (s_lineFunc)
+		{
+			s_records[getRecord(s_lineFunc)].selfTicks += now - s_lineTicks;
+		}
+		s_lineTicks = now;
+	}
+
+	// Called before each script statement, the time since the previous statement goes to the function it was in.
+	void lineCallback(asIScriptContext* context, void* userData)
+	{
+		flushLineTime(TFE_System::getCurrentTimeInTicks());
+		s_lineFunc = context->GetFunction(0);
+	}
+
+	// The line callback is only changed between frames, never while a script is running.
+	void applyLineTiming()
+	{
+		const bool active = s_enabled && s_lineTiming;
+		if (active == s_lineTimingActive || s_callDepth) { return; }
+
+		const size_t contextCount = s_contexts.size();
+		for (size_t i = 0; i < contextCount; i++)
+		{
+			if (active) { s_contexts[i]->SetLineCallback(asFUNCTION(lineCallback), nullptr, asCALL_CDECL); }
+			else { s_contexts[i]->ClearLineCallback(); }
+		}
+		s_lineTimingActive = active;
+		s_lineFunc = nullptr;
+	}
+}
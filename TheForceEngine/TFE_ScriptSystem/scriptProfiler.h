@@ -0,0 +1,49 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Script Profiler
+// Attributes script time and call counts to individual script
+// functions and modules.
+//
+// Every call from the engine into a script is timed and shows up as
+// a "Script <module>" zone in TFE_Profiler, nested under the zone
+// that made the call. Line timing additionally uses the AngelScript
+// line callback to measure the time spent in each script function
+// itself, including functions only called from other scripts. Line
+// timing forces the scripts to run in the interpreter so it is much
+// slower, use it to find hot spots rather than to measure totals.
+//////////////////////////////////////////////////////////////////////
+
+#include <TFE_System/types.h>
+
+class asIScriptContext;
+
+struct ScriptProfileInfo
+{
+	const char* module;
+	const char* func;		// function declaration.
+	u32 calls;				// calls from the engine in the last frame.
+	f64 timeAve;			// average time per frame, including called script functions.
+	f64 selfTimeAve;		// average time per frame in the function itself, only set with line timing.
+};
+
+namespace TFE_ScriptProfiler
+{
+	void init(asIScriptContext** contexts, u32 contextCount);
+	void shutdown();
+	// Called once per frame.
+	void update();
+
+	void enable(bool enable);
+	bool isEnabled();
+	void enableLineTiming(bool enable);
+	bool isLineTimingEnabled();
+
+	// Wraps every call from the engine into a script, 'func' is the asIScriptFunction called.
+	// Returns false if profiling is disabled, in which case endCall() must not be called.
+	bool beginCall(void* func);
+	void endCall(u32 callCount);
+
+	// Functions called in recent frames, sorted by time.
+	u32  getFunctionCount();
+	void getFunctionInfo(u32 index, ScriptProfileInfo* info);
+}
@@ -1,13 +1,19 @@
 #include "scriptSystem.h"
+#include "scriptJit.h"
+#include "scriptProfiler.h"
 #include <scriptstdstring/scriptstdstring.h>
 #include <scriptbuilder/scriptbuilder.h>
 #include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <TFE_FrontEndUI/console.h>
 #include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/fileutil.h>
 #include <TFE_FileSystem/paths.h>
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <string.h>
 #include <algorithm>
 
 namespace TFE_ScriptSystem
@@ -22,11 +28,75 @@ namespace TFE_ScriptSystem
 		"Test",		// SCRIPT_TYPE_TEST,
 	};
 
+	// Compiled modules are cached in "ProgramData/ScriptCache/<type>/<module>.dxc".
+	static const char* c_cacheDir = "ScriptCache";
+	static const u32 c_cacheMagic = 0x43584454;	// "TDXC"
+	// Bump whenever the engine interface registered with the script system changes in a way
+	// that AngelScript cannot detect when loading the bytecode (such as property offsets).
+	static const u32 c_cacheVersion = 1;
+	// Built twice by the "scriptJitCheck" console command, see Scripts/Test/jit_check.dxs.
+	static const char* c_jitCheckModule = "jit_check";
+
+	struct ScriptCacheHeader
+	{
+		u32 magic;
+		u32 version;
+		u64 sourceHash;
+	};
+
+	// Memory stream used to save and load module bytecode.
+	class ScriptByteStream : public asIBinaryStream
+	{
+	public:
+		ScriptByteStream() : m_readPos(0) {}
+
+		int Read(void* ptr, asUINT size) override
+		{
+			if (m_readPos + size > m_data.size()) { return asERROR; }
+			memcpy(ptr, m_data.data() + m_readPos, size);
+			m_readPos += size;
+			return size;
+		}
+
+		int Write(const void* ptr, asUINT size) override
+		{
+			if (!size) { return 0; }
+			const size_t pos = m_data.size();
+			m_data.resize(pos + size);
+			memcpy(m_data.data() + pos, ptr, size);
+			return size;
+		}
+
+		std::vector<u8> m_data;
+		size_t m_readPos;
+	};
+
 	asIScriptEngine* s_engine;
+	asIJITCompiler* s_jit = nullptr;
+	// Off by default, the JIT is new and the interpreter remains the reference. Only affects modules loaded afterwards.
+	static bool s_jitEnabled = false;
 	asIScriptContext* s_context[SCRIPT_TYPE_COUNT];
 	std::vector<ScriptTypeProp> s_prop;
 
+	// Garbage collection
+	static f32 s_gcBudgetMs = 0.25f;
+	static s32 s_gcLiveCount = 0;
+	static s32 s_gcCollectedCount = 0;
+	static s32 s_gcTimeUs = 0;
+
 	void messageCallback(const asSMessageInfo *msg, void *param);
+	void checkExecuteResult(ScriptType type, s32 res);
+	void collectGarbageStep();
+	asUINT getDestroyedCount();
+	void scriptGcConsole(const ConsoleArgList& args);
+	void scriptJitCheckConsole(const ConsoleArgList& args);
+	void setJitEnabled(bool enable);
+	bool compareJitResults(asIScriptModule* interpModule, asIScriptModule* jitModule, u32* compareCount);
+	bool readPrimitive(asIScriptEngine* engine, s32 typeId, const void* ptr, u64* value);
+	bool compileScriptModule(const char* moduleName, const char* path);
+	bool loadCachedModule(const char* moduleName, const char* cachePath, u64 sourceHash);
+	void saveCachedModule(const char* moduleName, const char* cachePath, u64 sourceHash);
+	bool hashScriptSource(const char* path, u64* hash, std::vector<std::string>& visited);
 
 	// Print the script string to the standard output stream
 	void TFE_Print(std::string& msg)
@@ -67,6 +137,24 @@ namespace TFE_ScriptSystem
 		s32 res = s_engine->SetMessageCallback(asFUNCTION(messageCallback), 0, asCALL_CDECL);
 		assert(res >= 0);
 
+		// The garbage collector is run from update() with a per-frame time budget instead of
+		// after script calls, where a large cycle would stall whichever logic happened to trigger it.
+		s_engine->SetEngineProperty(asEP_AUTO_GARBAGE_COLLECT, false);
+		CVAR_FLOAT(s_gcBudgetMs, "g_scriptGcBudget", 0, "Time in milliseconds the script garbage collector may use each frame.");
+		CCMD("scriptGc", scriptGcConsole, 0, "Run a full script garbage collection cycle.");
+		TFE_COUNTER(s_gcLiveCount, "Script GC Objects");
+		TFE_COUNTER(s_gcCollectedCount, "Script GC Collected");
+		TFE_COUNTER(s_gcTimeUs, "Script GC Time (us)");
+
+		// The JIT is assigned when each module is built or loaded, depending on g_scriptJit at that time.
+		s_jit = TFE_ScriptJit::createCompiler();
+		CVAR_BOOL(s_jitEnabled, "g_scriptJit", 0, "Compile scripts to native code, applies to scripts loaded afterwards (x86-64 only).");
+		CCMD("scriptJitCheck", scriptJitCheckConsole, 0, "Run Scripts/Test/jit_check.dxs interpreted and JIT compiled and compare the results.");
+		if (s_jitEnabled && !s_jit)
+		{
+			TFE_System::logWrite(LOG_WARNING, "Scripting", "The script JIT is not supported on this platform, scripts will be interpreted.");
+		}
+
 		// AngelScript doesn't have a built-in string type, as there is no definite standard 
 		// string type for C++ applications. Every developer is free to register its own string type.
 		// The SDK do however provide a standard add-on for registering a string type, so it's not
@@ -84,19 +172,32 @@ namespace TFE_ScriptSystem
 		{
 			s_context[i] = s_engine->CreateContext();
 		}
+		TFE_ScriptProfiler::init(s_context, SCRIPT_TYPE_COUNT);
 
 		return true;
 	}
 
 	void shutdown()
 	{
+		TFE_ScriptProfiler::shutdown();
 		for (u32 i = 0; i < SCRIPT_TYPE_COUNT; i++)
 		{
 			s_context[i]->Release();
 		}
 
+		ScriptJitStats stats;
+		TFE_ScriptJit::getStats(&stats);
+		if (s_jit && stats.functionCount)
+		{
+			const u32 instrCount = stats.nativeInstrCount + stats.fallbackInstrCount;
+			TFE_System::logWrite(LOG_MSG, "Scripting", "JIT compiled %u functions, %u of %u instructions native.", stats.functionCount, stats.nativeInstrCount, instrCount);
+		}
+
 		s_engine->ShutDownAndRelease();
 		s_engine = nullptr;
+		// The engine releases the JIT functions on shutdown.
+		TFE_ScriptJit::destroyCompiler(s_jit);
+		s_jit = nullptr;
 	}
 
 	void registerFunction(const char* declaration, const ScriptFuncPtr& funcPtr)
@@ -152,29 +253,40 @@ namespace TFE_ScriptSystem
 		char path[TFE_MAX_PATH];
 		sprintf(path, "%sScripts/%s/%s.dxs", programDir, c_scriptDir[type], moduleName);
 
-		CScriptBuilder builder;
-		s32 res = builder.StartNewModule(s_engine, moduleName);
-		if (res < 0)
+		const bool useJit = s_jitEnabled && s_jit;
+		setJitEnabled(useJit);
+
+		// The cache key covers the module source, its includes and the engine version so any change
+		// to the scripts or a new build recompiles the module.
+		u64 sourceHash = 14695981039346656037ull;
+		std::vector<std::string> visited;
+		const bool canCache = hashScriptSource(path, &sourceHash, visited) && TFE_Paths::hasPath(PATH_PROGRAM_DATA);
+
+		char cachePath[TFE_MAX_PATH];
+		if (canCache)
 		{
-			TFE_System::logWrite(LOG_ERROR, "Scripting", "Unrecoverable error while starting a new module.");
-			return false;
+			char cacheDir[TFE_MAX_PATH];
+			char typeDir[TFE_MAX_PATH];
+			TFE_Paths::appendPath(PATH_PROGRAM_DATA, c_cacheDir, cacheDir);
+			sprintf(typeDir, "%s/%s", cacheDir, c_scriptDir[type]);
+			FileUtil::makeDirectory(cacheDir);
+			FileUtil::makeDirectory(typeDir);
+			// Bytecode built for the JIT contains JitEntry instructions, so it is cached separately.
+			sprintf(cachePath, "%s/%s%s.dxc", typeDir, moduleName, useJit ? ".jit" : "");
+
+			if (loadCachedModule(moduleName, cachePath, sourceHash))
+			{
+				return true;
+			}
 		}
-		res = builder.AddSectionFromFile(path);
-		if (res < 0)
+
+		if (!compileScriptModule(moduleName, path))
 		{
-			// The builder wasn't able to load the file. Maybe the file
-			// has been removed, or the wrong name was given, or some
-			// preprocessing commands are incorrectly written.
-			TFE_System::logWrite(LOG_ERROR, "Scripting", "Cannot open or parse file.");
 			return false;
 		}
-		res = builder.BuildModule();
-		if (res < 0)
+		if (canCache)
 		{
-			// An error occurred. Instruct the script writer to fix the 
-			// compilation errors that were listed in the output stream.
-			TFE_System::logWrite(LOG_ERROR, "Scripting", "Compile error(s).");
-			return false;
+			saveCachedModule(moduleName, cachePath, sourceHash);
 		}
 		return true;
 	}
@@ -190,30 +302,258 @@ namespace TFE_ScriptSystem
 	{
 		if (!funcPtr) { return; }
 
+		const bool profile = TFE_ScriptProfiler::beginCall(funcPtr);
 		asIScriptFunction* func = (asIScriptFunction*)funcPtr;
 		s_context[type]->Prepare(func);
-		const s32 res = s_context[type]->Execute();
-		if (res != asEXECUTION_FINISHED)
-		{
-			// The execution didn't complete as expected. Determine what happened.
-			if (res == asEXECUTION_EXCEPTION)
-			{
-				// An exception occurred, let the script writer know what happened so it can be corrected.
-				TFE_System::logWrite(LOG_ERROR, "Scripting", "An exception '%s' occurred. Please correct the code and try again.\n", s_context[type]->GetExceptionString());
-			}
-		}
+		checkExecuteResult(type, s_context[type]->Execute());
+		if (profile) { TFE_ScriptProfiler::endCall(1); }
 	}
 
 	void executeScriptFunction(ScriptType type, void* funcPtr, s32 arg0, s32 arg1, s32 arg2)
 	{
 		if (!funcPtr) { return; }
 
+		const bool profile = TFE_ScriptProfiler::beginCall(funcPtr);
 		asIScriptFunction* func = (asIScriptFunction*)funcPtr;
 		s_context[type]->Prepare(func);
 		s_context[type]->SetArgDWord(0, arg0);
 		s_context[type]->SetArgDWord(1, arg1);
 		s_context[type]->SetArgDWord(2, arg2);
-		const s32 res = s_context[type]->Execute();
+		checkExecuteResult(type, s_context[type]->Execute());
+		if (profile) { TFE_ScriptProfiler::endCall(1); }
+	}
+
+	void executeScriptFunctionBatch(ScriptType type, void* funcPtr, u32 count, ScriptBatchSetup setup, void* userData)
+	{
+		if (!funcPtr) { return; }
+
+		// Preparing the context for the function it last executed skips most of the setup, so run every call in a row.
+		// The batch is profiled as a whole to keep the timer overhead out of the loop.
+		const bool profile = TFE_ScriptProfiler::beginCall(funcPtr);
+		asIScriptFunction* func = (asIScriptFunction*)funcPtr;
+		asIScriptContext* context = s_context[type];
+		for (u32 i = 0; i < count; i++)
+		{
+			setup(i, userData);
+			context->Prepare(func);
+			checkExecuteResult(type, context->Execute());
+		}
+		if (profile) { TFE_ScriptProfiler::endCall(count); }
+	}
+
+	bool isScriptFunctionEmpty(void* funcPtr)
+	{
+		if (!funcPtr) { return true; }
+
+		asIScriptFunction* func = (asIScriptFunction*)funcPtr;
+		asUINT length = 0;
+		const asDWORD* byteCode = func->GetByteCode(&length);
+		if (!byteCode) { return false; }
+
+		// An empty function only contains line cues (SUSPEND) and the return.
+		for (asUINT i = 0; i < length; )
+		{
+			const asEBCInstr op = asEBCInstr(*(const asBYTE*)&byteCode[i]);
+			if (op != asBC_SUSPEND && op != asBC_RET && op != asBC_JitEntry)
+			{
+				return false;
+			}
+			i += asBCTypeSize[asBCInfo[op].type];
+		}
+		return true;
+	}
+
+	void update()
+	{
+		if (!s_engine) { return; }
+
+		collectGarbageStep();
+		TFE_ScriptProfiler::update();
+	}
+
+	u32 collectAllGarbage()
+	{
+		if (!s_engine) { return 0; }
+
+		const asUINT destroyed = getDestroyedCount();
+		s_engine->GarbageCollect(asGC_FULL_CYCLE);
+		return u32(getDestroyedCount() - destroyed);
+	}
+
+	//////////////////////////////////////////////
+	// Internal
+	//////////////////////////////////////////////
+	// Run incremental collection steps until the cycle is done or the frame budget is used up.
+	void collectGarbageStep()
+	{
+		TFE_ZONE("Script GC");
+		const u64 start = TFE_System::getCurrentTimeInTicks();
+		const asUINT destroyed = getDestroyedCount();
+		const f64 budget = f64(s_gcBudgetMs) * 0.001;
+
+		f64 elapsed = 0.0;
+		do
+		{
+			if (s_engine->GarbageCollect(asGC_ONE_STEP) == 0) { break; }
+			elapsed = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start);
+		} while (elapsed < budget);
+		elapsed = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start);
+
+		asUINT liveCount = 0;
+		s_engine->GetGCStatistics(&liveCount);
+		s_gcLiveCount = s32(liveCount);
+		s_gcCollectedCount = s32(getDestroyedCount() - destroyed);
+		s_gcTimeUs = s32(elapsed * 1000000.0);
+	}
+
+	asUINT getDestroyedCount()
+	{
+		asUINT destroyed = 0, newDestroyed = 0;
+		s_engine->GetGCStatistics(nullptr, &destroyed, nullptr, nullptr, &newDestroyed);
+		return destroyed + newDestroyed;
+	}
+
+	void scriptGcConsole(const ConsoleArgList& args)
+	{
+		const u64 start = TFE_System::getCurrentTimeInTicks();
+		const u32 destroyed = collectAllGarbage();
+		const f64 elapsed = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start);
+
+		char res[256];
+		sprintf(res, "Script GC destroyed %u objects in %0.3fms.", destroyed, elapsed * 1000.0);
+		TFE_Console::addToHistory(res);
+	}
+
+	// Build the JIT check module interpreted and JIT compiled and compare the results of every function without parameters.
+	// Only this module is compared since the game scripts act on live objects through native functions.
+	void scriptJitCheckConsole(const ConsoleArgList& args)
+	{
+		if (!s_jit)
+		{
+			TFE_Console::addToHistory("The script JIT is not supported on this platform.");
+			return;
+		}
+
+		char path[TFE_MAX_PATH];
+		char interpName[64], jitName[64];
+		sprintf(path, "%sScripts/%s/%s.dxs", TFE_Paths::getPath(PATH_PROGRAM), c_scriptDir[SCRIPT_TYPE_TEST], c_jitCheckModule);
+		sprintf(interpName, "%s_interp", c_jitCheckModule);
+		sprintf(jitName, "%s_jit", c_jitCheckModule);
+
+		ScriptJitStats statsBefore, statsAfter;
+		TFE_ScriptJit::getStats(&statsBefore);
+		setJitEnabled(false);
+		bool built = compileScriptModule(interpName, path);
+		setJitEnabled(true);
+		built = built && compileScriptModule(jitName, path);
+		setJitEnabled(s_jitEnabled);
+		TFE_ScriptJit::getStats(&statsAfter);
+
+		asIScriptModule* interpModule = s_engine->GetModule(interpName);
+		asIScriptModule* jitModule = s_engine->GetModule(jitName);
+		char res[256];
+		if (built)
+		{
+			u32 compareCount = 0;
+			const bool match = compareJitResults(interpModule, jitModule, &compareCount);
+			sprintf(res, "Script JIT check %s: %u results compared, %u functions JIT compiled.", match ? "passed" : "FAILED",
+				compareCount, statsAfter.functionCount - statsBefore.functionCount);
+		}
+		else
+		{
+			sprintf(res, "Script JIT check failed to build '%s', see the log for details.", path);
+		}
+		TFE_Console::addToHistory(res);
+		TFE_System::logWrite(built ? LOG_MSG : LOG_ERROR, "Scripting", "%s", res);
+
+		if (interpModule) { interpModule->Discard(); }
+		if (jitModule) { jitModule->Discard(); }
+	}
+
+	bool compareJitResults(asIScriptModule* interpModule, asIScriptModule* jitModule, u32* compareCount)
+	{
+		asIScriptContext* context = s_context[SCRIPT_TYPE_TEST];
+		char res[256];
+		bool match = true;
+
+		const asUINT funcCount = interpModule->GetFunctionCount();
+		for (asUINT f = 0; f < funcCount; f++)
+		{
+			asIScriptFunction* interpFunc = interpModule->GetFunctionByIndex(f);
+			if (interpFunc->GetParamCount()) { continue; }
+			asIScriptFunction* jitFunc = jitModule->GetFunctionByDecl(interpFunc->GetDeclaration());
+			if (!jitFunc) { continue; }
+
+			const s32 returnTypeId = interpFunc->GetReturnTypeId();
+			s32 execRes[2];
+			u64 value[2] = {};
+			bool hasValue[2] = {};
+			asIScriptFunction* funcs[] = { interpFunc, jitFunc };
+			for (s32 i = 0; i < 2; i++)
+			{
+				context->Prepare(funcs[i]);
+				execRes[i] = context->Execute();
+				hasValue[i] = execRes[i] == asEXECUTION_FINISHED && readPrimitive(s_engine, returnTypeId, context->GetAddressOfReturnValue(), &value[i]);
+			}
+
+			(*compareCount)++;
+			if (execRes[0] != execRes[1] || hasValue[0] != hasValue[1] || value[0] != value[1])
+			{
+				sprintf(res, "  %s: interpreted 0x%llx (%d), JIT 0x%llx (%d)", interpFunc->GetDeclaration(), (unsigned long long)value[0], execRes[0], (unsigned long long)value[1], execRes[1]);
+				TFE_Console::addToHistory(res);
+				TFE_System::logWrite(LOG_ERROR, "Scripting", "JIT mismatch in %s", res);
+				match = false;
+			}
+		}
+
+		// The globals are compared after all of the functions have run.
+		const asUINT varCount = interpModule->GetGlobalVarCount();
+		for (asUINT v = 0; v < varCount; v++)
+		{
+			const char* name = nullptr;
+			s32 typeId = 0;
+			interpModule->GetGlobalVar(v, &name, nullptr, &typeId);
+			const s32 jitIndex = jitModule->GetGlobalVarIndexByName(name);
+			if (jitIndex < 0) { continue; }
+
+			u64 value[2] = {};
+			if (!readPrimitive(s_engine, typeId, interpModule->GetAddressOfGlobalVar(v), &value[0]) ||
+				!readPrimitive(s_engine, typeId, jitModule->GetAddressOfGlobalVar(jitIndex), &value[1]))
+			{
+				continue;
+			}
+
+			(*compareCount)++;
+			if (value[0] != value[1])
+			{
+				sprintf(res, "  global %s: interpreted 0x%llx, JIT 0x%llx", name, (unsigned long long)value[0], (unsigned long long)value[1]);
+				TFE_Console::addToHistory(res);
+				TFE_System::logWrite(LOG_ERROR, "Scripting", "JIT mismatch in %s", res);
+				match = false;
+			}
+		}
+		return match;
+	}
+
+	// Read a primitive value as raw bits so floats are compared exactly, returns false for other types.
+	bool readPrimitive(asIScriptEngine* engine, s32 typeId, const void* ptr, u64* value)
+	{
+		if (!ptr || (typeId & ~asTYPEID_MASK_SEQNBR) || typeId < asTYPEID_BOOL || typeId > asTYPEID_DOUBLE) { return false; }
+
+		*value = 0;
+		memcpy(value, ptr, engine->GetSizeOfPrimitiveType(typeId));
+		return true;
+	}
+
+	void setJitEnabled(bool enable)
+	{
+		enable = enable && s_jit;
+		s_engine->SetEngineProperty(asEP_INCLUDE_JIT_INSTRUCTIONS, enable);
+		s_engine->SetJITCompiler(enable ? s_jit : nullptr);
+	}
+
+	void checkExecuteResult(ScriptType type, s32 res)
+	{
 		if (res != asEXECUTION_FINISHED)
 		{
 			// The execution didn't complete as expected. Determine what happened.
@@ -225,8 +565,162 @@ namespace TFE_ScriptSystem
 		}
 	}
 
-	void update()
+	bool compileScriptModule(const char* moduleName, const char* path)
+	{
+		CScriptBuilder builder;
+		s32 res = builder.StartNewModule(s_engine, moduleName);
+		if (res < 0)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Scripting", "Unrecoverable error while starting a new module.");
+			return false;
+		}
+		res = builder.AddSectionFromFile(path);
+		if (res < 0)
+		{
+			// The builder wasn't able to load the file. Maybe the file
+			// has been removed, or the wrong name was given, or some
+			// preprocessing commands are incorrectly written.
+			TFE_System::logWrite(LOG_ERROR, "Scripting", "Cannot open or parse file.");
+			return false;
+		}
+		res = builder.BuildModule();
+		if (res < 0)
+		{
+			// An error occurred. Instruct the script writer to fix the 
+			// compilation errors that were listed in the output stream.
+			TFE_System::logWrite(LOG_ERROR, "Scripting", "Compile error(s).");
+			return false;
+		}
+		return true;
+	}
+
+	bool loadCachedModule(const char* moduleName, const char* cachePath, u64 sourceHash)
+	{
+		FileStream file;
+		if (!file.open(cachePath, FileStream::MODE_READ))
+		{
+			return false;
+		}
+
+		ScriptCacheHeader header = { 0 };
+		const size_t size = file.getSize();
+		if (size > sizeof(ScriptCacheHeader))
+		{
+			file.readBuffer(&header, sizeof(ScriptCacheHeader));
+		}
+		if (header.magic != c_cacheMagic || header.version != c_cacheVersion || header.sourceHash != sourceHash)
+		{
+			file.close();
+			return false;
+		}
+
+		ScriptByteStream stream;
+		stream.m_data.resize(size - sizeof(ScriptCacheHeader));
+		file.readBuffer(stream.m_data.data(), (u32)stream.m_data.size());
+		file.close();
+
+		// LoadByteCode() validates the bytecode against the registered engine interface, fall back to compiling if it no longer matches.
+		asIScriptModule* module = s_engine->GetModule(moduleName, asGM_ALWAYS_CREATE);
+		if (!module || module->LoadByteCode(&stream) < 0)
+		{
+			TFE_System::logWrite(LOG_WARNING, "Scripting", "Cached bytecode for module '%s' is out of date, recompiling.", moduleName);
+			if (module) { module->Discard(); }
+			return false;
+		}
+		return true;
+	}
+
+	void saveCachedModule(const char* moduleName, const char* cachePath, u64 sourceHash)
+	{
+		asIScriptModule* module = s_engine->GetModule(moduleName);
+		ScriptByteStream stream;
+		// Keep the debug info so script exceptions still report line numbers.
+		if (!module || module->SaveByteCode(&stream) < 0)
+		{
+			return;
+		}
+
+		FileStream file;
+		if (!file.open(cachePath, FileStream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_WARNING, "Scripting", "Cannot write the bytecode cache '%s'.", cachePath);
+			return;
+		}
+		const ScriptCacheHeader header = { c_cacheMagic, c_cacheVersion, sourceHash };
+		file.writeBuffer(&header, sizeof(ScriptCacheHeader));
+		file.writeBuffer(stream.m_data.data(), (u32)stream.m_data.size());
+		file.close();
+	}
+
+	void hashBytes(const void* data, size_t size, u64* hash)
 	{
+		// FNV-1a
+		const u8* bytes = (const u8*)data;
+		u64 h = *hash;
+		for (size_t i = 0; i < size; i++)
+		{
+			h ^= bytes[i];
+			h *= 1099511628211ull;
+		}
+		*hash = h;
+	}
+
+	// Hash the script and the files it includes (resolved relative to the including file, like CScriptBuilder),
+	// along with the engine and AngelScript versions, the pointer size and whether JIT instructions are included.
+	bool hashScriptSource(const char* path, u64* hash, std::vector<std::string>& visited)
+	{
+		if (visited.empty())
+		{
+			const char* tfeVersion = TFE_System::getVersionString();
+			const u32 ptrSize = (u32)sizeof(void*);
+			const u32 jitInstr = s_jit ? 1 : 0;
+			hashBytes(tfeVersion, strlen(tfeVersion), hash);
+			hashBytes(ANGELSCRIPT_VERSION_STRING, strlen(ANGELSCRIPT_VERSION_STRING), hash);
+			hashBytes(&ptrSize, sizeof(u32), hash);
+			hashBytes(&jitInstr, sizeof(u32), hash);
+		}
+		if (std::find(visited.begin(), visited.end(), path) != visited.end())
+		{
+			return true;
+		}
+		visited.push_back(path);
+
+		FileStream file;
+		if (!file.open(path, FileStream::MODE_READ))
+		{
+			return false;
+		}
+		std::vector<char> source(file.getSize() + 1);
+		file.readBuffer(source.data(), (u32)source.size() - 1);
+		file.close();
+		source.back() = 0;
+		hashBytes(path, strlen(path), hash);
+		hashBytes(source.data(), source.size() - 1, hash);
+
+		char baseDir[TFE_MAX_PATH];
+		FileUtil::getFilePath(path, baseDir);
+		for (const char* line = source.data(); line && *line; )
+		{
+			while (*line == ' ' || *line == '\t') { line++; }
+			if (strncmp(line, "#include", 8) == 0)
+			{
+				const char* start = strchr(line, '"');
+				const char* end = start ? strchr(start + 1, '"') : nullptr;
+				const char* eol = strchr(line, '\n');
+				if (end && (!eol || end < eol))
+				{
+					char includePath[TFE_MAX_PATH];
+					sprintf(includePath, "%s%.*s", baseDir, s32(end - start - 1), start + 1);
+					if (!hashScriptSource(includePath, hash, visited))
+					{
+						return false;
+					}
+				}
+			}
+			line = strchr(line, '\n');
+			if (line) { line++; }
+		}
+		return true;
 	}
 
 	//////////////////////////
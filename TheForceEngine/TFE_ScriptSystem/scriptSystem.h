@@ -12,6 +12,8 @@
 typedef asSFuncPtr ScriptFuncPtr;
 #define SCRIPT_FUNCTION asFUNCTION
 #define SCRIPT_FUNC_PTR void*
+// Called before each call of a batch to setup the script globals for item 'index'.
+typedef void(*ScriptBatchSetup)(u32 index, void* userData);
 
 enum ScriptType
 {
@@ -55,6 +57,10 @@ namespace TFE_ScriptSystem
 	void* getScriptFunction(const char* moduleName, const char* funcDecl);
 	void executeScriptFunction(ScriptType type, void* funcPtr);
 	void executeScriptFunction(ScriptType type, void* funcPtr, s32 arg0, s32 arg1, s32 arg2);
+	// Execute the same function 'count' times in a row, which avoids most of the per-call context setup.
+	void executeScriptFunctionBatch(ScriptType type, void* funcPtr, u32 count, ScriptBatchSetup setup, void* userData);
+	// Returns true if the function does nothing, so callers can skip executing it.
+	bool isScriptFunctionEmpty(void* funcPtr);
 
 	// This is required to be a template, so must be included here in the header.
 	// This also means that "angelscript" must be included more broadly than I would like.
@@ -69,7 +75,10 @@ namespace TFE_ScriptSystem
 
 	void registerFunction(const char* declaration, const ScriptFuncPtr& funcPtr);
 	
+	// Called once per frame, runs the garbage collector within its time budget.
 	void update();
+	// Runs a full garbage collection cycle, returns the number of objects destroyed.
+	u32  collectAllGarbage();
 
 	extern std::vector<ScriptTypeProp> s_prop;
 }
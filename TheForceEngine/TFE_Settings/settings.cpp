@@ -300,6 +300,15 @@ namespace TFE_Settings
 		writeHeader(settings, c_sectionNames[SECTION_SOUND]);
 		writeKeyValue_Float(settings, "soundFxVolume", s_soundSettings.soundFxVolume);
 		writeKeyValue_Float(settings, "musicVolume", s_soundSettings.musicVolume);
+		writeKeyValue_Int(settings, "outputSampleRate", s_soundSettings.outputSampleRate);
+		writeKeyValue_String(settings, "resampler", c_tfeResamplerStrings[s_soundSettings.resampler]);
+		writeKeyValue_Bool(settings, "preResampleVoc", s_soundSettings.preResampleVoc);
+		writeKeyValue_Bool(settings, "softwareSynth", s_soundSettings.softwareSynth);
+		writeKeyValue_String(settings, "soundFont", s_soundSettings.soundFont);
+		writeKeyValue_Int(settings, "synthMaxVoices", s_soundSettings.synthMaxVoices);
+		writeKeyValue_String(settings, "audioOutput", c_tfeAudioOutputStrings[s_soundSettings.audioOutput]);
+		writeKeyValue_String(settings, "audioClock", c_tfeAudioClockStrings[s_soundSettings.audioClock]);
+		writeKeyValue_String(settings, "audioCapturePath", s_soundSettings.audioCapturePath);
 	}
 
 	void writeGameSettings(FileStream& settings)
@@ -577,6 +586,63 @@ namespace TFE_Settings
 		{
 			s_soundSettings.musicVolume = parseFloat(value);
 		}
+		else if (strcasecmp("outputSampleRate", key) == 0)
+		{
+			s_soundSettings.outputSampleRate = parseInt(value);
+		}
+		else if (strcasecmp("resampler", key) == 0)
+		{
+			for (size_t i = 0; i < TFE_ARRAYSIZE(c_tfeResamplerStrings); i++)
+			{
+				if (strcasecmp(value, c_tfeResamplerStrings[i]) == 0)
+				{
+					s_soundSettings.resampler = TFE_AudioResampler(i);
+					break;
+				}
+			}
+		}
+		else if (strcasecmp("preResampleVoc", key) == 0)
+		{
+			s_soundSettings.preResampleVoc = parseBool(value);
+		}
+		else if (strcasecmp("softwareSynth", key) == 0)
+		{
+			s_soundSettings.softwareSynth = parseBool(value);
+		}
+		else if (strcasecmp("soundFont", key) == 0)
+		{
+			strcpy(s_soundSettings.soundFont, value);
+		}
+		else if (strcasecmp("synthMaxVoices", key) == 0)
+		{
+			s_soundSettings.synthMaxVoices = parseInt(value);
+		}
+		else if (strcasecmp("audioOutput", key) == 0)
+		{
+			for (size_t i = 0; i < TFE_ARRAYSIZE(c_tfeAudioOutputStrings); i++)
+			{
+				if (strcasecmp(value, c_tfeAudioOutputStrings[i]) == 0)
+				{
+					s_soundSettings.audioOutput = TFE_AudioOutput(i);
+					break;
+				}
+			}
+		}
+		else if (strcasecmp("audioClock", key) == 0)
+		{
+			for (size_t i = 0; i < TFE_ARRAYSIZE(c_tfeAudioClockStrings); i++)
+			{
+				if (strcasecmp(value, c_tfeAudioClockStrings[i]) == 0)
+				{
+					s_soundSettings.audioClock = TFE_AudioClock(i);
+					break;
+				}
+			}
+		}
+		else if (strcasecmp("audioCapturePath", key) == 0)
+		{
+			strcpy(s_soundSettings.audioCapturePath, value);
+		}
 	}
 
 	void parseGame(const char* key, const char* value)
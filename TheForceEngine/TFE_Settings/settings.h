@@ -74,10 +74,68 @@ struct TFE_Settings_Hud
 	s32 pixelOffset[2] = { 0 };
 };
 
+// Interpolation used when a sound's sample rate does not match the output sample rate.
+enum TFE_AudioResampler
+{
+	TFE_RESAMPLER_LINEAR = 0,	// Linear interpolation between neighboring samples.
+	TFE_RESAMPLER_SINC,			// 8 tap polyphase windowed-sinc filter.
+	TFE_RESAMPLER_COUNT
+};
+
+static const char* c_tfeResamplerStrings[] =
+{
+	"Linear",	// TFE_RESAMPLER_LINEAR
+	"Sinc",		// TFE_RESAMPLER_SINC
+};
+
+// Where the mixed audio goes.
+enum TFE_AudioOutput
+{
+	TFE_AUDIO_OUTPUT_DEVICE = 0,	// The system audio device.
+	TFE_AUDIO_OUTPUT_NULL,			// Mix but discard the output, used when there is no audio device.
+	TFE_AUDIO_OUTPUT_WAV,			// Mix and write the output to a WAV file.
+	TFE_AUDIO_OUTPUT_COUNT
+};
+
+static const char* c_tfeAudioOutputStrings[] =
+{
+	"Device",	// TFE_AUDIO_OUTPUT_DEVICE
+	"Null",		// TFE_AUDIO_OUTPUT_NULL
+	"WAV",		// TFE_AUDIO_OUTPUT_WAV
+};
+
+// Clock that drives mixing for the Null and WAV outputs, the audio device uses its own clock.
+enum TFE_AudioClock
+{
+	TFE_AUDIO_CLOCK_REALTIME = 0,	// Mix at the output sample rate on the audio thread.
+	TFE_AUDIO_CLOCK_UNTHROTTLED,	// Mix as fast as possible on the audio thread.
+	TFE_AUDIO_CLOCK_GAME,			// Mix on the game thread based on the frame delta time, so captures match the game frames.
+	TFE_AUDIO_CLOCK_COUNT
+};
+
+static const char* c_tfeAudioClockStrings[] =
+{
+	"Realtime",		// TFE_AUDIO_CLOCK_REALTIME
+	"Unthrottled",	// TFE_AUDIO_CLOCK_UNTHROTTLED
+	"Game",			// TFE_AUDIO_CLOCK_GAME
+};
+
 struct TFE_Settings_Sound
 {
 	f32 soundFxVolume = 1.0f;
 	f32 musicVolume = 1.0f;
+	u32 outputSampleRate = 11025;
+	TFE_AudioResampler resampler = TFE_RESAMPLER_LINEAR;
+	// Resample VOC data to the output sample rate when loaded, which avoids resampling during mixing at the cost of memory.
+	bool preResampleVoc = false;
+	// Play music through the built-in SoundFont synthesizer instead of the system midi device.
+	// The synthesizer is also used if no midi device is available.
+	bool softwareSynth = false;
+	char soundFont[TFE_MAX_PATH] = "SoundFonts/SYNTHGM.sf2";	// Relative to the program directory, unless absolute.
+	u32 synthMaxVoices = 64;
+	TFE_AudioOutput audioOutput = TFE_AUDIO_OUTPUT_DEVICE;
+	TFE_AudioClock audioClock = TFE_AUDIO_CLOCK_REALTIME;
+	char audioCapturePath[TFE_MAX_PATH] = "AudioCapture.wav";	// Relative to the user documents directory, unless absolute.
 };
 
 struct TFE_Game
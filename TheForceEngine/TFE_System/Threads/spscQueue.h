@@ -0,0 +1,60 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Single Producer / Single Consumer Queue
+// A fixed size, lock-free ring buffer that allows exactly one thread
+// to push() while exactly one other thread pops() - for example the
+// game thread sending commands to the audio thread.
+// Capacity must be a power of two.
+//////////////////////////////////////////////////////////////////////
+
+#include <TFE_System/types.h>
+
+template <typename T, u32 Capacity>
+class SpscQueue
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two.");
+
+public:
+	SpscQueue() : m_head(0u), m_tail(0u) {}
+
+	// Producer thread only.
+	// Returns false if the queue is full, in which case the item is not added.
+	bool push(const T& item)
+	{
+		const u32 tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) >= Capacity)
+		{
+			return false;
+		}
+
+		m_items[tail & (Capacity - 1)] = item;
+		m_tail.store(tail + 1u, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer thread only.
+	// Returns false if the queue is empty.
+	bool pop(T* item)
+	{
+		const u32 head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		*item = m_items[head & (Capacity - 1)];
+		m_head.store(head + 1u, std::memory_order_release);
+		return true;
+	}
+
+	// Approximate number of items in the queue, exact when called from the producer or consumer
+	// while the other thread is idle.
+	u32 getCount() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+	u32 getCapacity() const { return Capacity; }
+
+private:
+	T m_items[Capacity];
+	// Keep the read and write positions on seperate cache lines to avoid false sharing between the threads.
+	alignas(64) atomic_u32 m_head;
+	alignas(64) atomic_u32 m_tail;
+};
@@ -0,0 +1,195 @@
+#include "frameStats.h"
+#include <TFE_System/system.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_FrontEndUI/console.h>
+#include <assert.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+namespace TFE_FrameStats
+{
+	// Number of frames the statistics are computed over, about 17 seconds at 60 fps.
+	#define FRAME_WINDOW_SIZE 1024
+
+	struct FrameRecord
+	{
+		f64 frameTime;
+		f64 cpuTime;
+		f64 renderTime;
+		f64 swapTime;
+		u32 simTicks;
+	};
+
+	static FrameRecord s_frames[FRAME_WINDOW_SIZE];
+	static u32 s_frameCount = 0;		// total frames recorded.
+	static u64 s_frameBegin = 0;
+	static u64 s_lastFrameEnd = 0;
+	static u64 s_renderTicks = 0;
+	static u64 s_swapTicks = 0;
+	static u32 s_simTicks = 0;
+
+	// Cached statistics, only recomputed when new frames have been recorded.
+	static FrameTimeStats s_stats = {};
+	static u32 s_statsFrameCount = 0;
+	static std::vector<f64> s_sorted;
+
+	// CSV output
+	static bool s_csvEnabled = false;
+	static FileStream s_csvFile;
+	static bool s_csvOpen = false;
+
+	void updateCsv(const FrameRecord* record);
+	void computeStats();
+
+	void init()
+	{
+		CVAR_BOOL(s_csvEnabled, "g_frameStatsCsv", 0, "Write the time of each frame to a CSV file in the user documents folder while enabled.");
+		s_sorted.reserve(FRAME_WINDOW_SIZE);
+	}
+
+	void shutdown()
+	{
+		if (s_csvOpen)
+		{
+			s_csvFile.close();
+			s_csvOpen = false;
+		}
+	}
+
+	void beginFrame()
+	{
+		s_frameBegin = TFE_System::getCurrentTimeInTicks();
+		s_renderTicks = 0;
+		s_swapTicks = 0;
+		s_simTicks = 0;
+	}
+
+	void endFrame()
+	{
+		const u64 now = TFE_System::getCurrentTimeInTicks();
+		// The first frame has no previous frame to measure from.
+		if (!s_lastFrameEnd)
+		{
+			s_lastFrameEnd = now;
+			return;
+		}
+
+		FrameRecord* record = &s_frames[s_frameCount % FRAME_WINDOW_SIZE];
+		record->frameTime = TFE_System::convertFromTicksToSeconds(now - s_lastFrameEnd);
+		record->cpuTime = TFE_System::convertFromTicksToSeconds(now - s_frameBegin - std::min(s_swapTicks, now - s_frameBegin));
+		record->renderTime = TFE_System::convertFromTicksToSeconds(s_renderTicks);
+		record->swapTime = TFE_System::convertFromTicksToSeconds(s_swapTicks);
+		record->simTicks = s_simTicks;
+		s_frameCount++;
+		s_lastFrameEnd = now;
+
+		updateCsv(record);
+	}
+
+	void addSimTicks(u32 count)
+	{
+		s_simTicks += count;
+	}
+
+	void addRenderTime(u64 ticks)
+	{
+		s_renderTicks += ticks;
+	}
+
+	void addSwapTime(u64 ticks)
+	{
+		s_swapTicks += ticks;
+	}
+
+	void getStats(FrameTimeStats* stats)
+	{
+		if (s_statsFrameCount != s_frameCount)
+		{
+			computeStats();
+			s_statsFrameCount = s_frameCount;
+		}
+		*stats = s_stats;
+	}
+
+	//////////////////////////////////////////////
+	// Internal
+	//////////////////////////////////////////////
+	void computeStats()
+	{
+		const u32 count = std::min(s_frameCount, (u32)FRAME_WINDOW_SIZE);
+		s_stats = {};
+		s_stats.frameCount = count;
+		if (!count) { return; }
+
+		s_sorted.clear();
+		for (u32 i = 0; i < count; i++)
+		{
+			const FrameRecord* record = &s_frames[i];
+			s_sorted.push_back(record->frameTime);
+			s_stats.aveTime += record->frameTime;
+			s_stats.cpuTimeAve += record->cpuTime;
+			s_stats.renderTimeAve += record->renderTime;
+			s_stats.swapTimeAve += record->swapTime;
+			s_stats.simTicksAve += f64(record->simTicks);
+		}
+		const f64 scale = 1.0 / f64(count);
+		s_stats.aveTime *= scale;
+		s_stats.cpuTimeAve *= scale;
+		s_stats.renderTimeAve *= scale;
+		s_stats.swapTimeAve *= scale;
+		s_stats.simTicksAve *= scale;
+
+		// Nearest rank percentiles: the smallest value with at least p% of the frames at or below it,
+		// index ceil(p/100 * count) - 1.
+		std::sort(s_sorted.begin(), s_sorted.end());
+		s_stats.minTime = s_sorted.front();
+		s_stats.maxTime = s_sorted.back();
+		s_stats.p50 = s_sorted[(count * 50 + 99) / 100 - 1];
+		s_stats.p95 = s_sorted[(count * 95 + 99) / 100 - 1];
+		s_stats.p99 = s_sorted[(count * 99 + 99) / 100 - 1];
+
+		const u32 lowCount = std::max(count / 100, 1u);
+		f64 lowTime = 0.0;
+		for (u32 i = count - lowCount; i < count; i++)
+		{
+			lowTime += s_sorted[i];
+		}
+		s_stats.low1Fps = lowTime > 0.0 ? f64(lowCount) / lowTime : 0.0;
+	}
+
+	// Open or close the CSV file when the cvar changes and write the frame while it is enabled.
+	void updateCsv(const FrameRecord* record)
+	{
+		if (s_csvEnabled && !s_csvOpen)
+		{
+			char fileName[TFE_MAX_PATH];
+			char path[TFE_MAX_PATH];
+			const time_t curTime = time(nullptr);
+			strftime(fileName, TFE_MAX_PATH, "tfe_frame_stats_%Y%m%d_%H%M%S.csv", localtime(&curTime));
+			TFE_Paths::appendPath(PATH_USER_DOCUMENTS, fileName, path);
+
+			s_csvOpen = s_csvFile.open(path, FileStream::MODE_WRITE);
+			if (!s_csvOpen)
+			{
+				TFE_System::logWrite(LOG_ERROR, "FrameStats", "Cannot open \"%s\" for writing, frame statistics will not be saved.", path);
+				s_csvEnabled = false;
+				return;
+			}
+			TFE_System::logWrite(LOG_MSG, "FrameStats", "Writing frame statistics to \"%s\"", path);
+			s_csvFile.writeString("frame,frame_ms,cpu_ms,sim_ticks,render_ms,swap_ms\n");
+		}
+		else if (!s_csvEnabled && s_csvOpen)
+		{
+			s_csvFile.close();
+			s_csvOpen = false;
+		}
+
+		if (s_csvOpen)
+		{
+			s_csvFile.writeString("%u,%0.3f,%0.3f,%u,%0.3f,%0.3f\n", s_frameCount, record->frameTime * 1000.0, record->cpuTime * 1000.0,
+				record->simTicks, record->renderTime * 1000.0, record->swapTime * 1000.0);
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Frame Statistics
+// Records the time of every frame along with the simulation ticks,
+// render time and swap time it contains. Statistics are computed over
+// a rolling window of recent frames, and each frame can optionally be
+// written to a CSV file in the user documents folder (g_frameStatsCsv).
+//////////////////////////////////////////////////////////////////////
+
+#include "types.h"
+
+struct FrameTimeStats
+{
+	u32 frameCount;		// frames in the window.
+	// Frame times in seconds, from the end of the previous frame to the end of this one (endFrame() to endFrame()).
+	f64 minTime;
+	f64 aveTime;
+	f64 maxTime;
+	f64 p50;
+	f64 p95;
+	f64 p99;
+	f64 low1Fps;		// average frame rate of the slowest 1% of frames.
+	// Averages over the window.
+	f64 cpuTimeAve;		// frame time excluding the swap.
+	f64 renderTimeAve;
+	f64 swapTimeAve;
+	f64 simTicksAve;
+};
+
+namespace TFE_FrameStats
+{
+	void init();
+	void shutdown();
+
+	// Called at the start and end of the main loop.
+	void beginFrame();
+	void endFrame();
+
+	// Called during the frame to break down where the time went.
+	void addSimTicks(u32 count);
+	void addRenderTime(u64 ticks);
+	void addSwapTime(u64 ticks);
+
+	void getStats(FrameTimeStats* stats);
+}
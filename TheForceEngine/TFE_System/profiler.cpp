@@ -1,34 +1,103 @@
 #include "profiler.h"
+#include <TFE_FileSystem/filestream.h>
 #include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <map>
 
-// TODO: Support call "paths" - with seperate time per path.
-
 namespace TFE_Profiler
 {
-	#define ZONE_BUFFER_COUNT 2
+	#define MAX_ZONES 1024
+	#define MAX_ZONE_NODES 1024
 	#define MAX_ZONE_STACK 256
-	
+	#define MAX_PROFILE_THREADS 32
+	#define ROOT_NODE 0
+	// Timeline events per thread, about 3 seconds of a busy main thread.
+	#define TRACE_EVENT_COUNT (1 << 18)
+	#define TRACE_EVENT_MASK (TRACE_EVENT_COUNT - 1)
+
+	enum TraceEventType
+	{
+		TRACE_ZONE_BEGIN = 0,
+		TRACE_ZONE_END,
+		TRACE_FRAME,
+		TRACE_COUNTER,
+	};
+
+	// A zone registered by a TFE_ZONE call site.
 	struct Zone
 	{
-		u32  id;
-		u32  level = 0;
-		u32  parent = NULL_ZONE;
-		u64  path;
-		u64  frame;
 		char name[64];
 		char func[64];
 		u32  lineNumber;
+	};
+
+	// A zone along one call path, written by the thread that owns it.
+	// The totals only grow so the main thread can read them at the end of the frame without locking.
+	struct ZoneNode
+	{
+		u32 zone;
+		u32 parent;
+		u32 level;
+		u32 child = NULL_ZONE;		// owner thread only.
+		u32 sibling = NULL_ZONE;	// owner thread only.
+
+		std::atomic<u64> totalTicks;
+		std::atomic<u32> totalCalls;
+	};
+
+	// Per frame results for a node, main thread only.
+	struct NodeStats
+	{
+		u64 prevTicks;
+		u32 prevCalls;
+		u32 callCount;
+		f64 timeInZone;
+		f64 timeInZoneAve;
+		f64 fractOfParentAve;
+
+		u32 child;
+		u32 lastChild;
+		u32 sibling;
+	};
+
+	// Packed as type (8 bits), id (24 bits), value (32 bits) so the event is written with two plain stores.
+	struct TraceEvent
+	{
+		std::atomic<u64> ticks;
+		std::atomic<u64> data;
+	};
+
+	struct ThreadProfile
+	{
+		char name[64];
+		ZoneNode nodes[MAX_ZONE_NODES];
+		std::atomic<u32> nodeCount;
 
-		f64  timeInZone[ZONE_BUFFER_COUNT];
-		f64  timeInZoneAve;
-		f64  fractOfParentAve;
+		// Timeline ring buffer, allocated by the owner the first time it records an event.
+		std::atomic<TraceEvent*> trace;
+		std::atomic<u64> traceWriteCount;
 
-		u32  child = NULL_ZONE;
-		u32  sibling = NULL_ZONE;
+		// Owner thread only.
+		u32 stack[MAX_ZONE_STACK];
+		u32 level;
+		u32 overflow;
+
+		// Main thread only.
+		NodeStats stats[MAX_ZONE_NODES];
+		u32 statCount;
+	};
+
+	struct SortedZone
+	{
+		u32 thread;
+		u32 node;
 	};
 
 	struct Counter
@@ -41,117 +110,113 @@ namespace TFE_Profiler
 	};
 
 	typedef std::map<std::string, u32> ZoneMap;
-	typedef std::vector<Zone> ZoneList;
-	typedef std::vector<u32> SortedZoneList;
+	typedef std::vector<SortedZone> SortedZoneList;
 	typedef std::vector<Counter> CounterList;
 
-	static ZoneMap  s_zoneMap;
-	static ZoneList s_zoneList;
+	static std::mutex s_mutex;
+	static Zone s_zones[MAX_ZONES];
+	static std::atomic<u32> s_zoneCount(0);
+	static ZoneMap s_zoneMap;
+	static ThreadProfile* s_threads[MAX_PROFILE_THREADS];
+	static std::atomic<u32> s_threadCount(0);
+	static thread_local ThreadProfile* s_thread = nullptr;
 	static SortedZoneList s_sortedZoneList;
-	static SortedZoneList s_roots;
 
 	static ZoneMap  s_counterMap;
 	static CounterList s_counterList;
 
+	static std::atomic<bool> s_traceEnabled(false);
 	static u64 s_frameBegin;
 	static f64 s_frameTime;
-	static u32 s_readBuffer = 0;
-	static u32 s_writeBuffer = 1;
-	static u32 s_level;
-	static u32 s_maxLevel;
-	static u32 s_zoneStack[MAX_ZONE_STACK];
-	static u64 s_currentFrame = 1;
-	static u64 s_currentPath;
-
-	void addZoneChild(u32 parentId, u32 zoneId)
+	static u32 s_frameIndex = 0;
+	static const f64 c_expBlend = 0.99;
+	// Zones that were not entered this frame are still listed until their average drops below this.
+	static const f64 c_minListedTime = 1.0e-6;
+
+	ThreadProfile* getThreadProfile();
+	u32  getChildNode(ThreadProfile* thread, u32 parent, u32 zoneId);
+	void updateThreadStats(ThreadProfile* thread);
+	void traverseZoneTree(u32 threadIndex, ThreadProfile* thread, u32 node);
+	void recordTraceEvent(ThreadProfile* thread, TraceEventType type, u32 id, s32 value);
+	void writeJsonString(FileStream* file, const char* str);
+
+	u32 registerZone(const char* name, const char* func, u32 lineNumber)
 	{
-		Zone& parent = s_zoneList[parentId];
-		Zone& zone = s_zoneList[zoneId];
-		// This has already been added.
-		if (zone.sibling != NULL_ZONE)
-		{
-			return;
-		}
+		char key[256];
+		snprintf(key, sizeof(key), "%s|%s|%u", name, func, lineNumber);
 
-		if (parent.child == zoneId)
-		{
-			return;
-		}
-		else if (parent.child == NULL_ZONE)
+		std::lock_guard<std::mutex> lock(s_mutex);
+		ZoneMap::iterator iZone = s_zoneMap.find(key);
+		if (iZone != s_zoneMap.end())
 		{
-			parent.child = zoneId;
+			return iZone->second;
 		}
-		else
+
+		const u32 id = s_zoneCount.load(std::memory_order_relaxed);
+		if (id >= MAX_ZONES)
 		{
-			Zone* child = &s_zoneList[parent.child];
-			while (1)
-			{
-				if (child->sibling == zoneId)
-				{
-					return;
-				}
-				else if (child->sibling == NULL_ZONE)
-				{
-					child->sibling = zoneId;
-					break;
-				}
-				child = &s_zoneList[child->sibling];
-			};
+			assert(0);
+			return NULL_ZONE;
 		}
+
+		Zone* zone = &s_zones[id];
+		snprintf(zone->name, sizeof(zone->name), "%s", name);
+		snprintf(zone->func, sizeof(zone->func), "%s", func);
+		zone->lineNumber = lineNumber;
+
+		s_zoneMap[key] = id;
+		s_zoneCount.store(id + 1, std::memory_order_release);
+		return id;
 	}
 
-	u32 beginZone(const char* name, const char* func, u32 lineNumber)
+	void beginZone(u32 zoneId)
 	{
-		ZoneMap::iterator iZone = s_zoneMap.find(name);
-		u32 id = 0;
-
-		if (iZone == s_zoneMap.end())
+		ThreadProfile* thread = getThreadProfile();
+		if (s_traceEnabled.load(std::memory_order_relaxed))
 		{
-			id = (u32)s_zoneList.size();
-
-			Zone zone;
-			zone.id = id;
-			zone.path = s_currentPath;
-			zone.timeInZone[s_readBuffer]  = 0;
-			zone.timeInZone[s_writeBuffer] = 0;
-			zone.timeInZoneAve = 0.0;
-			zone.fractOfParentAve = 0.0;
-			zone.frame = 0;
-			
-			s_zoneList.push_back(zone);
-			s_zoneMap[name] = id;
+			recordTraceEvent(thread, TRACE_ZONE_BEGIN, zoneId, 0);
 		}
-		else
+		if (thread->overflow || thread->level >= MAX_ZONE_STACK)
 		{
-			id = iZone->second;
+			thread->overflow++;
+			return;
 		}
 
-		Zone& zone = s_zoneList[id];
-		strcpy(zone.name, name);
-		strcpy(zone.func, func);
-		zone.lineNumber = lineNumber;
-		zone.level = s_level;
+		const u32 parent = thread->stack[thread->level - 1];
+		thread->stack[thread->level] = getChildNode(thread, parent, zoneId);
+		thread->level++;
+	}
 
-		zone.parent = s_level > 0 ? s_zoneStack[s_level - 1] : NULL_ZONE;
-		if (zone.parent == NULL_ZONE)
+	void endZone(u32 zoneId, u64 dt)
+	{
+		ThreadProfile* thread = s_thread;
+		if (s_traceEnabled.load(std::memory_order_relaxed))
 		{
-			s_roots.push_back(id);
+			recordTraceEvent(thread, TRACE_ZONE_END, zoneId, 0);
 		}
-		else
+		if (thread->overflow)
 		{
-			addZoneChild(zone.parent, zone.id);
+			thread->overflow--;
+			return;
 		}
 
-		s_zoneStack[s_level] = id;
-		s_level++;
+		assert(thread->level > 1);
+		thread->level--;
+		const u32 nodeId = thread->stack[thread->level];
+		if (nodeId == NULL_ZONE) { return; }
 
-		return id;
+		// Only this thread writes the totals, so they don't need atomic read-modify-write operations.
+		ZoneNode* node = &thread->nodes[nodeId];
+		assert(node->zone == zoneId);
+		node->totalTicks.store(node->totalTicks.load(std::memory_order_relaxed) + dt, std::memory_order_relaxed);
+		node->totalCalls.store(node->totalCalls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 	}
 
-	void endZone(u32 id, u64 dt)
+	void setThreadName(const char* name)
 	{
-		s_zoneList[id].timeInZone[s_writeBuffer] += TFE_System::convertFromTicksToSeconds(dt);
-		s_level--;
+		ThreadProfile* thread = getThreadProfile();
+		std::lock_guard<std::mutex> lock(s_mutex);
+		snprintf(thread->name, sizeof(thread->name), "%s", name);
 	}
 
 	void addCounter(const char* name, s32* counter)
@@ -174,18 +239,6 @@ namespace TFE_Profiler
 
 	void frameBegin()
 	{
-		std::swap(s_readBuffer, s_writeBuffer);
-		s_level = 0;
-		s_maxLevel = 0;
-		s_roots.clear();
-
-		// Swap buffers, s_readBuffer is safe to read in the middle of the next frame.
-		const size_t zoneCount = s_zoneList.size();
-		for (size_t i = 0; i < zoneCount; i++)
-		{
-			s_zoneList[i].timeInZone[s_writeBuffer] = 0;
-		}
-
 		// Copy counter values from the frame, so that the results can be used
 	    // in the middle of the next frame.
 		const size_t counterCount = s_counterList.size();
@@ -194,71 +247,31 @@ namespace TFE_Profiler
 			s_counterList[i].prevValue = *s_counterList[i].ptr;
 		}
 
-		s_frameBegin = TFE_System::getCurrentTimeInTicks();
-	}
-
-	void traverseZoneTree(u32 id)
-	{
-		if (id == NULL_ZONE) { return; }
-		Zone* zone = &s_zoneList[id];
-		// Make sure zones are only inserted once for now.
-		if (zone->frame != s_currentFrame)
+		if (s_traceEnabled.load(std::memory_order_relaxed))
 		{
-			s_sortedZoneList.push_back(id);
-		}
-		zone->frame = s_currentFrame;
-		
-		while (zone->child != NULL_ZONE)
-		{
-			traverseZoneTree(zone->child);
-			zone = &s_zoneList[zone->child];
+			ThreadProfile* thread = getThreadProfile();
+			recordTraceEvent(thread, TRACE_FRAME, 0, s32(s_frameIndex));
+			for (size_t i = 0; i < counterCount; i++)
+			{
+				recordTraceEvent(thread, TRACE_COUNTER, u32(i), s_counterList[i].prevValue);
+			}
 		}
+		s_frameIndex++;
 
-		zone = &s_zoneList[id];
-		while (zone->sibling != NULL_ZONE)
-		{
-			traverseZoneTree(zone->sibling);
-			zone = &s_zoneList[zone->sibling];
-		}
+		s_frameBegin = TFE_System::getCurrentTimeInTicks();
 	}
 
 	void frameEnd()
 	{
 		s_frameTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - s_frameBegin);
-		const size_t zoneCount = s_zoneList.size();
-		const f64 expBlend = 0.99;
-
-		// Sort Zones
 		s_sortedZoneList.clear();
-		const size_t rootCount = s_roots.size();
-		for (size_t r = 0; r < rootCount; r++)
-		{
-			traverseZoneTree(s_roots[r]);
-		}
 
-		// First compute delta times for each zone.
-		for (size_t i = 0; i < zoneCount; i++)
+		const u32 threadCount = s_threadCount.load(std::memory_order_acquire);
+		for (u32 t = 0; t < threadCount; t++)
 		{
-			s_zoneList[i].timeInZoneAve = expBlend * s_zoneList[i].timeInZoneAve + (1.0 - expBlend)*s_zoneList[i].timeInZone[s_writeBuffer];
-		}
-
-		// Then handle percentage of parent and clear
-		for (size_t i = 0; i < zoneCount; i++)
-		{
-			f64 parentTime = (s_zoneList[i].parent != NULL_ZONE) ? s_zoneList[s_zoneList[i].parent].timeInZone[s_writeBuffer] : s_frameTime;
-			s_zoneList[i].fractOfParentAve = expBlend * s_zoneList[i].fractOfParentAve + (1.0 - expBlend)*s_zoneList[i].timeInZone[s_writeBuffer] / parentTime;
-			// Handle the rare case the parentTime = 0 causing s_zoneList[i].fractOfParentAve to become NAN. Once that happens it will never fix itself
-			// because we are doing an average. So fix it manually.
-			if (isnan(s_zoneList[i].fractOfParentAve))
-			{
-				s_zoneList[i].fractOfParentAve = 0.0;
-			}
-
-			s_zoneList[i].child = NULL_ZONE;
-			s_zoneList[i].sibling = NULL_ZONE;
+			updateThreadStats(s_threads[t]);
+			traverseZoneTree(t, s_threads[t], ROOT_NODE);
 		}
-
-		s_currentFrame++;
 	}
 
 	u32 getZoneCount()
@@ -270,15 +283,146 @@ namespace TFE_Profiler
 	{
 		if (index >= (u32)s_sortedZoneList.size()) { return; }
 
-		Zone& zone = s_zoneList[s_sortedZoneList[index]];
-		info->name = zone.name;
-		info->func = zone.func;
-		info->level = zone.level;
-		info->lineNumber = zone.lineNumber;
-		info->timeInZone = zone.timeInZone[s_readBuffer];
-		info->timeInZoneAve = zone.timeInZoneAve;
-		info->fractOfParentAve = zone.fractOfParentAve;
-		info->parentId = zone.parent;
+		const SortedZone& sorted = s_sortedZoneList[index];
+		const ThreadProfile* thread = s_threads[sorted.thread];
+		const ZoneNode* node = &thread->nodes[sorted.node];
+		const NodeStats* stats = &thread->stats[sorted.node];
+		Zone* zone = &s_zones[node->zone];
+
+		info->name = zone->name;
+		info->func = zone->func;
+		info->level = node->level;
+		info->lineNumber = zone->lineNumber;
+		info->thread = sorted.thread;
+		info->callCount = stats->callCount;
+		info->timeInZone = stats->timeInZone;
+		info->timeInZoneAve = stats->timeInZoneAve;
+		info->fractOfParentAve = stats->fractOfParentAve;
+		info->parentId = node->parent == ROOT_NODE ? NULL_ZONE : node->parent;
+	}
+
+	const char* getThreadName(u32 thread)
+	{
+		if (thread >= s_threadCount.load(std::memory_order_acquire)) { return ""; }
+		return s_threads[thread]->name;
+	}
+
+	void enableTrace(bool enable)
+	{
+		s_traceEnabled.store(enable, std::memory_order_relaxed);
+	}
+
+	bool isTraceEnabled()
+	{
+		return s_traceEnabled.load(std::memory_order_relaxed);
+	}
+
+	bool writeTrace(const char* path, f64 seconds)
+	{
+		FileStream file;
+		if (!file.open(path, FileStream::MODE_WRITE)) { return false; }
+
+		const u64 endTicks = TFE_System::getCurrentTimeInTicks();
+		const u32 threadCount = s_threadCount.load(std::memory_order_acquire);
+		std::vector<TraceEvent*> events(threadCount);
+		std::vector<u64> writeCount(threadCount);
+		std::vector<u64> firstEvent(threadCount);
+		std::vector<u64> eventTicks;
+		std::vector<u64> eventData;
+
+		// Find the start of the capture so timestamps can be written relative to it.
+		u64 baseTicks = endTicks;
+		for (u32 t = 0; t < threadCount; t++)
+		{
+			events[t] = s_threads[t]->trace.load(std::memory_order_acquire);
+			writeCount[t] = s_threads[t]->traceWriteCount.load(std::memory_order_acquire);
+			firstEvent[t] = writeCount[t] > TRACE_EVENT_COUNT ? writeCount[t] - TRACE_EVENT_COUNT : 0;
+			if (events[t] && writeCount[t] > firstEvent[t])
+			{
+				baseTicks = std::min(baseTicks, events[t][firstEvent[t] & TRACE_EVENT_MASK].ticks.load(std::memory_order_relaxed));
+			}
+		}
+		const f64 captureTime = TFE_System::convertFromTicksToSeconds(endTicks - baseTicks);
+		if (captureTime > seconds)
+		{
+			baseTicks = endTicks - u64(f64(endTicks - baseTicks) * seconds / captureTime);
+		}
+
+		file.writeString("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		file.writeString("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"The Force Engine\"}}");
+		for (u32 t = 0; t < threadCount; t++)
+		{
+			file.writeString(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", t);
+			writeJsonString(&file, s_threads[t]->name);
+			file.writeString("}}");
+			if (!events[t]) { continue; }
+
+			// Copy the events, then drop any the owner thread may have overwritten while they were copied.
+			eventTicks.clear();
+			eventData.clear();
+			for (u64 e = firstEvent[t]; e < writeCount[t]; e++)
+			{
+				eventTicks.push_back(events[t][e & TRACE_EVENT_MASK].ticks.load(std::memory_order_relaxed));
+				eventData.push_back(events[t][e & TRACE_EVENT_MASK].data.load(std::memory_order_relaxed));
+			}
+			const u64 newWriteCount = s_threads[t]->traceWriteCount.load(std::memory_order_acquire);
+			const u64 validStart = newWriteCount >= TRACE_EVENT_COUNT ? newWriteCount - TRACE_EVENT_COUNT + 1 : 0;
+			const size_t skip = validStart > firstEvent[t] ? size_t(validStart - firstEvent[t]) : 0;
+
+			u32 depth = 0;
+			u64 lastTicks = baseTicks;
+			const size_t eventCount = eventTicks.size();
+			for (size_t e = skip; e < eventCount; e++)
+			{
+				if (eventTicks[e] < baseTicks) { continue; }
+
+				const u32 type = u32(eventData[e] >> 56);
+				const u32 id = u32(eventData[e] >> 32) & 0xffffff;
+				const s32 value = s32(eventData[e] & 0xffffffff);
+				const f64 timeUs = TFE_System::convertFromTicksToSeconds(eventTicks[e] - baseTicks) * 1000000.0;
+				lastTicks = eventTicks[e];
+
+				switch (type)
+				{
+					case TRACE_ZONE_BEGIN:
+					{
+						file.writeString(",\n{\"ph\":\"B\",\"pid\":1,\"tid\":%u,\"ts\":%0.3f,\"name\":", t, timeUs);
+						writeJsonString(&file, s_zones[id].name);
+						file.writeString(",\"args\":{\"func\":");
+						writeJsonString(&file, s_zones[id].func);
+						file.writeString("}}");
+						depth++;
+					} break;
+					case TRACE_ZONE_END:
+					{
+						// Skip the ends of zones that began before the capture.
+						if (!depth) { break; }
+						file.writeString(",\n{\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%0.3f}", t, timeUs);
+						depth--;
+					} break;
+					case TRACE_FRAME:
+					{
+						file.writeString(",\n{\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%u,\"ts\":%0.3f,\"name\":\"Frame %d\"}", t, timeUs, value);
+					} break;
+					case TRACE_COUNTER:
+					{
+						file.writeString(",\n{\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%0.3f,\"name\":", t, timeUs);
+						writeJsonString(&file, s_counterList[id].name);
+						file.writeString(",\"args\":{\"value\":%d}}", value);
+					} break;
+				}
+			}
+
+			// Close the zones that were still open when the capture was written.
+			const f64 endUs = TFE_System::convertFromTicksToSeconds(lastTicks - baseTicks) * 1000000.0;
+			for (; depth > 0; depth--)
+			{
+				file.writeString(",\n{\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%0.3f}", t, endUs);
+			}
+		}
+		file.writeString("\n]}\n");
+		file.close();
+		return true;
 	}
 
 	f64 getTimeInFrame()
@@ -299,4 +443,159 @@ namespace TFE_Profiler
 		info->name = counter.name;
 		info->value = counter.prevValue;
 	}
+
+	//////////////////////////////////////////////
+	// Internal
+	//////////////////////////////////////////////
+	// Profiles are created on first use and live for the rest of the run, the main thread reads them
+	// at the end of each frame. Threads beyond MAX_PROFILE_THREADS are still timed but never listed.
+	ThreadProfile* getThreadProfile()
+	{
+		if (s_thread) { return s_thread; }
+
+		ThreadProfile* thread = new ThreadProfile();
+		thread->nodes[ROOT_NODE].zone = NULL_ZONE;
+		thread->nodes[ROOT_NODE].parent = NULL_ZONE;
+		thread->nodes[ROOT_NODE].level = 0;
+		thread->nodeCount.store(1, std::memory_order_relaxed);
+		thread->stack[0] = ROOT_NODE;
+		thread->level = 1;
+		thread->overflow = 0;
+		thread->statCount = 1;
+		thread->stats[ROOT_NODE] = {};
+		thread->stats[ROOT_NODE].child = NULL_ZONE;
+		thread->stats[ROOT_NODE].lastChild = NULL_ZONE;
+		thread->stats[ROOT_NODE].sibling = NULL_ZONE;
+
+		std::lock_guard<std::mutex> lock(s_mutex);
+		const u32 index = s_threadCount.load(std::memory_order_relaxed);
+		snprintf(thread->name, sizeof(thread->name), "Thread %u", index);
+		if (index < MAX_PROFILE_THREADS)
+		{
+			s_threads[index] = thread;
+			s_threadCount.store(index + 1, std::memory_order_release);
+		}
+		s_thread = thread;
+		return thread;
+	}
+
+	// Find the node for the zone under 'parent', adding it the first time the zone is entered along this path.
+	u32 getChildNode(ThreadProfile* thread, u32 parent, u32 zoneId)
+	{
+		if (parent == NULL_ZONE || zoneId == NULL_ZONE) { return NULL_ZONE; }
+
+		ZoneNode* nodes = thread->nodes;
+		for (u32 child = nodes[parent].child; child != NULL_ZONE; child = nodes[child].sibling)
+		{
+			if (nodes[child].zone == zoneId) { return child; }
+		}
+
+		const u32 id = thread->nodeCount.load(std::memory_order_relaxed);
+		if (id >= MAX_ZONE_NODES) { return NULL_ZONE; }
+
+		ZoneNode* node = &nodes[id];
+		node->zone = zoneId;
+		node->parent = parent;
+		node->level = parent == ROOT_NODE ? 0 : nodes[parent].level + 1;
+		node->totalTicks.store(0, std::memory_order_relaxed);
+		node->totalCalls.store(0, std::memory_order_relaxed);
+		node->sibling = nodes[parent].child;
+		nodes[parent].child = id;
+
+		// Publish the node to the main thread.
+		thread->nodeCount.store(id + 1, std::memory_order_release);
+		return id;
+	}
+
+	void updateThreadStats(ThreadProfile* thread)
+	{
+		const u32 nodeCount = thread->nodeCount.load(std::memory_order_acquire);
+		NodeStats* stats = thread->stats;
+
+		// Add new nodes to the main thread copy of the tree, in the order they were first entered.
+		for (u32 i = thread->statCount; i < nodeCount; i++)
+		{
+			const u32 parent = thread->nodes[i].parent;
+			stats[i] = {};
+			stats[i].child = NULL_ZONE;
+			stats[i].lastChild = NULL_ZONE;
+			stats[i].sibling = NULL_ZONE;
+
+			if (stats[parent].lastChild == NULL_ZONE) { stats[parent].child = i; }
+			else { stats[stats[parent].lastChild].sibling = i; }
+			stats[parent].lastChild = i;
+		}
+		thread->statCount = nodeCount;
+
+		// Nodes are always added after their parents, so parent times are ready when the children need them.
+		for (u32 i = 1; i < nodeCount; i++)
+		{
+			ZoneNode* node = &thread->nodes[i];
+			NodeStats* nodeStats = &stats[i];
+
+			const u64 totalTicks = node->totalTicks.load(std::memory_order_relaxed);
+			const u32 totalCalls = node->totalCalls.load(std::memory_order_relaxed);
+			nodeStats->timeInZone = TFE_System::convertFromTicksToSeconds(totalTicks - nodeStats->prevTicks);
+			nodeStats->callCount = totalCalls - nodeStats->prevCalls;
+			nodeStats->prevTicks = totalTicks;
+			nodeStats->prevCalls = totalCalls;
+			nodeStats->timeInZoneAve = c_expBlend * nodeStats->timeInZoneAve + (1.0 - c_expBlend) * nodeStats->timeInZone;
+
+			const f64 parentTime = node->parent != ROOT_NODE ? stats[node->parent].timeInZone : s_frameTime;
+			nodeStats->fractOfParentAve = c_expBlend * nodeStats->fractOfParentAve + (1.0 - c_expBlend) * nodeStats->timeInZone / parentTime;
+			// Handle the rare case the parentTime = 0 causing fractOfParentAve to become NAN. Once that happens it will never fix itself
+			// because we are doing an average. So fix it manually.
+			if (isnan(nodeStats->fractOfParentAve))
+			{
+				nodeStats->fractOfParentAve = 0.0;
+			}
+		}
+	}
+
+	void recordTraceEvent(ThreadProfile* thread, TraceEventType type, u32 id, s32 value)
+	{
+		if (id == NULL_ZONE) { return; }
+
+		TraceEvent* events = thread->trace.load(std::memory_order_relaxed);
+		if (!events)
+		{
+			events = new TraceEvent[TRACE_EVENT_COUNT];
+			thread->trace.store(events, std::memory_order_release);
+		}
+
+		// Only the owner writes to the ring, the write count is published after the event so the reader
+		// can tell which events were complete.
+		const u64 writeCount = thread->traceWriteCount.load(std::memory_order_relaxed);
+		TraceEvent* evt = &events[writeCount & TRACE_EVENT_MASK];
+		evt->ticks.store(TFE_System::getCurrentTimeInTicks(), std::memory_order_relaxed);
+		evt->data.store((u64(type) << 56) | (u64(id & 0xffffff) << 32) | u64(u32(value)), std::memory_order_relaxed);
+		thread->traceWriteCount.store(writeCount + 1, std::memory_order_release);
+	}
+
+	void writeJsonString(FileStream* file, const char* str)
+	{
+		char escaped[256];
+		size_t len = 0;
+		escaped[len++] = '"';
+		for (; *str && len < sizeof(escaped) - 3; str++)
+		{
+			if (*str == '"' || *str == '\\') { escaped[len++] = '\\'; }
+			escaped[len++] = *str;
+		}
+		escaped[len++] = '"';
+		file->writeBuffer(escaped, u32(len));
+	}
+
+	void traverseZoneTree(u32 threadIndex, ThreadProfile* thread, u32 node)
+	{
+		for (u32 child = thread->stats[node].child; child != NULL_ZONE; child = thread->stats[child].sibling)
+		{
+			const NodeStats* stats = &thread->stats[child];
+			if (stats->callCount || stats->timeInZoneAve >= c_minListedTime)
+			{
+				s_sortedZoneList.push_back({ threadIndex, child });
+				traverseZoneTree(threadIndex, thread, child);
+			}
+		}
+	}
 }
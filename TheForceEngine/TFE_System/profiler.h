@@ -3,7 +3,11 @@
 // The Force Engine Profiler
 // Simple "zone" based profiler.
 // Add TFE_PROFILE_ENABLED to preprocessor defines in the build to enable.
-// Currently does not respect the call path, that is TODO.
+//
+// Each TFE_ZONE call site registers its zone once, using a function
+// local static, so entering a zone does not need to look up its name.
+// Time is recorded per call path and per thread: the same zone entered
+// from different parent zones or threads is reported separately.
 //////////////////////////////////////////////////////////////////////
 
 #include "types.h"
@@ -14,12 +18,15 @@
 #define TOKENPASTE(x, y) x ## y
 #define TOKENPASTE2(x, y) TOKENPASTE(x, y)
 #ifdef  TFE_PROFILE_ENABLED
-#define TFE_ZONE(name)  TFE_Profiler_Zone TOKENPASTE2(__localZone, __LINE__)(name, __FUNCTION__, __LINE__)
-#define TFE_ZONE_BEGIN(varName, name)  TFE_Profiler_ZoneManual varName(name, __FUNCTION__, __LINE__)
+#define TFE_ZONE(name)  static const u32 TOKENPASTE2(__zoneId, __LINE__) = TFE_Profiler::registerZone(name, __FUNCTION__, __LINE__); \
+	TFE_Profiler_Zone TOKENPASTE2(__localZone, __LINE__)(TOKENPASTE2(__zoneId, __LINE__))
+#define TFE_ZONE_BEGIN(varName, name)  static const u32 TOKENPASTE2(varName, _zoneId) = TFE_Profiler::registerZone(name, __FUNCTION__, __LINE__); \
+	TFE_Profiler_ZoneManual varName(TOKENPASTE2(varName, _zoneId))
 #define TFE_ZONE_END(varName)  varName.end()
 #define TFE_FRAME_BEGIN() TFE_Profiler::frameBegin()
 #define TFE_FRAME_END() TFE_Profiler::frameEnd()
 #define TFE_COUNTER(varName, name) TFE_Profiler::addCounter(name, &varName)
+#define TFE_PROFILE_THREAD(name) TFE_Profiler::setThreadName(name)
 #else
 #define TFE_ZONE(name)
 #define TFE_ZONE_BEGIN(varName, name)
@@ -27,6 +34,7 @@
 #define TFE_FRAME_BEGIN()
 #define TFE_FRAME_END()
 #define TFE_COUNTER(varName, name)
+#define TFE_PROFILE_THREAD(name)
 #endif
 
 #define NULL_ZONE 0xffffffff
@@ -39,6 +47,8 @@ struct TFE_ZoneInfo
 	u32  lineNumber;
 	u32  level;
 	u32  parentId;
+	u32  thread;		// index of the thread the zone was recorded on.
+	u32  callCount;		// times the zone was entered in the last frame.
 	f64  timeInZone;
 	f64  timeInZoneAve;
 	f64  fractOfParentAve;
@@ -53,8 +63,12 @@ struct TFE_CounterInfo
 namespace TFE_Profiler
 {
 	// The main profiling API is used through Macros which can be disabled based on build flags.
-	u32  beginZone(const char* name, const char* func, u32 lineNumber);
-	void endZone(u32 id, u64 dt);
+	// Zones with the same name, function and line share an id.
+	u32  registerZone(const char* name, const char* func, u32 lineNumber);
+	void beginZone(u32 zoneId);
+	void endZone(u32 zoneId, u64 dt);
+	// Names the calling thread in the profile, otherwise threads are numbered in the order they enter their first zone.
+	void setThreadName(const char* name);
 		
 	void frameBegin();
 	void frameEnd();
@@ -64,20 +78,29 @@ namespace TFE_Profiler
 	// Profile data API, this is used directly.
 	f64  getTimeInFrame();
 
+	// Zones recorded in the last frame, in call tree order grouped by thread.
 	u32  getZoneCount();
 	void getZoneInfo(u32 index, TFE_ZoneInfo* info);
+	const char* getThreadName(u32 thread);
 	
 	u32  getCounterCount();
 	void getCounterInfo(u32 index, TFE_CounterInfo* info);
+
+	// Timeline recording of zone begin/end times on every thread, along with frame markers and counters.
+	void enableTrace(bool enable);
+	bool isTraceEnabled();
+	// Writes up to the last 'seconds' of the timeline as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+	bool writeTrace(const char* path, f64 seconds);
 }
 
 class TFE_Profiler_Zone
 {
 public:
-	TFE_Profiler_Zone(const char* name, const char* func, u32 lineNumber)
+	TFE_Profiler_Zone(u32 zoneId)
 	{
+		m_id = zoneId;
+		TFE_Profiler::beginZone(zoneId);
 		m_time = TFE_System::getCurrentTimeInTicks();
-		m_id = TFE_Profiler::beginZone(name, func, lineNumber);
 	}
 
 	~TFE_Profiler_Zone()
@@ -87,16 +110,17 @@ public:
 	}
 private:
 	u64 m_time;
-	s32 m_id;
+	u32 m_id;
 };
 
 class TFE_Profiler_ZoneManual
 {
 public:
-	TFE_Profiler_ZoneManual(const char* name, const char* func, u32 lineNumber)
+	TFE_Profiler_ZoneManual(u32 zoneId)
 	{
+		m_id = zoneId;
+		TFE_Profiler::beginZone(zoneId);
 		m_time = TFE_System::getCurrentTimeInTicks();
-		m_id = TFE_Profiler::beginZone(name, func, lineNumber);
 	}
 
 	void end()
@@ -106,6 +130,6 @@ public:
 	}
 private:
 	u64 m_time;
-	s32 m_id;
+	u32 m_id;
 };
 #endif
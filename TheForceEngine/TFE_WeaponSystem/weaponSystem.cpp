@@ -25,6 +25,12 @@
 #include <assert.h>
 #include <algorithm>
 
+// SSE2 is always available on x64, other targets use the scalar paths.
+#if defined(_M_X64) || defined(__SSE2__)
+#define WEAPON_SYSTEM_SSE2 1
+#include <emmintrin.h>
+#endif
+
 // TEMP
 #include <TFE_Game/modelRendering.h>
 #include <TFE_Game/renderCommon.h>
@@ -114,18 +120,41 @@ namespace TFE_WeaponSystem
 		PFLAG_EXPLODE_ON_RANGE = (1 << 3),
 	};
 
-	struct Projectile
+	// Active projectiles stored as parallel arrays, so the motion of every projectile can be integrated
+	// together each step. Removing a projectile moves the last one into its slot.
+	struct ProjectileList
 	{
-		GameObject* obj;
-		ProjectilePool* pool;
-		ProjectilePool* effectPool;
-		const SoundBuffer* hitEffectSound = nullptr;
-		Vec3f pos;
-		Vec3f vel;
-		u32 flags;	// ProjectileFlags
-		u32 damage;
-		f32 value0;
-		f32 value1;
+		u32 count;
+
+		// Motion, updated every step.
+		f32 posX[MAX_ACTIVE_PROJECTILES];
+		f32 posY[MAX_ACTIVE_PROJECTILES];
+		f32 posZ[MAX_ACTIVE_PROJECTILES];
+		f32 velX[MAX_ACTIVE_PROJECTILES];
+		f32 velY[MAX_ACTIVE_PROJECTILES];
+		f32 velZ[MAX_ACTIVE_PROJECTILES];
+		u32 flags[MAX_ACTIVE_PROJECTILES];	// ProjectileFlags
+
+		// Only needed when the projectile hits something.
+		GameObject* obj[MAX_ACTIVE_PROJECTILES];
+		ProjectilePool* pool[MAX_ACTIVE_PROJECTILES];
+		ProjectilePool* effectPool[MAX_ACTIVE_PROJECTILES];
+		const SoundBuffer* hitEffectSound[MAX_ACTIVE_PROJECTILES];
+		u32 damage[MAX_ACTIVE_PROJECTILES];
+		f32 value0[MAX_ACTIVE_PROJECTILES];
+		f32 value1[MAX_ACTIVE_PROJECTILES];
+	};
+
+	// Per-step scratch data for the projectile simulation.
+	struct ProjectileStep
+	{
+		f32 dirX[MAX_ACTIVE_PROJECTILES];
+		f32 dirY[MAX_ACTIVE_PROJECTILES];
+		f32 dirZ[MAX_ACTIVE_PROJECTILES];
+		f32 length[MAX_ACTIVE_PROJECTILES];
+		Ray ray[MAX_ACTIVE_PROJECTILES];
+		RayHitInfo hit[MAX_ACTIVE_PROJECTILES];
+		bool collided[MAX_ACTIVE_PROJECTILES];
 	};
 
 	struct HitEffect
@@ -173,9 +202,9 @@ namespace TFE_WeaponSystem
 	static u32 s_projPoolCount = 0;
 	static ProjectilePool s_projectilePool[MAX_POOL_COUNT];
 
-	static u32 s_projCount = 0;
 	static u32 s_effectCount = 0;
-	static Projectile s_proj[MAX_ACTIVE_PROJECTILES];
+	static ProjectileList s_proj;
+	static ProjectileStep s_projStep;
 	static HitEffect s_effect[MAX_ACTIVE_EFFECTS];
 
 	void TFE_WeaponPrimed(s32 primeCount);
@@ -184,6 +213,10 @@ namespace TFE_WeaponSystem
 	void TFE_SetProjectileScale(f32 x, f32 y, f32 z);
 	void TFE_SetProjectileRenderOffset(f32 offset);
 	void explodeOnImpact(ProjectilePool* effectPool, const SoundBuffer* hitEffectSound, const Vec3f* hitPoint, s32 hitSectorId, s32 hitWallId, GameObject* hitObject, f32 radius, u32 damage);
+	void computeProjectileSteps(u32 count);
+	void integrateProjectiles(u32 count);
+	void traceProjectileRays(u32 count);
+	void removeProjectile(u32 index);
 
 	void clearWeapons()
 	{
@@ -192,7 +225,7 @@ namespace TFE_WeaponSystem
 		s_callSwitchTo = false;
 		s_primeTimer = 0;
 		s_projPoolCount = 0;
-		s_projCount = 0;
+		s_proj.count = 0;
 		s_effectCount = 0;
 		if (s_memoryPool) { s_memoryPool->clear(); }
 	}
@@ -244,7 +277,7 @@ namespace TFE_WeaponSystem
 		{
 			// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
 			// Note that looping one shots are valid though may generate too many sound sources if not used carefully.
-			TFE_Audio::playOneShot(SOUND_2D, volume, MONO_SEPERATION, buffer, false);
+			TFE_Audio::playOneShot(SOUND_2D, volume, MONO_SEPERATION, buffer, SOUND_CATEGORY_WEAPON, SOUND_PRIORITY_HIGH);
 		}
 	}
 
@@ -263,6 +296,8 @@ namespace TFE_WeaponSystem
 		projPool->activeObj[activeIndex] = projPool->freeObj[freeIndex];
 		GameObject* obj = &projPool->obj[projPool->activeObj[activeIndex]];
 		memset(obj, 0, sizeof(GameObject));
+		obj->sectorSlot = SECTOR_SLOT_NONE;
+		obj->awakeSlot = AWAKE_SLOT_NONE;
 		obj->show = true;
 		if (projPool->type == PROJ_FRAME)
 		{
@@ -300,6 +335,7 @@ namespace TFE_WeaponSystem
 				break;
 			}
 		}
+		LevelGameObjects::removeFromSector(projPool->startIndex + index);
 	}
 		
 	ProjectilePool* createProjectilePool(ProjPoolType type, void* asset)
@@ -424,25 +460,26 @@ namespace TFE_WeaponSystem
 		GameObject* projObj = getProjectile(s_weapon.projPool);
 		if (!projObj) { return; }
 
-		Projectile* proj = nullptr;
-		if (s_projCount == MAX_ACTIVE_PROJECTILES)
+		u32 slot;
+		if (s_proj.count == MAX_ACTIVE_PROJECTILES)
 		{
 			// Steal it from the beginning of the list.
-			proj = &s_proj[0];
-			returnProjectile(proj->pool, proj->obj);
+			slot = 0;
+			returnProjectile(s_proj.pool[0], s_proj.obj[0]);
+			s_proj.obj[0]->show = false;
 		}
 		else
 		{
-			proj = &s_proj[s_projCount];
-			s_projCount++;
+			slot = s_proj.count;
+			s_proj.count++;
 		}
 
-		proj->obj = projObj;
-		proj->pool = s_weapon.projPool;
-		proj->effectPool = s_weapon.hitEffectPool;
-		proj->hitEffectSound = s_weapon.hitEffectSound;
+		s_proj.obj[slot] = projObj;
+		s_proj.pool[slot] = s_weapon.projPool;
+		s_proj.effectPool[slot] = s_weapon.hitEffectPool;
+		s_proj.hitEffectSound[slot] = s_weapon.hitEffectSound;
 
-		if (proj->obj->oclass == CLASS_3D)
+		if (projObj->oclass == CLASS_3D)
 		{
 			Vec3f fwd = { dir.x, 0.0f, dir.z };
 			fwd = TFE_Math::normalize(&fwd);
@@ -452,31 +489,31 @@ namespace TFE_WeaponSystem
 			f32 cosPitch = (fwd.x*dir.x + fwd.z*dir.z);
 			f32 pitch = acosf(cosPitch) * 180.0f * TFE_Math::sign(dir.y) / PI;
 			
-			proj->obj->angles = { pitch, yaw, 0.0f };
-			proj->obj->scale  = s_weapon.scale;
-			proj->obj->zbias = -s_weapon.renderOffset;
+			projObj->angles = { pitch, yaw, 0.0f };
+			projObj->scale  = s_weapon.scale;
+			projObj->zbias = -s_weapon.renderOffset;
 
-			proj->obj->fullbright = true;
+			projObj->fullbright = true;
 		}
 		else
 		{
-			proj->obj->scale = { 1.0f, 1.0f, 1.0f };
-			proj->obj->zbias = 0.0f;
+			projObj->scale = { 1.0f, 1.0f, 1.0f };
+			projObj->zbias = 0.0f;
 		}
 
-		SectorObjectList* secList = LevelGameObjects::getSectorObjectList();
-		std::vector<u32>& list = (*secList)[hitInfo.hitSectorId].list;
 		u32 index = (u32)((u8*)projObj - (u8*)s_weapon.projPool->obj) / sizeof(GameObject);
-		list.push_back(index + s_weapon.projPool->startIndex);
-
-		proj->obj->sectorId = hitInfo.hitSectorId;
-
-		proj->pos = origin;
-		proj->vel = { dir.x * fwdSpeed, dir.y * fwdSpeed + upwardSpeed, dir.z * fwdSpeed };
-		proj->flags = flags;
-		proj->damage = damage;
-		proj->value0 = value0;
-		proj->value1 = value1;
+		LevelGameObjects::addToSector(index + s_weapon.projPool->startIndex, hitInfo.hitSectorId);
+
+		s_proj.posX[slot] = origin.x;
+		s_proj.posY[slot] = origin.y;
+		s_proj.posZ[slot] = origin.z;
+		s_proj.velX[slot] = dir.x * fwdSpeed;
+		s_proj.velY[slot] = dir.y * fwdSpeed + upwardSpeed;
+		s_proj.velZ[slot] = dir.z * fwdSpeed;
+		s_proj.flags[slot] = flags;
+		s_proj.damage[slot] = damage;
+		s_proj.value0[slot] = value0;
+		s_proj.value1[slot] = value1;
 
 		projObj->position = { origin.x + dir.x * s_weapon.renderOffset, origin.y + dir.y * s_weapon.renderOffset, origin.z + dir.z * s_weapon.renderOffset };
 	}
@@ -513,10 +550,8 @@ namespace TFE_WeaponSystem
 		effectObj->frameIndex = 0;
 		effectObj->fullbright = true;
 
-		SectorObjectList* secList = LevelGameObjects::getSectorObjectList();
-		std::vector<u32>& list = (*secList)[sectorId].list;
 		u32 index = (u32)((u8*)effectObj - (u8*)effectPool->obj) / sizeof(GameObject);
-		list.push_back(index + effectPool->startIndex);
+		LevelGameObjects::addToSector(index + effectPool->startIndex, sectorId);
 	}
 
 	void updateEffects()
@@ -536,35 +571,17 @@ namespace TFE_WeaponSystem
 			effect->obj->frameIndex = u16(effect->frame);
 		}
 
-		SectorObjectList* secList = LevelGameObjects::getSectorObjectList();
+		// Remove in reverse order so the effects moved into the removed slots have already been processed.
 		for (s32 i = delCount - 1; i >= 0; i--)
 		{
 			s32 index = delList[i];
 			HitEffect* effect = &s_effect[index];
+			// Returning the object also removes it from its sector.
 			returnProjectile(effect->pool, effect->obj);
 			effect->obj->show = false;
 
-			// Delete from the sector.
-			u32 objIndex = (u32)((u8*)effect->obj - (u8*)effect->pool->obj) / sizeof(GameObject);
-			u32 startIndex = effect->pool->startIndex;
-
-			// Remove from the old sector.
-			std::vector<u32>& prevlist = (*secList)[effect->obj->sectorId].list;
-			const size_t prevCount = prevlist.size();
-			for (u32 j = 0; j < prevCount; j++)
-			{
-				if (prevlist[j] == objIndex + startIndex)
-				{
-					prevlist.erase(prevlist.begin() + j);
-					break;
-				}
-			}
-
-			for (s32 j = index; j < (s32)s_effectCount - 1; j++)
-			{
-				s_effect[j] = s_effect[j + 1];
-			}
 			s_effectCount--;
+			s_effect[index] = s_effect[s_effectCount];
 		}
 	}
 
@@ -576,7 +593,7 @@ namespace TFE_WeaponSystem
 			spawnEffect(effectPool, hitPoint, hitSectorId);
 			if (hitEffectSound)
 			{
-				TFE_Audio::playOneShot(SOUND_3D, 1.0f, MONO_SEPERATION, hitEffectSound, false, hitPoint, true);
+				TFE_Audio::playOneShot(SOUND_3D, 1.0f, MONO_SEPERATION, hitEffectSound, false, hitPoint, true, nullptr, nullptr, 0, SOUND_CATEGORY_WEAPON);
 			}
 		}
 		// Damage.
@@ -607,121 +624,65 @@ namespace TFE_WeaponSystem
 		}
 	}
 
-	void projectileHit(Projectile* proj, const RayHitInfo* hitInfo)
+	void projectileHit(u32 index, const RayHitInfo* hitInfo)
 	{
-		SectorObjectList* secList = LevelGameObjects::getSectorObjectList();
-
-		if (proj->flags & PFLAG_EXPLODE_ON_IMPACT)
+		if (s_proj.flags[index] & PFLAG_EXPLODE_ON_IMPACT)
 		{
+			ProjectilePool* effectPool = s_proj.effectPool[index];
+			const SoundBuffer* hitEffectSound = s_proj.hitEffectSound[index];
+
 			// Explode here.
-			if (proj->effectPool)
+			if (effectPool)
 			{
-				spawnEffect(proj->effectPool, &hitInfo->hitPoint, hitInfo->hitSectorId);
-				if (proj->hitEffectSound)
+				spawnEffect(effectPool, &hitInfo->hitPoint, hitInfo->hitSectorId);
+				if (hitEffectSound)
 				{
-					TFE_Audio::playOneShot(SOUND_3D, 1.0f, MONO_SEPERATION, proj->hitEffectSound, false, &proj->pos, true);
+					TFE_Audio::playOneShot(SOUND_3D, 1.0f, MONO_SEPERATION, hitEffectSound, false, &hitInfo->hitPoint, true, nullptr, nullptr, 0, SOUND_CATEGORY_WEAPON);
 				}
 			}
 			// Damage.
-			explodeOnImpact(proj->effectPool, proj->hitEffectSound, &hitInfo->hitPoint, hitInfo->hitSectorId, hitInfo->hitWallId, (GameObject*)hitInfo->obj, proj->value0, proj->damage);
+			explodeOnImpact(effectPool, hitEffectSound, &hitInfo->hitPoint, hitInfo->hitSectorId, hitInfo->hitWallId, (GameObject*)hitInfo->obj, s_proj.value0[index], s_proj.damage[index]);
 		}
 		// Handle bouncing, etc.
 
-		// Remove object
-		returnProjectile(proj->pool, proj->obj);
-		proj->obj->show = false;
-
-		// Delete from the sector.
-		u32 index = (u32)((u8*)proj->obj - (u8*)proj->pool->obj) / sizeof(GameObject);
-		u32 startIndex = proj->pool->startIndex;
-
-		// Remove from the old sector.
-		std::vector<u32>& prevlist = (*secList)[proj->obj->sectorId].list;
-		const size_t prevCount = prevlist.size();
-		for (u32 j = 0; j < prevCount; j++)
-		{
-			if (prevlist[j] == index + startIndex)
-			{
-				prevlist.erase(prevlist.begin() + j);
-				break;
-			}
-		}
+		// Remove object, this also removes it from its sector.
+		returnProjectile(s_proj.pool[index], s_proj.obj[index]);
+		s_proj.obj[index]->show = false;
 	}
 
 	void simulateProjectiles()
 	{
-		SectorObjectList* secList = LevelGameObjects::getSectorObjectList();
-		
-		Projectile* proj = s_proj;
-		s32 delCount = 0;
-		s32 delList[256];
-		for (u32 i = 0; i < s_projCount; i++, proj++)
+		const u32 count = s_proj.count;
+		if (!count) { return; }
+
+		// Compute the motion for this step and trace all of the rays together.
+		computeProjectileSteps(count);
+		traceProjectileRays(count);
+		// Move all of the projectiles and apply gravity, projectiles that hit something are removed below.
+		integrateProjectiles(count);
+
+		// Go backwards so projectiles moved into removed slots have already been processed.
+		const f32 renderOffset = s_weapon.renderOffset;
+		for (s32 i = s32(count) - 1; i >= 0; i--)
 		{
-			const Vec3f p0 = proj->pos;
-			const Vec3f p1 = { p0.x + proj->vel.x * c_step, p0.y + proj->vel.y * c_step, p0.z + proj->vel.z * c_step };
-
-			f32 stepLen = TFE_Math::distance(&p0, &p1);
-			f32 scale = 1.0f / stepLen;
-			Vec3f dir = { (p1.x - p0.x) * scale, (p1.y - p0.y) * scale, (p1.z - p0.z) * scale };
-
-			// Collision
-			const Ray ray=
+			const RayHitInfo* hitInfo = &s_projStep.hit[i];
+			if (s_projStep.collided[i])
 			{
-				p0,
-				dir,
-				proj->obj->sectorId,
-				stepLen,
-			};
-			RayHitInfo hitInfo;
-			if (TFE_Physics::traceRay(&ray, &hitInfo))
-			{
-				projectileHit(proj, &hitInfo);
-				delList[delCount++] = i;
+				projectileHit(i, hitInfo);
+				removeProjectile(i);
 				continue;
 			}
-			if (proj->obj->sectorId != hitInfo.hitSectorId && hitInfo.hitSectorId > -1)
-			{
-				u32 index = (u32)((u8*)proj->obj - (u8*)proj->pool->obj) / sizeof(GameObject);
-				u32 startIndex = proj->pool->startIndex;
 
-				// Remove from the old sector.
-				std::vector<u32>& prevlist = (*secList)[proj->obj->sectorId].list;
-				const size_t prevCount = prevlist.size();
-				for (u32 i = 0; i < prevCount; i++)
-				{
-					if (prevlist[i] == index + startIndex)
-					{
-						prevlist.erase(prevlist.begin() + i);
-						break;
-					}
-				}
-
-				// Add to the new sector.
-				std::vector<u32>& newlist = (*secList)[hitInfo.hitSectorId].list;
-				newlist.push_back(index + startIndex);
-
-				proj->obj->sectorId = hitInfo.hitSectorId;
-			}
-			
-			// Assuming no collision.
-			proj->pos = p1;
-			proj->obj->position = { p1.x + dir.x * s_weapon.renderOffset, p1.y + dir.y * s_weapon.renderOffset, p1.z + dir.z * s_weapon.renderOffset };
-
-			// Physics
-			if (proj->flags & PFLAG_HAS_GRAVITY)
+			GameObject* obj = s_proj.obj[i];
+			if (obj->sectorId != hitInfo->hitSectorId && hitInfo->hitSectorId > -1)
 			{
-				proj->vel.y += c_gravityAccelStep;
+				u32 index = (u32)((u8*)obj - (u8*)s_proj.pool[i]->obj) / sizeof(GameObject);
+				LevelGameObjects::moveToSector(index + s_proj.pool[i]->startIndex, hitInfo->hitSectorId);
 			}
-		}
 
-		for (s32 i = delCount - 1; i >= 0; i--)
-		{
-			s32 index = delList[i];
-			for (s32 j = index; j < (s32)s_projCount - 1; j++)
-			{
-				s_proj[j] = s_proj[j + 1];
-			}
-			s_projCount--;
+			obj->position.x = s_proj.posX[i] + s_projStep.dirX[i] * renderOffset;
+			obj->position.y = s_proj.posY[i] + s_projStep.dirY[i] * renderOffset;
+			obj->position.z = s_proj.posZ[i] + s_projStep.dirZ[i] * renderOffset;
 		}
 	}
 
@@ -975,4 +936,103 @@ namespace TFE_WeaponSystem
 		else if (s_player && s_player->m_shooting) { ambient = 31; }
 		s_renderer->blitImage(frame, s_weapon.x + TFE_RenderBackend::getVirtualDisplayOffset2D(), s_weapon.y + s_weapon.yOffset, s_screen.scaleX, s_screen.scaleY, ambient);
 	}
+
+	//////////////////////////////////////////////
+	// Internal
+	//////////////////////////////////////////////
+	// Compute the normalized direction and length of each projectile's motion for this step.
+	void computeProjectileSteps(u32 count)
+	{
+		u32 i = 0;
+	#ifdef WEAPON_SYSTEM_SSE2
+		const __m128 step4 = _mm_set1_ps(c_step);
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 dx = _mm_mul_ps(_mm_loadu_ps(s_proj.velX + i), step4);
+			const __m128 dy = _mm_mul_ps(_mm_loadu_ps(s_proj.velY + i), step4);
+			const __m128 dz = _mm_mul_ps(_mm_loadu_ps(s_proj.velZ + i), step4);
+			const __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+			const __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), len);
+			_mm_storeu_ps(s_projStep.dirX + i, _mm_mul_ps(dx, scale));
+			_mm_storeu_ps(s_projStep.dirY + i, _mm_mul_ps(dy, scale));
+			_mm_storeu_ps(s_projStep.dirZ + i, _mm_mul_ps(dz, scale));
+			_mm_storeu_ps(s_projStep.length + i, len);
+		}
+	#endif
+		for (; i < count; i++)
+		{
+			const f32 dx = s_proj.velX[i] * c_step;
+			const f32 dy = s_proj.velY[i] * c_step;
+			const f32 dz = s_proj.velZ[i] * c_step;
+			const f32 len = sqrtf(dx*dx + dy*dy + dz*dz);
+			const f32 scale = 1.0f / len;
+			s_projStep.dirX[i] = dx * scale;
+			s_projStep.dirY[i] = dy * scale;
+			s_projStep.dirZ[i] = dz * scale;
+			s_projStep.length[i] = len;
+		}
+	}
+
+	// Move the projectiles by their velocity for this step, then apply gravity to the velocity.
+	void integrateProjectiles(u32 count)
+	{
+		u32 i = 0;
+	#ifdef WEAPON_SYSTEM_SSE2
+		const __m128 step4 = _mm_set1_ps(c_step);
+		const __m128 gravity4 = _mm_set1_ps(c_gravityAccelStep);
+		const __m128i gravityFlag4 = _mm_set1_epi32(PFLAG_HAS_GRAVITY);
+		for (; i + 4 <= count; i += 4)
+		{
+			_mm_storeu_ps(s_proj.posX + i, _mm_add_ps(_mm_loadu_ps(s_proj.posX + i), _mm_mul_ps(_mm_loadu_ps(s_proj.velX + i), step4)));
+			_mm_storeu_ps(s_proj.posY + i, _mm_add_ps(_mm_loadu_ps(s_proj.posY + i), _mm_mul_ps(_mm_loadu_ps(s_proj.velY + i), step4)));
+			_mm_storeu_ps(s_proj.posZ + i, _mm_add_ps(_mm_loadu_ps(s_proj.posZ + i), _mm_mul_ps(_mm_loadu_ps(s_proj.velZ + i), step4)));
+
+			const __m128i flags = _mm_loadu_si128((const __m128i*)(s_proj.flags + i));
+			const __m128 hasGravity = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, gravityFlag4), gravityFlag4));
+			_mm_storeu_ps(s_proj.velY + i, _mm_add_ps(_mm_loadu_ps(s_proj.velY + i), _mm_and_ps(hasGravity, gravity4)));
+		}
+	#endif
+		for (; i < count; i++)
+		{
+			s_proj.posX[i] += s_proj.velX[i] * c_step;
+			s_proj.posY[i] += s_proj.velY[i] * c_step;
+			s_proj.posZ[i] += s_proj.velZ[i] * c_step;
+			if (s_proj.flags[i] & PFLAG_HAS_GRAVITY)
+			{
+				s_proj.velY[i] += c_gravityAccelStep;
+			}
+		}
+	}
+
+	// Trace the motion of every projectile for this step as a single batch.
+	void traceProjectileRays(u32 count)
+	{
+		for (u32 i = 0; i < count; i++)
+		{
+			s_projStep.ray[i] = { { s_proj.posX[i], s_proj.posY[i], s_proj.posZ[i] }, { s_projStep.dirX[i], s_projStep.dirY[i], s_projStep.dirZ[i] }, s_proj.obj[i]->sectorId, s_projStep.length[i] };
+		}
+		TFE_Physics::traceRays(s_projStep.ray, count, s_projStep.hit, s_projStep.collided);
+	}
+
+	void removeProjectile(u32 index)
+	{
+		const u32 last = s_proj.count - 1;
+		s_proj.count--;
+		if (index == last) { return; }
+
+		s_proj.posX[index] = s_proj.posX[last];
+		s_proj.posY[index] = s_proj.posY[last];
+		s_proj.posZ[index] = s_proj.posZ[last];
+		s_proj.velX[index] = s_proj.velX[last];
+		s_proj.velY[index] = s_proj.velY[last];
+		s_proj.velZ[index] = s_proj.velZ[last];
+		s_proj.flags[index] = s_proj.flags[last];
+		s_proj.obj[index] = s_proj.obj[last];
+		s_proj.pool[index] = s_proj.pool[last];
+		s_proj.effectPool[index] = s_proj.effectPool[last];
+		s_proj.hitEffectSound[index] = s_proj.hitEffectSound[last];
+		s_proj.damage[index] = s_proj.damage[last];
+		s_proj.value0[index] = s_proj.value0[last];
+		s_proj.value1[index] = s_proj.value1[last];
+	}
 }
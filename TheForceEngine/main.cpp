@@ -2,6 +2,7 @@
 #include <SDL.h>
 #include <TFE_System/types.h>
 #include <TFE_System/profiler.h>
+#include <TFE_System/frameStats.h>
 #include <TFE_ScriptSystem/scriptSystem.h>
 #include <TFE_InfSystem/infSystem.h>
 #include <TFE_Editor/editor.h>
@@ -55,6 +56,10 @@ static u32  s_monitorWidth = 1280;
 static u32  s_monitorHeight = 720;
 static bool s_gameUiInitRequired = true;
 static char s_screenshotTime[TFE_MAX_PATH];
+// Run the audio mixer benchmark after startup and exit.
+static bool s_audioBenchmark = false;
+static u32  s_audioBenchmarkSources = 32;
+static u32  s_audioBenchmarkFrames = 1024 * 1024;
 
 void parseOption(const char* name, const std::vector<const char*>& values, bool longName);
 
@@ -406,6 +411,7 @@ int main(int argc, char* argv[])
 	pathsSet &= TFE_Paths::setProgramDataPath("TheForceEngine");
 	pathsSet &= TFE_Paths::setUserDocumentsPath("TheForceEngine");
 	TFE_System::logOpen("the_force_engine_log.txt");
+	TFE_PROFILE_THREAD("Main");
 	TFE_System::logWrite(LOG_MSG, "Main", "The Force Engine v%d.%02d.%03d", TFE_MAJOR_VERSION, TFE_MINOR_VERSION, TFE_BUILD_VERSION);
 	if (!pathsSet)
 	{
@@ -484,8 +490,14 @@ int main(int argc, char* argv[])
 		return PROGRAM_ERROR;
 	}
 	TFE_FrontEndUI::initConsole();
+	TFE_FrameStats::init();
 	TFE_Audio::init();
 	TFE_MidiPlayer::init();
+	if (s_audioBenchmark)
+	{
+		TFE_Audio::runBenchmark(s_audioBenchmarkSources, s_audioBenchmarkFrames);
+		s_loop = false;
+	}
 	TFE_Polygon::init();
 	TFE_Image::init();
 	TFE_ScriptSystem::init();
@@ -531,6 +543,7 @@ int main(int argc, char* argv[])
 	while (s_loop)
 	{
 		TFE_FRAME_BEGIN();
+		TFE_FrameStats::beginFrame();
 
 		bool enableRelative = TFE_Input::relativeModeEnabled();
 		if (enableRelative != relativeMode)
@@ -614,6 +627,7 @@ int main(int argc, char* argv[])
 		TFE_FrontEndUI::draw(s_curState == APP_STATE_MENU || s_curState == APP_STATE_NO_GAME_DATA, s_curState == APP_STATE_NO_GAME_DATA);
 
 		// Render
+		const u64 renderStart = TFE_System::getCurrentTimeInTicks();
 		renderer->begin();
 		// Do stuff
 		bool swap = s_curState != APP_STATE_EDITOR && (s_curState != APP_STATE_MENU || TFE_FrontEndUI::isConfigMenuOpen());
@@ -622,18 +636,24 @@ int main(int argc, char* argv[])
 			swap = TFE_Editor::render();
 		}
 		renderer->end();
+		const u64 swapStart = TFE_System::getCurrentTimeInTicks();
+		TFE_FrameStats::addRenderTime(swapStart - renderStart);
 
 		// Blit the frame to the window and draw UI.
 		TFE_RenderBackend::swap(swap);
+		TFE_FrameStats::addSwapTime(TFE_System::getCurrentTimeInTicks() - swapStart);
 
 		// Clear transitory input state.
 		TFE_Input::endFrame();
+		TFE_ScriptSystem::update();
 		frame++;
 
+		TFE_FrameStats::endFrame();
 		TFE_FRAME_END();
 	}
 
 	// Cleanup
+	TFE_FrameStats::shutdown();
 	TFE_FrontEndUI::shutdown();
 	TFE_Audio::shutdown();
 	TFE_MidiPlayer::destroy();
@@ -715,5 +735,29 @@ void parseOption(const char* name, const std::vector<const char*>& values, bool
 			// --nocutscenes
 			TFE_System::logWrite(LOG_MSG, "CommandLine", "Disable cutscenes and title screen.");
 		}
+		else if (strcasecmp(name, "audio") == 0 && values.size() >= 1)		// Select the audio output and optionally the clock.
+		{
+			// --audio Null
+			// --audio WAV Game
+			TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
+			for (size_t i = 0; i < TFE_ARRAYSIZE(c_tfeAudioOutputStrings); i++)
+			{
+				if (strcasecmp(values[0], c_tfeAudioOutputStrings[i]) == 0) { soundSettings->audioOutput = TFE_AudioOutput(i); }
+			}
+			for (size_t i = 0; i < TFE_ARRAYSIZE(c_tfeAudioClockStrings) && values.size() >= 2; i++)
+			{
+				if (strcasecmp(values[1], c_tfeAudioClockStrings[i]) == 0) { soundSettings->audioClock = TFE_AudioClock(i); }
+			}
+			TFE_System::logWrite(LOG_MSG, "CommandLine", "Audio output: %s, clock: %s", c_tfeAudioOutputStrings[soundSettings->audioOutput], c_tfeAudioClockStrings[soundSettings->audioClock]);
+		}
+		else if (strcasecmp(name, "audioBenchmark") == 0)		// Run the audio mixer benchmark and exit.
+		{
+			// --audioBenchmark 64 1048576
+			char* endPtr = nullptr;
+			s_audioBenchmark = true;
+			if (values.size() >= 1) { s_audioBenchmarkSources = strtol(values[0], &endPtr, 10); }
+			if (values.size() >= 2) { s_audioBenchmarkFrames  = strtol(values[1], &endPtr, 10); }
+			TFE_System::logWrite(LOG_MSG, "CommandLine", "Audio benchmark: %u sources, %u frames", s_audioBenchmarkSources, s_audioBenchmarkFrames);
+		}
 	}
 }
\ No newline at end of file